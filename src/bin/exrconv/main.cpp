@@ -2,11 +2,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "ImfArray.h"
 #include "ImfCompression.h"
 #include "ImfHeader.h"
 #include "ImfRgbaFile.h"
 #include "ImfFrameBuffer.h"
+#include "ImfThreading.h"
+#include <IlmThreadConfig.h>
 #include <ImfNamespace.h>
 #include <OpenEXRConfig.h>
 
@@ -22,6 +31,9 @@ typedef struct _commandline_args
   unsigned int end_frame;
   char compression_string[512];
   bool is_process_framerange;
+  unsigned int frames_in_flight; // frames converted concurrently
+  unsigned int pool_threads; // size of the global compression thread pool
+  bool is_pool_threads_set;
 } commandline_args_t;
 
 static const char *compression_string_table[NUM_COMPRESSION_METHODS] = {
@@ -46,6 +58,9 @@ static const char *compression_string_table[NUM_COMPRESSION_METHODS] = {
 "HT256_COMPRESSION",
 "HTK_COMPRESSION",
 "HTK256_COMPRESSION",
+"HT_LOSSY_COMPRESSION",
+"PIZ_MS_COMPRESSION",
+"HT_STRIPED_COMPRESSION",
 };
 
 void print_argument_list(int argc, char* argv[])
@@ -80,9 +95,12 @@ void print_usage(int argc, char* argv[])
   print_allowed_compression_strings();
   fprintf(stderr, " -s <start_frame>\n");
   fprintf(stderr, " -e <end_frame>\n");
+  fprintf(stderr, " -j <frames_in_flight> - number of frames read, converted and written concurrently, default 1\n");
+  fprintf(stderr, " -t <threads> - size of the compression thread pool shared by all frames in flight, default is the number of cores\n");
 
   fprintf(stderr, "\nUSAGE EXAMPLE: %s -i input.exr -o output.%%01d.exr\n", argv[0]);
   fprintf(stderr, "\nUSAGE EXAMPLE: %s -i input.%%06d.exr -o output.%%07d.exr -s 3 -e 450 -c ZIP_COMPRESSION\n", argv[0]);
+  fprintf(stderr, "\nUSAGE EXAMPLE: %s -i input.%%06d.exr -o output.%%06d.exr -s 1 -e 2000 -c HT_COMPRESSION -j 4 -t 16\n", argv[0]);
 
 
   if (argc != 1)
@@ -106,6 +124,9 @@ int process_commandline_args(int argc, char* argv[], commandline_args_t *args)
   bool is_c_parsed = false;
   bool is_s_parsed = false;
   bool is_e_parsed = false;
+  bool is_j_parsed = false;
+
+  args->frames_in_flight = 1;
 
   if (argc == 1)
   {
@@ -208,6 +229,58 @@ int process_commandline_args(int argc, char* argv[], commandline_args_t *args)
       }
     }
 
+    // frames in flight
+    else if (strcmp(argv[i], "-j") == 0)
+    {
+      if (args_remaining <= 1)
+      {
+        fprintf(stderr, "USAGE ERROR in function %s of file %s on line %d:\n -j missing frame count argument\n", __FUNCTION__, __FILE__, __LINE__);
+        return -1;
+      }
+      else if (true == is_j_parsed)
+      {
+        fprintf(stderr, "USAGE ERROR in function %s of file %s on line %d:\n -j argument has already been processed, -j should only be used once\n", __FUNCTION__, __FILE__, __LINE__);
+        return -1;
+      }
+      else if (atoi(argv[i + 1]) < 1)
+      {
+        fprintf(stderr, "USAGE ERROR in function %s of file %s on line %d:\n -j frame count must be at least 1\n", __FUNCTION__, __FILE__, __LINE__);
+        return -1;
+      }
+      else
+      {
+        args->frames_in_flight = (unsigned int)atoi(argv[i + 1]);
+        i = i + 1;
+        is_j_parsed = true;
+      }
+    }
+
+    // compression threads
+    else if (strcmp(argv[i], "-t") == 0)
+    {
+      if (args_remaining <= 1)
+      {
+        fprintf(stderr, "USAGE ERROR in function %s of file %s on line %d:\n -t missing thread count argument\n", __FUNCTION__, __FILE__, __LINE__);
+        return -1;
+      }
+      else if (true == args->is_pool_threads_set)
+      {
+        fprintf(stderr, "USAGE ERROR in function %s of file %s on line %d:\n -t argument has already been processed, -t should only be used once\n", __FUNCTION__, __FILE__, __LINE__);
+        return -1;
+      }
+      else if (atoi(argv[i + 1]) < 0)
+      {
+        fprintf(stderr, "USAGE ERROR in function %s of file %s on line %d:\n -t thread count must not be negative\n", __FUNCTION__, __FILE__, __LINE__);
+        return -1;
+      }
+      else
+      {
+        args->pool_threads = (unsigned int)atoi(argv[i + 1]);
+        i = i + 1;
+        args->is_pool_threads_set = true;
+      }
+    }
+
     // compression
     else if (strcmp(argv[i], "-c") == 0)
     {
@@ -355,6 +428,92 @@ Compression get_compression_from_compression_string(const char* compression_stri
   return NO_COMPRESSION;
 }
 
+typedef struct _batch_state
+{
+  const commandline_args_t *args;
+  Compression compression;
+  int threads_per_frame; // line buffers per file, bounds its queued pool tasks
+  unsigned int number_of_frames;
+  std::atomic<unsigned int> next_frame{0};
+  std::atomic<unsigned int> frames_done{0};
+  std::atomic<unsigned long long> bytes_read{0};
+  std::atomic<unsigned long long> bytes_written{0};
+  std::atomic<bool> has_error{false};
+  std::mutex print_mutex;
+} batch_state_t;
+
+unsigned long long get_file_size(const char* filename)
+{
+  unsigned long long size = 0;
+  FILE *file = fopen(filename, "rb");
+  if (NULL != file)
+  {
+    if (0 == fseek(file, 0, SEEK_END))
+    {
+      long end = ftell(file);
+      if (end > 0)
+        size = (unsigned long long)end;
+    }
+    fclose(file);
+  }
+  return size;
+}
+
+void convert_frame(const char* input_filename, const char* output_filename, Compression compression, int num_threads)
+{
+  RgbaInputFile i_file(input_filename, num_threads);
+
+  Box2i         dw = i_file.dataWindow ();
+  int           width = dw.max.x - dw.min.x + 1;
+  int           height = dw.max.y - dw.min.y + 1;
+
+  Array2D<Rgba> pixels (height, width);
+
+  i_file.setFrameBuffer (&pixels[-dw.min.y][-dw.min.x], 1, width);
+  i_file.readPixels (dw.min.y, dw.max.y);
+
+  Header        header = i_file.header();
+  header.compression () = compression;
+
+  RgbaOutputFile o_file(output_filename, header, WRITE_RGB, num_threads);
+  o_file.setFrameBuffer(&pixels[-dw.min.y][-dw.min.x], 1, width);
+  o_file.writePixels(height);
+}
+
+// worker loop: claim the next unconverted frame until none are left
+void convert_frames(batch_state_t *state)
+{
+  const commandline_args_t *args = state->args;
+
+  for (;;)
+  {
+    unsigned int frame_index = state->next_frame++;
+    if (frame_index >= state->number_of_frames)
+      break;
+
+    // make image filenames
+    char input_filename[512] = { '\0' };
+    char output_filename[512] = { '\0' };
+    sprintf(input_filename, args->input_filename, frame_index + args->start_frame);
+    sprintf(output_filename, args->output_filename, frame_index + args->start_frame);
+
+    try
+    {
+      convert_frame(input_filename, output_filename, state->compression, state->threads_per_frame);
+
+      state->bytes_read += get_file_size(input_filename);
+      state->bytes_written += get_file_size(output_filename);
+      state->frames_done++;
+    }
+    catch (const std::exception& e)
+    {
+      std::lock_guard<std::mutex> lock(state->print_mutex);
+      fprintf(stderr, "ERROR converting %s to %s: %s\n", input_filename, output_filename, e.what());
+      state->has_error = true;
+    }
+  }
+}
+
 int main(int argc, char* argv[])
 {
   // process command line arguments
@@ -383,34 +542,59 @@ int main(int argc, char* argv[])
   Compression selected_compression = get_compression_from_compression_string(args.compression_string);
 
   unsigned int number_of_frames_to_process = args.end_frame - args.start_frame + 1;
-  for (unsigned int frame_index = 0; frame_index < number_of_frames_to_process; frame_index++)
-  {
-    // make image filenames
-    char input_filename[512] = { '\0' };
-    char output_filename[512] = { '\0' };
-    sprintf(input_filename, args.input_filename, frame_index + args.start_frame);
-    sprintf(output_filename, args.output_filename, frame_index + args.start_frame);
 
-    RgbaInputFile i_file(input_filename);
+#if !ILMTHREAD_THREADING_ENABLED
+  args.frames_in_flight = 1;
+#endif
+
+  if (args.frames_in_flight > number_of_frames_to_process)
+    args.frames_in_flight = number_of_frames_to_process;
+
+  // all frames share one global pool; the per-file thread count only
+  // sets how many line buffers each file keeps queued on it, so it caps
+  // a frame's share of the pool rather than reserving one
+  if (false == args.is_pool_threads_set)
+    args.pool_threads = std::thread::hardware_concurrency();
+
+  setGlobalThreadCount((int)args.pool_threads);
 
-    Box2i         dw = i_file.dataWindow ();
-    int           width = dw.max.x - dw.min.x + 1;
-    int           height = dw.max.y - dw.min.y + 1;
+  int threads_per_frame = (int)(args.pool_threads / args.frames_in_flight);
+  if (threads_per_frame < 1 && args.pool_threads > 0)
+    threads_per_frame = 1;
 
-    Array2D<Rgba> pixels (height, width);
+  batch_state_t state;
+  state.args = &args;
+  state.compression = selected_compression;
+  state.threads_per_frame = threads_per_frame;
+  state.number_of_frames = number_of_frames_to_process;
 
-    i_file.setFrameBuffer (&pixels[-dw.min.x][-dw.min.y], 1, width);
-    i_file.readPixels (dw.min.y, dw.max.y);
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
 
-    Header        header = i_file.header();
-    header.compression () = selected_compression;
+  // each worker converts one frame at a time, so at most
+  // frames_in_flight frames are held in memory at once
+  std::vector<std::thread> workers;
+  for (unsigned int i = 1; i < args.frames_in_flight; i++)
+    workers.push_back(std::thread(convert_frames, &state));
 
+  convert_frames(&state);
 
-    RgbaOutputFile o_file(output_filename, header, WRITE_RGB);
-    o_file.setFrameBuffer(&pixels[-dw.min.x][-dw.min.y], 1, width);
-    o_file.writePixels(height);
+  for (size_t i = 0; i < workers.size(); i++)
+    workers[i].join();
 
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+  unsigned int frames_done = state.frames_done;
+  double mbytes_read = state.bytes_read / (1024.0 * 1024.0);
+  double mbytes_written = state.bytes_written / (1024.0 * 1024.0);
+
+  fprintf(stderr, "Converted %u of %u frames in %.2f s with %u frames in flight and %d line buffers per frame\n",
+    frames_done, number_of_frames_to_process, seconds, args.frames_in_flight, threads_per_frame);
+
+  if (seconds > 0)
+  {
+    fprintf(stderr, " %.2f frames/s, read %.1f MB at %.1f MB/s, wrote %.1f MB at %.1f MB/s\n",
+      frames_done / seconds, mbytes_read, mbytes_read / seconds, mbytes_written, mbytes_written / seconds);
   }
 
-  return 0;
+  return state.has_error ? 1 : 0;
 }
\ No newline at end of file
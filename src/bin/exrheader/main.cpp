@@ -65,6 +65,20 @@ printCompression (Compression c)
 
         case DWAB_COMPRESSION: cout << "dwa, medium scanline blocks"; break;
 
+        case HT_COMPRESSION: cout << "ht, full frame"; break;
+
+        case HT256_COMPRESSION: cout << "ht, medium scanline blocks"; break;
+
+        case HTK_COMPRESSION: cout << "htk, full frame"; break;
+
+        case HTK256_COMPRESSION: cout << "htk, medium scanline blocks"; break;
+
+        case HT_LOSSY_COMPRESSION: cout << "lossy ht, medium scanline blocks"; break;
+
+        case PIZ_MS_COMPRESSION: cout << "piz, multi-stream"; break;
+
+        case HT_STRIPED_COMPRESSION: cout << "ht, full frame, striped"; break;
+
         default: cout << int (c); break;
     }
 }
@@ -14,10 +14,14 @@
 #include <ImathFun.h>
 #include <ImathMath.h>
 #include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
 #include <ImfInputFile.h>
 #include <ImfOutputFile.h>
 #include <ImfPreviewImage.h>
 #include <ImfRgbaFile.h>
+#include <ImfStandardAttributes.h>
 #include <ImfTiledOutputFile.h>
 #include <algorithm>
 #include <iostream>
@@ -56,6 +60,48 @@ gamma (half h, float m)
         std::pow (x, 0.4545f) * 84.66f, 0.f, 255.f));
 }
 
+//
+// The resolution level at which an HT compressed RGB file can be
+// read without dropping below the preview width, or 0 if the file
+// can only be read at full resolution.
+//
+
+int
+reducedLevel (const Header& header, int width, int previewWidth)
+{
+    Compression c = header.compression ();
+
+    if ((c != HT_COMPRESSION && c != HT256_COMPRESSION &&
+         c != HT_LOSSY_COMPRESSION && c != HT_STRIPED_COMPRESSION) ||
+        header.hasTileDescription () || !header.channels ().findChannel ("R") ||
+        !header.channels ().findChannel ("G") ||
+        !header.channels ().findChannel ("B"))
+    {
+        return 0;
+    }
+
+    for (ChannelList::ConstIterator i = header.channels ().begin ();
+         i != header.channels ().end ();
+         ++i)
+    {
+        if (i.channel ().xSampling != 1 || i.channel ().ySampling != 1)
+            return 0;
+    }
+
+    int maxLevel = hasHtDecompositionLevels (header)
+                       ? min (htDecompositionLevels (header), 5)
+                       : 5;
+    int level    = 0;
+
+    while (level < maxLevel &&
+           (width + (2 << level) - 1) >> (level + 1) >= previewWidth)
+    {
+        ++level;
+    }
+
+    return level;
+}
+
 void
 generatePreview (
     const char            inFileName[],
@@ -68,16 +114,57 @@ generatePreview (
     // Read the input file
     //
 
-    RgbaInputFile in (inFileName);
+    Array2D<Rgba> pixels;
+    Box2i         dw;
+    float         a;
+    int           w;
+    int           h;
+
+    {
+        InputFile in (inFileName);
+
+        dw = in.header ().dataWindow ();
+        a  = in.header ().pixelAspectRatio ();
+        w  = dw.max.x - dw.min.x + 1;
+        h  = dw.max.y - dw.min.y + 1;
+
+        int level = reducedLevel (in.header (), w, previewWidth);
+
+        if (level > 0)
+        {
+            //
+            // Decode only the wavelet levels that the preview needs.
+            //
+
+            w  = (w + (1 << level) - 1) >> level;
+            h  = (h + (1 << level) - 1) >> level;
+            dw = Box2i (dw.min, dw.min + V2i (w - 1, h - 1));
 
-    Box2i dw = in.dataWindow ();
-    float a  = in.pixelAspectRatio ();
-    int   w  = dw.max.x - dw.min.x + 1;
-    int   h  = dw.max.y - dw.min.y + 1;
+            pixels.resizeErase (h, w);
 
-    Array2D<Rgba> pixels (h, w);
-    in.setFrameBuffer (ComputeBasePointer (&pixels[0][0], dw), 1, w);
-    in.readPixels (dw.min.y, dw.max.y);
+            Rgba*       base = &pixels[0][0];
+            FrameBuffer fb;
+
+            fb.insert ("R", Slice::Make (HALF, &base->r, dw, sizeof (Rgba)));
+            fb.insert ("G", Slice::Make (HALF, &base->g, dw, sizeof (Rgba)));
+            fb.insert ("B", Slice::Make (HALF, &base->b, dw, sizeof (Rgba)));
+            fb.insert (
+                "A",
+                Slice::Make (HALF, &base->a, dw, sizeof (Rgba), 0, 1, 1, 1.0));
+
+            in.setFrameBuffer (fb);
+            in.readPixelsReduced (level);
+        }
+    }
+
+    if (pixels.height () == 0)
+    {
+        RgbaInputFile in (inFileName);
+
+        pixels.resizeErase (h, w);
+        in.setFrameBuffer (ComputeBasePointer (&pixels[0][0], dw), 1, w);
+        in.readPixels (dw.min.y, dw.max.y);
+    }
 
     //
     // Make a preview image
@@ -3,12 +3,18 @@
 #include <chrono>
 #include <numeric>
 #include <cmath>
+#include <sstream>
+#include <vector>
 
 #include "ImfArray.h"
 #include "ImfCompression.h"
+#include "ImfCompressor.h"
 #include "ImfHeader.h"
 #include "ImfRgbaFile.h"
 #include "ImfFrameBuffer.h"
+#include "ImfStandardAttributes.h"
+#include "ImfThreading.h"
+#include "IlmThreadPool.h"
 #include <ImfNamespace.h>
 #include <OpenEXRConfig.h>
 
@@ -32,7 +38,10 @@ static std::map<std::string, Compression> comp_table = {
      {"HT_COMPRESSION", HT_COMPRESSION},
      {"HT256_COMPRESSION", HT256_COMPRESSION},
      {"HTK_COMPRESSION", HTK_COMPRESSION},
-     {"HTK256_COMPRESSION", HTK256_COMPRESSION}}
+     {"HTK256_COMPRESSION", HTK256_COMPRESSION},
+     {"HT_LOSSY_COMPRESSION", HT_LOSSY_COMPRESSION},
+     {"PIZ_MS_COMPRESSION", PIZ_MS_COMPRESSION},
+     {"HT_STRIPED_COMPRESSION", HT_STRIPED_COMPRESSION}}
 };
 
 template <class T>
@@ -118,6 +127,125 @@ private:
     std::stringstream::pos_type _size;
 };
 
+//
+// Parses a "WxH" size, as used by the --ht-block and --ht-precinct options
+//
+
+static V2i
+parseSize (const std::string& s)
+{
+    V2i  size;
+    char x = 0;
+
+    std::istringstream is (s);
+    if (!(is >> size.x >> x >> size.y) || x != 'x')
+    {
+        std::cerr << "Invalid size '" << s << "', expected WxH" << std::endl;
+        exit (-1);
+    }
+
+    return size;
+}
+
+//
+// One point of the HT coding parameter sweep. Unset parameters are
+// left out of the header, so the compressor defaults apply.
+//
+
+struct HTParams
+{
+    int         levels = -1;
+    std::string block;
+    std::string progression;
+    std::string precinct;
+
+    void apply (Header& header) const
+    {
+        if (levels >= 0) addHtDecompositionLevels (header, levels);
+        if (!block.empty ()) addHtCodeBlockSize (header, parseSize (block));
+        if (!progression.empty ())
+            addHtProgressionOrder (header, progression);
+        if (!precinct.empty ())
+            addHtPrecinctSize (header, parseSize (precinct));
+    }
+
+    std::string str () const
+    {
+        std::ostringstream os;
+        os << (levels >= 0 ? std::to_string (levels) : "default") << ", "
+           << (block.empty () ? "default" : block) << ", "
+           << (progression.empty () ? "default" : progression) << ", "
+           << (precinct.empty () ? "default" : precinct);
+        return os.str ();
+    }
+};
+
+//
+// Expands the comma-separated lists of the --ht-* options into their
+// cartesian product.
+//
+
+static std::vector<HTParams>
+htSweep (const cxxopts::ParseResult& args)
+{
+    std::vector<int>         levels (1, -1);
+    std::vector<std::string> blocks (1), progressions (1), precincts (1);
+
+    if (args.count ("ht-levels"))
+        levels = args["ht-levels"].as<std::vector<int>> ();
+    if (args.count ("ht-block"))
+        blocks = args["ht-block"].as<std::vector<std::string>> ();
+    if (args.count ("ht-progression"))
+        progressions = args["ht-progression"].as<std::vector<std::string>> ();
+    if (args.count ("ht-precinct"))
+        precincts = args["ht-precinct"].as<std::vector<std::string>> ();
+
+    std::vector<HTParams> sweep;
+
+    for (int l: levels)
+        for (const std::string& b: blocks)
+            for (const std::string& o: progressions)
+                for (const std::string& p: precincts)
+                {
+                    HTParams params;
+                    params.levels      = l;
+                    params.block       = b;
+                    params.progression = o;
+                    params.precinct    = p;
+                    sweep.push_back (params);
+                }
+
+    return sweep;
+}
+
+/* install the thread pool provider named on the command line */
+
+static void
+usePool (const std::string& pool, int threads)
+{
+    ILMTHREAD_NAMESPACE::ThreadPool& tp =
+        ILMTHREAD_NAMESPACE::ThreadPool::globalThreadPool ();
+
+    if (pool == "default")
+    {
+        tp.setThreadProvider (nullptr);
+        tp.setNumThreads (threads);
+    }
+    else if (pool == "stealing")
+    {
+        tp.setThreadProvider (
+            threads > 0
+                ? new ILMTHREAD_NAMESPACE::WorkStealingThreadPoolProvider (
+                      threads)
+                : nullptr);
+    }
+    else
+    {
+        std::cerr << "Unknown thread pool " << pool << std::endl;
+        exit (-1);
+    }
+}
+
 int
 main (int argc, char* argv[])
 {
@@ -137,6 +265,21 @@ main (int argc, char* argv[])
         "l",
         "Line by line read",
         cxxopts::value<bool> ()->default_value ("false")) (
+        "ht-levels",
+        "HT decomposition levels to sweep, e.g. 3,5",
+        cxxopts::value<std::vector<int>> ()) (
+        "ht-block",
+        "HT code block sizes to sweep, e.g. 128x32,64x64",
+        cxxopts::value<std::vector<std::string>> ()) (
+        "ht-progression",
+        "HT progression orders to sweep, e.g. RPCL,LRCP",
+        cxxopts::value<std::vector<std::string>> ()) (
+        "ht-precinct",
+        "HT precinct sizes to sweep, e.g. 256x256",
+        cxxopts::value<std::vector<std::string>> ()) (
+        "pool",
+        "Thread pool providers to compare, e.g. default,stealing",
+        cxxopts::value<std::vector<std::string>> ()) (
         "file", "Input image", cxxopts::value<std::string> ()) (
         "compression", "Compression", cxxopts::value<std::string> ());
 
@@ -156,6 +299,9 @@ main (int argc, char* argv[])
 
     auto& src_fn = args["file"].as<std::string> ();
 
+    bool sweep = args.count ("ht-levels") || args.count ("ht-block") ||
+                 args.count ("ht-progression") || args.count ("ht-precinct");
+
     /* load src image */
     RgbaInputFile src_file (src_fn.c_str ());
 
@@ -168,103 +314,132 @@ main (int argc, char* argv[])
     src_file.setFrameBuffer (&src_pixels[-dw.min.x][-dw.min.y], 1, width);
     src_file.readPixels (dw.min.y, dw.max.y);
 
-    Header src_header         = src_file.header ();
-    src_header.compression () = c;
-
     /* thread count */
 
     setGlobalThreadCount (args["threads"].as<int> ());
 
-    /* mem buffer */
+    bool comparePools = args.count ("pool") != 0;
 
-    std::stringstream mem_file;
+    std::vector<std::string> pools = {"default"};
+    if (comparePools) pools = args["pool"].as<std::vector<std::string>> ();
 
-    /* encode performance */
+    if (args["verbose"].as<bool> ())
+        std::cout
+            << "fn, c, n, threads, encoded size, encode time mean, encode time stddev, decode time mean, decode time stddev"
+            << (sweep ? ", ht levels, ht block, ht progression, ht precinct"
+                      : "")
+            << (comparePools ? ", pool" : "") << std::endl;
 
-    std::vector<double> encode_times;
+    std::string fn = src_fn.substr (src_fn.find_last_of ("/\\") + 1);
 
-    int encoded_size;
+    std::vector<HTParams> params_sweep = htSweep (args);
 
-    for (int i = 0; i < args["repetitions"].as<int> (); i++)
+    for (const std::string& pool: pools)
     {
+        if (comparePools) usePool (pool, args["threads"].as<int> ());
 
-        OMemStream o_memfile (&mem_file);
+        for (const HTParams& params: params_sweep)
+        {
+            Header src_header         = src_file.header ();
+            src_header.compression () = c;
+            params.apply (src_header);
 
-        RgbaOutputFile o_file (o_memfile, src_header, src_file.channels ());
-        o_file.setFrameBuffer (&src_pixels[-dw.min.x][-dw.min.y], 1, width);
+            /* mem buffer */
 
-        auto start = std::chrono::high_resolution_clock::now ();
-        o_file.writePixels (height);
-        auto dur = std::chrono::high_resolution_clock::now () - start;
+            std::stringstream mem_file;
 
-        encode_times.push_back (std::chrono::duration<double> (dur).count ());
+            /* encode performance */
 
-        if (i == 0) { encoded_size = mem_file.tellp (); }
-    }
+            std::vector<double> encode_times;
 
-    /* decode performance */
+            int encoded_size;
 
-    std::vector<double> decode_times;
+            for (int i = 0; i < args["repetitions"].as<int> (); i++)
+            {
 
-    for (int i = 0; i < args["repetitions"].as<int> (); i++)
-    {
+                OMemStream o_memfile (&mem_file);
 
-        IMemStream i_memfile (&mem_file);
+                RgbaOutputFile o_file (
+                    o_memfile, src_header, src_file.channels ());
+                o_file.setFrameBuffer (
+                    &src_pixels[-dw.min.x][-dw.min.y], 1, width);
 
-        RgbaInputFile i_file (i_memfile);
+                auto start = std::chrono::high_resolution_clock::now ();
+                o_file.writePixels (height);
+                auto dur = std::chrono::high_resolution_clock::now () - start;
 
-        Array2D<Rgba> decoded_pixels (width, height);
-        i_file.setFrameBuffer (&decoded_pixels[-dw.min.x][-dw.min.y], 1, width);
+                encode_times.push_back (
+                    std::chrono::duration<double> (dur).count ());
 
-        auto start = std::chrono::high_resolution_clock::now ();
-        if (args["l"].as<bool> ()) {
-            for (size_t j = dw.min.y; j <= dw.max.y; j++)
-            {
-                i_file.readPixels (j, j);
+                if (i == 0) { encoded_size = mem_file.tellp (); }
             }
-        } else {
-            i_file.readPixels (dw.min.y, dw.max.y);
-        }
-        auto dur = std::chrono::high_resolution_clock::now () - start;
 
-        decode_times.push_back (std::chrono::duration<double> (dur).count ());
+            /* decode performance */
 
-        /* compare pixels */
+            std::vector<double> decode_times;
 
-        for (size_t y = 0; y < height; y++)
-        {
-            for (size_t x = 0; x < width; x++)
+            for (int i = 0; i < args["repetitions"].as<int> (); i++)
             {
-                if (decoded_pixels[x][y].r != src_pixels[x][y].r ||
-                    decoded_pixels[x][y].g != src_pixels[x][y].g ||
-                    decoded_pixels[x][y].b != src_pixels[x][y].b)
+
+                IMemStream i_memfile (&mem_file);
+
+                RgbaInputFile i_file (i_memfile);
+
+                Array2D<Rgba> decoded_pixels (width, height);
+                i_file.setFrameBuffer (
+                    &decoded_pixels[-dw.min.x][-dw.min.y], 1, width);
+
+                auto start = std::chrono::high_resolution_clock::now ();
+                if (args["l"].as<bool> ()) {
+                    for (size_t j = dw.min.y; j <= dw.max.y; j++)
+                    {
+                        i_file.readPixels (j, j);
+                    }
+                } else {
+                    i_file.readPixels (dw.min.y, dw.max.y);
+                }
+                auto dur = std::chrono::high_resolution_clock::now () - start;
+
+                decode_times.push_back (
+                    std::chrono::duration<double> (dur).count ());
+
+                /* compare pixels, unless the compression is lossy */
+
+                for (size_t y = 0; !isLossyCompression (c) && y < height; y++)
                 {
-                    std::cerr << "Not lossless at " << x << ", " << y
-                              << std::endl;
-                    exit (-1);
+                    for (size_t x = 0; x < width; x++)
+                    {
+                        if (decoded_pixels[x][y].r != src_pixels[x][y].r ||
+                            decoded_pixels[x][y].g != src_pixels[x][y].g ||
+                            decoded_pixels[x][y].b != src_pixels[x][y].b)
+                        {
+                            std::cerr << "Not lossless at " << x << ", " << y
+                                      << std::endl;
+                            exit (-1);
+                        }
+                    }
                 }
             }
-        }
-    }
 
-    double encode_time_mean = mean (encode_times);
-    double encode_time_dev  = stddev (encode_times, encode_time_mean);
+            double encode_time_mean = mean (encode_times);
+            double encode_time_dev  = stddev (encode_times, encode_time_mean);
 
-    double decode_time_mean = mean (decode_times);
-    double decode_time_dev  = stddev (decode_times, decode_time_mean);
+            double decode_time_mean = mean (decode_times);
+            double decode_time_dev  = stddev (decode_times, decode_time_mean);
 
-    if (args["verbose"].as<bool> ())
-        std::cout
-            << "fn, c, n, threads, encoded size, encode time mean, encode time stddev, decode time mean, decode time stddev"
-            << std::endl;
+            std::cout << fn << ", " << args["compression"].as<std::string> ()
+                      << ", " << args["repetitions"].as<int> () << ", "
+                      << args["threads"].as<int> () << ", " << encoded_size << ", "
+                      << encode_time_mean << ", " << encode_time_dev << ", "
+                      << decode_time_mean << ", " << decode_time_dev;
 
-    std::string fn = src_fn.substr (src_fn.find_last_of ("/\\") + 1);
+            if (sweep) std::cout << ", " << params.str ();
+
+            if (comparePools) std::cout << ", " << pool;
 
-    std::cout << fn << ", " << args["compression"].as<std::string> () << ", "
-              << args["repetitions"].as<int> () << ", "
-              << args["threads"].as<int> () << ", " << encoded_size << ", "
-              << encode_time_mean << ", " << encode_time_dev << ", "
-              << decode_time_mean << ", " << decode_time_dev << std::endl;
+            std::cout << std::endl;
+        }
+    }
 
     return 0;
 }
@@ -15,9 +15,13 @@
 #include "IlmThreadSemaphore.h"
 
 #include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <thread>
 #include <vector>
 
@@ -325,6 +329,529 @@ DefaultThreadPoolProvider::threadLoop (
     }
 }
 
+//
+// class TaskDeque -- the Chase-Lev work-stealing deque, with the
+// memory orderings of "Correct and Efficient Work-Stealing for Weak
+// Memory Models" (Le et al., PPoPP 2013).  Only the owning thread
+// may call push() and pop(), any thread may call steal().  The ring
+// doubles when it fills up; the old rings are kept until the deque
+// is destroyed, because a thief may still be reading one.
+//
+
+class TaskDeque
+{
+public:
+    TaskDeque () : _top (0), _bottom (0)
+    {
+        _rings.emplace_back (new Ring (64));
+        _ring.store (_rings.back ().get (), std::memory_order_relaxed);
+    }
+
+    TaskDeque (const TaskDeque&)            = delete;
+    TaskDeque& operator= (const TaskDeque&) = delete;
+    TaskDeque (TaskDeque&&)                 = delete;
+    TaskDeque& operator= (TaskDeque&&)      = delete;
+
+    void push (Task* task)
+    {
+        int64_t b = _bottom.load (std::memory_order_relaxed);
+        int64_t t = _top.load (std::memory_order_acquire);
+        Ring*   r = _ring.load (std::memory_order_relaxed);
+
+        if (b - t > r->mask)
+        {
+            Ring* bigger = new Ring (2 * (r->mask + 1));
+            for (int64_t i = t; i != b; ++i)
+                bigger->put (i, r->get (i));
+            _rings.emplace_back (bigger);
+            _ring.store (bigger, std::memory_order_release);
+            r = bigger;
+        }
+
+        r->put (b, task);
+        std::atomic_thread_fence (std::memory_order_release);
+        _bottom.store (b + 1, std::memory_order_relaxed);
+    }
+
+    Task* pop ()
+    {
+        int64_t b = _bottom.load (std::memory_order_relaxed) - 1;
+        Ring*   r = _ring.load (std::memory_order_relaxed);
+        _bottom.store (b, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        int64_t t = _top.load (std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            // empty
+            _bottom.store (b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Task* task = r->get (b);
+
+        if (t == b)
+        {
+            // last task, race the thieves for it
+            if (!_top.compare_exchange_strong (
+                    t,
+                    t + 1,
+                    std::memory_order_seq_cst,
+                    std::memory_order_relaxed))
+                task = nullptr;
+            _bottom.store (b + 1, std::memory_order_relaxed);
+        }
+
+        return task;
+    }
+
+    Task* steal ()
+    {
+        while (true)
+        {
+            int64_t t = _top.load (std::memory_order_acquire);
+            std::atomic_thread_fence (std::memory_order_seq_cst);
+            int64_t b = _bottom.load (std::memory_order_acquire);
+
+            if (t >= b) return nullptr;
+
+            Ring* r    = _ring.load (std::memory_order_acquire);
+            Task* task = r->get (t);
+
+            if (_top.compare_exchange_strong (
+                    t,
+                    t + 1,
+                    std::memory_order_seq_cst,
+                    std::memory_order_relaxed))
+                return task;
+
+            // lost the race to another thief or the owner, try again
+        }
+    }
+
+private:
+    struct Ring
+    {
+        explicit Ring (int64_t size)
+            : mask (size - 1), slots (new std::atomic<Task*>[size])
+        {}
+
+        Task* get (int64_t i) const
+        {
+            return slots[i & mask].load (std::memory_order_relaxed);
+        }
+
+        void put (int64_t i, Task* task)
+        {
+            slots[i & mask].store (task, std::memory_order_relaxed);
+        }
+
+        const int64_t                          mask;
+        std::unique_ptr<std::atomic<Task*>[]> slots;
+    };
+
+    // keep the ends of the deque, written by different
+    // threads, on separate cache lines
+    std::atomic<int64_t> _top;
+    char                 _pad0[64 - sizeof (std::atomic<int64_t>)];
+    std::atomic<int64_t> _bottom;
+    char                 _pad1[64 - sizeof (std::atomic<int64_t>)];
+
+    std::atomic<Ring*>                 _ring;
+    std::vector<std::unique_ptr<Ring>> _rings; // owner only
+};
+
+//
+// One worker of a WorkStealingThreadPoolProvider.  The inbox
+// receives the tasks added from threads outside the pool, which
+// cannot push onto the deque; its lock is only ever contended by
+// one producer and the threads emptying it.
+//
+
+struct StealingWorker
+{
+    TaskDeque          deque;
+    std::mutex         inboxMutex;
+    std::vector<Task*> inbox;
+    std::atomic<int>   inboxSize{0};
+    std::thread        thread;
+};
+
+} //namespace
+
+//
+// struct WorkStealingThreadPoolProvider::Data
+//
+// Idle workers sleep on a semaphore.  A worker registers in
+// sleepers before it looks for work one last time, and addTask ()
+// queues the task before it reads sleepers, so either the worker
+// sees the task or addTask () sees the worker and wakes one.  Both
+// sides need a full barrier between their store and their load:
+// the worker's is the fetch_add on sleepers, a task added to an
+// inbox has the store to inboxSize, and a task added to a deque
+// from inside the pool has an explicit fence.
+//
+// addTask () calls from outside the pool hold workersMutex shared
+// while they use workers and wake; start () and stop () hold it
+// exclusively while they replace them.  The workers themselves do
+// not take it, since the vector never changes while they run.
+//
+
+struct WorkStealingThreadPoolProvider::Data
+{
+    std::mutex threadMutex; // serializes setNumThreads () and finish ()
+
+    std::shared_timed_mutex                      workersMutex;
+    std::vector<std::unique_ptr<StealingWorker>> workers;
+    std::unique_ptr<Semaphore>                   wake;
+    std::atomic<int>                             numWorkers{0};
+    std::atomic<int>                             sleepers{0};
+    std::atomic<unsigned>                        nextInbox{0};
+    std::atomic<bool>                            stopping{false};
+
+    void  start (int count);
+    void  stop (std::vector<Task*>& leftover);
+    void  threadLoop (size_t index);
+    Task* findTask (size_t index);
+    Task* takeFromInbox (StealingWorker& worker, bool all);
+    bool  claimSleeper ();
+};
+
+namespace
+{
+
+//
+// The provider and worker index of the current thread, if it is a
+// worker of a WorkStealingThreadPoolProvider, so that nested tasks
+// go onto its own deque.
+//
+
+thread_local WorkStealingThreadPoolProvider::Data* tlsStealingPool = nullptr;
+thread_local size_t                               tlsStealingIndex = 0;
+
+} //namespace
+
+void
+WorkStealingThreadPoolProvider::Data::start (int count)
+{
+    {
+        std::lock_guard<std::shared_timed_mutex> lock (workersMutex);
+
+        stopping = false;
+        sleepers = 0;
+        wake.reset (new Semaphore (0));
+
+        workers.resize (static_cast<size_t> (count));
+        for (auto& w: workers)
+            w.reset (new StealingWorker);
+
+        numWorkers = count;
+    }
+
+    for (size_t i = 0; i < workers.size (); ++i)
+        workers[i]->thread = std::thread (&Data::threadLoop, this, i);
+}
+
+void
+WorkStealingThreadPoolProvider::Data::stop (std::vector<Task*>& leftover)
+{
+    //
+    // The workers run whatever is still queued before they exit.
+    // Post once per worker so that every sleeping worker wakes up
+    // and sees that we are stopping.
+    //
+
+    stopping = true;
+
+    for (size_t i = 0; i < workers.size (); ++i)
+        wake->post ();
+
+    for (auto& w: workers)
+        w->thread.join ();
+
+    //
+    // addTask () may have queued tasks after their worker last
+    // looked for work.  Hand them back to the caller, which must
+    // run them once it no longer holds threadMutex, so that no
+    // task is lost and no TaskGroup waits forever.
+    //
+
+    std::lock_guard<std::shared_timed_mutex> lock (workersMutex);
+
+    for (auto& w: workers)
+    {
+        leftover.insert (leftover.end (), w->inbox.begin (), w->inbox.end ());
+
+        while (Task* task = w->deque.pop ())
+            leftover.push_back (task);
+    }
+
+    workers.clear ();
+    numWorkers = 0;
+}
+
+bool
+WorkStealingThreadPoolProvider::Data::claimSleeper ()
+{
+    int s = sleepers.load ();
+    while (s > 0)
+    {
+        if (sleepers.compare_exchange_weak (s, s - 1)) return true;
+    }
+    return false;
+}
+
+Task*
+WorkStealingThreadPoolProvider::Data::takeFromInbox (
+    StealingWorker& worker, bool all)
+{
+    if (worker.inboxSize.load () == 0) return nullptr;
+
+    std::lock_guard<std::mutex> lock (worker.inboxMutex);
+
+    if (worker.inbox.empty ()) return nullptr;
+
+    Task* task;
+
+    if (all)
+    {
+        //
+        // The owner moves the backlog onto its deque, where
+        // the other workers can steal it without locking.
+        //
+
+        task = worker.inbox.back ();
+        for (size_t i = 0; i + 1 < worker.inbox.size (); ++i)
+            worker.deque.push (worker.inbox[i]);
+        worker.inbox.clear ();
+    }
+    else
+    {
+        task = worker.inbox.front ();
+        worker.inbox.erase (worker.inbox.begin ());
+    }
+
+    worker.inboxSize = static_cast<int> (worker.inbox.size ());
+    return task;
+}
+
+Task*
+WorkStealingThreadPoolProvider::Data::findTask (size_t index)
+{
+    StealingWorker& self = *workers[index];
+
+    if (Task* task = self.deque.pop ()) return task;
+    if (Task* task = takeFromInbox (self, true)) return task;
+
+    size_t n = workers.size ();
+
+    for (size_t i = 1; i < n; ++i)
+    {
+        if (Task* task = workers[(index + i) % n]->deque.steal ())
+            return task;
+    }
+
+    for (size_t i = 1; i < n; ++i)
+    {
+        if (Task* task = takeFromInbox (*workers[(index + i) % n], false))
+            return task;
+    }
+
+    return nullptr;
+}
+
+void
+WorkStealingThreadPoolProvider::Data::threadLoop (size_t index)
+{
+    tlsStealingPool  = this;
+    tlsStealingIndex = index;
+
+    while (true)
+    {
+        Task* task = findTask (index);
+
+        if (task)
+        {
+            handleProcessTask (task);
+            continue;
+        }
+
+        if (stopping.load ()) break;
+
+        sleepers.fetch_add (1);
+
+        task = findTask (index);
+
+        if (task || stopping.load ())
+        {
+            // withdraw, unless addTask () or stop () has already
+            // claimed us, in which case eat the wake up they sent
+            if (!claimSleeper ()) wake->wait ();
+
+            if (task) handleProcessTask (task);
+            continue;
+        }
+
+        wake->wait ();
+    }
+
+    tlsStealingPool = nullptr;
+}
+
+#endif // ENABLE_THREADING
+
+//
+// class WorkStealingThreadPoolProvider
+//
+
+WorkStealingThreadPoolProvider::WorkStealingThreadPoolProvider (int count)
+    :
+#ifdef ENABLE_THREADING
+    _data (new Data)
+#else
+    _data (nullptr)
+#endif
+{
+    setNumThreads (count);
+}
+
+WorkStealingThreadPoolProvider::~WorkStealingThreadPoolProvider ()
+{
+#ifdef ENABLE_THREADING
+    finish ();
+    delete _data;
+#endif
+}
+
+int
+WorkStealingThreadPoolProvider::numThreads () const
+{
+#ifdef ENABLE_THREADING
+    // no lock, tasks ask for this while the pool is being resized
+    return _data->numWorkers.load ();
+#else
+    return 0;
+#endif
+}
+
+void
+WorkStealingThreadPoolProvider::setNumThreads (int count)
+{
+#ifdef ENABLE_THREADING
+    if (count < 0)
+        throw IEX_INTERNAL_NAMESPACE::ArgExc (
+            "Attempt to set the number of threads "
+            "in a thread pool to a negative value.");
+
+    std::vector<Task*>           leftover;
+    std::unique_lock<std::mutex> lock (_data->threadMutex);
+
+    if (static_cast<size_t> (count) == _data->workers.size ()) return;
+
+    //
+    // The deques are sized for a fixed set of workers, so
+    // resizing means draining and restarting all of them.
+    // Tasks that missed the old workers go to the new ones.
+    //
+
+    if (!_data->workers.empty ()) _data->stop (leftover);
+    if (count > 0) _data->start (count);
+
+    lock.unlock ();
+
+    for (Task* task: leftover)
+        addTask (task);
+#else
+    (void) count;
+#endif
+}
+
+void
+WorkStealingThreadPoolProvider::addTask (Task* task)
+{
+#ifdef ENABLE_THREADING
+    Data* d = _data;
+
+    if (tlsStealingPool == d)
+    {
+        d->workers[tlsStealingIndex]->deque.push (task);
+
+        //
+        // push () publishes the task with a relaxed store; without a
+        // full fence the load of sleepers could be ordered before it,
+        // and a worker going to sleep might miss the task while we
+        // miss the worker.
+        //
+
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+
+        if (d->claimSleeper ()) d->wake->post ();
+        return;
+    }
+
+    {
+        std::shared_lock<std::shared_timed_mutex> workersLock (
+            d->workersMutex);
+
+        if (!d->workers.empty ())
+        {
+            unsigned        n = static_cast<unsigned> (d->workers.size ());
+            StealingWorker& w = *d->workers[d->nextInbox.fetch_add (1) % n];
+
+            {
+                std::lock_guard<std::mutex> lock (w.inboxMutex);
+                w.inbox.push_back (task);
+                w.inboxSize = static_cast<int> (w.inbox.size ());
+            }
+
+            if (d->claimSleeper ()) d->wake->post ();
+            return;
+        }
+    }
+
+    handleProcessTask (task);
+#else
+    handleProcessTask (task);
+#endif
+}
+
+void
+WorkStealingThreadPoolProvider::finish ()
+{
+#ifdef ENABLE_THREADING
+    std::vector<Task*> leftover;
+
+    {
+        std::lock_guard<std::mutex> lock (_data->threadMutex);
+
+        if (!_data->workers.empty ()) _data->stop (leftover);
+    }
+
+    for (Task* task: leftover)
+        handleProcessTask (task);
+#endif
+}
+
+#ifdef ENABLE_THREADING
+
+namespace
+{
+
+//
+// ILMTHREAD_WORK_STEALING=1 in the environment makes ThreadPool
+// create WorkStealingThreadPoolProviders instead of default ones.
+//
+
+bool
+useWorkStealing ()
+{
+    static const bool use = [] {
+        const char* env = getenv ("ILMTHREAD_WORK_STEALING");
+        return env && *env && strcmp (env, "0") != 0;
+    }();
+    return use;
+}
+
 } //namespace
 
 //
@@ -533,6 +1060,9 @@ ThreadPool::setNumThreads (int count)
     // a default provider to a null one or vice-versa
     if (count == 0)
         _data->setProvider (nullptr);
+    else if (useWorkStealing ())
+        _data->setProvider (
+            std::make_shared<WorkStealingThreadPoolProvider> (count));
     else
         _data->setProvider (
             std::make_shared<DefaultThreadPoolProvider> (count));
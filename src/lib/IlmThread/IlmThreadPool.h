@@ -70,6 +70,42 @@ public:
     ThreadPoolProvider& operator= (ThreadPoolProvider&&) = delete;
 };
 
+//-------------------------------------------------------
+// WorkStealingThreadPoolProvider -- a ThreadPoolProvider
+// where every worker thread owns a deque of tasks, so that
+// there is no single lock which every task has to go
+// through.  Tasks added by a worker thread (nested tasks)
+// go onto that thread's deque; tasks added by any other
+// thread are spread over per-worker inboxes.  A worker
+// takes the newest task from its own deque, refills the
+// deque from its inbox, and when both are empty, steals
+// the oldest task from another worker's deque without
+// locking.
+//
+// Install it with ThreadPool::setThreadProvider(), or set
+// the environment variable ILMTHREAD_WORK_STEALING to a
+// value other than 0 to make ThreadPool::setNumThreads()
+// create it instead of the default provider.
+//-------------------------------------------------------
+
+class ILMTHREAD_EXPORT_TYPE WorkStealingThreadPoolProvider
+    : public ThreadPoolProvider
+{
+public:
+    ILMTHREAD_EXPORT WorkStealingThreadPoolProvider (int count);
+    ILMTHREAD_EXPORT ~WorkStealingThreadPoolProvider () override;
+
+    ILMTHREAD_EXPORT int  numThreads () const override;
+    ILMTHREAD_EXPORT void setNumThreads (int count) override;
+    ILMTHREAD_EXPORT void addTask (Task* task) override;
+    ILMTHREAD_EXPORT void finish () override;
+
+    struct ILMTHREAD_HIDDEN Data;
+
+private:
+    Data* _data;
+};
+
 class ILMTHREAD_EXPORT_TYPE ThreadPool
 {
 public:
@@ -0,0 +1,104 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//-----------------------------------------------------------------------------
+//
+//	class AsyncRead
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfAsyncRead.h"
+#include "ImfAsyncReadData.h"
+
+#include "Iex.h"
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+AsyncRead::Data::Data (const std::string& name)
+    : taskGroup (new ILMTHREAD_NAMESPACE::TaskGroup)
+    , fileName (name)
+    , hasException (false)
+{
+    // empty
+}
+
+AsyncRead::Data::~Data ()
+{
+    finish ();
+}
+
+void
+AsyncRead::Data::finish ()
+{
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (*this);
+#endif
+
+    if (!taskGroup) return;
+
+    //
+    // Destroying the task group waits for its tasks
+    //
+
+    taskGroup.reset ();
+
+    if (collectExceptions)
+    {
+        hasException      = collectExceptions (exception);
+        collectExceptions = nullptr;
+    }
+}
+
+AsyncRead::AsyncRead ()
+{
+    // empty
+}
+
+AsyncRead::AsyncRead (const std::shared_ptr<Data>& data) : _data (data)
+{
+    // empty
+}
+
+AsyncRead::~AsyncRead ()
+{
+    if (_data) _data->finish ();
+}
+
+AsyncRead::AsyncRead (AsyncRead&& other) : _data (std::move (other._data))
+{
+    // empty
+}
+
+AsyncRead&
+AsyncRead::operator= (AsyncRead&& other)
+{
+    if (this != &other)
+    {
+        if (_data) _data->finish ();
+        _data = std::move (other._data);
+    }
+
+    return *this;
+}
+
+void
+AsyncRead::wait ()
+{
+    if (!_data) return;
+
+    _data->finish ();
+
+    if (_data->hasException)
+    {
+        _data->hasException = false;
+
+        THROW (
+            IEX_NAMESPACE::IoExc,
+            "Error reading pixel data from image file \""
+                << _data->fileName << "\". " << _data->exception);
+    }
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -0,0 +1,74 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_ASYNC_READ_H
+#define INCLUDED_IMF_ASYNC_READ_H
+
+//-----------------------------------------------------------------------------
+//
+//	class AsyncRead -- a handle to a read that runs in the
+//	background, returned by InputFile::readPixelsAsync() and
+//	ScanLineInputFile::readPixelsAsync().
+//
+//	The chunks of an asynchronous read are read and uncompressed by
+//	the global thread pool while the calling thread does other work.
+//	wait() blocks until all of them have been stored in the frame
+//	buffer, and throws if any of them could not be read.  Destroying
+//	the handle also waits, but does not throw.
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfExport.h"
+#include "ImfNamespace.h"
+
+#include <memory>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+class IMF_EXPORT_TYPE AsyncRead
+{
+public:
+    //-------------------------------------------------------
+    // Constructor -- a handle to a read that has finished.
+    //-------------------------------------------------------
+
+    IMF_EXPORT
+    AsyncRead ();
+
+    //-----------------------------------------------
+    // Destructor -- waits for the read to finish.
+    //-----------------------------------------------
+
+    IMF_EXPORT
+    ~AsyncRead ();
+
+    IMF_EXPORT
+    AsyncRead (AsyncRead&& other);
+    IMF_EXPORT
+    AsyncRead& operator= (AsyncRead&& other);
+
+    AsyncRead (const AsyncRead&)            = delete;
+    AsyncRead& operator= (const AsyncRead&) = delete;
+
+    //------------------------------------------------------------
+    // Wait for the read to finish.  If any of its chunks could
+    // not be read, wait() throws an IEX_NAMESPACE::IoExc, once.
+    //------------------------------------------------------------
+
+    IMF_EXPORT
+    void wait ();
+
+    struct IMF_HIDDEN Data;
+
+    IMF_HIDDEN
+    explicit AsyncRead (const std::shared_ptr<Data>& data);
+
+private:
+    std::shared_ptr<Data> _data;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
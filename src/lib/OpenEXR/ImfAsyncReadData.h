@@ -0,0 +1,62 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_ASYNC_READ_DATA_H
+#define INCLUDED_IMF_ASYNC_READ_DATA_H
+
+#include "ImfAsyncRead.h"
+
+#include "IlmThreadConfig.h"
+#include "IlmThreadPool.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#if ILMTHREAD_THREADING_ENABLED
+#    include <mutex>
+#endif
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+//
+// The state of an asynchronous read, shared by the AsyncRead handle
+// and the file that started it.  The file finishes a pending read
+// before it changes anything the read's tasks use, and before it is
+// destroyed, so the tasks and collectExceptions never outlive it.
+//
+
+struct AsyncRead::Data
+#if ILMTHREAD_THREADING_ENABLED
+    : public std::mutex
+#endif
+{
+    explicit Data (const std::string& fileName);
+    ~Data ();
+
+    Data (const Data&)            = delete;
+    Data& operator= (const Data&) = delete;
+    Data (Data&&)                 = delete;
+    Data& operator= (Data&&)      = delete;
+
+    //
+    // Wait for the tasks of the read, then ask collectExceptions
+    // for the first exception they stored, if any.  Only the
+    // first call does anything.
+    //
+
+    void finish ();
+
+    std::unique_ptr<ILMTHREAD_NAMESPACE::TaskGroup> taskGroup;
+    std::function<bool (std::string&)>              collectExceptions;
+
+    std::string fileName;
+    bool        hasException;
+    std::string exception;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -0,0 +1,81 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_CACHED_TILE_H
+#define INCLUDED_IMF_CACHED_TILE_H
+
+#include "ImfCompressor.h"
+#include "ImfForward.h"
+#include "ImfNamespace.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+//
+// An uncompressed tile held by the tile cache (see ImfTileCache.h).
+// The data is in the given format, exactly as the tile's compressor
+// returned it, or in XDR format if the tile was stored uncompressed.
+// Entries are immutable; a reader keeps its entry alive while it
+// copies from it, even if the cache evicts it in the meantime.
+//
+
+struct CachedTile
+{
+    std::vector<char>  data;
+    Compressor::Format format;
+};
+
+struct TileCacheKey
+{
+    const std::string* fileId;   // owned by the file doing the lookup
+    size_t             fileHash; // std::hash of *fileId
+    int                partNumber;
+    int                dx;
+    int                dy;
+    int                lx;
+    int                ly;
+    uint64_t           offset; // of the tile in the file
+};
+
+//
+// Return the string that identifies the file read through a stream in
+// the cache.  Streams that the library opens from a file name get the
+// file's identity (device and inode, or volume and file index, plus
+// size and modification time), so every reader of the same file shares
+// its tiles, and a rewritten file never matches stale ones.  Any other
+// stream gets an id of its own, and its tiles are never shared.
+//
+
+std::string tileCacheFileId (IStream& is);
+
+//
+// True if the cache size is not zero
+//
+
+bool tileCacheEnabled ();
+
+//
+// Return the cached tile for key, or a null pointer on a miss
+//
+
+std::shared_ptr<const CachedTile> findCachedTile (const TileCacheKey& key);
+
+//
+// Insert a copy of size bytes of uncompressed tile data
+//
+
+void cacheTile (
+    const TileCacheKey& key,
+    const char*         data,
+    size_t              size,
+    Compressor::Format  format);
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -53,6 +53,21 @@ enum IMF_EXPORT_ENUM Compression
 
     HTK256_COMPRESSION = 13,
 
+    HT_LOSSY_COMPRESSION = 14, // lossy HT, using the irreversible 9/7
+                               // wavelet transform, in blocks of 256
+                               // scanlines. See setDefaultHtCompressionLevel.
+
+    PIZ_MS_COMPRESSION = 15, // piz, with the Huffman data split into
+                             // several streams that can be decoded
+                             // side by side. Faster to decode than
+                             // PIZ_COMPRESSION, for a few more bytes.
+
+    HT_STRIPED_COMPRESSION = 16, // ht, in full frame chunks that are split
+                                 // into independent 256 scanline stripes.
+                                 // Faster to encode and decode with many
+                                 // threads, and for partial reads, than
+                                 // HT_COMPRESSION.
+
     NUM_COMPRESSION_METHODS // number of different compression methods
 };
 
@@ -63,6 +78,11 @@ IMF_EXPORT void setDefaultZipCompressionLevel (int level);
 /// Controls the default quality level for the DWA lossy compression
 IMF_EXPORT void setDefaultDwaCompressionLevel (float level);
 
+/// Controls the default quantization step used by HT_LOSSY_COMPRESSION,
+/// in units of the last place of a HALF value: larger is smaller and
+/// lossier
+IMF_EXPORT void setDefaultHtCompressionLevel (float level);
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
 
 #endif
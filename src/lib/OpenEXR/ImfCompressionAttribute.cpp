@@ -59,7 +59,9 @@ CompressionAttribute::readValueFrom (
         tmp != B44_COMPRESSION && tmp != B44A_COMPRESSION &&
         tmp != DWAA_COMPRESSION && tmp != DWAB_COMPRESSION &&
         tmp != HT_COMPRESSION && tmp != HT256_COMPRESSION &&
-        tmp != HTK_COMPRESSION && tmp != HTK256_COMPRESSION)
+        tmp != HTK_COMPRESSION && tmp != HTK256_COMPRESSION &&
+        tmp != HT_LOSSY_COMPRESSION && tmp != PIZ_MS_COMPRESSION &&
+        tmp != HT_STRIPED_COMPRESSION)
     {
         tmp = NUM_COMPRESSION_METHODS;
     }
@@ -51,6 +51,21 @@ Compressor::uncompressTile (
     return uncompress (inPtr, inSize, range.min.y, outPtr);
 }
 
+int
+Compressor::uncompressLines (
+    const char*  inPtr,
+    int          inSize,
+    int          minY,
+    int&         lineMin,
+    int&         lineMax,
+    const char*& outPtr)
+{
+    lineMin = minY;
+    lineMax = minY + numScanLines () - 1;
+
+    return uncompress (inPtr, inSize, minY, outPtr);
+}
+
 bool
 isValidCompression (Compression c)
 {
@@ -61,6 +76,7 @@ isValidCompression (Compression c)
         case ZIPS_COMPRESSION:
         case ZIP_COMPRESSION:
         case PIZ_COMPRESSION:
+        case PIZ_MS_COMPRESSION:
         case PXR24_COMPRESSION:
         case B44_COMPRESSION:
         case B44A_COMPRESSION:
@@ -69,7 +85,9 @@ isValidCompression (Compression c)
         case HT_COMPRESSION:
         case HT256_COMPRESSION:
         case HTK_COMPRESSION:
-        case HTK256_COMPRESSION: return true;
+        case HTK256_COMPRESSION:
+        case HT_LOSSY_COMPRESSION:
+        case HT_STRIPED_COMPRESSION: return true;
 
         default: return false;
     }
@@ -83,7 +101,8 @@ isLossyCompression (Compression c)
         case B44_COMPRESSION:
         case B44A_COMPRESSION:
         case DWAA_COMPRESSION:
-        case DWAB_COMPRESSION: return true;
+        case DWAB_COMPRESSION:
+        case HT_LOSSY_COMPRESSION: return true;
         default: return false;
     }
 }
@@ -123,6 +142,10 @@ newCompressor (Compression c, size_t maxScanLineSize, const Header& hdr)
 
             return new PizCompressor (hdr, maxScanLineSize, 32);
 
+        case PIZ_MS_COMPRESSION:
+
+            return new PizCompressor (hdr, maxScanLineSize, 32, true);
+
         case PXR24_COMPRESSION:
 
             return new Pxr24Compressor (hdr, maxScanLineSize, 16);
@@ -159,6 +182,14 @@ newCompressor (Compression c, size_t maxScanLineSize, const Header& hdr)
 
             return new HTCompressor (hdr, 256);
 
+        case HT_LOSSY_COMPRESSION:
+
+            return new HTCompressor (hdr, 256, true);
+
+        case HT_STRIPED_COMPRESSION:
+
+            return new HTCompressor (hdr, 0, false, true);
+
         case HTK_COMPRESSION:
 
             return new HTKCompressor (hdr);
@@ -183,16 +214,19 @@ numLinesInBuffer (Compression comp)
         case RLE_COMPRESSION:
         case ZIPS_COMPRESSION: return 1;
         case ZIP_COMPRESSION: return 16;
-        case PIZ_COMPRESSION: return 32;
+        case PIZ_COMPRESSION:
+        case PIZ_MS_COMPRESSION: return 32;
         case PXR24_COMPRESSION: return 16;
         case B44_COMPRESSION:
         case B44A_COMPRESSION:
         case DWAA_COMPRESSION: return 32;
         case HT256_COMPRESSION:
         case HTK256_COMPRESSION:
+        case HT_LOSSY_COMPRESSION:
         case DWAB_COMPRESSION: return 256;
         case HT_COMPRESSION:
-        case HTK_COMPRESSION: return 16000;
+        case HTK_COMPRESSION:
+        case HT_STRIPED_COMPRESSION: return 16000;
 
         default: throw IEX_NAMESPACE::ArgExc ("Unknown compression type");
     }
@@ -217,6 +251,10 @@ newTileCompressor (
 
             return new PizCompressor (hdr, tileLineSize, numTileLines);
 
+        case PIZ_MS_COMPRESSION:
+
+            return new PizCompressor (hdr, tileLineSize, numTileLines, true);
+
         case PXR24_COMPRESSION:
 
             return new Pxr24Compressor (hdr, tileLineSize, numTileLines);
@@ -152,6 +152,30 @@ public:
     virtual int uncompress (
         const char* inPtr, int inSize, int minY, const char*& outPtr) = 0;
 
+    //-------------------------------------------------------------------------
+    // Uncompress only the scan lines that a reader actually needs:
+    //
+    //	    lineMin, lineMax	On entry, the range of scan lines that
+    //				must be uncompressed.  On return, the
+    //				range of scan lines that are valid in
+    //				the output buffer; it always includes
+    //				the requested range.
+    //
+    // The other arguments and the return value are the same as for
+    // uncompress(), and the output buffer has the same layout; lines
+    // outside [lineMin, lineMax] are left undefined.  The default
+    // implementation uncompresses everything.
+    //-------------------------------------------------------------------------
+
+    IMF_EXPORT
+    virtual int uncompressLines (
+        const char*  inPtr,
+        int          inSize,
+        int          minY,
+        int&         lineMin,
+        int&         lineMax,
+        const char*& outPtr);
+
     IMF_EXPORT
     virtual int uncompressTile (
         const char*            inPtr,
@@ -0,0 +1,129 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_COMPRESSOR_JOBS_H
+#define INCLUDED_IMF_COMPRESSOR_JOBS_H
+
+//-----------------------------------------------------------------------------
+//
+//	runCompressorJobs () -- split the work of compressing or
+//	uncompressing a single chunk across the global thread pool.
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfNamespace.h"
+
+#include "IlmThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+//
+// Work shared between the thread calling compress () / uncompress ()
+// and the helper tasks it adds to the global thread pool. Jobs are
+// claimed one at a time, so the calling thread never waits for a
+// helper that has not started yet; this keeps the scheme deadlock
+// free when the caller is itself a pool thread (e.g. LineBufferTask).
+// Helpers that start after all jobs are claimed return at once,
+// and only touch this (reference counted) object.
+//
+
+struct CompressorJobs
+{
+    CompressorJobs (int count, const std::function<void (int)>& fn)
+        : next (0), count (count), done (0), fn (fn)
+    {}
+
+    void run ()
+    {
+        for (int j = next++; j < count; j = next++)
+        {
+            try
+            {
+                fn (j);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                if (!exception) exception = std::current_exception ();
+            }
+
+            std::lock_guard<std::mutex> lock (mutex);
+            if (++done == count) finished.notify_all ();
+        }
+    }
+
+    void wait ()
+    {
+        std::unique_lock<std::mutex> lock (mutex);
+        finished.wait (lock, [this] { return done == count; });
+    }
+
+    std::atomic<int>          next;
+    const int                 count;
+    int                       done;
+    std::exception_ptr        exception; // the first one thrown by fn
+    std::mutex                mutex;
+    std::condition_variable   finished;
+    std::function<void (int)> fn;
+};
+
+class CompressorJobTask : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    CompressorJobTask (const std::shared_ptr<CompressorJobs>& jobs)
+        : ILMTHREAD_NAMESPACE::Task (0), _jobs (jobs)
+    {}
+
+    virtual void execute () { _jobs->run (); }
+
+private:
+    std::shared_ptr<CompressorJobs> _jobs;
+};
+
+//
+// Run fn (0) ... fn (count - 1) on the calling thread and on as
+// many threads of the global thread pool as are available, and
+// return when all of them are done. Jobs are started in index
+// order. If any job throws, the first exception is rethrown
+// after the others have finished.
+//
+
+inline void
+runCompressorJobs (int count, const std::function<void (int)>& fn)
+{
+    if (count <= 1)
+    {
+        if (count == 1) fn (0);
+        return;
+    }
+
+    std::shared_ptr<CompressorJobs> jobs =
+        std::make_shared<CompressorJobs> (count, fn);
+
+    int helpers = std::min (
+        ILMTHREAD_NAMESPACE::ThreadPool::globalThreadPool ().numThreads (),
+        count - 1);
+
+    for (int i = 0; i < helpers; ++i)
+        ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (
+            new CompressorJobTask (jobs));
+
+    jobs->run ();
+    jobs->wait ();
+
+    if (jobs->exception) std::rethrow_exception (jobs->exception);
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -124,6 +124,7 @@ struct LineBuffer
     Compressor*           compressor;
     Compressor::Format    format;
     int                   number;
+    bool                  needsRead; // buffer is filled in by the task
     bool                  hasException;
     string                exception;
     Array2D<unsigned int> _tempCountBuffer;
@@ -144,6 +145,7 @@ LineBuffer::LineBuffer ()
     , compressor (0)
     , format (defaultFormat (compressor))
     , number (-1)
+    , needsRead (false)
     , hasException (false)
     , exception ()
     , _sem (1)
@@ -528,6 +530,112 @@ readPixelData (
         ifd->nextLineBufferMinY = minY - ifd->linesInBuffer;
 }
 
+//
+// Read a single line buffer's pixel data with IStream::readAt()
+// instead of seekg() and read().  This is called by the line buffer
+// tasks, without the stream mutex, so that several tasks can wait
+// for I/O at once.  The sample counts have been read already.
+//
+
+void
+readPixelDataAt (DeepScanLineInputFile::Data* ifd, LineBuffer* lineBuffer)
+{
+    lineBuffer->needsRead = false;
+
+    try
+    {
+        int minY             = lineBuffer->minY;
+        int lineBufferNumber = (minY - ifd->minY) / ifd->linesInBuffer;
+
+        uint64_t lineOffset = ifd->lineOffsets[lineBufferNumber];
+
+        if (lineOffset == 0)
+            THROW (
+                IEX_NAMESPACE::InputExc,
+                "Scan line " << minY << " is missing.");
+
+        //
+        // Read the data block's header: the part number in a
+        // multi-part file, the y coordinate, and the sizes of
+        // the sample count table and of the pixel data.
+        //
+
+        char header[2 * 4 + 3 * 8];
+        int  headerSize = 3 * Xdr::size<uint64_t> () + Xdr::size<int> ();
+        if (isMultiPart (ifd->version)) headerSize += Xdr::size<int> ();
+
+        ifd->_streamData->is->readAt (lineOffset, header, headerSize);
+
+        const char* readPtr = header;
+        int         yInFile;
+        uint64_t    sampleCountTableSize;
+        uint64_t    packedDataSize;
+        uint64_t    unpackedDataSize;
+
+        if (isMultiPart (ifd->version))
+        {
+            int partNumber;
+            Xdr::read<CharPtrIO> (readPtr, partNumber);
+            if (partNumber != ifd->partNumber)
+            {
+                THROW (
+                    IEX_NAMESPACE::ArgExc,
+                    "Unexpected part number " << partNumber << ", should be "
+                                              << ifd->partNumber << ".");
+            }
+        }
+
+        Xdr::read<CharPtrIO> (readPtr, yInFile);
+
+        if (yInFile != minY)
+            throw IEX_NAMESPACE::InputExc (
+                "Unexpected data block y coordinate.");
+
+        Xdr::read<CharPtrIO> (readPtr, sampleCountTableSize);
+        Xdr::read<CharPtrIO> (readPtr, packedDataSize);
+        Xdr::read<CharPtrIO> (readPtr, unpackedDataSize);
+
+        //
+        // Same size limits as readPixelData().
+        //
+
+        int compressorMaxDataSize = std::numeric_limits<int>::max ();
+        if (sampleCountTableSize > uint64_t (compressorMaxDataSize) ||
+            packedDataSize > uint64_t (compressorMaxDataSize) ||
+            unpackedDataSize > uint64_t (compressorMaxDataSize))
+        {
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "This version of the library does not support "
+                    << "the allocation of data with size  > "
+                    << compressorMaxDataSize
+                    << " file unpacked size :" << unpackedDataSize
+                    << " file packed size   :" << packedDataSize << ".\n");
+        }
+
+        if (lineBuffer->buffer != 0) delete[] lineBuffer->buffer;
+        lineBuffer->buffer = new char[packedDataSize];
+
+        ifd->_streamData->is->readAt (
+            lineOffset + headerSize + sampleCountTableSize,
+            lineBuffer->buffer,
+            static_cast<int> (packedDataSize));
+
+        lineBuffer->packedDataSize   = packedDataSize;
+        lineBuffer->unpackedDataSize = unpackedDataSize;
+    }
+    catch (...)
+    {
+        //
+        // The buffer holds nothing useful, make sure the
+        // next request for it reads it again.
+        //
+
+        lineBuffer->number = -1;
+        throw;
+    }
+}
+
 void
 readSampleCountForLineBlock (
     InputStreamMutex*            streamData,
@@ -789,9 +897,11 @@ LineBufferTask::execute ()
     try
     {
         //
-        // Uncompress the data, if necessary
+        // Read and uncompress the data, if necessary
         //
 
+        if (_lineBuffer->needsRead) readPixelDataAt (_ifd, _lineBuffer);
+
         if (_lineBuffer->uncompressedData == 0)
         {
             uint64_t uncompressedSize = 0;
@@ -1056,13 +1166,17 @@ newLineBufferTask (
                     false);
             }
 
-            readPixelData (
-                ifd->_streamData,
-                ifd,
-                lineBuffer->minY,
-                lineBuffer->buffer,
-                lineBuffer->packedDataSize,
-                lineBuffer->unpackedDataSize);
+            if (!ifd->memoryMapped &&
+                ifd->_streamData->is->isStatelessRead ())
+                lineBuffer->needsRead = true;
+            else
+                readPixelData (
+                    ifd->_streamData,
+                    ifd,
+                    lineBuffer->minY,
+                    lineBuffer->buffer,
+                    lineBuffer->packedDataSize,
+                    lineBuffer->unpackedDataSize);
         }
     }
     catch (std::exception& e)
@@ -123,6 +123,7 @@ struct TileBuffer
     int                   dy;
     int                   lx;
     int                   ly;
+    bool                  needsRead; // buffer is filled in by the task
     bool                  hasException;
     string                exception;
 
@@ -146,6 +147,7 @@ TileBuffer::TileBuffer ()
     , dy (-1)
     , lx (-1)
     , ly (-1)
+    , needsRead (false)
     , hasException (false)
     , exception ()
     , _sem (1)
@@ -474,6 +476,101 @@ readTileData (
                                   dataSize;
 }
 
+//
+// Read a single tile's pixel data with IStream::readAt() instead of
+// seekg() and read().  This is called by the tile buffer tasks,
+// without the stream mutex, so that several tasks can wait for I/O
+// at once.  The sample counts have been read already.
+//
+
+void
+readTileDataAt (DeepTiledInputFile::Data* ifd, TileBuffer* tileBuffer)
+{
+    tileBuffer->needsRead = false;
+
+    int dx = tileBuffer->dx;
+    int dy = tileBuffer->dy;
+    int lx = tileBuffer->lx;
+    int ly = tileBuffer->ly;
+
+    uint64_t tileOffset = ifd->tileOffsets (dx, dy, lx, ly);
+
+    if (tileOffset == 0)
+    {
+        THROW (
+            IEX_NAMESPACE::InputExc,
+            "Tile (" << dx << ", " << dy << ", " << lx << ", " << ly
+                     << ") is missing.");
+    }
+
+    //
+    // Read and verify the tile's header: the part number in a
+    // multi-part file, the tile and level coordinates, and the
+    // sizes of the sample count table and of the pixel data.
+    //
+
+    char header[5 * 4 + 3 * 8];
+    int  headerSize = 4 * Xdr::size<int> () + 3 * Xdr::size<uint64_t> ();
+    if (isMultiPart (ifd->version)) headerSize += Xdr::size<int> ();
+
+    ifd->_streamData->is->readAt (tileOffset, header, headerSize);
+
+    const char* readPtr = header;
+    int         tileXCoord, tileYCoord, levelX, levelY;
+    uint64_t    tableSize, dataSize, unpackedDataSize;
+
+    if (isMultiPart (ifd->version))
+    {
+        int partNumber;
+        Xdr::read<CharPtrIO> (readPtr, partNumber);
+        if (partNumber != ifd->partNumber)
+        {
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Unexpected part number " << partNumber << ", should be "
+                                          << ifd->partNumber << ".");
+        }
+    }
+
+    Xdr::read<CharPtrIO> (readPtr, tileXCoord);
+    Xdr::read<CharPtrIO> (readPtr, tileYCoord);
+    Xdr::read<CharPtrIO> (readPtr, levelX);
+    Xdr::read<CharPtrIO> (readPtr, levelY);
+    Xdr::read<CharPtrIO> (readPtr, tableSize);
+    Xdr::read<CharPtrIO> (readPtr, dataSize);
+    Xdr::read<CharPtrIO> (readPtr, unpackedDataSize);
+
+    if (tileXCoord != dx)
+        throw IEX_NAMESPACE::InputExc ("Unexpected tile x coordinate.");
+
+    if (tileYCoord != dy)
+        throw IEX_NAMESPACE::InputExc ("Unexpected tile y coordinate.");
+
+    if (levelX != lx)
+        throw IEX_NAMESPACE::InputExc (
+            "Unexpected tile x level number coordinate.");
+
+    if (levelY != ly)
+        throw IEX_NAMESPACE::InputExc (
+            "Unexpected tile y level number coordinate.");
+
+    uint64_t maxDataSize =
+        static_cast<uint64_t> (std::numeric_limits<int>::max ());
+    if (tableSize > maxDataSize || dataSize > maxDataSize)
+        throw IEX_NAMESPACE::InputExc ("Unexpected tile block length.");
+
+    if (tileBuffer->buffer != 0) delete[] tileBuffer->buffer;
+    tileBuffer->buffer = new char[dataSize];
+
+    ifd->_streamData->is->readAt (
+        tileOffset + headerSize + tableSize,
+        tileBuffer->buffer,
+        static_cast<int> (dataSize));
+
+    tileBuffer->dataSize             = dataSize;
+    tileBuffer->uncompressedDataSize = unpackedDataSize;
+}
+
 //
 // A TileBufferTask encapsulates the task of uncompressing
 // a single tile and copying it into the frame buffer.
@@ -517,6 +614,8 @@ TileBufferTask::execute ()
 {
     try
     {
+        if (_tileBuffer->needsRead) readTileDataAt (_ifd, _tileBuffer);
+
         //
         // Calculate information about the tile
         //
@@ -754,16 +853,19 @@ newTileBufferTask (
 
         tileBuffer->uncompressedData = 0;
 
-        readTileData (
-            ifd->_streamData,
-            ifd,
-            dx,
-            dy,
-            lx,
-            ly,
-            tileBuffer->buffer,
-            tileBuffer->dataSize,
-            tileBuffer->uncompressedDataSize);
+        if (!ifd->memoryMapped && ifd->_streamData->is->isStatelessRead ())
+            tileBuffer->needsRead = true;
+        else
+            readTileData (
+                ifd->_streamData,
+                ifd,
+                dx,
+                dy,
+                lx,
+                ly,
+                tileBuffer->buffer,
+                tileBuffer->dataSize,
+                tileBuffer->uncompressedDataSize);
     }
     catch (...)
     {
@@ -102,6 +102,7 @@
 #include "ImfDwaCompressorSimd.h"
 
 #include "ImfChannelList.h"
+#include "ImfCompressorJobs.h"
 #include "ImfHeader.h"
 #include "ImfHuf.h"
 #include "ImfIO.h"
@@ -124,6 +125,7 @@
 #include <array>
 #include <cassert>
 #include <cctype>
+#include <functional>
 #include <limits>
 #include <string>
 #include <vector>
@@ -176,6 +178,221 @@ void (*dctInverse8x8_5) (float*) = dctInverse8x8_scalar<5>;
 void (*dctInverse8x8_6) (float*) = dctInverse8x8_scalar<6>;
 void (*dctInverse8x8_7) (float*) = dctInverse8x8_scalar<7>;
 
+//
+// Precomputing the bit count runs faster than using
+// the builtin instruction, at least in one case..
+//
+// Precomputing 8-bits is no slower than 16-bits,
+// and saves a fair bit of overhead..
+//
+
+int
+countSetBits (unsigned short src)
+{
+    static const unsigned short numBitsSet[256] = {
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 1, 2, 2, 3, 2, 3, 3, 4,
+        2, 3, 3, 4, 3, 4, 4, 5, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+        2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 1, 2, 2, 3, 2, 3, 3, 4,
+        2, 3, 3, 4, 3, 4, 4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+        2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6,
+        4, 5, 5, 6, 5, 6, 6, 7, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+        2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 2, 3, 3, 4, 3, 4, 4, 5,
+        3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+        2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6,
+        4, 5, 5, 6, 5, 6, 6, 7, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+        4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8};
+
+    return numBitsSet[src & 0xff] + numBitsSet[src >> 8];
+}
+
+//
+// Take a DCT coefficient, as well as an acceptable error. Search
+// nearby values within the error tolerance, that have fewer
+// bits set.
+//
+// The list of candidates has been pre-computed and sorted
+// in order of increasing numbers of bits set. This way, we
+// can stop searching as soon as we find a candidate that
+// is within the error tolerance.
+//
+
+half
+quantize (half src, float errorTolerance)
+{
+    half                  tmp;
+    float                 srcFloat   = (float) src;
+    int                   numSetBits = countSetBits (src.bits ());
+    const unsigned short* closest =
+        closestData + closestDataOffset[src.bits ()];
+
+    for (int targetNumSetBits = numSetBits - 1; targetNumSetBits >= 0;
+         --targetNumSetBits)
+    {
+        tmp.setBits (*closest);
+
+        if (fabs ((float) tmp - srcFloat) < errorTolerance) return tmp;
+
+        closest++;
+    }
+
+    return src;
+}
+
+//
+// Count the packed AC components of numBlocks RLE'd blocks, the
+// way LossyDctDecoderBase::unRleAc () reads them, stopping at
+// packedAcEnd.
+//
+
+size_t
+countRleAc (
+    const unsigned short* packedAc,
+    const unsigned short* packedAcEnd,
+    size_t                numBlocks)
+{
+    const unsigned short* currAcComp = packedAc;
+
+    for (size_t block = 0; block < numBlocks; ++block)
+    {
+        int dctComp = 1;
+
+        while (dctComp < 64 && currAcComp < packedAcEnd)
+        {
+            if (*currAcComp == 0xff00)
+                dctComp = 64;
+            else if ((*currAcComp) >> 8 == 0xff)
+                dctComp += (*currAcComp) & 0xff;
+            else
+                dctComp++;
+
+            currAcComp++;
+        }
+    }
+
+    return currAcComp - packedAc;
+}
+
+//
+// Forward DCT of an 8x8 block, followed by quantization of each
+// coefficient against a per-coefficient error tolerance. The
+// output is in natural order, not zig-zag order.
+//
+
+void
+dctForwardQuantize64_scalar (half* dst, float* data, const float* tolerance)
+{
+    dctForward8x8 (data);
+
+    for (int i = 0; i < 64; ++i)
+        dst[i] = quantize ((half) data[i], tolerance[i]);
+}
+
+#ifdef IMF_HAVE_AVX2_DISPATCH
+
+//
+// Forward DCT, then quantize each coefficient as quantize () does:
+// round to half with F16C, and test up to 16 candidates from
+// closestData against the tolerance at once, taking the first
+// one that fits. Candidate lists which end too close to the end
+// of closestData to load 16 values go through quantize ().
+//
+
+DWA_AVX2_TARGET void
+dctForwardQuantize64_avx2 (half* dst, float* data, const float* tolerance)
+{
+    static const size_t numClosest =
+        sizeof (closestData) / sizeof (closestData[0]);
+
+    unsigned short src[64];
+    unsigned short numSetBits[64];
+    float          srcFloat[64];
+
+    const __m128i m1 = _mm_set1_epi16 (0x5555);
+    const __m128i m2 = _mm_set1_epi16 (0x3333);
+    const __m128i m4 = _mm_set1_epi16 (0x0f0f);
+    const __m256  absMask =
+        _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff));
+
+    dctForward8x8_avx2 (data);
+
+    for (int i = 0; i < 64; i += 8)
+    {
+        __m128i h = _mm256_cvtps_ph (
+            _mm256_loadu_ps (data + i), _MM_FROUND_TO_NEAREST_INT);
+        __m128i n =
+            _mm_sub_epi16 (h, _mm_and_si128 (_mm_srli_epi16 (h, 1), m1));
+
+        n = _mm_add_epi16 (
+            _mm_and_si128 (n, m2), _mm_and_si128 (_mm_srli_epi16 (n, 2), m2));
+        n = _mm_and_si128 (_mm_add_epi16 (n, _mm_srli_epi16 (n, 4)), m4);
+        n = _mm_and_si128 (
+            _mm_add_epi16 (n, _mm_srli_epi16 (n, 8)), _mm_set1_epi16 (0x1f));
+
+        _mm_storeu_si128 ((__m128i*) (src + i), h);
+        _mm_storeu_si128 ((__m128i*) (numSetBits + i), n);
+        _mm256_storeu_ps (srcFloat + i, _mm256_cvtph_ps (h));
+    }
+
+    for (int i = 0; i < 64; ++i)
+    {
+        unsigned int          offset  = closestDataOffset[src[i]];
+        const unsigned short* closest = closestData + offset;
+        int                   n       = numSetBits[i];
+        unsigned int          hit;
+        __m256                f, tol;
+
+        dst[i].setBits (src[i]);
+        if (n == 0) continue;
+
+        if (offset + 16 > numClosest)
+        {
+            dst[i] = quantize (dst[i], tolerance[i]);
+            continue;
+        }
+
+        f   = _mm256_set1_ps (srcFloat[i]);
+        tol = _mm256_set1_ps (tolerance[i]);
+
+        hit = (unsigned int) _mm256_movemask_ps (_mm256_cmp_ps (
+            _mm256_and_ps (
+                _mm256_sub_ps (
+                    _mm256_cvtph_ps (
+                        _mm_loadu_si128 ((const __m128i*) closest)),
+                    f),
+                absMask),
+            tol,
+            _CMP_LT_OQ));
+        if (n > 8)
+            hit |= (unsigned int) _mm256_movemask_ps (_mm256_cmp_ps (
+                       _mm256_and_ps (
+                           _mm256_sub_ps (
+                               _mm256_cvtph_ps (_mm_loadu_si128 (
+                                   (const __m128i*) (closest + 8))),
+                               f),
+                           absMask),
+                       tol,
+                       _CMP_LT_OQ))
+                   << 8;
+
+        hit &= (1u << n) - 1;
+        if (hit)
+        {
+#    if defined(_MSC_VER)
+            unsigned long first;
+            _BitScanForward (&first, hit);
+#    else
+            int first = __builtin_ctz (hit);
+#    endif
+            dst[i].setBits (closest[first]);
+        }
+    }
+}
+
+#endif /* IMF_HAVE_AVX2_DISPATCH */
+
+void (*dctForwardQuantize64) (half*, float*, const float*) =
+    dctForwardQuantize64_scalar;
+
 } // namespace
 
 struct DwaCompressor::ChannelData
@@ -207,6 +424,25 @@ struct DwaCompressor::ChannelData
     int       planarUncSize;
 };
 
+//
+// A LOSSY_DCT channel, or a set of three channels coded together
+// with a color space conversion, handled by one job of compress ()
+// or uncompress (). numBlocks counts the 8x8 blocks of all of its
+// channels, packedAc and packedDc point to its coefficients, and
+// numAc and numDc count them.
+//
+
+struct DwaCompressor::LossyDctJob
+{
+    int    chan[3];
+    int    numChan;
+    size_t numBlocks;
+    char*  packedAc;
+    char*  packedDc;
+    int    numAc;
+    int    numDc;
+};
+
 struct DwaCompressor::CscChannelSet
 {
     int idx[3];
@@ -520,8 +756,6 @@ public:
 
 protected:
     void toZigZag (half* dst, half* src);
-    int  countSetBits (unsigned short src);
-    half quantize (half src, float errorTolerance);
     void rleAc (half* block, unsigned short*& acPtr);
 
     float _quantBaseError;
@@ -1310,6 +1544,19 @@ DwaCompressor::LossyDctEncoderBase::execute ()
     half halfZigCoef[64];
     half halfCoef[64];
 
+    //
+    // Per-coefficient error tolerance for the quantizer
+    //
+
+    float toleranceY[64];
+    float toleranceCbCr[64];
+
+    for (int i = 0; i < 64; ++i)
+    {
+        toleranceY[i]    = _quantBaseError * _quantTableY[i];
+        toleranceCbCr[i] = _quantBaseError * _quantTableCbCr[i];
+    }
+
     std::vector<unsigned short*> currDcComp (_rowPtrs.size ());
     unsigned short*              currAcComp = (unsigned short*) _packedAc;
 
@@ -1464,33 +1711,13 @@ DwaCompressor::LossyDctEncoderBase::execute ()
             for (unsigned int chan = 0; chan < _rowPtrs.size (); ++chan)
             {
                 //
-                // Forward DCT
-                //
-
-                dctForward8x8 (_dctData[chan]._buffer);
-
-                //
-                // Quantize to half, and zigzag
+                // Forward DCT, quantize to half, and zigzag
                 //
 
-                if (chan == 0)
-                {
-                    for (int i = 0; i < 64; ++i)
-                    {
-                        halfCoef[i] = quantize (
-                            (half) _dctData[chan]._buffer[i],
-                            _quantBaseError * _quantTableY[i]);
-                    }
-                }
-                else
-                {
-                    for (int i = 0; i < 64; ++i)
-                    {
-                        halfCoef[i] = quantize (
-                            (half) _dctData[chan]._buffer[i],
-                            _quantBaseError * _quantTableCbCr[i]);
-                    }
-                }
+                (*dctForwardQuantize64) (
+                    halfCoef,
+                    _dctData[chan]._buffer,
+                    chan == 0 ? toleranceY : toleranceCbCr);
 
                 toZigZag (halfZigCoef, halfCoef);
 
@@ -1541,66 +1768,6 @@ DwaCompressor::LossyDctEncoderBase::toZigZag (half* dst, half* src)
         dst[i] = src[remap[i]];
 }
 
-//
-// Precomputing the bit count runs faster than using
-// the builtin instruction, at least in one case..
-//
-// Precomputing 8-bits is no slower than 16-bits,
-// and saves a fair bit of overhead..
-//
-
-int
-DwaCompressor::LossyDctEncoderBase::countSetBits (unsigned short src)
-{
-    static const unsigned short numBitsSet[256] = {
-        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 1, 2, 2, 3, 2, 3, 3, 4,
-        2, 3, 3, 4, 3, 4, 4, 5, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-        2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 1, 2, 2, 3, 2, 3, 3, 4,
-        2, 3, 3, 4, 3, 4, 4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-        2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6,
-        4, 5, 5, 6, 5, 6, 6, 7, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-        2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 2, 3, 3, 4, 3, 4, 4, 5,
-        3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-        2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6,
-        4, 5, 5, 6, 5, 6, 6, 7, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-        4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8};
-
-    return numBitsSet[src & 0xff] + numBitsSet[src >> 8];
-}
-
-//
-// Take a DCT coefficient, as well as an acceptable error. Search
-// nearby values within the error tolerance, that have fewer
-// bits set.
-//
-// The list of candidates has been pre-computed and sorted
-// in order of increasing numbers of bits set. This way, we
-// can stop searching as soon as we find a candidate that
-// is within the error tolerance.
-//
-
-half
-DwaCompressor::LossyDctEncoderBase::quantize (half src, float errorTolerance)
-{
-    half                  tmp;
-    float                 srcFloat   = (float) src;
-    int                   numSetBits = countSetBits (src.bits ());
-    const unsigned short* closest =
-        closestData + closestDataOffset[src.bits ()];
-
-    for (int targetNumSetBits = numSetBits - 1; targetNumSetBits >= 0;
-         --targetNumSetBits)
-    {
-        tmp.setBits (*closest);
-
-        if (fabs ((float) tmp - srcFloat) < errorTolerance) return tmp;
-
-        closest++;
-    }
-
-    return src;
-}
-
 //
 // RLE the zig-zag of the AC components + copy over
 // into another tmp buffer
@@ -1928,88 +2095,119 @@ DwaCompressor::compress (
     inDataPtr = inPtr;
 
     //
-    // Make a pass over all our CSC sets and try to encode them first
+    // Each CSC set and each remaining LOSSY_DCT channel is encoded by
+    // a job of its own. The number of DC values a job writes is known
+    // up front, one per 8x8 block of each of its channels, but the
+    // number of AC values is not. Each job gets room for the worst
+    // case of 63 AC values per block, and the AC values are packed
+    // together once all the jobs are done.
     //
 
-    for (unsigned int csc = 0; csc < _cscSets.size (); ++csc)
-    {
+    std::vector<LossyDctJob> dctJobs;
 
-        LossyDctEncoderCsc encoder (
-            _dwaCompressionLevel / 100000.f,
-            rowPtrs[_cscSets[csc].idx[0]],
-            rowPtrs[_cscSets[csc].idx[1]],
-            rowPtrs[_cscSets[csc].idx[2]],
-            packedAcEnd,
-            packedDcEnd,
-            dwaCompressorToNonlinear,
-            _channelData[_cscSets[csc].idx[0]].width,
-            _channelData[_cscSets[csc].idx[0]].height,
-            _channelData[_cscSets[csc].idx[0]].type,
-            _channelData[_cscSets[csc].idx[1]].type,
-            _channelData[_cscSets[csc].idx[2]].type);
+    lossyDctJobs (dctJobs, encodedChannels);
 
-        encoder.execute ();
+    for (size_t i = 0; i < dctJobs.size (); ++i)
+    {
+        dctJobs[i].packedAc = packedAcEnd;
+        dctJobs[i].packedDc = packedDcEnd;
 
-        *totalAcUncompressedCount += encoder.numAcValuesEncoded ();
-        *totalDcUncompressedCount += encoder.numDcValuesEncoded ();
+        packedAcEnd += dctJobs[i].numBlocks * 63 * sizeof (unsigned short);
+        packedDcEnd += dctJobs[i].numBlocks * sizeof (unsigned short);
+    }
 
-        packedAcEnd += encoder.numAcValuesEncoded () * sizeof (unsigned short);
-        packedDcEnd += encoder.numDcValuesEncoded () * sizeof (unsigned short);
+    //
+    // The RLE channels and the UNKNOWN channels are each handled by
+    // one more job. The UNKNOWN data comes first in the output buffer,
+    // so it can be compressed in place. The RLE data comes last, after
+    // the AC and DC data, so it is compressed into rleOut, and copied
+    // into the output buffer at the end.
+    //
 
-        encodedChannels[_cscSets[csc].idx[0]] = true;
-        encodedChannels[_cscSets[csc].idx[1]] = true;
-        encodedChannels[_cscSets[csc].idx[2]] = true;
-    }
+    std::vector<std::function<void ()>> jobs;
+    std::vector<char>                   rleOut;
+    bool                                haveUnknown = false;
+    bool                                haveRle     = false;
 
     for (unsigned int chan = 0; chan < _channelData.size (); ++chan)
     {
-        ChannelData* cd = &_channelData[chan];
-
         if (encodedChannels[chan]) continue;
 
-        switch (cd->compression)
+        switch (_channelData[chan].compression)
         {
-            case LOSSY_DCT:
+            case RLE: haveRle = true; break;
+            case UNKNOWN: haveUnknown = true; break;
+            default: assert (false);
+        }
+    }
+
+    if (haveUnknown)
+    {
+        jobs.push_back ([&] {
+            for (unsigned int chan = 0; chan < _channelData.size (); ++chan)
+            {
+                ChannelData* cd = &_channelData[chan];
+
+                if (encodedChannels[chan] || cd->compression != UNKNOWN)
+                    continue;
 
                 //
-                // For LOSSY_DCT, treat this just like the CSC'd case,
-                // but only operate on one channel
+                // Copy the data over verbatim
                 //
 
-                {
-                    const unsigned short* nonlinearLut = 0;
-
-                    if (!cd->pLinear) nonlinearLut = dwaCompressorToNonlinear;
+                int scanlineSize =
+                    cd->width * OPENEXR_IMF_NAMESPACE::pixelTypeSize (cd->type);
 
-                    LossyDctEncoder encoder (
-                        _dwaCompressionLevel / 100000.f,
-                        rowPtrs[chan],
-                        packedAcEnd,
-                        packedDcEnd,
-                        nonlinearLut,
-                        cd->width,
-                        cd->height,
-                        cd->type);
+                for (unsigned int y = 0; y < rowPtrs[chan].size (); ++y)
+                {
+                    memcpy (
+                        cd->planarUncBufferEnd, rowPtrs[chan][y], scanlineSize);
 
-                    encoder.execute ();
+                    cd->planarUncBufferEnd += scanlineSize;
+                }
 
-                    *totalAcUncompressedCount += encoder.numAcValuesEncoded ();
-                    *totalDcUncompressedCount += encoder.numDcValuesEncoded ();
+                *unknownUncompressedSize += cd->planarUncSize;
+            }
 
-                    packedAcEnd +=
-                        encoder.numAcValuesEncoded () * sizeof (unsigned short);
+            //
+            // Instead of just copying it uncompressed, try zlib
+            // compression at least.
+            //
 
-                    packedDcEnd +=
-                        encoder.numDcValuesEncoded () * sizeof (unsigned short);
+            if (*unknownUncompressedSize > 0)
+            {
+                size_t outSize;
+                if (EXR_ERR_SUCCESS != exr_compress_buffer(
+                        nullptr,
+                        9, // TODO: use default??? the old call to zlib had 9 hardcoded
+                        _planarUncBuffer[UNKNOWN],
+                        *unknownUncompressedSize,
+                        outDataPtr,
+                        exr_compress_max_buffer_size (*unknownUncompressedSize),
+                        &outSize))
+                {
+                    throw IEX_NAMESPACE::BaseExc ("Data compression (zlib) failed.");
                 }
 
-                break;
+                *unknownCompressedSize = outSize;
+            }
+        });
+    }
 
-            case RLE:
+    if (haveRle)
+    {
+        jobs.push_back ([&] {
+            for (unsigned int chan = 0; chan < _channelData.size (); ++chan)
+            {
+                ChannelData* cd = &_channelData[chan];
+
+                if (encodedChannels[chan] || cd->compression != RLE)
+                    continue;
 
                 //
-                // For RLE, bash the bytes up so that the first bytes of each
-                // pixel are contiguous, as are the second bytes, and so on.
+                // Bash the bytes up so that the first bytes of each
+                // pixel are contiguous, as are the second bytes, and
+                // so on.
                 //
 
                 for (unsigned int y = 0; y < rowPtrs[chan].size (); ++y)
@@ -2032,63 +2230,125 @@ DwaCompressor::compress (
                         cd->width *
                         OPENEXR_IMF_NAMESPACE::pixelTypeSize (cd->type);
                 }
+            }
 
-                break;
+            //
+            // RLE encode the data and set the uncompressed size. Then,
+            // deflate the results and set the compressed size.
+            //
 
-            case UNKNOWN:
+            if (*rleRawSize > 0)
+            {
+                *rleUncompressedSize = rleCompress (
+                    (int) (*rleRawSize),
+                    _planarUncBuffer[RLE],
+                    (signed char*) _rleBuffer);
 
-                //
-                // Otherwise, just copy data over verbatim
-                //
+                rleOut.resize (
+                    exr_compress_max_buffer_size (*rleUncompressedSize));
 
+                size_t dstLen;
+                if (EXR_ERR_SUCCESS != exr_compress_buffer(
+                        nullptr,
+                        9, // TODO: use default??? the old call to zlib had 9 hardcoded
+                        _rleBuffer,
+                        *rleUncompressedSize,
+                        rleOut.data (),
+                        rleOut.size (),
+                        &dstLen))
                 {
-                    int scanlineSize =
-                        cd->width *
-                        OPENEXR_IMF_NAMESPACE::pixelTypeSize (cd->type);
-
-                    for (unsigned int y = 0; y < rowPtrs[chan].size (); ++y)
-                    {
-                        memcpy (
-                            cd->planarUncBufferEnd,
-                            rowPtrs[chan][y],
-                            scanlineSize);
-
-                        cd->planarUncBufferEnd += scanlineSize;
-                    }
-
-                    *unknownUncompressedSize += cd->planarUncSize;
+                    throw IEX_NAMESPACE::BaseExc ("Error compressing RLE'd data.");
                 }
 
-                break;
+                *rleCompressedSize = dstLen;
+            }
+        });
+    }
 
-            default: assert (false);
-        }
+    for (size_t i = 0; i < dctJobs.size (); ++i)
+    {
+        jobs.push_back ([&, i] {
+            LossyDctJob&       job = dctJobs[i];
+            const ChannelData& cd  = _channelData[job.chan[0]];
+
+            if (job.numChan == 3)
+            {
+                LossyDctEncoderCsc encoder (
+                    _dwaCompressionLevel / 100000.f,
+                    rowPtrs[job.chan[0]],
+                    rowPtrs[job.chan[1]],
+                    rowPtrs[job.chan[2]],
+                    job.packedAc,
+                    job.packedDc,
+                    dwaCompressorToNonlinear,
+                    cd.width,
+                    cd.height,
+                    cd.type,
+                    _channelData[job.chan[1]].type,
+                    _channelData[job.chan[2]].type);
+
+                encoder.execute ();
+
+                job.numAc = encoder.numAcValuesEncoded ();
+                job.numDc = encoder.numDcValuesEncoded ();
+            }
+            else
+            {
+                //
+                // For LOSSY_DCT, treat this just like the CSC'd case,
+                // but only operate on one channel
+                //
 
-        encodedChannels[chan] = true;
+                const unsigned short* nonlinearLut = 0;
+
+                if (!cd.pLinear) nonlinearLut = dwaCompressorToNonlinear;
+
+                LossyDctEncoder encoder (
+                    _dwaCompressionLevel / 100000.f,
+                    rowPtrs[job.chan[0]],
+                    job.packedAc,
+                    job.packedDc,
+                    nonlinearLut,
+                    cd.width,
+                    cd.height,
+                    cd.type);
+
+                encoder.execute ();
+
+                job.numAc = encoder.numAcValuesEncoded ();
+                job.numDc = encoder.numDcValuesEncoded ();
+            }
+        });
     }
 
+    runCompressorJobs (static_cast<int> (jobs.size ()), [&] (int j) {
+        jobs[j] ();
+    });
+
+    //
+    // The UNKNOWN data has been packed into the output buffer first.
+    //
+
+    outDataPtr += *unknownCompressedSize;
+
     //
-    // Pack the Unknown data into the output buffer first. Instead of
-    // just copying it uncompressed, try zlib compression at least.
+    // Close the gaps between the AC values of the LOSSY_DCT jobs. The
+    // DC values are already contiguous.
     //
 
-    if (*unknownUncompressedSize > 0)
+    packedAcEnd = _packedAcBuffer;
+
+    for (size_t i = 0; i < dctJobs.size (); ++i)
     {
-        size_t outSize;
-        if (EXR_ERR_SUCCESS != exr_compress_buffer(
-                nullptr,
-                9, // TODO: use default??? the old call to zlib had 9 hardcoded
-                _planarUncBuffer[UNKNOWN],
-                *unknownUncompressedSize,
-                outDataPtr,
-                exr_compress_max_buffer_size (*unknownUncompressedSize),
-                &outSize))
-        {
-            throw IEX_NAMESPACE::BaseExc ("Data compression (zlib) failed.");
-        }
+        size_t acSize = dctJobs[i].numAc * sizeof (unsigned short);
+
+        if (dctJobs[i].packedAc != packedAcEnd)
+            memmove (packedAcEnd, dctJobs[i].packedAc, acSize);
+
+        packedAcEnd += acSize;
 
-        outDataPtr += outSize;
-        *unknownCompressedSize = outSize;
+        *totalAcUncompressedCount += dctJobs[i].numAc;
+        *totalDcUncompressedCount += dctJobs[i].numDc;
     }
 
     //
@@ -2155,31 +2415,12 @@ DwaCompressor::compress (
     }
 
     //
-    // If we have RLE data, first RLE encode it and set the uncompressed
-    // size. Then, deflate the results and set the compressed size.
+    // And the RLE data last
     //
 
-    if (*rleRawSize > 0)
+    if (*rleCompressedSize > 0)
     {
-        *rleUncompressedSize = rleCompress (
-            (int) (*rleRawSize),
-            _planarUncBuffer[RLE],
-            (signed char*) _rleBuffer);
-
-        size_t dstLen;
-        if (EXR_ERR_SUCCESS != exr_compress_buffer(
-                nullptr,
-                9, // TODO: use default??? the old call to zlib had 9 hardcoded
-                _rleBuffer,
-                *rleUncompressedSize,
-                outDataPtr,
-                exr_compress_max_buffer_size (*rleUncompressedSize),
-                &dstLen))
-        {
-            throw IEX_NAMESPACE::BaseExc ("Error compressing RLE'd data.");
-        }
-
-        *rleCompressedSize = dstLen;
+        memcpy (outDataPtr, rleOut.data (), *rleCompressedSize);
         outDataPtr += *rleCompressedSize;
     }
 
@@ -2351,20 +2592,6 @@ DwaCompressor::uncompress (
 
     char* outBufferEnd = _outBuffer;
 
-    //
-    // Find the start of the RLE packed AC components and
-    // the DC components for each channel. This will be handy
-    // if you want to decode the channels in parallel later on.
-    //
-
-    char* packedAcBufferEnd = 0;
-
-    if (_packedAcBuffer) packedAcBufferEnd = _packedAcBuffer;
-
-    char* packedDcBufferEnd = 0;
-
-    if (_packedDcBuffer) packedDcBufferEnd = _packedDcBuffer;
-
     //
     // UNKNOWN data is packed first, followed by the
     // Huffman-compressed AC, then the DC values,
@@ -2394,374 +2621,406 @@ DwaCompressor::uncompress (
     setupChannelData (minX, minY, maxX, maxY);
 
     //
-    // Uncompress the UNKNOWN data into _planarUncBuffer[UNKNOWN]
+    // Determine the start of each row in the output buffer
     //
 
-    if (unknownCompressedSize > 0)
+    std::vector<bool>               decodedChannels (_channelData.size ());
+    std::vector<std::vector<char*>> rowPtrs (_channelData.size ());
+
+    for (unsigned int chan = 0; chan < _channelData.size (); ++chan)
+        decodedChannels[chan] = false;
+
+    outBufferEnd = _outBuffer;
+
+    for (int y = minY; y <= maxY; ++y)
     {
-        if (unknownUncompressedSize > _planarUncBufferSize[UNKNOWN])
+        for (unsigned int chan = 0; chan < _channelData.size (); ++chan)
         {
-            throw IEX_NAMESPACE::InputExc ("Error uncompressing DWA data"
-                                           "(corrupt header).");
-        }
+            ChannelData* cd = &_channelData[chan];
 
-        if (EXR_ERR_SUCCESS != exr_uncompress_buffer (
-                nullptr,
-                compressedUnknownBuf,
-                unknownCompressedSize,
-                _planarUncBuffer[UNKNOWN],
-                unknownUncompressedSize,
-                nullptr))
-        {
-            throw IEX_NAMESPACE::BaseExc ("Error uncompressing UNKNOWN data.");
+            if (IMATH_NAMESPACE::modp (y, cd->ySampling) != 0) continue;
+
+            rowPtrs[chan].push_back (outBufferEnd);
+            outBufferEnd +=
+                cd->width * OPENEXR_IMF_NAMESPACE::pixelTypeSize (cd->type);
         }
     }
 
     //
-    // Uncompress the AC data into _packedAcBuffer
+    // Blocks of 3 channels that need to be handled together
+    // must all be LOSSY_DCT
     //
 
-    if (acCompressedSize > 0)
+    for (unsigned int csc = 0; csc < _cscSets.size (); ++csc)
     {
-        if (!_packedAcBuffer ||
-            totalAcUncompressedCount * sizeof (unsigned short) >
-                _packedAcBufferSize)
+        for (int comp = 0; comp < 3; ++comp)
         {
-            throw IEX_NAMESPACE::InputExc ("Error uncompressing DWA data"
-                                           "(corrupt header).");
+            if (_channelData[_cscSets[csc].idx[comp]].compression != LOSSY_DCT)
+            {
+                throw IEX_NAMESPACE::BaseExc (
+                    "Bad DWA compression type detected");
+            }
         }
+    }
 
-        //
-        // Don't trust the user to get it right, look in the file.
-        //
+    std::vector<LossyDctJob> dctJobs;
 
-        switch (acCompression)
-        {
-            case STATIC_HUFFMAN:
+    lossyDctJobs (dctJobs, decodedChannels);
 
-                hufUncompress (
-                    compressedAcBuf,
-                    (int) acCompressedSize,
-                    (unsigned short*) _packedAcBuffer,
-                    (int) totalAcUncompressedCount);
+    //
+    // The UNKNOWN data, the RLE data, the AC data and the DC data
+    // are uncompressed by independent jobs. The UNKNOWN and RLE
+    // jobs also put their channels into the output buffer.
+    //
+
+    std::vector<std::function<void ()>> jobs;
+    bool                                haveUnknown = false;
+    bool                                haveRle     = false;
 
+    for (unsigned int chan = 0; chan < _channelData.size (); ++chan)
+    {
+        if (decodedChannels[chan]) continue;
+
+        switch (_channelData[chan].compression)
+        {
+            case RLE: haveRle = true; break;
+            case UNKNOWN: haveUnknown = true; break;
+            default:
+                throw IEX_NAMESPACE::NoImplExc (
+                    "Unhandled compression scheme case");
                 break;
+        }
+    }
 
-            case DEFLATE: {
-                size_t destLen;
+    if (haveUnknown || unknownCompressedSize > 0)
+    {
+        jobs.push_back ([&] {
+            //
+            // Uncompress the UNKNOWN data into _planarUncBuffer[UNKNOWN]
+            //
 
-                if (EXR_ERR_SUCCESS != exr_uncompress_buffer (
-                        nullptr,
-                        compressedAcBuf,
-                        acCompressedSize,
-                        _packedAcBuffer,
-                        totalAcUncompressedCount * sizeof (unsigned short),
-                        &destLen))
+            if (unknownCompressedSize > 0)
+            {
+                if (unknownUncompressedSize > _planarUncBufferSize[UNKNOWN])
                 {
                     throw IEX_NAMESPACE::InputExc (
-                        "Data decompression (zlib) failed.");
+                        "Error uncompressing DWA data"
+                        "(corrupt header).");
                 }
 
-                if (totalAcUncompressedCount * sizeof (unsigned short) !=
-                    destLen)
+                if (EXR_ERR_SUCCESS != exr_uncompress_buffer (
+                        nullptr,
+                        compressedUnknownBuf,
+                        unknownCompressedSize,
+                        _planarUncBuffer[UNKNOWN],
+                        unknownUncompressedSize,
+                        nullptr))
                 {
-                    throw IEX_NAMESPACE::InputExc ("AC data corrupt.");
+                    throw IEX_NAMESPACE::BaseExc (
+                        "Error uncompressing UNKNOWN data.");
                 }
             }
-            break;
 
-            default:
+            for (unsigned int chan = 0; chan < _channelData.size (); ++chan)
+            {
+                ChannelData* cd = &_channelData[chan];
 
-                throw IEX_NAMESPACE::NoImplExc ("Unknown AC Compression");
-                break;
-        }
-    }
+                if (decodedChannels[chan] || cd->compression != UNKNOWN)
+                    continue;
 
-    //
-    // Uncompress the DC data into _packedDcBuffer
-    //
+                //
+                // The data is already in planarUncBufferEnd and just
+                // needs to copied over to the output buffer
+                //
 
-    if (dcCompressedSize > 0)
-    {
-        if (totalDcUncompressedCount * sizeof (unsigned short) >
-            _packedDcBufferSize)
-        {
-            throw IEX_NAMESPACE::InputExc ("Error uncompressing DWA data"
-                                           "(corrupt header).");
-        }
+                int dstScanlineSize =
+                    cd->width * OPENEXR_IMF_NAMESPACE::pixelTypeSize (cd->type);
 
-        if (static_cast<uint64_t> (_zip->uncompress (
-                compressedDcBuf, (int) dcCompressedSize, _packedDcBuffer)) !=
-            totalDcUncompressedCount * sizeof (unsigned short))
-        {
-            throw IEX_NAMESPACE::BaseExc ("DC data corrupt.");
-        }
-    }
-    else
-    {
-        // if the compressed size is 0, then the uncompressed size must also be zero
-        if (totalDcUncompressedCount != 0)
-        {
-            throw IEX_NAMESPACE::BaseExc ("DC data corrupt.");
-        }
-    }
+                for (size_t row = 0; row < rowPtrs[chan].size (); ++row)
+                {
+                    //
+                    // sanity check for buffer data lying within range
+                    //
+                    if ((cd->planarUncBufferEnd +
+                         static_cast<size_t> (dstScanlineSize)) >
+                        (_planarUncBuffer[UNKNOWN] +
+                         _planarUncBufferSize[UNKNOWN]))
+                    {
+                        throw IEX_NAMESPACE::InputExc ("DWA data corrupt");
+                    }
 
-    //
-    // Uncompress the RLE data into _rleBuffer, then unRLE the results
-    // into _planarUncBuffer[RLE]
-    //
+                    memcpy (
+                        rowPtrs[chan][row],
+                        cd->planarUncBufferEnd,
+                        dstScanlineSize);
 
-    if (rleRawSize > 0)
-    {
-        if (rleUncompressedSize > _rleBufferSize ||
-            rleRawSize > _planarUncBufferSize[RLE])
-        {
-            throw IEX_NAMESPACE::InputExc ("Error uncompressing DWA data"
-                                           "(corrupt header).");
-        }
+                    cd->planarUncBufferEnd += dstScanlineSize;
+                }
+            }
+        });
+    }
 
-        size_t dstLen;
+    if (acCompressedSize > 0)
+    {
+        jobs.push_back ([&] {
+            //
+            // Uncompress the AC data into _packedAcBuffer
+            //
 
-        if (EXR_ERR_SUCCESS != exr_uncompress_buffer (
-                nullptr,
-                compressedRleBuf,
-                rleCompressedSize,
-                _rleBuffer,
-                rleUncompressedSize,
-                &dstLen))
-        {
-            throw IEX_NAMESPACE::BaseExc ("Error uncompressing RLE data.");
-        }
+            if (!_packedAcBuffer ||
+                totalAcUncompressedCount * sizeof (unsigned short) >
+                    _packedAcBufferSize)
+            {
+                throw IEX_NAMESPACE::InputExc ("Error uncompressing DWA data"
+                                               "(corrupt header).");
+            }
 
-        if (dstLen != rleUncompressedSize)
-            throw IEX_NAMESPACE::BaseExc ("RLE data corrupted");
+            //
+            // Don't trust the user to get it right, look in the file.
+            //
 
-        if (static_cast<uint64_t> (rleUncompress (
-                (int) rleUncompressedSize,
-                (int) rleRawSize,
-                (signed char*) _rleBuffer,
-                _planarUncBuffer[RLE])) != rleRawSize)
-        {
-            throw IEX_NAMESPACE::BaseExc ("RLE data corrupted");
-        }
-    }
+            switch (acCompression)
+            {
+                case STATIC_HUFFMAN:
 
-    //
-    // Determine the start of each row in the output buffer
-    //
+                    hufUncompress (
+                        compressedAcBuf,
+                        (int) acCompressedSize,
+                        (unsigned short*) _packedAcBuffer,
+                        (int) totalAcUncompressedCount);
 
-    std::vector<bool>               decodedChannels (_channelData.size ());
-    std::vector<std::vector<char*>> rowPtrs (_channelData.size ());
+                    break;
 
-    for (unsigned int chan = 0; chan < _channelData.size (); ++chan)
-        decodedChannels[chan] = false;
+                case DEFLATE: {
+                    size_t destLen;
 
-    outBufferEnd = _outBuffer;
+                    if (EXR_ERR_SUCCESS != exr_uncompress_buffer (
+                            nullptr,
+                            compressedAcBuf,
+                            acCompressedSize,
+                            _packedAcBuffer,
+                            totalAcUncompressedCount * sizeof (unsigned short),
+                            &destLen))
+                    {
+                        throw IEX_NAMESPACE::InputExc (
+                            "Data decompression (zlib) failed.");
+                    }
 
-    for (int y = minY; y <= maxY; ++y)
-    {
-        for (unsigned int chan = 0; chan < _channelData.size (); ++chan)
-        {
-            ChannelData* cd = &_channelData[chan];
+                    if (totalAcUncompressedCount * sizeof (unsigned short) !=
+                        destLen)
+                    {
+                        throw IEX_NAMESPACE::InputExc ("AC data corrupt.");
+                    }
+                }
+                break;
 
-            if (IMATH_NAMESPACE::modp (y, cd->ySampling) != 0) continue;
+                default:
 
-            rowPtrs[chan].push_back (outBufferEnd);
-            outBufferEnd +=
-                cd->width * OPENEXR_IMF_NAMESPACE::pixelTypeSize (cd->type);
-        }
+                    throw IEX_NAMESPACE::NoImplExc ("Unknown AC Compression");
+                    break;
+            }
+        });
     }
 
     //
-    // Setup to decode each block of 3 channels that need to
-    // be handled together
+    // Uncompress the DC data into _packedDcBuffer
     //
 
-    for (unsigned int csc = 0; csc < _cscSets.size (); ++csc)
+    if (dcCompressedSize > 0)
     {
-        int rChan = _cscSets[csc].idx[0];
-        int gChan = _cscSets[csc].idx[1];
-        int bChan = _cscSets[csc].idx[2];
+        jobs.push_back ([&] {
+            if (totalDcUncompressedCount * sizeof (unsigned short) >
+                _packedDcBufferSize)
+            {
+                throw IEX_NAMESPACE::InputExc ("Error uncompressing DWA data"
+                                               "(corrupt header).");
+            }
 
-        if (_channelData[rChan].compression != LOSSY_DCT ||
-            _channelData[gChan].compression != LOSSY_DCT ||
-            _channelData[bChan].compression != LOSSY_DCT)
+            if (static_cast<uint64_t> (_zip->uncompress (
+                    compressedDcBuf, (int) dcCompressedSize, _packedDcBuffer)) !=
+                totalDcUncompressedCount * sizeof (unsigned short))
+            {
+                throw IEX_NAMESPACE::BaseExc ("DC data corrupt.");
+            }
+        });
+    }
+    else
+    {
+        // if the compressed size is 0, then the uncompressed size must also be zero
+        if (totalDcUncompressedCount != 0)
         {
-            throw IEX_NAMESPACE::BaseExc ("Bad DWA compression type detected");
+            throw IEX_NAMESPACE::BaseExc ("DC data corrupt.");
         }
-
-        LossyDctDecoderCsc decoder (
-            rowPtrs[rChan],
-            rowPtrs[gChan],
-            rowPtrs[bChan],
-            packedAcBufferEnd,
-            packedAcBufferEnd +
-                totalAcUncompressedCount * sizeof (unsigned short),
-            packedDcBufferEnd,
-            dwaCompressorToLinear,
-            _channelData[rChan].width,
-            _channelData[rChan].height,
-            _channelData[rChan].type,
-            _channelData[gChan].type,
-            _channelData[bChan].type);
-
-        decoder.execute ();
-
-        packedAcBufferEnd +=
-            decoder.numAcValuesEncoded () * sizeof (unsigned short);
-
-        packedDcBufferEnd +=
-            decoder.numDcValuesEncoded () * sizeof (unsigned short);
-
-        decodedChannels[rChan] = true;
-        decodedChannels[gChan] = true;
-        decodedChannels[bChan] = true;
     }
 
-    //
-    // Setup to handle the remaining channels by themselves
-    //
-
-    for (unsigned int chan = 0; chan < _channelData.size (); ++chan)
+    if (haveRle || rleRawSize > 0)
     {
-        if (decodedChannels[chan]) continue;
-
-        ChannelData* cd = &_channelData[chan];
-        int pixelSize   = OPENEXR_IMF_NAMESPACE::pixelTypeSize (cd->type);
-
-        switch (cd->compression)
-        {
-            case LOSSY_DCT:
-
-                //
-                // Setup a single-channel lossy DCT decoder pointing
-                // at the output buffer
-                //
+        jobs.push_back ([&] {
+            //
+            // Uncompress the RLE data into _rleBuffer, then unRLE the
+            // results into _planarUncBuffer[RLE]
+            //
 
+            if (rleRawSize > 0)
+            {
+                if (rleUncompressedSize > _rleBufferSize ||
+                    rleRawSize > _planarUncBufferSize[RLE])
                 {
-                    const unsigned short* linearLut = 0;
-
-                    if (!cd->pLinear) linearLut = dwaCompressorToLinear;
+                    throw IEX_NAMESPACE::InputExc (
+                        "Error uncompressing DWA data"
+                        "(corrupt header).");
+                }
 
-                    LossyDctDecoder decoder (
-                        rowPtrs[chan],
-                        packedAcBufferEnd,
-                        packedAcBufferEnd +
-                            totalAcUncompressedCount * sizeof (unsigned short),
-                        packedDcBufferEnd,
-                        linearLut,
-                        cd->width,
-                        cd->height,
-                        cd->type);
+                size_t dstLen;
 
-                    decoder.execute ();
+                if (EXR_ERR_SUCCESS != exr_uncompress_buffer (
+                        nullptr,
+                        compressedRleBuf,
+                        rleCompressedSize,
+                        _rleBuffer,
+                        rleUncompressedSize,
+                        &dstLen))
+                {
+                    throw IEX_NAMESPACE::BaseExc (
+                        "Error uncompressing RLE data.");
+                }
 
-                    packedAcBufferEnd +=
-                        decoder.numAcValuesEncoded () * sizeof (unsigned short);
+                if (dstLen != rleUncompressedSize)
+                    throw IEX_NAMESPACE::BaseExc ("RLE data corrupted");
 
-                    packedDcBufferEnd +=
-                        decoder.numDcValuesEncoded () * sizeof (unsigned short);
+                if (static_cast<uint64_t> (rleUncompress (
+                        (int) rleUncompressedSize,
+                        (int) rleRawSize,
+                        (signed char*) _rleBuffer,
+                        _planarUncBuffer[RLE])) != rleRawSize)
+                {
+                    throw IEX_NAMESPACE::BaseExc ("RLE data corrupted");
                 }
+            }
 
-                break;
+            for (unsigned int chan = 0; chan < _channelData.size (); ++chan)
+            {
+                ChannelData* cd = &_channelData[chan];
+                int pixelSize = OPENEXR_IMF_NAMESPACE::pixelTypeSize (cd->type);
 
-            case RLE:
+                if (decodedChannels[chan] || cd->compression != RLE)
+                    continue;
 
                 //
-                // For the RLE case, the data has been un-RLE'd into
-                // planarUncRleEnd[], but is still split out by bytes.
-                // We need to rearrange the bytes back into the correct
-                // order in the output buffer;
+                // The data has been un-RLE'd into planarUncRleEnd[], but
+                // is still split out by bytes. We need to rearrange the
+                // bytes back into the correct order in the output buffer.
                 //
 
+                for (size_t row = 0; row < rowPtrs[chan].size (); ++row)
                 {
-                    int row = 0;
+                    char* dst = rowPtrs[chan][row];
 
-                    for (int y = minY; y <= maxY; ++y)
+                    if (pixelSize == 2)
                     {
-                        if (IMATH_NAMESPACE::modp (y, cd->ySampling) != 0)
-                            continue;
-
-                        char* dst = rowPtrs[chan][row];
-
-                        if (pixelSize == 2)
-                        {
-                            interleaveByte2 (
-                                dst,
-                                cd->planarUncRleEnd[0],
-                                cd->planarUncRleEnd[1],
-                                cd->width);
-
-                            cd->planarUncRleEnd[0] += cd->width;
-                            cd->planarUncRleEnd[1] += cd->width;
-                        }
-                        else
+                        interleaveByte2 (
+                            dst,
+                            cd->planarUncRleEnd[0],
+                            cd->planarUncRleEnd[1],
+                            cd->width);
+
+                        cd->planarUncRleEnd[0] += cd->width;
+                        cd->planarUncRleEnd[1] += cd->width;
+                    }
+                    else
+                    {
+                        for (int x = 0; x < cd->width; ++x)
                         {
-                            for (int x = 0; x < cd->width; ++x)
+                            for (int byte = 0; byte < pixelSize; ++byte)
                             {
-                                for (int byte = 0; byte < pixelSize; ++byte)
-                                {
-                                    *dst++ = *cd->planarUncRleEnd[byte]++;
-                                }
+                                *dst++ = *cd->planarUncRleEnd[byte]++;
                             }
                         }
-
-                        row++;
                     }
                 }
+            }
+        });
+    }
 
-                break;
+    runCompressorJobs (static_cast<int> (jobs.size ()), [&] (int j) {
+        jobs[j] ();
+    });
 
-            case UNKNOWN:
+    //
+    // Find the start of the packed AC and DC components of each
+    // LOSSY_DCT job. There is one DC component per block, but the
+    // AC components have to be counted, which is much quicker than
+    // decoding them. Then decode the jobs in parallel.
+    //
 
-                //
-                // In the UNKNOWN case, data is already in planarUncBufferEnd
-                // and just needs to copied over to the output buffer
-                //
+    if (totalAcUncompressedCount * sizeof (unsigned short) >
+        _packedAcBufferSize)
+    {
+        throw IEX_NAMESPACE::InputExc ("Error uncompressing DWA data"
+                                       "(corrupt header).");
+    }
 
-                {
-                    int row = 0;
-                    int dstScanlineSize =
-                        cd->width *
-                        OPENEXR_IMF_NAMESPACE::pixelTypeSize (cd->type);
+    const unsigned short* packedAcEnd =
+        (const unsigned short*) _packedAcBuffer + totalAcUncompressedCount;
 
-                    for (int y = minY; y <= maxY; ++y)
-                    {
-                        if (IMATH_NAMESPACE::modp (y, cd->ySampling) != 0)
-                            continue;
+    const unsigned short* packedAc = (const unsigned short*) _packedAcBuffer;
+    char*                 packedDc = _packedDcBuffer;
 
-                        //
-                        // sanity check for buffer data lying within range
-                        //
-                        if ((cd->planarUncBufferEnd +
-                             static_cast<size_t> (dstScanlineSize)) >
-                            (_planarUncBuffer[UNKNOWN] +
-                             _planarUncBufferSize[UNKNOWN]))
-                        {
-                            throw IEX_NAMESPACE::InputExc ("DWA data corrupt");
-                        }
+    for (size_t i = 0; i < dctJobs.size (); ++i)
+    {
+        dctJobs[i].packedAc = (char*) packedAc;
+        dctJobs[i].packedDc = packedDc;
 
-                        memcpy (
-                            rowPtrs[chan][row],
-                            cd->planarUncBufferEnd,
-                            dstScanlineSize);
+        packedAc += countRleAc (packedAc, packedAcEnd, dctJobs[i].numBlocks);
+        packedDc += dctJobs[i].numBlocks * sizeof (unsigned short);
+    }
 
-                        cd->planarUncBufferEnd += dstScanlineSize;
-                        row++;
-                    }
-                }
+    runCompressorJobs (static_cast<int> (dctJobs.size ()), [&] (int i) {
+        LossyDctJob&       job = dctJobs[i];
+        const ChannelData& cd  = _channelData[job.chan[0]];
 
-                break;
+        if (job.numChan == 3)
+        {
+            LossyDctDecoderCsc decoder (
+                rowPtrs[job.chan[0]],
+                rowPtrs[job.chan[1]],
+                rowPtrs[job.chan[2]],
+                job.packedAc,
+                (char*) packedAcEnd,
+                job.packedDc,
+                dwaCompressorToLinear,
+                cd.width,
+                cd.height,
+                cd.type,
+                _channelData[job.chan[1]].type,
+                _channelData[job.chan[2]].type);
+
+            decoder.execute ();
+        }
+        else
+        {
+            //
+            // Setup a single-channel lossy DCT decoder pointing
+            // at the output buffer
+            //
 
-            default:
+            const unsigned short* linearLut = 0;
 
-                throw IEX_NAMESPACE::NoImplExc (
-                    "Unhandled compression scheme case");
-                break;
-        }
+            if (!cd.pLinear) linearLut = dwaCompressorToLinear;
 
-        decodedChannels[chan] = true;
-    }
+            LossyDctDecoder decoder (
+                rowPtrs[job.chan[0]],
+                job.packedAc,
+                (char*) packedAcEnd,
+                job.packedDc,
+                linearLut,
+                cd.width,
+                cd.height,
+                cd.type);
+
+            decoder.execute ();
+        }
+    });
 
     //
     // Return a ptr to _outBuffer
@@ -2832,6 +3091,16 @@ DwaCompressor::initializeFuncs ()
         dctInverse8x8_6 = dctInverse8x8_sse2<6>;
         dctInverse8x8_7 = dctInverse8x8_sse2<7>;
     }
+
+    //
+    // Setup forward DCT and quantization implementations
+    //
+
+    dctForwardQuantize64 = dctForwardQuantize64_scalar;
+
+#ifdef IMF_HAVE_AVX2_DISPATCH
+    if (hasAvx2 ()) dctForwardQuantize64 = dctForwardQuantize64_avx2;
+#endif
 }
 
 //
@@ -3310,6 +3579,58 @@ DwaCompressor::classifyChannels (
         cscData[offset] = tmpCscSet[offset];
 }
 
+//
+// Gather the CSC sets and the remaining LOSSY_DCT channels into
+// jobs, and count their 8x8 blocks.
+//
+
+void
+DwaCompressor::lossyDctJobs (
+    std::vector<LossyDctJob>& jobs, std::vector<bool>& lossyDctChannels) const
+{
+    for (unsigned int csc = 0; csc < _cscSets.size (); ++csc)
+    {
+        LossyDctJob job;
+
+        for (int comp = 0; comp < 3; ++comp)
+        {
+            job.chan[comp]                   = _cscSets[csc].idx[comp];
+            lossyDctChannels[job.chan[comp]] = true;
+        }
+
+        job.numChan = 3;
+        jobs.push_back (job);
+    }
+
+    for (unsigned int chan = 0; chan < _channelData.size (); ++chan)
+    {
+        if (lossyDctChannels[chan] ||
+            _channelData[chan].compression != LOSSY_DCT)
+            continue;
+
+        LossyDctJob job;
+
+        job.chan[0] = chan;
+        job.numChan = 1;
+        jobs.push_back (job);
+
+        lossyDctChannels[chan] = true;
+    }
+
+    for (size_t i = 0; i < jobs.size (); ++i)
+    {
+        const ChannelData& cd = _channelData[jobs[i].chan[0]];
+
+        jobs[i].numBlocks = jobs[i].numChan *
+                            static_cast<size_t> ((cd.width + 7) / 8) *
+                            static_cast<size_t> ((cd.height + 7) / 8);
+        jobs[i].packedAc  = 0;
+        jobs[i].packedDc  = 0;
+        jobs[i].numAc     = 0;
+        jobs[i].numDc     = 0;
+    }
+}
+
 //
 // Setup some buffer pointers, determine channel sizes, things
 // like that.
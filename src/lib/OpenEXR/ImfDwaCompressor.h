@@ -83,6 +83,8 @@ private:
     class LossyDctEncoder;
     class LossyDctEncoderCsc;
 
+    struct LossyDctJob;
+
     enum CompressorScheme
     {
         UNKNOWN = 0,
@@ -162,6 +164,16 @@ private:
 
     void relevantChannelRules (std::vector<Classifier>&) const;
 
+    //
+    // List the CSC sets and the remaining LOSSY_DCT channels, each
+    // of which is coded by a job of its own in compress () and
+    // uncompress (), and flag their channels in lossyDctChannels.
+    //
+
+    void lossyDctJobs (
+        std::vector<LossyDctJob>& jobs,
+        std::vector<bool>&        lossyDctChannels) const;
+
     //
     // Populate our cached version of the channel data with
     // data from the real channel list. We want to
@@ -764,4 +764,286 @@ FastHufDecoder::decode (
     }
 }
 
+//
+// State of one bit reader of decodeStreams (). Each stream has one,
+// and all of them share the decoder's tables.
+//
+// Unlike decode (), which keeps a second 64-bit buffer, the reader
+// reloads buffer with an unaligned 64-bit read at the first byte it
+// has not consumed completely, which leaves fewer values to carry
+// from one symbol to the next.
+//
+
+struct FastHufDecoder::Stream
+{
+    uint64_t buffer;        // next bits in the stream, left justified
+    int      bufferNumBits; // bits in buffer read from whole bytes
+
+    const unsigned char* src;      // start of the stream
+    int                  srcPos;   // next byte to read into buffer
+    int                  srcBytes; // length of the stream in bytes
+    int                  srcBits;  // length of the stream in bits
+
+    unsigned short* dst;
+    int             dstIdx;
+    int             numDstElems;
+};
+
+void
+FastHufDecoder::initStream (
+    Stream&              s,
+    const unsigned char* src,
+    int                  numSrcBits,
+    unsigned short*      dst,
+    int                  numDstElems)
+{
+    s.buffer        = 0;
+    s.bufferNumBits = 0;
+
+    s.src      = src;
+    s.srcPos   = 0;
+    s.srcBytes = (numSrcBits + 7) / 8;
+    s.srcBits  = numSrcBits;
+
+    s.dst         = dst;
+    s.dstIdx      = 0;
+    s.numDstElems = numDstElems;
+}
+
+//
+// Top up buffer so that it holds at least 56 bits. Only the last
+// 8 bytes of a stream take the slow path.
+//
+
+inline void
+FastHufDecoder::refill (Stream& s)
+{
+    if (s.srcBytes - s.srcPos >= 8)
+    {
+        s.buffer |= READ64 (s.src + s.srcPos) >> s.bufferNumBits;
+        s.srcPos += (63 - s.bufferNumBits) >> 3;
+        s.bufferNumBits |= 56;
+    }
+    else
+    {
+        //
+        // Hand refillTail () a copy, so that s does not have to
+        // live in memory in the caller's loop.
+        //
+
+        Stream t = s;
+        refillTail (t);
+        s = t;
+    }
+}
+
+void
+FastHufDecoder::refillTail (Stream& s)
+{
+    //
+    // Past the end of the stream, shift in zeros; finish () checks
+    // that no more bits were consumed than the stream holds.
+    //
+
+    while (s.bufferNumBits <= 56)
+    {
+        uint64_t byte = s.srcPos < s.srcBytes ? s.src[s.srcPos] : 0;
+
+        s.buffer |= byte << (56 - s.bufferNumBits);
+        s.bufferNumBits += 8;
+        s.srcPos++;
+    }
+}
+
+//
+// Decode one symbol of a stream. The caller makes sure that dstIdx <
+// numDstElems. step () only handles table hits that are not runs, so
+// that it stays small enough to inline several times in one loop, and
+// leaves everything else to stepSlow ().
+//
+
+inline void
+FastHufDecoder::step (Stream& s)
+{
+    refill (s);
+
+    if (_tableMin <= s.buffer)
+    {
+        int tableIdx = s.buffer >> (64 - TABLE_LOOKUP_BITS);
+        int symbol   = _tableSymbol[tableIdx];
+
+        if (symbol != _rleSymbol)
+        {
+            int codeLen = _tableCodeLen[tableIdx];
+
+            s.buffer = s.buffer << codeLen;
+            s.bufferNumBits -= codeLen;
+            s.dst[s.dstIdx++] = symbol;
+            return;
+        }
+    }
+
+    Stream t = s;
+    stepSlow (t);
+    s = t;
+}
+
+void
+FastHufDecoder::stepSlow (Stream& s)
+{
+    int codeLen;
+    int symbol;
+
+    if (_tableMin <= s.buffer)
+    {
+        int tableIdx = s.buffer >> (64 - TABLE_LOOKUP_BITS);
+
+        codeLen = _tableCodeLen[tableIdx];
+        symbol  = _tableSymbol[tableIdx];
+    }
+    else
+    {
+        codeLen = TABLE_LOOKUP_BITS + 1;
+
+        while (_ljBase[codeLen] > s.buffer && codeLen <= _maxCodeLength)
+            codeLen++;
+
+        //
+        // buffer holds at least 56 bits, and no table the encoder
+        // builds for a chunk has longer codes than that.
+        //
+
+        uint64_t id = _ljOffset[codeLen] + (s.buffer >> (64 - codeLen));
+
+        if (codeLen > _maxCodeLength || codeLen > 56 ||
+            id >= static_cast<uint64_t> (_numSymbols))
+        {
+            throw IEX_NAMESPACE::InputExc ("Huffman decode error "
+                                           "(Decoded an invalid symbol).");
+        }
+
+        symbol = _idToSymbol[id];
+    }
+
+    s.buffer = s.buffer << codeLen;
+    s.bufferNumBits -= codeLen;
+
+    if (symbol != _rleSymbol)
+    {
+        s.dst[s.dstIdx++] = symbol;
+        return;
+    }
+
+    if (s.bufferNumBits < 8) refill (s);
+
+    int rleCount = s.buffer >> 56;
+
+    if (s.dstIdx < 1)
+    {
+        throw IEX_NAMESPACE::InputExc ("Huffman decode error (RLE code "
+                                       "with no previous symbol).");
+    }
+
+    if (s.dstIdx + rleCount > s.numDstElems)
+    {
+        throw IEX_NAMESPACE::InputExc ("Huffman decode error (Symbol run "
+                                       "beyond expected output buffer length).");
+    }
+
+    if (rleCount <= 0)
+    {
+        throw IEX_NAMESPACE::InputExc ("Huffman decode error"
+                                       " (Invalid RLE length)");
+    }
+
+    for (int i = 0; i < rleCount; ++i)
+        s.dst[s.dstIdx + i] = s.dst[s.dstIdx - 1];
+
+    s.dstIdx += rleCount;
+
+    s.buffer = s.buffer << 8;
+    s.bufferNumBits -= 8;
+}
+
+void
+FastHufDecoder::finish (Stream& s)
+{
+    while (s.dstIdx < s.numDstElems)
+        step (s);
+
+    if (8 * static_cast<int64_t> (s.srcPos) - s.bufferNumBits > s.srcBits)
+    {
+        throw IEX_NAMESPACE::InputExc ("Huffman decode error "
+                                       "(Truncated data).");
+    }
+}
+
+//
+// Each symbol depends on the bits consumed by the previous one, so
+// decode () leaves most of the CPU waiting on table lookups and shifts.
+// Stepping groups of streams in lock step gives it independent chains
+// to overlap. Local copies of the stream states let the compiler keep
+// them in registers.
+//
+
+void
+FastHufDecoder::decodeStreams (
+    int                         numStreams,
+    const unsigned char* const* src,
+    const int*                  numSrcBits,
+    unsigned short* const*      dst,
+    const int*                  numDstElems)
+{
+    std::vector<Stream> streams (numStreams);
+
+    for (int i = 0; i < numStreams; ++i)
+        initStream (streams[i], src[i], numSrcBits[i], dst[i], numDstElems[i]);
+
+    int i = 0;
+
+    for (; i + 4 <= numStreams; i += 4)
+    {
+        Stream s0 = streams[i];
+        Stream s1 = streams[i + 1];
+        Stream s2 = streams[i + 2];
+        Stream s3 = streams[i + 3];
+
+        while (s0.dstIdx < s0.numDstElems && s1.dstIdx < s1.numDstElems &&
+               s2.dstIdx < s2.numDstElems && s3.dstIdx < s3.numDstElems)
+        {
+            step (s0);
+            step (s1);
+            step (s2);
+            step (s3);
+        }
+
+        streams[i]     = s0;
+        streams[i + 1] = s1;
+        streams[i + 2] = s2;
+        streams[i + 3] = s3;
+    }
+
+    for (; i + 2 <= numStreams; i += 2)
+    {
+        Stream s0 = streams[i];
+        Stream s1 = streams[i + 1];
+
+        while (s0.dstIdx < s0.numDstElems && s1.dstIdx < s1.numDstElems)
+        {
+            step (s0);
+            step (s1);
+        }
+
+        streams[i]     = s0;
+        streams[i + 1] = s1;
+    }
+
+    //
+    // Finish whatever each stream has left on its own
+    //
+
+    for (i = 0; i < numStreams; ++i)
+        finish (streams[i]);
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -75,11 +75,35 @@ public:
         unsigned short*      dst,
         int                  numDstElems);
 
+    //
+    // Decode numStreams bitstreams coded with this table, as written
+    // by hufCompressStreams (). Stream i holds numSrcBits[i] bits at
+    // src[i], and decodes to numDstElems[i] values at dst[i]. The
+    // streams are decoded side by side, which is faster than decoding
+    // them one after the other.
+    //
+
+    void decodeStreams (
+        int                         numStreams,
+        const unsigned char* const* src,
+        const int*                  numSrcBits,
+        unsigned short* const*      dst,
+        const int*                  numDstElems);
+
 private:
+    struct Stream;
+
     void buildTables (uint64_t*, uint64_t*);
     void refill (uint64_t&, int, uint64_t&, int&, const unsigned char*&, int&);
     uint64_t readBits (int, uint64_t&, int&, const char*&);
 
+    void initStream (Stream&, const unsigned char*, int, unsigned short*, int);
+    void refill (Stream&);
+    void refillTail (Stream&);
+    void step (Stream&);
+    void stepSlow (Stream&);
+    void finish (Stream&);
+
     int _rleSymbol; // RLE symbol written by the encoder.
                     // This could be 65536, so beware
                     // when you use shorts to hold things.
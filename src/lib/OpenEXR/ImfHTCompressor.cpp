@@ -10,18 +10,28 @@
 //-----------------------------------------------------------------------------
 
 #include "ImfHTCompressor.h"
+#include "Iex.h"
 #include "ImfAutoArray.h"
 #include "ImfChannelList.h"
 #include "ImfCheckedArithmetic.h"
+#include "ImfCompressorJobs.h"
 #include "ImfHeader.h"
 #include "ImfIO.h"
 #include "ImfMisc.h"
 #include "ImfNamespace.h"
+#include "ImfSimd.h"
+#include "ImfStandardAttributes.h"
+#include "ImfSystemSpecific.h"
 #include "ImfXdr.h"
 #include <assert.h>
 #include <string.h>
 
 #include <ImathBox.h>
+#include <ImathFun.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
 
 #include <ojph_arch.h>
 #include <ojph_file.h>
@@ -29,14 +39,642 @@
 #include <ojph_mem.h>
 
 using IMATH_NAMESPACE::Box2i;
+using IMATH_NAMESPACE::modp;
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 
-HTCompressor::HTCompressor (const Header& hdr, int numScanLines)
-    : Compressor (hdr), _num_comps (0), _buffer (NULL), _numScanLines ()
+namespace
+{
+
+//
+// HT_STRIPED_COMPRESSION chunks are coded as a sequence of
+// independent codestreams, one per horizontal stripe of
+// STRIPE_LINES scan lines:
+//
+//	unsigned int	number of stripes, n >= 1
+//	unsigned int	stripe height, in scan lines
+//	unsigned int	size of each codestream, n times
+//	char		codestreams, back to back
+//
+// The chunks of all other HT compression types hold a single bare
+// codestream, as any J2K decoder expects.
+//
+
+const int STRIPE_LINES = 256;
+
+//
+// Find the codestreams of a chunk of height scan lines, and return
+// the stripe height.
+//
+
+ojph::ui32
+splitStripes (
+    const char*               inPtr,
+    int                       inSize,
+    ojph::ui32                height,
+    bool                      striped,
+    std::vector<const char*>& stripeData,
+    std::vector<size_t>&      stripeSize)
+{
+    if (!striped)
+    {
+        stripeData.push_back (inPtr);
+        stripeSize.push_back (inSize);
+        return height;
+    }
+
+    const char*  inEnd = inPtr + inSize;
+    unsigned int numStripes;
+    unsigned int stripeLines;
+
+    if (inSize < 2 * Xdr::size<unsigned int> ())
+        throw IEX_NAMESPACE::InputExc ("HT chunk header is truncated.");
+
+    Xdr::read<CharPtrIO> (inPtr, numStripes);
+    Xdr::read<CharPtrIO> (inPtr, stripeLines);
+
+    if (numStripes < 1 || stripeLines == 0 ||
+        static_cast<uint64_t> (numStripes - 1) * stripeLines >= height ||
+        static_cast<uint64_t> (numStripes) * stripeLines < height ||
+        static_cast<uint64_t> (numStripes) * Xdr::size<unsigned int> () >
+            static_cast<uint64_t> (inEnd - inPtr))
+    {
+        throw IEX_NAMESPACE::InputExc ("HT chunk header is corrupt.");
+    }
+
+    const char* data = inPtr + numStripes * Xdr::size<unsigned int> ();
+
+    for (unsigned int s = 0; s < numStripes; ++s)
+    {
+        unsigned int size;
+        Xdr::read<CharPtrIO> (inPtr, size);
+
+        if (size > static_cast<uint64_t> (inEnd - data))
+            throw IEX_NAMESPACE::InputExc ("HT chunk header is corrupt.");
+
+        stripeData.push_back (data);
+        stripeSize.push_back (size);
+        data += size;
+    }
+
+    return stripeLines;
+}
+
+//
+// Run fn (0) ... fn (count - 1) through runCompressorJobs (). When
+// the stripes are spread across threads, an error in any of them is
+// reported as IoExc, whatever its original type.
+//
+
+void
+runStripes (int count, const std::function<void (int)>& fn)
+{
+    if (count <= 1)
+    {
+        runCompressorJobs (count, fn);
+        return;
+    }
+
+    try
+    {
+        runCompressorJobs (count, fn);
+    }
+    catch (std::exception& e)
+    {
+        throw IEX_NAMESPACE::IoExc (e.what ());
+    }
+    catch (...)
+    {
+        throw IEX_NAMESPACE::IoExc ("unrecognized exception");
+    }
+}
+
+//
+// One codestream component: the samples of one channel that fall
+// within a stripe.
+//
+
+struct Component
+{
+    PixelType     type;
+    ojph::point   sampling;
+    ojph::ui32    width;  // samples per line
+    ojph::ui32    height; // lines in the stripe
+    const size_t* lines;  // offset of each line in the chunk
+};
+
+//
+// The component for the lines y0 to y1 - 1 of a channel, in a chunk
+// that starts at scan line minY.
+//
+
+Component
+stripeComponent (
+    PixelType                  type,
+    int                        xSampling,
+    int                        ySampling,
+    int                        width,
+    const std::vector<size_t>& lines,
+    int                        minY,
+    int                        y0,
+    int                        y1)
+{
+    Component comp;
+    comp.type     = type;
+    comp.sampling = ojph::point (xSampling, ySampling);
+    comp.width    = width;
+    comp.height   = numSamples (ySampling, y0, y1 - 1);
+    comp.lines    = lines.data () + numSamples (ySampling, minY, y0 - 1);
+    return comp;
+}
+
+ojph::ui32
+bitDepth (PixelType type)
+{
+    return type == HALF ? 16 : 32;
+}
+
+//
+// HALF and FLOAT samples are sign-magnitude values; the codestream
+// holds them as two's complement integers with the same ordering.
+//
+
+template <class T>
+void
+packLine (T* out, const char* in, PixelType type, ojph::ui32 width)
+{
+    switch (type)
+    {
+        case HALF:
+            for (ojph::ui32 p = 0; p < width; ++p)
+            {
+                int16_t v;
+                memcpy (&v, in + p * sizeof (v), sizeof (v));
+                out[p] = v < 0 ? v ^ 0x7FFF : v;
+            }
+            break;
+
+        case FLOAT:
+            for (ojph::ui32 p = 0; p < width; ++p)
+            {
+                int32_t v;
+                memcpy (&v, in + p * sizeof (v), sizeof (v));
+                out[p] = v < 0 ? v ^ 0x7FFFFFFF : v;
+            }
+            break;
+
+        case UINT:
+            for (ojph::ui32 p = 0; p < width; ++p)
+            {
+                uint32_t v;
+                memcpy (&v, in + p * sizeof (v), sizeof (v));
+                out[p] = static_cast<T> (v);
+            }
+            break;
+
+        default: assert (false);
+    }
+}
+
+template <class T>
+void
+unpackLine (char* out, const T* in, PixelType type, ojph::ui32 width)
+{
+    switch (type)
+    {
+        case HALF:
+            for (ojph::ui32 p = 0; p < width; ++p)
+            {
+                int16_t v = static_cast<int16_t> (
+                    in[p] < 0 ? in[p] ^ 0x7FFF : in[p]);
+                memcpy (out + p * sizeof (v), &v, sizeof (v));
+            }
+            break;
+
+        case FLOAT:
+            for (ojph::ui32 p = 0; p < width; ++p)
+            {
+                int32_t v = static_cast<int32_t> (
+                    in[p] < 0 ? in[p] ^ 0x7FFFFFFF : in[p]);
+                memcpy (out + p * sizeof (v), &v, sizeof (v));
+            }
+            break;
+
+        case UINT:
+            for (ojph::ui32 p = 0; p < width; ++p)
+            {
+                uint32_t v = static_cast<uint32_t> (in[p]);
+                memcpy (out + p * sizeof (v), &v, sizeof (v));
+            }
+            break;
+
+        default: assert (false);
+    }
+}
+
+//
+// Quantization noise can push the samples of a lossy codestream past
+// infinity, into NaN bit patterns, or out of the range of the pixel
+// type altogether.
+//
+
+template <class T>
+void
+clampLine (T* line, PixelType type, ojph::ui32 width)
+{
+    T lo, hi;
+
+    switch (type)
+    {
+        case HALF:
+            lo = -0x7C00 - 1; // -inf
+            hi = 0x7C00;      // +inf
+            break;
+
+        case FLOAT:
+            lo = -0x7F800000 - 1;
+            hi = 0x7F800000;
+            break;
+
+        default: return;
+    }
+
+    for (ojph::ui32 p = 0; p < width; ++p)
+        line[p] = std::min (std::max (line[p], lo), hi);
+}
+
+//
+// HALF lines with 32-bit line buffers are by far the most common
+// case, so they get vectorized versions of packLine () and
+// unpackLine (), selected in HTCompressor::initializeFuncs ().
+//
+
+void
+packHalfLine_scalar (ojph::si32* out, const char* in, ojph::ui32 width)
+{
+    packLine (out, in, HALF, width);
+}
+
+void
+unpackHalfLine_scalar (char* out, const ojph::si32* in, ojph::ui32 width)
+{
+    unpackLine (out, in, HALF, width);
+}
+
+#ifdef IMF_HAVE_SSE2
+
+void
+packHalfLine_sse2 (ojph::si32* out, const char* in, ojph::ui32 width)
+{
+    const __m128i mask = _mm_set1_epi16 (0x7FFF);
+    ojph::ui32    p    = 0;
+
+    for (; p + 8 <= width; p += 8)
+    {
+        __m128i v = _mm_loadu_si128 (
+            reinterpret_cast<const __m128i*> (in + p * sizeof (int16_t)));
+
+        v = _mm_xor_si128 (v, _mm_and_si128 (_mm_srai_epi16 (v, 15), mask));
+
+        _mm_storeu_si128 (
+            reinterpret_cast<__m128i*> (out + p),
+            _mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16));
+        _mm_storeu_si128 (
+            reinterpret_cast<__m128i*> (out + p + 4),
+            _mm_srai_epi32 (_mm_unpackhi_epi16 (v, v), 16));
+    }
+
+    packLine (out + p, in + p * sizeof (int16_t), HALF, width - p);
+}
+
+void
+unpackHalfLine_sse2 (char* out, const ojph::si32* in, ojph::ui32 width)
+{
+    const __m128i mask = _mm_set1_epi16 (0x7FFF);
+    ojph::ui32    p    = 0;
+
+    for (; p + 8 <= width; p += 8)
+    {
+        __m128i v = _mm_packs_epi32 (
+            _mm_loadu_si128 (reinterpret_cast<const __m128i*> (in + p)),
+            _mm_loadu_si128 (reinterpret_cast<const __m128i*> (in + p + 4)));
+
+        v = _mm_xor_si128 (v, _mm_and_si128 (_mm_srai_epi16 (v, 15), mask));
+
+        _mm_storeu_si128 (
+            reinterpret_cast<__m128i*> (out + p * sizeof (int16_t)), v);
+    }
+
+    unpackLine (out + p * sizeof (int16_t), in + p, HALF, width - p);
+}
+
+#endif
+
+#ifdef IMF_HAVE_NEON_AARCH64
+
+void
+packHalfLine_neon (ojph::si32* out, const char* in, ojph::ui32 width)
+{
+    const int16x8_t mask = vdupq_n_s16 (0x7FFF);
+    ojph::ui32      p    = 0;
+
+    for (; p + 8 <= width; p += 8)
+    {
+        int16x8_t v = vld1q_s16 (
+            reinterpret_cast<const int16_t*> (in + p * sizeof (int16_t)));
+
+        v = veorq_s16 (v, vandq_s16 (vshrq_n_s16 (v, 15), mask));
+
+        vst1q_s32 (out + p, vmovl_s16 (vget_low_s16 (v)));
+        vst1q_s32 (out + p + 4, vmovl_high_s16 (v));
+    }
+
+    packLine (out + p, in + p * sizeof (int16_t), HALF, width - p);
+}
+
+void
+unpackHalfLine_neon (char* out, const ojph::si32* in, ojph::ui32 width)
+{
+    const int16x8_t mask = vdupq_n_s16 (0x7FFF);
+    ojph::ui32      p    = 0;
+
+    for (; p + 8 <= width; p += 8)
+    {
+        int16x8_t v = vcombine_s16 (
+            vqmovn_s32 (vld1q_s32 (in + p)),
+            vqmovn_s32 (vld1q_s32 (in + p + 4)));
+
+        v = veorq_s16 (v, vandq_s16 (vshrq_n_s16 (v, 15), mask));
+
+        vst1q_s16 (reinterpret_cast<int16_t*> (out + p * sizeof (int16_t)), v);
+    }
+
+    unpackLine (out + p * sizeof (int16_t), in + p, HALF, width - p);
+}
+
+#endif
+
+auto packHalfLine   = packHalfLine_scalar;
+auto unpackHalfLine = unpackHalfLine_scalar;
+
+//
+// An OpenJPH output that writes into a fixed part of the chunk
+// buffer.  A stripe that does not fit would make the chunk larger
+// than its uncompressed size, and the chunk is then stored as is,
+// so running out of room only sets a flag instead of making OpenJPH
+// report a write error.
+//
+
+class ChunkOutfile : public ojph::outfile_base
+{
+public:
+    ChunkOutfile (char* buf, size_t capacity)
+        : buf (buf), capacity (capacity), pos (0), overflow (false)
+    {}
+
+    virtual size_t write (const void* ptr, size_t size)
+    {
+        if (overflow || size > capacity - pos)
+            overflow = true;
+        else
+        {
+            memcpy (buf + pos, ptr, size);
+            pos += size;
+        }
+        return size;
+    }
+
+    virtual ojph::si64 tell () { return static_cast<ojph::si64> (pos); }
+
+    char*  buf;
+    size_t capacity;
+    size_t pos;
+    bool   overflow;
+};
+
+bool
+isPowerOfTwo (int v, int lo, int hi)
+{
+    return v >= lo && v <= hi && (v & (v - 1)) == 0;
+}
+
+void
+encodeStripe (
+    const char*                   chunk,
+    const std::vector<Component>& comps,
+    ojph::ui32                    width,
+    ojph::ui32                    height,
+    ojph::ui32                    yOffset,
+    bool                          isPlanar,
+    ojph::codestream&             cs,
+    ojph::outfile_base&           output)
+{
+    cs.set_planar (isPlanar);
+
+    ojph::param_siz siz = cs.access_siz ();
+
+    siz.set_num_components (static_cast<ojph::ui32> (comps.size ()));
+    for (size_t c = 0; c < comps.size (); c++)
+    {
+        siz.set_component (
+            static_cast<ojph::ui32> (c),
+            comps[c].sampling,
+            bitDepth (comps[c].type),
+            comps[c].type != UINT);
+    }
+
+    //
+    // The vertical offset makes the J2K subsampling grid line up
+    // with the data window, so that each component has exactly as
+    // many lines as the channel has in the stripe.
+    //
+
+    siz.set_image_offset (ojph::point (0, yOffset));
+    siz.set_tile_offset (ojph::point (0, 0));
+    siz.set_image_extent (ojph::point (width, yOffset + height));
+    siz.set_tile_size (ojph::size (width, yOffset + height));
+
+    cs.write_headers (&output);
+
+    ojph::ui32 total = 0;
+    for (size_t c = 0; c < comps.size (); c++)
+        total += comps[c].height;
+
+    std::vector<ojph::ui32> line (comps.size (), 0);
+    ojph::ui32              next_comp = 0;
+    ojph::line_buf*         cur_line  = cs.exchange (NULL, next_comp);
+
+    for (ojph::ui32 i = 0; i < total; ++i)
+    {
+        const Component& comp = comps[next_comp];
+
+        assert (line[next_comp] < comp.height);
+
+        const char* in = chunk + comp.lines[line[next_comp]++];
+
+        if (cur_line->flags & ojph::line_buf::LFT_64BIT)
+            packLine (cur_line->i64, in, comp.type, comp.width);
+        else if (comp.type == HALF)
+            packHalfLine (cur_line->i32, in, comp.width);
+        else
+            packLine (cur_line->i32, in, comp.type, comp.width);
+
+        cur_line = cs.exchange (cur_line, next_comp);
+    }
+
+    cs.flush ();
+}
+
+//
+// Decode one codestream into the lines of a chunk listed in comps,
+// after checking that its components match them.  With level > 0,
+// the codestream is reconstructed at 1 / 2^level of its resolution,
+// and the highest level wavelet subbands are not decoded at all.
+//
+
+void
+decodeStripe (
+    const char*                   inPtr,
+    size_t                        inSize,
+    char*                         chunk,
+    const std::vector<Component>& comps,
+    ojph::ui32                    width,
+    ojph::ui32                    level,
+    bool                          isPlanar,
+    ojph::codestream&             cs)
+{
+    ojph::mem_infile infile;
+    infile.open (reinterpret_cast<const ojph::ui8*> (inPtr), inSize);
+
+    cs.read_headers (&infile);
+
+    if (level > 0)
+    {
+        if (cs.access_cod ().get_num_decompositions () < level)
+        {
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Cannot decode HT codestream at resolution level "
+                    << level << ", it has only "
+                    << cs.access_cod ().get_num_decompositions ()
+                    << " decomposition levels.");
+        }
+
+        cs.restrict_input_resolution (level, level);
+    }
+
+    bool irreversible = !cs.access_cod ().is_reversible ();
+
+    ojph::param_siz siz = cs.access_siz ();
+    ojph::ui32 cs_width  = siz.get_image_extent ().x - siz.get_image_offset ().x;
+
+    bool matches = cs_width == width &&
+                   siz.get_num_components () == comps.size ();
+
+    for (ojph::ui32 c = 0; matches && c < comps.size (); c++)
+    {
+        matches = siz.get_recon_width (c) == comps[c].width &&
+                  siz.get_recon_height (c) == comps[c].height &&
+                  siz.get_bit_depth (c) == bitDepth (comps[c].type) &&
+                  siz.is_signed (c) == (comps[c].type != UINT);
+    }
+
+    if (!matches)
+    {
+        throw IEX_NAMESPACE::InputExc (
+            "HT codestream does not match the chunk dimensions.");
+    }
+
+    ojph::ui32 total = 0;
+    for (size_t c = 0; c < comps.size (); c++)
+        total += comps[c].height;
+
+    cs.set_planar (isPlanar);
+
+    cs.create ();
+
+    std::vector<ojph::ui32> line (comps.size (), 0);
+
+    for (ojph::ui32 i = 0; i < total; ++i)
+    {
+        ojph::ui32      next_comp = 0;
+        ojph::line_buf* cur_line  = cs.pull (next_comp);
+
+        if (next_comp >= comps.size () ||
+            line[next_comp] >= comps[next_comp].height)
+        {
+            throw IEX_NAMESPACE::InputExc (
+                "HT codestream lines are out of order.");
+        }
+
+        const Component& comp = comps[next_comp];
+
+        char* out = chunk + comp.lines[line[next_comp]++];
+
+        if (irreversible)
+        {
+            if (cur_line->flags & ojph::line_buf::LFT_64BIT)
+                clampLine (cur_line->i64, comp.type, comp.width);
+            else
+                clampLine (cur_line->i32, comp.type, comp.width);
+        }
+
+        if (cur_line->flags & ojph::line_buf::LFT_64BIT)
+            unpackLine (out, cur_line->i64, comp.type, comp.width);
+        else if (comp.type == HALF)
+            unpackHalfLine (out, cur_line->i32, comp.width);
+        else
+            unpackLine (out, cur_line->i32, comp.type, comp.width);
+    }
+
+    infile.close();
+}
+
+} // namespace
+
+//
+// The coding state of one stripe.  OpenJPH keeps the memory of a
+// codestream across restart (), so reusing it saves most of the
+// allocations that setting up a codestream for every chunk would
+// otherwise cost.
+//
+
+struct HTCompressor::StripeCoder
+{
+    StripeCoder () : used (false) {}
+
+    ojph::codestream& resetCodestream ()
+    {
+        if (used) codestream.restart ();
+        used = true;
+        return codestream;
+    }
+
+    ojph::codestream codestream;
+    bool             used;
+};
+
+HTCompressor::HTCompressor (
+    const Header& hdr, int numScanLines, bool irreversible, bool striped)
+    : Compressor (hdr)
+    , _num_comps (0)
+    , _numScanLines ()
+    , _isRGB (false)
+    , _isSubsampled (false)
+    , _numDecompositions (5)
+    , _blockSize (128, 32)
+    , _progressionOrder ("RPCL")
+    , _precinctSize (0, 0)
+    , _irreversible (irreversible)
+    , _striped (striped)
+    , _qstep (hdr.htCompressionLevel ())
 {
     this->_numScanLines = numScanLines > 0 ? numScanLines : 16000;
 
+    Box2i dw     = this->header ().dataWindow ();
+    this->_height = std::min (dw.size ().y + 1, this->_numScanLines);
+    this->_width  = dw.size ().x + 1;
+
     /* generate channel map */
 
     const ChannelList& channels = header ().channels ();
@@ -48,26 +686,46 @@ HTCompressor::HTCompressor (const Header& hdr, int numScanLines)
     for (ChannelList::ConstIterator c = channels.begin (); c != channels.end ();
          ++c)
     {
-        assert (c.channel ().type == HALF);
-        assert (c.channel ().xSampling == 1);
-        assert (c.channel ().ySampling == 1);
+        Channel ch;
+        ch.type      = c.channel ().type;
+        ch.xSampling = c.channel ().xSampling;
+        ch.ySampling = c.channel ().ySampling;
+        ch.width     = numSamples (ch.xSampling, dw.min.x, dw.max.x);
+
+        if (ch.xSampling != 1 || ch.ySampling != 1)
+            this->_isSubsampled = true;
+
+        if (irreversible && ch.type == UINT)
+        {
+            throw IEX_NAMESPACE::ArgExc (
+                "Cannot compress UINT channels with lossy HT.");
+        }
+
+        //
+        // The color transform is only applied to full resolution
+        // HALF channels.
+        //
+
+        bool isColor = ch.type == HALF && ch.xSampling == 1 && ch.ySampling == 1;
 
         std::string name (c.name ());
 
-        if (name == "R") { r_index = this->_num_comps; }
-        else if (name == "G")
+        if (name == "R" && isColor) { r_index = this->_num_comps; }
+        else if (name == "G" && isColor)
         {
             g_index = this->_num_comps;
         }
-        else if (name ==  "B")
+        else if (name ==  "B" && isColor)
         {
             b_index = this->_num_comps;
         }
 
+        this->_channels.push_back (ch);
         this->_num_comps++;
     }
 
     this->_cs_to_file_ch.resize (this->_num_comps);
+    this->_lineOffsets.resize (this->_num_comps);
 
     if (r_index >= 0 && g_index >= 0 && b_index >= 0)
     {
@@ -99,15 +757,144 @@ HTCompressor::HTCompressor (const Header& hdr, int numScanLines)
         }
     }
 
-    Box2i dw     = this->header ().dataWindow ();
-    this->_height = std::min (dw.size ().y + 1, this->_numScanLines);
-    this->_width  = dw.size ().x + 1;
-    this->_buffer = new int16_t[this->_num_comps * this->_width * this->_height];
+    if (irreversible && !(this->_qstep > 0.f))
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Invalid HT compression level " << this->_qstep
+                                            << ", must be positive.");
+    }
+
+    /* optional coding parameters, see ImfStandardAttributes.h */
+
+    if (hasHtDecompositionLevels (hdr))
+    {
+        int levels = htDecompositionLevels (hdr);
+
+        if (levels < 0 || levels > 32)
+        {
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Invalid htDecompositionLevels " << levels
+                                                 << ", must be in [0, 32].");
+        }
+
+        this->_numDecompositions = static_cast<ojph::ui32> (levels);
+    }
+
+    if (hasHtCodeBlockSize (hdr))
+    {
+        const IMATH_NAMESPACE::V2i& size = htCodeBlockSize (hdr);
+
+        if (!isPowerOfTwo (size.x, 4, 1024) ||
+            !isPowerOfTwo (size.y, 4, 1024) || size.x * size.y > 4096)
+        {
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Invalid htCodeBlockSize " << size.x << "x" << size.y
+                                           << ", dimensions must be powers "
+                                              "of 2 in [4, 1024] with an "
+                                              "area of at most 4096.");
+        }
+
+        this->_blockSize = ojph::size (size.x, size.y);
+    }
+
+    if (hasHtProgressionOrder (hdr))
+    {
+        const std::string& order = htProgressionOrder (hdr);
+
+        if (order != "LRCP" && order != "RLCP" && order != "RPCL" &&
+            order != "PCRL" && order != "CPRL")
+        {
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Invalid htProgressionOrder \"" << order << "\".");
+        }
+
+        this->_progressionOrder = order;
+    }
+
+    if (hasHtPrecinctSize (hdr))
+    {
+        const IMATH_NAMESPACE::V2i& size = htPrecinctSize (hdr);
+
+        if (!isPowerOfTwo (size.x, 2, 32768) ||
+            !isPowerOfTwo (size.y, 2, 32768))
+        {
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Invalid htPrecinctSize " << size.x << "x" << size.y
+                                          << ", dimensions must be powers "
+                                             "of 2 of at least 2.");
+        }
+
+        this->_precinctSize = ojph::size (size.x, size.y);
+    }
 }
 
 HTCompressor::~HTCompressor ()
 {
-    delete[] this->_buffer;
+}
+
+ojph::codestream&
+HTCompressor::setCodingStyle (ojph::codestream& cs) const
+{
+    ojph::param_cod cod = cs.access_cod ();
+
+    cod.set_color_transform (this->_isRGB);
+    cod.set_reversible (!this->_irreversible);
+    cod.set_block_dims (this->_blockSize.w, this->_blockSize.h);
+    cod.set_num_decomposition (this->_numDecompositions);
+    cod.set_progression_order (this->_progressionOrder.c_str ());
+
+    if (this->_precinctSize.w != 0)
+    {
+        std::vector<ojph::size> precincts (
+            this->_numDecompositions + 1, this->_precinctSize);
+
+        cod.set_precinct_size (
+            static_cast<int> (precincts.size ()), precincts.data ());
+    }
+
+    if (this->_irreversible)
+    {
+        //
+        // Samples are normalized by their bit depth, and FLOAT has
+        // 13 more mantissa bits than HALF.
+        //
+
+        ojph::param_qcd qcd = cs.access_qcd ();
+
+        qcd.set_irrev_quant (this->_qstep / 65536.f);
+        for (int c = 0; c < this->_num_comps; ++c)
+        {
+            if (this->_channels[this->_cs_to_file_ch[c]].type == FLOAT)
+                qcd.set_irrev_quant (
+                    static_cast<ojph::ui32> (c), this->_qstep / 524288.f);
+        }
+    }
+
+    return cs;
+}
+
+void
+HTCompressor::initializeFuncs ()
+{
+    CpuId cpuId;
+
+#ifdef IMF_HAVE_SSE2
+    if (cpuId.sse2)
+    {
+        packHalfLine   = packHalfLine_sse2;
+        unpackHalfLine = unpackHalfLine_sse2;
+    }
+#endif
+
+#ifdef IMF_HAVE_NEON_AARCH64
+    packHalfLine   = packHalfLine_neon;
+    unpackHalfLine = unpackHalfLine_neon;
+#endif
 }
 
 int
@@ -122,138 +909,393 @@ HTCompressor::format () const
     return Compressor::Format::NATIVE;
 }
 
+//
+// Record where each line of each channel starts in a chunk of
+// height scan lines starting at minY, and return the chunk size.
+//
+
+size_t
+HTCompressor::lineOffsets (int minY, int height)
+{
+    size_t offset = 0;
+
+    for (int i = 0; i < this->_num_comps; ++i)
+        this->_lineOffsets[i].clear ();
+
+    for (int y = minY; y < minY + height; ++y)
+    {
+        for (int i = 0; i < this->_num_comps; ++i)
+        {
+            const Channel& ch = this->_channels[i];
+
+            if (modp (y, ch.ySampling) != 0) continue;
+
+            this->_lineOffsets[i].push_back (offset);
+            offset += ch.width * pixelTypeSize (ch.type);
+        }
+    }
+
+    return offset;
+}
+
 int
 HTCompressor::compress (
     const char* inPtr, int inSize, int minY, const char*& outPtr)
 {
     Box2i      dw     = this->header ().dataWindow ();
-    ojph::ui32 height = std::min (dw.size ().y + 1 - minY, this->_numScanLines);
+    ojph::ui32 height = std::min (dw.max.y - minY + 1, this->_numScanLines);
     ojph::ui32 width  = dw.size ().x + 1;
 
     assert(this->_width == width);
     assert(this->_height >= height);
 
-    ojph::codestream  cs;
-    cs.set_planar (false);
+    size_t chunkSize = lineOffsets (minY, height);
 
-    ojph::param_siz siz = cs.access_siz ();
+    assert (inSize == static_cast<int> (chunkSize));
 
-    siz.set_num_components (this->_num_comps);
-    for (ojph::ui32 c = 0; c < this->_num_comps; c++)
-        siz.set_component (c, ojph::point (1, 1), 16, true);
+    //
+    // Only HT_STRIPED_COMPRESSION splits a chunk; otherwise the whole
+    // chunk is a single stripe.
+    //
 
-    /* TODO: extend to multiple tiles and non-coincident data and display windows */
-    siz.set_image_offset (ojph::point (0, 0));
-    siz.set_tile_offset (ojph::point (0, 0));
-    siz.set_image_extent (ojph::point (width, height));
-    siz.set_tile_size (ojph::size (width, height));
+    int stripeLines =
+        this->_striped ? STRIPE_LINES : static_cast<int> (height);
+    int numStripes = (height + stripeLines - 1) / stripeLines;
 
-    ojph::param_cod cod = cs.access_cod ();
+    while (this->_coders.size () < static_cast<size_t> (numStripes))
+        this->_coders.emplace_back (new StripeCoder);
 
-    cod.set_color_transform (this->_isRGB);
-    cod.set_reversible (true);
-    cod.set_block_dims (128, 32);
-    cod.set_num_decomposition (5);
+    //
+    // Collect the components of each stripe before starting any
+    // threads; J2K components can not be empty.
+    //
+
+    std::vector<std::vector<Component>> comps (numStripes);
+
+    for (int s = 0; s < numStripes; ++s)
+    {
+        int y0 = minY + s * stripeLines;
+        int y1 = std::min<int> (y0 + stripeLines, minY + height);
 
-    this->_output.close ();
-    this->_output.open ();
+        for (int c = 0; c < this->_num_comps; ++c)
+        {
+            int            i  = this->_cs_to_file_ch[c];
+            const Channel& ch = this->_channels[i];
+
+            Component comp = stripeComponent (
+                ch.type,
+                ch.xSampling,
+                ch.ySampling,
+                ch.width,
+                this->_lineOffsets[i],
+                minY,
+                y0,
+                y1);
+
+            if (comp.height == 0)
+            {
+                throw IEX_NAMESPACE::ArgExc (
+                    "Cannot compress a chunk with HT: a channel has no "
+                    "samples in some of its scan lines.");
+            }
 
-    cs.write_headers (&this->_output);
+            comps[s].push_back (comp);
+        }
+    }
+
+    //
+    // Each stripe is coded straight into its own slot of the chunk
+    // buffer, as large as the uncompressed stripe.  The slots are
+    // closed up afterwards.
+    //
 
-    assert (
-        inSize == (this->_num_comps * pixelTypeSize (HALF) * height * width));
+    size_t headerSize =
+        this->_striped ? (2 + numStripes) * Xdr::size<unsigned int> () : 0;
 
-    const int16_t*  pixels      = (const int16_t*) inPtr;
-    const int16_t*  line_pixels = pixels;
-    ojph::ui32      next_comp   = 0;
-    ojph::line_buf* cur_line    = cs.exchange (NULL, next_comp);
+    std::vector<size_t> slots (numStripes + 1, headerSize);
 
-    for (ojph::ui32 i = 0; i < height; ++i)
+    for (int s = 0; s < numStripes; ++s)
     {
-        const char* in_buf;
+        slots[s + 1] = slots[s];
 
-        for (ojph::ui32 c = 0; c < this->_num_comps; c++)
+        for (size_t c = 0; c < comps[s].size (); ++c)
         {
-            assert (next_comp == c);
+            slots[s + 1] += static_cast<size_t> (comps[s][c].height) *
+                            comps[s][c].width * pixelTypeSize (comps[s][c].type);
+        }
+    }
 
-            const int16_t* channel_pixels =
-                line_pixels + width * this->_cs_to_file_ch[c];
+    this->_outBuffer.resize (slots[numStripes]);
 
-            for (uint32_t p = 0; p < width; p++)
-            {
-                ojph::si32 c = static_cast<const ojph::si32> (*channel_pixels++);
+    std::vector<size_t> sizes (numStripes);
+    std::atomic<bool>   overflow (false);
 
-                cur_line->i32[p] = c < 0 ? -32769 - c : c;
-            }
+    runStripes (numStripes, [&] (int s) {
+        int          y0 = s * stripeLines;
+        ChunkOutfile output (
+            this->_outBuffer.data () + slots[s], slots[s + 1] - slots[s]);
 
-            cur_line = cs.exchange (cur_line, next_comp);
-        }
+        encodeStripe (
+            inPtr,
+            comps[s],
+            width,
+            std::min<ojph::ui32> (stripeLines, height - y0),
+            this->_isSubsampled ? minY + y0 - dw.min.y : 0,
+            this->_isSubsampled,
+            this->setCodingStyle (this->_coders[s]->resetCodestream ()),
+            output);
+
+        sizes[s] = output.pos;
+        if (output.overflow) overflow = true;
+    });
+
+    if (overflow)
+    {
+        //
+        // The caller stores chunks that do not shrink uncompressed.
+        //
 
-        line_pixels += width * this->_num_comps;
+        outPtr = inPtr;
+        return inSize;
     }
 
-    cs.flush ();
+    char* outEnd = this->_outBuffer.data ();
 
-    assert (this->_output.tell () >= 0);
+    if (this->_striped)
+    {
+        Xdr::write<CharPtrIO> (outEnd, static_cast<unsigned int> (numStripes));
+        Xdr::write<CharPtrIO> (
+            outEnd, static_cast<unsigned int> (stripeLines));
 
-    outPtr = reinterpret_cast<const char*> (this->_output.get_data ());
+        for (int s = 0; s < numStripes; ++s)
+            Xdr::write<CharPtrIO> (outEnd, static_cast<unsigned int> (sizes[s]));
+    }
 
-    return static_cast<int> (this->_output.tell ());
+    for (int s = 0; s < numStripes; ++s)
+    {
+        char* stripe = this->_outBuffer.data () + slots[s];
+
+        if (outEnd != stripe) memmove (outEnd, stripe, sizes[s]);
+        outEnd += sizes[s];
+    }
+
+    outPtr = this->_outBuffer.data ();
+
+    return static_cast<int> (outEnd - this->_outBuffer.data ());
 }
 
 int
 HTCompressor::uncompress (
     const char* inPtr, int inSize, int minY, const char*& outPtr)
 {
-    ojph::mem_infile infile;
-    infile.open (reinterpret_cast<const ojph::ui8*> (inPtr), inSize);
+    int lineMin = minY;
+    int lineMax = minY + this->_height - 1;
 
-    ojph::codestream  cs;
-    cs.read_headers (&infile);
+    return uncompressLines (inPtr, inSize, minY, lineMin, lineMax, outPtr);
+}
 
-    ojph::param_siz siz = cs.access_siz ();
-    ojph::ui32 width    = siz.get_image_extent ().x - siz.get_image_offset ().x;
-    ojph::ui32 height   = siz.get_image_extent ().y - siz.get_image_offset ().y;
+int
+HTCompressor::uncompressLines (
+    const char*  inPtr,
+    int          inSize,
+    int          minY,
+    int&         lineMin,
+    int&         lineMax,
+    const char*& outPtr)
+{
+    Box2i      dw     = this->header ().dataWindow ();
+    ojph::ui32 height = std::min<ojph::ui32> (dw.max.y - minY + 1, this->_height);
 
-    assert (this->_width >= width);
-    assert (this->_height >= height);
-    assert (this->_num_comps == siz.get_num_components ());
+    size_t chunkSize = lineOffsets (minY, height);
 
-    cs.set_planar (false);
+    this->_buffer.resize (chunkSize);
 
-    cs.create ();
+    std::vector<const char*> stripeData;
+    std::vector<size_t>      stripeSize;
+    ojph::ui32               stripeLines =
+        splitStripes (
+            inPtr, inSize, height, this->_striped, stripeData, stripeSize);
+
+    //
+    // Decode only the stripes that overlap the requested lines.
+    //
+
+    int stripeHeight = static_cast<int> (stripeLines);
+    int numStripes   = static_cast<int> (stripeData.size ());
+    int first        = std::max (lineMin - minY, 0) / stripeHeight;
+    int last         = std::min (
+        std::max (lineMax - minY, 0) / stripeHeight, numStripes - 1);
 
-    assert (sizeof (int16_t) == pixelTypeSize (HALF));
-    int16_t* line_pixels = this->_buffer;
+    first = std::min (first, last);
 
-    for (uint32_t i = 0; i < height; ++i)
+    std::vector<std::vector<Component>> comps (last - first + 1);
+
+    for (int s = first; s <= last; ++s)
     {
+        int y0 = minY + s * stripeHeight;
+        int y1 = std::min<int> (y0 + stripeHeight, minY + height);
 
-        for (uint32_t c = 0; c < this->_num_comps; c++)
+        for (int c = 0; c < this->_num_comps; ++c)
         {
-            ojph::ui32      next_comp = 0;
-            ojph::line_buf* cur_line  = cs.pull (next_comp);
+            int            i  = this->_cs_to_file_ch[c];
+            const Channel& ch = this->_channels[i];
+
+            comps[s - first].push_back (stripeComponent (
+                ch.type,
+                ch.xSampling,
+                ch.ySampling,
+                ch.width,
+                this->_lineOffsets[i],
+                minY,
+                y0,
+                y1));
+        }
+    }
 
-            assert (next_comp == c);
+    while (this->_coders.size () < static_cast<size_t> (last - first + 1))
+        this->_coders.emplace_back (new StripeCoder);
 
-            int16_t* channel_pixels = line_pixels + width * this->_cs_to_file_ch[c];
+    runStripes (last - first + 1, [&] (int i) {
+        decodeStripe (
+            stripeData[first + i],
+            stripeSize[first + i],
+            this->_buffer.data (),
+            comps[i],
+            this->_width,
+            0,
+            this->_isSubsampled,
+            this->_coders[i]->resetCodestream ());
+    });
 
-            for (uint32_t p = 0; p < width; p++)
-            {
-                ojph::si32 c = cur_line->i32[p];
+    lineMin = minY + first * stripeHeight;
+    lineMax = minY + std::min<int> ((last + 1) * stripeHeight, height) - 1;
 
-                *channel_pixels++ = (int16_t) (c < 0 ? -32769 - c : c);
-            }
-        }
+    outPtr = this->_buffer.data ();
 
-        line_pixels += width * this->_num_comps;
+    return static_cast<int> (chunkSize);
+}
+
+int
+HTCompressor::reducedSize (int size, int level)
+{
+    return static_cast<int> (
+        (static_cast<int64_t> (size) + (int64_t (1) << level) - 1) >> level);
+}
+
+int
+HTCompressor::uncompressReduced (
+    const char*  inPtr,
+    int          inSize,
+    int          minY,
+    int          level,
+    const char*& outPtr)
+{
+    if (level < 0 || level > MAX_REDUCTION_LEVEL)
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Invalid HT resolution level " << level << ", must be in [0, "
+                                           << MAX_REDUCTION_LEVEL << "].");
     }
 
-    infile.close();
+    if (this->_isSubsampled)
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Cannot decode subsampled channels at a reduced resolution.");
+    }
+
+    Box2i      dw     = this->header ().dataWindow ();
+    ojph::ui32 height = std::min<ojph::ui32> (dw.max.y - minY + 1, this->_height);
+
+    std::vector<const char*> stripeData;
+    std::vector<size_t>      stripeSize;
+    ojph::ui32               stripeLines =
+        splitStripes (
+            inPtr, inSize, height, this->_striped, stripeData, stripeSize);
+
+    //
+    // Each stripe shrinks to ceil (lines / 2^level) lines, so all but
+    // the last must have a multiple of 2^level lines for the reduced
+    // stripes to tile the reduced chunk.
+    //
+
+    int numStripes = static_cast<int> (stripeData.size ());
+
+    if (numStripes > 1 && stripeLines % (1u << level) != 0)
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Cannot decode HT stripes of " << stripeLines
+                                           << " scan lines at resolution "
+                                              "level "
+                                           << level << ".");
+    }
+
+    //
+    // The reduced chunk holds, for each line, the samples of each
+    // channel in file order.
+    //
+
+    int    rw       = reducedSize (this->_width, level);
+    int    rh       = reducedSize (height, level);
+    size_t lineSize = 0;
+
+    for (int i = 0; i < this->_num_comps; ++i)
+        lineSize += rw * pixelTypeSize (this->_channels[i].type);
+
+    for (int i = 0, offset = 0; i < this->_num_comps; ++i)
+    {
+        this->_lineOffsets[i].resize (rh);
+
+        for (int y = 0; y < rh; ++y)
+            this->_lineOffsets[i][y] = y * lineSize + offset;
+
+        offset += rw * pixelTypeSize (this->_channels[i].type);
+    }
+
+    this->_buffer.resize (lineSize * rh);
+
+    std::vector<std::vector<Component>> comps (numStripes);
+
+    for (int s = 0; s < numStripes; ++s)
+    {
+        int y0 = s * (stripeLines >> level);
+        int y1 = std::min (y0 + reducedSize (stripeLines, level), rh);
+
+        for (int c = 0; c < this->_num_comps; ++c)
+        {
+            int i = this->_cs_to_file_ch[c];
+
+            comps[s].push_back (stripeComponent (
+                this->_channels[i].type,
+                1,
+                1,
+                rw,
+                this->_lineOffsets[i],
+                0,
+                y0,
+                y1));
+        }
+    }
+
+    while (this->_coders.size () < static_cast<size_t> (numStripes))
+        this->_coders.emplace_back (new StripeCoder);
+
+    runStripes (numStripes, [&] (int s) {
+        decodeStripe (
+            stripeData[s],
+            stripeSize[s],
+            this->_buffer.data (),
+            comps[s],
+            this->_width,
+            static_cast<ojph::ui32> (level),
+            false,
+            this->_coders[s]->resetCodestream ());
+    });
 
-    outPtr = (const char*) this->_buffer;
+    outPtr = this->_buffer.data ();
 
-    return this->_num_comps * pixelTypeSize (HALF) * width * height;
+    return static_cast<int> (this->_buffer.size ());
 }
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
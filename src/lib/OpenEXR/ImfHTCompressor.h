@@ -10,13 +10,40 @@
 //
 //	class HTCompressor -- uses High-Throughput JPEG 2000.
 //
+//	HT_COMPRESSION, HT256_COMPRESSION and HT_LOSSY_COMPRESSION chunks
+//	hold a single codestream.  HT_STRIPED_COMPRESSION chunks are split
+//	into horizontal stripes, each coded as an independent codestream,
+//	so that a single chunk can be encoded and decoded by several
+//	threads of the global thread pool, and so that reading a few scan
+//	lines only decodes the stripes that contain them.
+//
+//	HALF channels are coded as 16-bit components, FLOAT and UINT
+//	channels as 32-bit components, and channel x and y sampling
+//	rates become J2K component subsampling factors.
+//
+//	The number of decomposition levels, code block size, progression
+//	order and precinct size can be set with the htDecompositionLevels,
+//	htCodeBlockSize, htProgressionOrder and htPrecinctSize attributes.
+//
+//	The irreversible variant, used for HT_LOSSY_COMPRESSION, quantizes
+//	the wavelet coefficients with a step set by htCompressionLevel ()
+//	in the header.  Decoding needs no extra information, since the
+//	codestream says whether it is reversible.
+//
+//	uncompressReduced () decodes a chunk at 1/2, 1/4 ... 1/32 of its
+//	resolution from the lower wavelet levels alone, which is much
+//	cheaper than decoding it in full and filtering it down.
+//
 //-----------------------------------------------------------------------------
 
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "ImfNamespace.h"
 
 #include "ImfCompressor.h"
+#include "ImfPixelType.h"
 
 #include <ojph_codestream.h>
 #include <ojph_file.h>
@@ -26,7 +53,11 @@ OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 class HTCompressor : public Compressor
 {
 public:
-    HTCompressor (const Header& hdr, int numScanLines = 0);
+    HTCompressor (
+        const Header& hdr,
+        int           numScanLines = 0,
+        bool          irreversible = false,
+        bool          striped      = false);
 
     virtual ~HTCompressor ();
 
@@ -45,15 +76,72 @@ public:
     virtual int
     uncompress (const char* inPtr, int inSize, int minY, const char*& outPtr);
 
+    virtual int uncompressLines (
+        const char*  inPtr,
+        int          inSize,
+        int          minY,
+        int&         lineMin,
+        int&         lineMax,
+        const char*& outPtr);
+
+    //
+    // Decode a chunk at 1 / 2^level of its width and height, where
+    // level is at most MAX_REDUCTION_LEVEL and at most the number of
+    // decomposition levels of the codestreams.  The output holds,
+    // for each reduced scan line, reducedSize (width, level) samples
+    // of each channel in file order.  Subsampled channels are not
+    // supported.
+    //
+
+    static const int MAX_REDUCTION_LEVEL = 5;
+
+    int uncompressReduced (
+        const char*  inPtr,
+        int          inSize,
+        int          minY,
+        int          level,
+        const char*& outPtr);
+
+    static int reducedSize (int size, int level);
+
+    static void initializeFuncs ();
+
 private:
+    struct Channel
+    {
+        PixelType type;
+        int       xSampling;
+        int       ySampling;
+        int       width; /* samples per scan line */
+    };
+
+    size_t lineOffsets (int minY, int height);
+
+    ojph::codestream& setCodingStyle (ojph::codestream& cs) const;
+
     ojph::ui32                 _width;
     ojph::ui32                 _height;
-    ojph::mem_outfile          _output;
     int                        _num_comps;
-    int16_t*                   _buffer;
+    std::vector<char>          _buffer;
     int                        _numScanLines;
+    std::vector<Channel>       _channels;         /* in file order */
     std::vector<int>           _cs_to_file_ch;    /* maps from codestream channel to file channel */
     bool                       _isRGB;
+    bool                       _isSubsampled;     /* some channel has x or y sampling > 1 */
+    ojph::ui32                 _numDecompositions;
+    ojph::size                 _blockSize;        /* code block width and height */
+    std::string                _progressionOrder;
+    ojph::size                 _precinctSize;     /* 0x0 for maximal precincts */
+    bool                       _irreversible;     /* 9/7 wavelet and quantization */
+    bool                       _striped;          /* chunks are split into stripes */
+    float                      _qstep;            /* in HALF units in the last place */
+
+    std::vector<std::vector<size_t>> _lineOffsets; /* per file channel, offset of each line in a chunk */
+
+    struct StripeCoder;
+
+    std::vector<std::unique_ptr<StripeCoder>> _coders; /* one per stripe, reused across chunks */
+    std::vector<char>          _outBuffer;        /* compressed chunk, coded in place */
 };
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
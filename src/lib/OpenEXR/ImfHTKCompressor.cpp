@@ -10,6 +10,7 @@
 //-----------------------------------------------------------------------------
 
 #include "ImfHTKCompressor.h"
+#include "Iex.h"
 #include "ImfAutoArray.h"
 #include "ImfChannelList.h"
 #include "ImfCheckedArithmetic.h"
@@ -71,9 +72,13 @@ HTKCompressor::HTKCompressor (const Header& hdr, int numScanLines)
     for (ChannelList::ConstIterator c = channels.begin (); c != channels.end ();
          ++c)
     {
-        assert (c.channel ().type == HALF);
-        assert (c.channel ().xSampling == 1);
-        assert (c.channel ().ySampling == 1);
+        if (c.channel ().type != HALF || c.channel ().xSampling != 1 ||
+            c.channel ().ySampling != 1)
+        {
+            throw IEX_NAMESPACE::ArgExc (
+                "HTK compression only supports HALF channels without "
+                "subsampling; use HT compression instead.");
+        }
 
         std::string name (c.name ());
 
@@ -181,7 +186,7 @@ HTKCompressor::compress (
 
     kdu_codestream codestream;
 
-    this->_output.close ();
+    this->_output.reset (inSize);
 
     // kdu_simple_file_target target("/tmp/out.j2c");
     // codestream.create (&siz, &target);
@@ -214,9 +219,16 @@ HTKCompressor::compress (
 
     compressor.finish();
 
-    outPtr = reinterpret_cast<const char*> (this->_output.get_buffer().data());
+    if (this->_output.overflowed ())
+    {
+        // the caller stores chunks that do not shrink uncompressed
+        outPtr = inPtr;
+        return inSize;
+    }
+
+    outPtr = reinterpret_cast<const char*> (this->_output.get_data ());
 
-    return static_cast<int> (this->_output.get_buffer().size());
+    return static_cast<int> (this->_output.size ());
 }
 
 int
@@ -12,6 +12,7 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <string.h>
 #include <vector>
 
 #include "ImfNamespace.h"
@@ -26,28 +27,46 @@ OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 
 using namespace kdu_supp;
 
+/* Writes a codestream into a buffer sized for the uncompressed chunk.
+   A codestream that does not fit would be stored uncompressed anyway,
+   so running out of room only sets overflowed(). */
+
 class mem_compressed_target : public kdu_compressed_target {
  public:
-  mem_compressed_target() {}
+  mem_compressed_target() : limit(0), pos(0), overflow(false) {}
 
-  bool close() {
-    this->buf.clear();
-    return true;
+  void reset(size_t capacity) {
+    if (this->buf.size() < capacity) this->buf.resize(capacity);
+    this->limit = capacity;
+    this->pos = 0;
+    this->overflow = false;
   }
 
+  bool close() { return true; }
+
   bool write(const kdu_byte* buf, int num_bytes) {
-    std::copy(buf, buf + num_bytes, std::back_inserter(this->buf));
+    if (this->overflow || static_cast<size_t>(num_bytes) > this->limit - this->pos) {
+      this->overflow = true;
+    } else {
+      memcpy(this->buf.data() + this->pos, buf, num_bytes);
+      this->pos += num_bytes;
+    }
     return true;
   }
 
-  void set_target_size(kdu_long num_bytes) { this->buf.reserve(num_bytes); }
+  bool prefer_large_writes() const { return true; }
+
+  const uint8_t* get_data() const { return this->buf.data(); }
 
-  bool prefer_large_writes() const { return false; }
+  size_t size() const { return this->pos; }
 
-  std::vector<uint8_t>& get_buffer() { return this->buf; }
+  bool overflowed() const { return this->overflow; }
 
  private:
   std::vector<uint8_t> buf;
+  size_t limit;
+  size_t pos;
+  bool overflow;
 };
 
 class HTKCompressor : public Compressor
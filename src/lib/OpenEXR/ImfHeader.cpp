@@ -22,6 +22,7 @@
 #include <ImfEnvmapAttribute.h>
 #include <ImfFloatAttribute.h>
 #include <ImfFloatVectorAttribute.h>
+#include <ImfHTCompressor.h>
 #include <ImfHeader.h>
 #include <ImfIDManifestAttribute.h>
 #include <ImfIntAttribute.h>
@@ -70,9 +71,11 @@ struct CompressionRecord
     {
         exr_get_default_zip_compression_level(&zip_level);
         exr_get_default_dwa_compression_quality(&dwa_level);
+        exr_get_default_ht_compression_quality(&ht_level);
     }
     int   zip_level;
     float dwa_level;
+    float ht_level;
 };
 // NB: This is extra complicated than one would normally write to
 // handle scenario that seems to happen on MacOS/Windows (probably
@@ -266,6 +269,12 @@ setDefaultDwaCompressionLevel (float level)
     exr_set_default_dwa_compression_quality (level);
 }
 
+void
+setDefaultHtCompressionLevel (float level)
+{
+    exr_set_default_ht_compression_quality (level);
+}
+
 Header::Header (
     int         width,
     int         height,
@@ -708,6 +717,18 @@ Header::dwaCompressionLevel () const
     return retrieveCompressionRecord (this).dwa_level;
 }
 
+float&
+Header::htCompressionLevel ()
+{
+    return retrieveCompressionRecord (this).ht_level;
+}
+
+float
+Header::htCompressionLevel () const
+{
+    return retrieveCompressionRecord (this).ht_level;
+}
+
 void
 Header::setName (const string& name)
 {
@@ -1091,7 +1112,13 @@ Header::sanityCheck (bool isTiled, bool isMultipartFile) const
     }
     else
     {
-        if (lineOrder != INCREASING_Y && lineOrder != DECREASING_Y)
+        //
+        // Flat scan line images may store their chunks in any order
+        // (see OutputFile::setOutOfOrderWrites()).
+        //
+
+        if (lineOrder != INCREASING_Y && lineOrder != DECREASING_Y &&
+            (isDeep || lineOrder != RANDOM_Y))
             throw IEX_NAMESPACE::ArgExc ("Invalid line order in image header.");
     }
 
@@ -1509,6 +1536,7 @@ staticInitialize ()
         //
 
         DwaCompressor::initializeFuncs ();
+        HTCompressor::initializeFuncs ();
         Zip::initializeFuncs ();
 
         initialized = true;
@@ -285,6 +285,10 @@ public:
     float& dwaCompressionLevel ();
     IMF_EXPORT
     float dwaCompressionLevel () const;
+    IMF_EXPORT
+    float& htCompressionLevel ();
+    IMF_EXPORT
+    float htCompressionLevel () const;
 
     //-----------------------------------------------------
     // Access to required attributes for multipart files
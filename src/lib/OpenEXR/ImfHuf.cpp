@@ -179,7 +179,10 @@ hufCanonicalCodeTable (uint64_t hcode[HUF_ENCSIZE])
         n[i] = 0;
 
     for (int i = 0; i < HUF_ENCSIZE; ++i)
-        n[hcode[i]] += 1;
+    {
+        // most entries are unused; counting them only stalls on n[0]
+        if (hcode[i] > 0) n[hcode[i]] += 1;
+    }
 
     //
     // For each i from 58 through 1, compute the
@@ -219,19 +222,55 @@ hufCanonicalCodeTable (uint64_t hcode[HUF_ENCSIZE])
 //	- original frequencies are destroyed;
 //	- encoding tables are used by hufEncode() and hufBuildDecTable();
 //
-// NB: The following code "(*a == *b) && (a > b))" was added to ensure
-//     elements in the heap with the same value are sorted by index.
-//     This is to ensure, the STL make_heap()/pop_heap()/push_heap() methods
-//     produced a resultant sorted heap that is identical across OSes.
+// The code must not depend on the platform, so ties between equal
+// frequencies are broken by symbol index: each node carries a key,
+// (frequency << HUF_KEYSHIFT) | index, and a node made by merging two
+// others takes the index of the second one. This gives the same
+// tree, and so the same code lengths, as repeatedly merging the two
+// smallest nodes of a heap ordered by those keys, so the output does
+// not change, but takes linear time once the leaves are sorted.
 //
 
-struct FHeapCompare
+const int      HUF_KEYSHIFT = HUF_ENCBITS + 1;
+const uint64_t HUF_KEYMASK  = (1 << HUF_KEYSHIFT) - 1;
+
+//
+// Sort n keys by frequency, keeping keys with equal frequencies in
+// index order. The keys are built in index order, so a stable LSD
+// radix sort over the bytes of the frequency is enough; only the
+// bytes the largest frequency uses get a pass.
+//
+
+uint64_t*
+hufSortKeys (uint64_t* keys, uint64_t* tmp, int n, uint64_t maxFreq)
 {
-    bool operator() (uint64_t* a, uint64_t* b)
+    int count[256];
+
+    for (int shift = HUF_KEYSHIFT; (maxFreq >> (shift - HUF_KEYSHIFT)) != 0;
+         shift += 8)
     {
-        return ((*a > *b) || ((*a == *b) && (a > b)));
+        memset (count, 0, sizeof (count));
+
+        for (int i = 0; i < n; ++i)
+            count[(keys[i] >> shift) & 0xff]++;
+
+        int sum = 0;
+
+        for (int b = 0; b < 256; ++b)
+        {
+            int c    = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+
+        for (int i = 0; i < n; ++i)
+            tmp[count[(keys[i] >> shift) & 0xff]++] = keys[i];
+
+        swap (keys, tmp);
     }
-};
+
+    return keys;
+}
 
 void
 hufBuildEncTable (
@@ -245,163 +284,136 @@ hufBuildEncTable (
     // that are to be Huffman-encoded.  (frq[i] contains the number
     // of occurrences of symbol i in the data.)
     //
-    // The loop below does three things:
-    //
-    // 1) Finds the minimum and maximum indices that point
-    //    to non-zero entries in frq:
+    // The loop below finds the minimum and maximum indices that
+    // point to non-zero entries in frq:
     //
     //     frq[im] != 0, and frq[i] == 0 for all i < im
     //     frq[iM] != 0, and frq[i] == 0 for all i > iM
     //
-    // 2) Fills array fHeap with pointers to all non-zero
-    //    entries in frq.
-    //
-    // 3) Initializes array hlink such that hlink[i] == i
-    //    for all array entries.
+    // and fills scode with the keys of all non-zero entries.
     //
 
-    AutoArray<int, HUF_ENCSIZE>       hlink;
-    AutoArray<uint64_t*, HUF_ENCSIZE> fHeap;
+    AutoArray<uint64_t, HUF_ENCSIZE> scode;
+    AutoArray<int, HUF_ENCSIZE>      sym;
+    AutoArray<int, HUF_ENCSIZE>      leafParent;
+
+    uint64_t maxFreq = 1;
+    int      nf      = 0;
 
     *im = 0;
 
     while (!frq[*im])
         (*im)++;
 
-    int nf = 0;
-
     for (int i = *im; i < HUF_ENCSIZE; i++)
     {
-        hlink[i] = i;
-
         if (frq[i])
         {
-            fHeap[nf] = &frq[i];
-            nf++;
-            *iM = i;
+            scode[nf++] = (frq[i] << HUF_KEYSHIFT) | i;
+            maxFreq     = max (maxFreq, frq[i]);
+            *iM         = i;
         }
     }
 
     //
-    // Add a pseudo-symbol, with a frequency count of 1, to frq;
-    // adjust the fHeap and hlink array accordingly.  Function
+    // Add a pseudo-symbol, with a frequency count of 1.  Function
     // hufEncode() uses the pseudo-symbol for run-length encoding.
     //
 
     (*iM)++;
-    frq[*iM]  = 1;
-    fHeap[nf] = &frq[*iM];
-    nf++;
+    scode[nf++] = (uint64_t (1) << HUF_KEYSHIFT) | *iM;
 
     //
-    // Build an array, scode, such that scode[i] contains the number
-    // of bits assigned to symbol i.  Conceptually this is done by
-    // constructing a tree whose leaves are the symbols with non-zero
-    // frequency:
-    //
-    //     Make a heap that contains all symbols with a non-zero frequency,
-    //     with the least frequent symbol on top.
-    //
-    //     Repeat until only one symbol is left on the heap:
-    //
-    //         Take the two least frequent symbols off the top of the heap.
-    //         Create a new node that has first two nodes as children, and
-    //         whose frequency is the sum of the frequencies of the first
-    //         two nodes.  Put the new node back into the heap.
-    //
-    // The last node left on the heap is the root of the tree.  For each
-    // leaf node, the distance between the root and the leaf is the length
-    // of the code for the corresponding symbol.
+    // Sort the leaves, using frq as scratch space; the frequencies
+    // are all in the keys now.
     //
-    // The loop below doesn't actually build the tree; instead we compute
-    // the distances of the leaves from the root on the fly.  When a new
-    // node is added to the heap, then that node's descendants are linked
-    // into a single linear list that starts at the new node, and the code
-    // lengths of the descendants (that is, their distance from the root
-    // of the tree) are incremented by one.
-    //
-
-    make_heap (&fHeap[0], &fHeap[nf], FHeapCompare ());
 
-    AutoArray<uint64_t, HUF_ENCSIZE> scode;
-    memset (scode, 0, sizeof (uint64_t) * HUF_ENCSIZE);
+    uint64_t* keys = hufSortKeys (scode, frq, nf, maxFreq);
 
-    while (nf > 1)
+    if (keys != scode)
     {
-        //
-        // Find the indices, mm and m, of the two smallest non-zero frq
-        // values in fHeap, add the smallest frq to the second-smallest
-        // frq, and remove the smallest frq value from fHeap.
-        //
+        memcpy (scode, keys, sizeof (uint64_t) * nf);
+        keys = scode;
+    }
 
-        int mm = fHeap[0] - frq;
-        pop_heap (&fHeap[0], &fHeap[nf], FHeapCompare ());
-        --nf;
+    for (int i = 0; i < nf; ++i)
+        sym[i] = int (keys[i] & HUF_KEYMASK);
 
-        int m = fHeap[0] - frq;
-        pop_heap (&fHeap[0], &fHeap[nf], FHeapCompare ());
+    //
+    // Build the tree in place (Moffat and Katajainen, "In-Place
+    // Calculation of Minimum-Redundancy Codes"). Leaves are taken
+    // from the front of keys, and internal nodes are stored behind
+    // them, in keys[0 .. next - 1], in the order they are made; the
+    // smallest unmerged node is always at the head of one of those
+    // two queues. A merged node's slot is reused for its parent's
+    // position, and each leaf's parent is kept in leafParent.
+    //
 
-        frq[m] += frq[mm];
-        push_heap (&fHeap[0], &fHeap[nf], FHeapCompare ());
+    leafParent[0] = 0;
+    leafParent[1] = 0;
+    keys[0]       = (((keys[0] >> HUF_KEYSHIFT) + (keys[1] >> HUF_KEYSHIFT))
+               << HUF_KEYSHIFT) |
+              (keys[1] & HUF_KEYMASK);
 
-        //
-        // The entries in scode are linked into lists with the
-        // entries in hlink serving as "next" pointers and with
-        // the end of a list marked by hlink[j] == j.
-        //
-        // Traverse the lists that start at scode[m] and scode[mm].
-        // For each element visited, increment the length of the
-        // corresponding code by one bit. (If we visit scode[j]
-        // during the traversal, then the code for symbol j becomes
-        // one bit longer.)
-        //
-        // Merge the lists that start at scode[m] and scode[mm]
-        // into a single list that starts at scode[m].
-        //
+    int root = 0;
+    int leaf = 2;
 
-        //
-        // Add a bit to all codes in the first list.
-        //
+    for (int next = 1; next < nf - 1; ++next)
+    {
+        uint64_t a, b;
 
-        for (int j = m; true; j = hlink[j])
+        if (leaf >= nf || keys[root] < keys[leaf])
         {
-            scode[j]++;
+            a            = keys[root];
+            keys[root++] = next;
+        }
+        else
+        {
+            a                  = keys[leaf];
+            leafParent[leaf++] = next;
+        }
 
-            assert (scode[j] <= 58);
+        if (leaf >= nf || (root < next && keys[root] < keys[leaf]))
+        {
+            b            = keys[root];
+            keys[root++] = next;
+        }
+        else
+        {
+            b                  = keys[leaf];
+            leafParent[leaf++] = next;
+        }
 
-            if (hlink[j] == j)
-            {
-                //
-                // Merge the two lists.
-                //
+        keys[next] = (((a >> HUF_KEYSHIFT) + (b >> HUF_KEYSHIFT))
+                      << HUF_KEYSHIFT) |
+                     (b & HUF_KEYMASK);
+    }
 
-                hlink[j] = mm;
-                break;
-            }
-        }
+    //
+    // Turn the parent positions of the internal nodes into depths,
+    // from the root down, then give each leaf the depth below its
+    // parent. Those depths are the code lengths.
+    //
 
-        //
-        // Add a bit to all codes in the second list
-        //
+    keys[nf - 2] = 0;
 
-        for (int j = mm; true; j = hlink[j])
-        {
-            scode[j]++;
+    for (int i = nf - 3; i >= 0; --i)
+        keys[i] = keys[keys[i]] + 1;
 
-            assert (scode[j] <= 58);
+    memset (frq, 0, sizeof (uint64_t) * HUF_ENCSIZE);
 
-            if (hlink[j] == j) break;
-        }
+    for (int i = 0; i < nf; ++i)
+    {
+        frq[sym[i]] = keys[leafParent[i]] + 1;
+        assert (frq[sym[i]] <= 58);
     }
 
     //
     // Build a canonical Huffman code table, replacing the code
-    // lengths in scode with (code, code length) pairs.  Copy the
-    // code table from scode into frq.
+    // lengths in frq with (code, code length) pairs.
     //
 
-    hufCanonicalCodeTable (scode);
-    memcpy (frq, scode, sizeof (uint64_t) * HUF_ENCSIZE);
+    hufCanonicalCodeTable (frq);
 }
 
 //
@@ -665,10 +677,54 @@ hufFreeDecTable (HufDec* hdecod) // io: Decoding table
 // ENCODING
 //
 
+//
+// Codes are collected in a 64-bit accumulator and written out 32 bits
+// at a time, instead of testing for, and writing, each byte as soon as
+// it is complete. Only whole bytes are ever written, so the output
+// never runs past the end of the encoded data.
+//
+
+inline void
+writeBits (int nBits, uint64_t bits, uint64_t& c, int& lc, char*& out)
+{
+    //
+    // nBits must be at most 32; lc is less than 32 between calls
+    //
+
+    c = (c << nBits) | bits;
+    lc += nBits;
+
+    if (lc >= 32)
+    {
+        lc -= 32;
+
+        uint32_t      w = uint32_t (c >> lc);
+        unsigned char* b = (unsigned char*) out;
+
+        b[0] = (unsigned char) (w >> 24);
+        b[1] = (unsigned char) (w >> 16);
+        b[2] = (unsigned char) (w >> 8);
+        b[3] = (unsigned char) (w);
+        out += 4;
+    }
+}
+
 inline void
 outputCode (uint64_t code, uint64_t& c, int& lc, char*& out)
 {
-    outputBits (hufLength (code), hufCode (code), c, lc, out);
+    int len = hufLength (code);
+
+    if (len <= 32)
+        writeBits (len, hufCode (code), c, lc, out);
+    else
+    {
+        //
+        // Only very skewed histograms give codes this long
+        //
+
+        writeBits (len - 32, hufCode (code) >> 32, c, lc, out);
+        writeBits (32, hufCode (code) & 0xffffffff, c, lc, out);
+    }
 }
 
 inline void
@@ -692,7 +748,7 @@ sendCode (
     {
         outputCode (sCode, c, lc, out);
         outputCode (runCode, c, lc, out);
-        outputBits (8, runCount, c, lc, out);
+        writeBits (8, runCount, c, lc, out);
     }
     else
     {
@@ -717,6 +773,7 @@ int hufEncode                     // return: output size (in bits)
     int      lc       = 0; // number of valid bits in c (LSB)
     int      s        = in[0];
     int      cs       = 0;
+    uint64_t runCode  = hcode[rlc];
 
     //
     // Loop on input values
@@ -731,7 +788,10 @@ int hufEncode                     // return: output size (in bits)
         if (s == in[i] && cs < 255) { cs++; }
         else
         {
-            sendCode (hcode[s], cs, hcode[rlc], c, lc, out);
+            if (cs == 0)
+                outputCode (hcode[s], c, lc, out);
+            else
+                sendCode (hcode[s], cs, runCode, c, lc, out);
             cs = 0;
         }
 
@@ -742,7 +802,10 @@ int hufEncode                     // return: output size (in bits)
     // Send remaining code
     //
 
-    sendCode (hcode[s], cs, hcode[rlc], c, lc, out);
+    sendCode (hcode[s], cs, runCode, c, lc, out);
+
+    while (lc >= 8)
+        *out++ = (c >> (lc -= 8));
 
     if (lc) *out = (c << (8 - lc)) & 0xff;
 
@@ -925,7 +988,32 @@ countFrequencies (
     for (int i = 0; i < HUF_ENCSIZE; ++i)
         freq[i] = 0;
 
-    for (int i = 0; i < n; ++i)
+    if (n <= 0) return;
+
+    //
+    // PIZ data has long runs of equal values, and incrementing the
+    // same counter again and again waits on the previous increment
+    // every time. A block of 8 values that all equal the value before
+    // them is found with one 16-byte compare and counted with a
+    // single add.
+    //
+
+    ++freq[data[0]];
+
+    int i = 1;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        if (memcmp (data + i - 1, data + i, 8 * sizeof (unsigned short)) == 0)
+            freq[data[i]] += 8;
+        else
+        {
+            for (int k = 0; k < 8; ++k)
+                ++freq[data[i + k]];
+        }
+    }
+
+    for (; i < n; ++i)
         ++freq[data[i]];
 }
 
@@ -1064,4 +1152,178 @@ hufUncompress (
     }
 }
 
+//
+// Multi-stream layout: im, iM, tableLength, numStreams and a reserved
+// word, then the length in bits of each stream, the packed table,
+// and the streams, each starting on a byte boundary. Stream i codes
+// raw[nRaw * i / numStreams] up to raw[nRaw * (i + 1) / numStreams].
+//
+
+namespace
+{
+
+const int HUF_MAX_STREAMS = 8;
+
+inline int
+hufStreamStart (int nRaw, int i, int numStreams)
+{
+    return static_cast<int> (static_cast<int64_t> (nRaw) * i / numStreams);
+}
+
+} // namespace
+
+int
+hufCompressStreams (
+    const unsigned short raw[], int nRaw, int numStreams, char compressed[])
+{
+    if (nRaw == 0) return 0;
+
+    if (numStreams < 1 || numStreams > HUF_MAX_STREAMS)
+        throw ArgExc ("Invalid number of Huffman streams.");
+
+    numStreams = std::min (numStreams, nRaw);
+
+    AutoArray<uint64_t, HUF_ENCSIZE> freq;
+
+    countFrequencies (freq, raw, nRaw);
+
+    int im = 0;
+    int iM = 0;
+    hufBuildEncTable (freq, &im, &iM);
+
+    char* tableStart = compressed + 20 + 4 * numStreams;
+    char* tableEnd   = tableStart;
+    hufPackEncTable (freq, im, iM, &tableEnd);
+    int tableLength = tableEnd - tableStart;
+
+    char* dataStart = tableEnd;
+
+    for (int i = 0; i < numStreams; ++i)
+    {
+        int b     = hufStreamStart (nRaw, i, numStreams);
+        int e     = hufStreamStart (nRaw, i + 1, numStreams);
+        int nBits = hufEncode (freq, raw + b, e - b, iM, dataStart);
+
+        writeUInt (compressed + 20 + 4 * i, nBits);
+        dataStart += (nBits + 7) / 8;
+    }
+
+    writeUInt (compressed, im);
+    writeUInt (compressed + 4, iM);
+    writeUInt (compressed + 8, tableLength);
+    writeUInt (compressed + 12, numStreams);
+    writeUInt (compressed + 16, 0); // room for future extensions
+
+    return dataStart - compressed;
+}
+
+void
+hufUncompressStreams (
+    const char compressed[], int nCompressed, unsigned short raw[], int nRaw)
+{
+    //
+    // need at least 20 bytes for header
+    //
+    if (nCompressed < 20)
+    {
+        if (nRaw != 0) notEnoughData ();
+
+        return;
+    }
+
+    int im          = readUInt (compressed);
+    int iM          = readUInt (compressed + 4);
+    int tableLength = readUInt (compressed + 8);
+    int numStreams  = readUInt (compressed + 12);
+
+    if (im < 0 || im >= HUF_ENCSIZE || iM < 0 || iM >= HUF_ENCSIZE)
+        invalidTableSize ();
+
+    if (numStreams < 1 || numStreams > HUF_MAX_STREAMS || numStreams > nRaw)
+        throw InputExc ("Invalid number of Huffman streams.");
+
+    int hdrLength = 20 + 4 * numStreams;
+
+    if (tableLength < 0 || tableLength > nCompressed - hdrLength)
+        notEnoughData ();
+
+    const char*          ptr       = compressed + hdrLength;
+    const char*          dataStart = ptr + tableLength;
+    const unsigned char* src[HUF_MAX_STREAMS];
+    int                  nBits[HUF_MAX_STREAMS];
+    unsigned short*      dst[HUF_MAX_STREAMS];
+    int                  nDst[HUF_MAX_STREAMS];
+    uint64_t             nBytes = hdrLength + tableLength;
+    bool                 fast   = FastHufDecoder::enabled ();
+
+    for (int i = 0; i < numStreams; ++i)
+    {
+        int b = hufStreamStart (nRaw, i, numStreams);
+        int e = hufStreamStart (nRaw, i + 1, numStreams);
+
+        nBits[i] = readUInt (compressed + 20 + 4 * i);
+        if (nBits[i] < 0) invalidNBits ();
+
+        src[i]  = (const unsigned char*) compressed + nBytes;
+        dst[i]  = raw + b;
+        nDst[i] = e - b;
+        nBytes += (static_cast<uint64_t> (nBits[i]) + 7) / 8;
+
+        //
+        // Fast decoder needs at least 2x64-bits of compressed data
+        // in every stream
+        //
+
+        if (nBits[i] <= 128) fast = false;
+    }
+
+    if (nBytes > static_cast<uint64_t> (nCompressed))
+    {
+        notEnoughData ();
+        return;
+    }
+
+    if (fast)
+    {
+        FastHufDecoder fhd (ptr, nCompressed - hdrLength, im, iM, iM);
+
+        if (ptr > dataStart) invalidTableSize ();
+
+        fhd.decodeStreams (numStreams, src, nBits, dst, nDst);
+    }
+    else
+    {
+        AutoArray<uint64_t, HUF_ENCSIZE> freq;
+        AutoArray<HufDec, HUF_DECSIZE>   hdec;
+
+        hufClearDecTable (hdec);
+
+        hufUnpackEncTable (&ptr, tableLength, im, iM, freq);
+
+        try
+        {
+            hufBuildDecTable (freq, im, iM, hdec);
+
+            for (int i = 0; i < numStreams; ++i)
+            {
+                hufDecode (
+                    freq,
+                    hdec,
+                    (const char*) src[i],
+                    nBits[i],
+                    iM,
+                    nDst[i],
+                    dst[i]);
+            }
+        }
+        catch (...)
+        {
+            hufFreeDecTable (hdec);
+            throw;
+        }
+
+        hufFreeDecTable (hdec);
+    }
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
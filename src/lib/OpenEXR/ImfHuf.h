@@ -27,6 +27,18 @@
 //		Uncompresses the data in array c (with length nc),
 //		and stores the results in array r (with length nr).
 //
+//	hufCompressStreams (r, nr, ns, c)
+//
+//		Like hufCompress (), but splits r into ns (at most 8)
+//		consecutive runs of values, each coded as a separate
+//		bitstream with a shared table, so that the streams
+//		can be decoded side by side. The size of array c
+//		should be at least 2 * nr + 65536 + 5 * ns.
+//
+//	hufUncompressStreams (c, nc, r, nr)
+//
+//		Uncompresses data written by hufCompressStreams ().
+//
 //-----------------------------------------------------------------------------
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
@@ -44,6 +56,20 @@ void hufUncompress (
     unsigned short raw[/*nRaw*/],
     int            nRaw);
 
+IMF_EXPORT
+int hufCompressStreams (
+    const unsigned short raw[/*nRaw*/],
+    int                  nRaw,
+    int                  numStreams,
+    char                 compressed[/*2 * nRaw + 65536 + 5 * numStreams*/]);
+
+IMF_EXPORT
+void hufUncompressStreams (
+    const char     compressed[/*nCompressed*/],
+    int            nCompressed,
+    unsigned short raw[/*nRaw*/],
+    int            nRaw);
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
 
 #endif
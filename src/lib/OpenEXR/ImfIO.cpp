@@ -38,6 +38,19 @@ IStream::readMemoryMapped (int n)
                                    "on a file that is not memory mapped.");
 }
 
+bool
+IStream::isStatelessRead () const
+{
+    return false;
+}
+
+void
+IStream::readAt (uint64_t, char[], int)
+{
+    throw IEX_NAMESPACE::InputExc ("Attempt to perform a positional read "
+                                   "on a stream that does not support it.");
+}
+
 void
 IStream::clear ()
 {
@@ -89,6 +89,28 @@ public:
 
     IMF_EXPORT virtual void clear ();
 
+    //---------------------------------------------------------
+    // Positional reads:
+    //
+    // If isStatelessRead() returns true, readAt(pos,c,n) reads
+    // n bytes, starting pos bytes from the beginning of the
+    // file, and stores them in array c.  readAt() does not
+    // change the current reading position, and it is safe to
+    // call from several threads at once, and concurrently
+    // with read(), seekg() and tellg().  This lets the file
+    // readers fetch chunks from inside their worker tasks
+    // instead of one at a time under the stream's mutex.
+    // If there are less than n bytes at pos, or if an I/O
+    // error occurs, readAt() throws an exception.
+    //
+    // By default, isStatelessRead() returns false and
+    // readAt() throws an exception.
+    //---------------------------------------------------------
+
+    IMF_EXPORT virtual bool isStatelessRead () const;
+
+    IMF_EXPORT virtual void readAt (uint64_t pos, char c[/*n*/], int n);
+
     //------------------------------------------------------
     // Get the name of the file associated with this stream.
     //------------------------------------------------------
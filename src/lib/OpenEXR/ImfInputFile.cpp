@@ -905,6 +905,64 @@ InputFile::readPixels (int scanLine)
     readPixels (scanLine, scanLine);
 }
 
+AsyncRead
+InputFile::readPixelsAsync (int scanLine1, int scanLine2)
+{
+    if (_data->compositor || _data->isTiled)
+    {
+        readPixels (scanLine1, scanLine2);
+        return AsyncRead ();
+    }
+
+    return _data->sFile->readPixelsAsync (scanLine1, scanLine2);
+}
+
+void
+InputFile::setReadAhead (int numChunks)
+{
+    if (!_data->compositor && !_data->isTiled)
+        _data->sFile->setReadAhead (numChunks);
+}
+
+int
+InputFile::readAhead () const
+{
+    if (!_data->compositor && !_data->isTiled)
+        return _data->sFile->readAhead ();
+
+    return 0;
+}
+
+void
+InputFile::readPixelsReduced (int level)
+{
+    try
+    {
+        if (_data->dsFile)
+        {
+            throw IEX_NAMESPACE::ArgExc ("Tried to read reduced resolution "
+                                         "pixels from a deep image.");
+        }
+
+        else if (_data->isTiled)
+        {
+            throw IEX_NAMESPACE::ArgExc ("Tried to read reduced resolution "
+                                         "pixels from a tiled image.");
+        }
+
+        _data->sFile->readPixelsReduced (level);
+    }
+    catch (IEX_NAMESPACE::BaseExc& e)
+    {
+        REPLACE_EXC (
+            e,
+            "Error reading pixel data from image "
+            "file \""
+                << fileName () << "\". " << e.what ());
+        throw;
+    }
+}
+
 void
 InputFile::rawPixelData (
     int firstScanLine, const char*& pixelData, int& pixelDataSize)
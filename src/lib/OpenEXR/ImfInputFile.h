@@ -15,6 +15,7 @@
 
 #include "ImfForward.h"
 
+#include "ImfAsyncRead.h"
 #include "ImfGenericInputFile.h"
 #include "ImfThreading.h"
 
@@ -154,6 +155,53 @@ public:
     IMF_EXPORT
     void readPixels (int scanLine);
 
+    //---------------------------------------------------------------
+    // Read pixel data asynchronously:
+    //
+    // readPixelsAsync(s1,s2) starts reading the same scan lines as
+    // readPixels(s1,s2), and returns an AsyncRead handle that waits
+    // for the read to finish.  The frame buffer must stay valid
+    // until then.  See ScanLineInputFile::readPixelsAsync() for
+    // details.
+    //
+    // Only scan line files are read in the background; for tiled
+    // and deep files readPixelsAsync() reads the scan lines before
+    // it returns.
+    //
+    //---------------------------------------------------------------
+
+    IMF_EXPORT
+    AsyncRead readPixelsAsync (int scanLine1, int scanLine2);
+
+    //---------------------------------------------------------------
+    // Read-ahead:
+    //
+    // setReadAhead(n) makes each read also prefetch the n chunks
+    // that follow the ones it read, see
+    // ScanLineInputFile::setReadAhead().  It has no effect on
+    // tiled and deep files.
+    //
+    //---------------------------------------------------------------
+
+    IMF_EXPORT
+    void setReadAhead (int numChunks);
+
+    IMF_EXPORT
+    int readAhead () const;
+
+    //---------------------------------------------------------------
+    // Read pixel data at a reduced resolution:
+    //
+    // readPixelsReduced(l) reads the whole image at 1 / 2^l of its
+    // width and height, for l in [0, 5], into the current frame
+    // buffer.  Only HT compressed scan line files without subsampled
+    // channels are supported; see ScanLineInputFile for details.
+    //
+    //---------------------------------------------------------------
+
+    IMF_EXPORT
+    void readPixelsReduced (int level);
+
     //----------------------------------------------
     // Read a block of raw pixel data from the file,
     // without uncompressing it (this function is
@@ -22,8 +22,8 @@ enum IMF_EXPORT_ENUM LineOrder
 
     DECREASING_Y = 1, // first scan line has highest y coordinate
 
-    RANDOM_Y = 2, // only for tiled files; tiles are written
-                  // in random order
+    RANDOM_Y = 2, // tiles, or the chunks of a flat scan line
+                  // file, are written in random order
 
     NUM_LINEORDERS // number of different line orders
 };
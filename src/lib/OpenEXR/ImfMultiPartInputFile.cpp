@@ -548,11 +548,14 @@ MultiPartInputFile::Data::chunkOffsetReconstruction (
             switch (parts[i]->header.compression ())
             {
                 case HT_COMPRESSION:
-                case HTK_COMPRESSION: rowsizes[i] = 16000; break;
+                case HTK_COMPRESSION:
+                case HT_STRIPED_COMPRESSION: rowsizes[i] = 16000; break;
                 case HT256_COMPRESSION:
                 case HTK256_COMPRESSION:
+                case HT_LOSSY_COMPRESSION:
                 case DWAB_COMPRESSION: rowsizes[i] = 256; break;
                 case PIZ_COMPRESSION:
+                case PIZ_MS_COMPRESSION:
                 case B44_COMPRESSION:
                 case B44A_COMPRESSION:
                 case DWAA_COMPRESSION: rowsizes[i] = 32; break;
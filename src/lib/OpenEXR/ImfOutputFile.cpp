@@ -162,6 +162,16 @@ struct OutputFile::Data
                                        // buffer holds
     size_t lineBufferSize;             // size of the line buffer
 
+    bool        outOfOrder;            // store chunks as they complete
+    LineBuffer* partialBuffer;         // partially full line buffer,
+                                       // in out-of-order mode
+    vector<LineBuffer*> doneBuffers;   // finished line buffers that
+                                       // have not been written yet
+    Semaphore           doneSemaphore; // counts doneBuffers
+#if ILMTHREAD_THREADING_ENABLED
+    std::mutex doneMutex;              // guards doneBuffers
+#endif
+
     int                partNumber; // the output part number
     OutputStreamMutex* _streamData;
     bool               _deleteStream;
@@ -180,6 +190,9 @@ struct OutputFile::Data
 
 OutputFile::Data::Data (int numThreads)
     : lineOffsetsPosition (0)
+    , outOfOrder (false)
+    , partialBuffer (0)
+    , doneSemaphore (0)
     , partNumber (-1)
     , _streamData (0)
     , _deleteStream (false)
@@ -244,8 +257,8 @@ writePixelData (
     if (currentPosition == 0) currentPosition = filedata->os->tellp ();
 
     partdata->lineOffsets
-        [(partdata->currentScanLine - partdata->minY) /
-         partdata->linesInBuffer] = currentPosition;
+        [(lineBufferMinY - partdata->minY) / partdata->linesInBuffer] =
+        currentPosition;
 
 #ifdef DEBUG
 
@@ -371,6 +384,7 @@ public:
         TaskGroup*        group,
         OutputFile::Data* ofd,
         int               number,
+        LineBuffer*       lineBuffer,
         int               scanLineMin,
         int               scanLineMax);
 
@@ -387,9 +401,10 @@ LineBufferTask::LineBufferTask (
     TaskGroup*        group,
     OutputFile::Data* ofd,
     int               number,
+    LineBuffer*       lineBuffer,
     int               scanLineMin,
     int               scanLineMax)
-    : Task (group), _ofd (ofd), _lineBuffer (_ofd->getLineBuffer (number))
+    : Task (group), _ofd (ofd), _lineBuffer (lineBuffer)
 {
     //
     // Wait for the lineBuffer to become available
@@ -424,6 +439,23 @@ LineBufferTask::~LineBufferTask ()
     //
 
     _lineBuffer->post ();
+
+    //
+    // In out-of-order mode, writePixels() waits for whichever
+    // line buffer finishes first, rather than for a particular one
+    //
+
+    if (_ofd->outOfOrder)
+    {
+        {
+#if ILMTHREAD_THREADING_ENABLED
+            std::lock_guard<std::mutex> lock (_ofd->doneMutex);
+#endif
+            _ofd->doneBuffers.push_back (_lineBuffer);
+        }
+
+        _ofd->doneSemaphore.post ();
+    }
 }
 
 void
@@ -438,7 +470,7 @@ LineBufferTask::execute ()
 
         int yStart, yStop, dy;
 
-        if (_ofd->lineOrder == INCREASING_Y)
+        if (_ofd->lineOrder != DECREASING_Y)
         {
             yStart = _lineBuffer->scanLineMin;
             yStop  = _lineBuffer->scanLineMax + 1;
@@ -613,6 +645,159 @@ LineBufferTask::execute ()
     }
 }
 
+void
+throwLineBufferException (OutputFile::Data* ofd)
+{
+    //
+    // LineBufferTask::execute() may have encountered exceptions, but
+    // those exceptions occurred in another thread, not in the thread
+    // that is executing this call to OutputFile::writePixels().
+    // LineBufferTask::execute() has caught all exceptions and stored
+    // the exceptions' what() strings in the line buffers.
+    // Now we check if any line buffer contains a stored exception; if
+    // this is the case then we re-throw the exception in this thread.
+    // (It is possible that multiple line buffers contain stored
+    // exceptions.  We re-throw the first exception we find and
+    // ignore all others.)
+    //
+
+    const string* exception = 0;
+
+    for (size_t i = 0; i < ofd->lineBuffers.size (); ++i)
+    {
+        LineBuffer* lineBuffer = ofd->lineBuffers[i];
+
+        if (lineBuffer->hasException && !exception)
+            exception = &lineBuffer->exception;
+
+        lineBuffer->hasException = false;
+    }
+
+    if (exception) throw IEX_NAMESPACE::IoExc (*exception);
+}
+
+void
+writePixelsOutOfOrder (OutputFile::Data* ofd, int numScanLines)
+{
+    //
+    // Compress each chunk in whichever line buffer is free, and store
+    // it in the file as soon as its task has finished, so that a chunk
+    // that is slow to compress does not hold up the ones after it.
+    // Only the last chunk of a call can be left partially full, in
+    // ofd->partialBuffer; the next call completes it.
+    //
+
+    if (numScanLines > ofd->missingScanLines)
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Tried to write more scan lines "
+            "than specified by the data window.");
+    }
+
+    if (numScanLines <= 0) return;
+
+    int step = (ofd->lineOrder != DECREASING_Y) ? 1 : -1;
+
+    int firstLine = ofd->currentScanLine;
+    int lastLine  = firstLine + step * (numScanLines - 1);
+
+    int scanLineMin = min (firstLine, lastLine);
+    int scanLineMax = max (firstLine, lastLine);
+
+    int next = (firstLine - ofd->minY) / ofd->linesInBuffer;
+    int stop = (lastLine - ofd->minY) / ofd->linesInBuffer + step;
+
+    vector<LineBuffer*> freeBuffers;
+
+    for (size_t i = 0; i < ofd->lineBuffers.size (); ++i)
+    {
+        if (ofd->lineBuffers[i] != ofd->partialBuffer)
+            freeBuffers.push_back (ofd->lineBuffers[i]);
+    }
+
+    //
+    // Forget line buffers left over from a call that threw
+    //
+
+    while (ofd->doneSemaphore.tryWait ())
+        ;
+
+    ofd->doneBuffers.clear ();
+
+    {
+        TaskGroup taskGroup;
+        int       numInFlight = 0;
+
+        while (next != stop || numInFlight > 0)
+        {
+            //
+            // Keep all free line buffers busy.  A partially
+            // full line buffer can only hold the first one.
+            //
+
+            while (next != stop &&
+                   (ofd->partialBuffer || !freeBuffers.empty ()))
+            {
+                LineBuffer* lineBuffer = ofd->partialBuffer;
+
+                if (lineBuffer)
+                    ofd->partialBuffer = 0;
+                else
+                {
+                    lineBuffer = freeBuffers.back ();
+                    freeBuffers.pop_back ();
+                }
+
+                ThreadPool::addGlobalTask (new LineBufferTask (
+                    &taskGroup,
+                    ofd,
+                    next,
+                    lineBuffer,
+                    scanLineMin,
+                    scanLineMax));
+
+                next += step;
+                ++numInFlight;
+            }
+
+            //
+            // Wait until some line buffer is ready to be written
+            //
+
+            ofd->doneSemaphore.wait ();
+
+            LineBuffer* writeBuffer;
+
+            {
+#if ILMTHREAD_THREADING_ENABLED
+                std::lock_guard<std::mutex> lock (ofd->doneMutex);
+#endif
+                writeBuffer = ofd->doneBuffers.back ();
+                ofd->doneBuffers.pop_back ();
+            }
+
+            --numInFlight;
+
+            int numLines =
+                writeBuffer->scanLineMax - writeBuffer->scanLineMin + 1;
+
+            ofd->missingScanLines -= numLines;
+            ofd->currentScanLine += step * numLines;
+
+            if (writeBuffer->partiallyFull)
+            {
+                ofd->partialBuffer = writeBuffer;
+                continue;
+            }
+
+            writePixelData (ofd->_streamData, ofd, writeBuffer);
+            freeBuffers.push_back (writeBuffer);
+        }
+    }
+
+    throwLineBufferException (ofd);
+}
+
 } // namespace
 
 OutputFile::OutputFile (
@@ -776,7 +961,7 @@ OutputFile::initialize (const Header& header)
 
     const Box2i& dataWindow = header.dataWindow ();
 
-    _data->currentScanLine = (header.lineOrder () == INCREASING_Y)
+    _data->currentScanLine = (header.lineOrder () != DECREASING_Y)
                                  ? dataWindow.min.y
                                  : dataWindow.max.y;
 
@@ -995,6 +1180,12 @@ OutputFile::writePixels (int numScanLines)
             throw IEX_NAMESPACE::ArgExc (
                 "No frame buffer specified as pixel data source.");
 
+        if (_data->outOfOrder)
+        {
+            writePixelsOutOfOrder (_data, numScanLines);
+            return;
+        }
+
         //
         // Maintain two iterators:
         //     nextWriteBuffer: next linebuffer to be written to the file
@@ -1027,7 +1218,7 @@ OutputFile::writePixels (int numScanLines)
             // individual task might not do anything if numScanLines == 0.
             //
 
-            if (_data->lineOrder == INCREASING_Y)
+            if (_data->lineOrder != DECREASING_Y)
             {
                 int last = (_data->currentScanLine + (numScanLines - 1) -
                             _data->minY) /
@@ -1046,6 +1237,7 @@ OutputFile::writePixels (int numScanLines)
                         &taskGroup,
                         _data,
                         first + i,
+                        _data->getLineBuffer (first + i),
                         scanLineMin,
                         scanLineMax));
                 }
@@ -1073,6 +1265,7 @@ OutputFile::writePixels (int numScanLines)
                         &taskGroup,
                         _data,
                         first - i,
+                        _data->getLineBuffer (first - i),
                         scanLineMin,
                         scanLineMax));
                 }
@@ -1133,7 +1326,7 @@ OutputFile::writePixels (int numScanLines)
 
                 assert (
                     _data->currentScanLine ==
-                    ((_data->lineOrder == INCREASING_Y)
+                    ((_data->lineOrder != DECREASING_Y)
                          ? writeBuffer->scanLineMax + 1
                          : writeBuffer->scanLineMin - 1));
 
@@ -1166,6 +1359,7 @@ OutputFile::writePixels (int numScanLines)
                     &taskGroup,
                     _data,
                     nextCompressBuffer,
+                    _data->getLineBuffer (nextCompressBuffer),
                     scanLineMin,
                     scanLineMax));
 
@@ -1181,34 +1375,7 @@ OutputFile::writePixels (int numScanLines)
             //
         }
 
-        //
-        // Exception handling:
-        //
-        // LineBufferTask::execute() may have encountered exceptions, but
-        // those exceptions occurred in another thread, not in the thread
-        // that is executing this call to OutputFile::writePixels().
-        // LineBufferTask::execute() has caught all exceptions and stored
-        // the exceptions' what() strings in the line buffers.
-        // Now we check if any line buffer contains a stored exception; if
-        // this is the case then we re-throw the exception in this thread.
-        // (It is possible that multiple line buffers contain stored
-        // exceptions.  We re-throw the first exception we find and
-        // ignore all others.)
-        //
-
-        const string* exception = 0;
-
-        for (size_t i = 0; i < _data->lineBuffers.size (); ++i)
-        {
-            LineBuffer* lineBuffer = _data->lineBuffers[i];
-
-            if (lineBuffer->hasException && !exception)
-                exception = &lineBuffer->exception;
-
-            lineBuffer->hasException = false;
-        }
-
-        if (exception) throw IEX_NAMESPACE::IoExc (*exception);
+        throwLineBufferException (_data);
     }
     catch (IEX_NAMESPACE::BaseExc& e)
     {
@@ -1221,6 +1388,53 @@ OutputFile::writePixels (int numScanLines)
     }
 }
 
+void
+OutputFile::setOutOfOrderWrites (int numChunksInFlight)
+{
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (*_data->_streamData);
+#endif
+
+    if (_data->lineOrder != RANDOM_Y)
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Cannot enable out-of-order writes for image file \""
+                << fileName () << "\". Its header does not declare "
+                << "RANDOM_Y line order.");
+
+    if (_data->missingScanLines != _data->maxY - _data->minY + 1)
+        THROW (
+            IEX_NAMESPACE::LogicExc,
+            "Cannot enable out-of-order writes for image file \""
+                << fileName () << "\". The file already contains "
+                << "pixel data.");
+
+    size_t n = numChunksInFlight > 0 ? size_t (numChunksInFlight)
+                                     : _data->lineBuffers.size ();
+
+    if (n != _data->lineBuffers.size ())
+    {
+        size_t maxBytesPerLine = *std::max_element (
+            _data->bytesPerLine.begin (), _data->bytesPerLine.end ());
+
+        for (size_t i = n; i < _data->lineBuffers.size (); ++i)
+            delete _data->lineBuffers[i];
+
+        size_t oldSize = _data->lineBuffers.size ();
+        _data->lineBuffers.resize (n);
+
+        for (size_t i = oldSize; i < n; ++i)
+        {
+            _data->lineBuffers[i] = new LineBuffer (newCompressor (
+                _data->header.compression (), maxBytesPerLine, _data->header));
+
+            _data->lineBuffers[i]->buffer.resizeErase (_data->lineBufferSize);
+        }
+    }
+
+    _data->outOfOrder = true;
+}
+
 int
 OutputFile::currentScanLine () const
 {
@@ -1346,7 +1560,7 @@ OutputFile::copyPixels (InputFile& in)
             pixelData,
             pixelDataSize);
 
-        _data->currentScanLine += (_data->lineOrder == INCREASING_Y)
+        _data->currentScanLine += (_data->lineOrder != DECREASING_Y)
                                       ? _data->linesInBuffer
                                       : -_data->linesInBuffer;
 
@@ -119,6 +119,32 @@ public:
     IMF_EXPORT
     void writePixels (int numScanLines = 1);
 
+    //------------------------------------------------------------------
+    // Out-of-order writing:
+    //
+    // By default, writePixels() compresses up to 2 * numThreads chunks
+    // at a time, but stores them in the file strictly in line order,
+    // so a single chunk that is slow to compress holds up all threads
+    // that have finished later chunks.
+    //
+    // setOutOfOrderWrites(n) lets writePixels() compress up to n chunks
+    // at a time, and store each chunk as soon as it is done.  The line
+    // offset table records where every chunk ends up, so the file reads
+    // back normally.  As the chunks are not stored in y order, the
+    // file's header must declare RANDOM_Y line order, or an ArgExc is
+    // thrown; with RANDOM_Y, writePixels() still takes the scan lines
+    // in increasing y order.  n <= 0 keeps the default number of chunks
+    // in flight.
+    //
+    // Files with RANDOM_Y scan line order cannot be read by versions
+    // of the library older than this one.
+    //
+    // setOutOfOrderWrites() must be called before writePixels().
+    //------------------------------------------------------------------
+
+    IMF_EXPORT
+    void setOutOfOrderWrites (int numChunksInFlight = 0);
+
     //------------------------------------------------------------------
     // Access to the current scan line:
     //
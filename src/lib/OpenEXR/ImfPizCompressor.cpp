@@ -30,6 +30,7 @@ OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 
 using IEX_NAMESPACE::InputExc;
 using IMATH_NAMESPACE::Box2i;
+using IMATH_NAMESPACE::clamp;
 using IMATH_NAMESPACE::divp;
 using IMATH_NAMESPACE::modp;
 using IMATH_NAMESPACE::V2i;
@@ -133,7 +134,10 @@ struct PizCompressor::ChannelData
 };
 
 PizCompressor::PizCompressor (
-    const Header& hdr, size_t maxScanLineSize, size_t numScanLines)
+    const Header& hdr,
+    size_t        maxScanLineSize,
+    size_t        numScanLines,
+    bool          multiStream)
     : Compressor (hdr)
     , _maxScanLineSize (maxScanLineSize)
     , _format (XDR)
@@ -143,6 +147,7 @@ PizCompressor::PizCompressor (
     , _numChans (0)
     , _channels (hdr.channels ())
     , _channelData (0)
+    , _multiStream (multiStream)
 {
     // TODO: Remove this when we can change the ABI
     (void) _maxScanLineSize;
@@ -415,7 +420,24 @@ PizCompressor::compress (
     char* lengthPtr = buf;
     Xdr::write<CharPtrIO> (buf, int (0));
 
-    int length = hufCompress (_tmpBuffer, tmpBufferEnd - _tmpBuffer, buf);
+    int length;
+
+    if (_multiStream)
+    {
+        //
+        // One stream per 4096 values, up to 4; more streams would
+        // only add header bytes without speeding up decoding.
+        //
+
+        int n          = tmpBufferEnd - _tmpBuffer;
+        int numStreams = clamp (n / 4096, 1, 4);
+
+        length = hufCompressStreams (_tmpBuffer, n, numStreams, buf);
+    }
+    else
+    {
+        length = hufCompress (_tmpBuffer, tmpBufferEnd - _tmpBuffer, buf);
+    }
     Xdr::write<CharPtrIO> (lengthPtr, length);
 
     outPtr = _outBuffer;
@@ -536,7 +558,11 @@ PizCompressor::uncompress (
                         "(invalid array length).");
     }
 
-    hufUncompress (inPtr, length, _tmpBuffer, tmpBufferEnd - _tmpBuffer);
+    if (_multiStream)
+        hufUncompressStreams (
+            inPtr, length, _tmpBuffer, tmpBufferEnd - _tmpBuffer);
+    else
+        hufUncompress (inPtr, length, _tmpBuffer, tmpBufferEnd - _tmpBuffer);
 
     //
     // Wavelet decoding
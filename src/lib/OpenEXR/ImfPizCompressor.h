@@ -10,6 +10,10 @@
 //
 //	class PizCompressor -- uses Wavelet and Huffman encoding.
 //
+//	With multiStream set, used for PIZ_MS_COMPRESSION, the Huffman
+//	data of large chunks is split into several streams, which
+//	hufUncompressStreams () decodes side by side.
+//
 //-----------------------------------------------------------------------------
 
 #include "ImfNamespace.h"
@@ -22,7 +26,10 @@ class PizCompressor : public Compressor
 {
 public:
     PizCompressor (
-        const Header& hdr, size_t maxScanLineSize, size_t numScanLines);
+        const Header& hdr,
+        size_t        maxScanLineSize,
+        size_t        numScanLines,
+        bool          multiStream = false);
 
     virtual ~PizCompressor ();
 
@@ -79,6 +86,7 @@ private:
     int                _minX;
     int                _maxX;
     int                _maxY;
+    bool               _multiStream;
 };
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
@@ -202,7 +202,7 @@ RgbaOutputFile::ToYca::ToYca (OutputFile& outputFile, RgbaChannels rgbaChannels)
     _linesConverted = 0;
     _lineOrder      = _outputFile.header ().lineOrder ();
 
-    if (_lineOrder == INCREASING_Y)
+    if (_lineOrder != DECREASING_Y)
         _currentScanLine = dw.min.y;
     else
         _currentScanLine = dw.max.y;
@@ -349,7 +349,7 @@ RgbaOutputFile::ToYca::writePixels (int numScanLines)
 
             ++_linesConverted;
 
-            if (_lineOrder == INCREASING_Y)
+            if (_lineOrder != DECREASING_Y)
                 ++_currentScanLine;
             else
                 --_currentScanLine;
@@ -444,7 +444,7 @@ RgbaOutputFile::ToYca::writePixels (int numScanLines)
                 }
             }
 
-            if (_lineOrder == INCREASING_Y)
+            if (_lineOrder != DECREASING_Y)
                 ++_currentScanLine;
             else
                 --_currentScanLine;
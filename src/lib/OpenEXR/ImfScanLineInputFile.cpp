@@ -10,12 +10,14 @@
 //-----------------------------------------------------------------------------
 
 #include "ImfScanLineInputFile.h"
+#include "ImfAsyncReadData.h"
 #include "Iex.h"
 #include "IlmThreadPool.h"
 #include "IlmThreadSemaphore.h"
 #include "ImfChannelList.h"
 #include "ImfCompressor.h"
 #include "ImfConvert.h"
+#include "ImfHTCompressor.h"
 #include "ImfInputPartData.h"
 #include "ImfInputStreamMutex.h"
 #include "ImfMisc.h"
@@ -32,6 +34,7 @@
 #include <algorithm>
 #include <assert.h>
 #include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -109,11 +112,15 @@ struct LineBuffer
     const char*        uncompressedData;
     char*              buffer;
     int                dataSize;
+    int                packedDataSize;
     int                minY;
     int                maxY;
+    int                validMinY; // range of lines in uncompressedData
+    int                validMaxY;
     Compressor*        compressor;
     Compressor::Format format;
     int                number;
+    bool               needsRead; // buffer is filled in by the task
     bool               hasException;
     string             exception;
 
@@ -126,6 +133,7 @@ struct LineBuffer
     LineBuffer& operator= (LineBuffer&& other) = delete;
 
     inline void wait () { _sem.wait (); }
+    inline bool tryWait () { return _sem.tryWait (); }
     inline void post () { _sem.post (); }
 
 private:
@@ -136,9 +144,13 @@ LineBuffer::LineBuffer (Compressor* comp)
     : uncompressedData (0)
     , buffer (0)
     , dataSize (0)
+    , packedDataSize (0)
+    , validMinY (0)
+    , validMaxY (-1)
     , compressor (comp)
     , format (defaultFormat (compressor))
     , number (-1)
+    , needsRead (false)
     , hasException (false)
     , exception ()
     , _sem (1)
@@ -208,10 +220,23 @@ struct ScanLineInputFile::Data
     int    partNumber;                 // part number
 
     bool             memoryMapped;     // if the stream is memory mapped
+    OPENEXR_IMF_INTERNAL_NAMESPACE::IStream*
+                     statelessStream;  // if the line buffer tasks read
+                                       // their own data with readAt()
     OptimizationMode optimizationMode; // optimizibility of the input file
     vector<sliceOptimizationData>
         optimizationData; ///< channel ordering for optimized reading
 
+    std::shared_ptr<AsyncRead::Data>
+                   pendingRead;        // asynchronous read in progress
+    int            readAhead;          // number of line buffers to
+                                       // prefetch after each read
+    size_t         minLineBuffers;     // line buffers without read-ahead
+    std::unique_ptr<TaskGroup>
+                   prefetchTasks;      // tasks prefetching line buffers
+    vector<char>   rawBuffer;          // holds the chunk returned by
+                                       // rawPixelData ()
+
     Data (int numThreads);
     ~Data ();
 
@@ -226,7 +251,11 @@ struct ScanLineInputFile::Data
 };
 
 ScanLineInputFile::Data::Data (int numThreads)
-    : partNumber (-1), memoryMapped (false)
+    : partNumber (-1)
+    , memoryMapped (false)
+    , statelessStream (nullptr)
+    , readAhead (0)
+    , prefetchTasks (new TaskGroup)
 {
     //
     // We need at least one lineBuffer, but if threading is used,
@@ -234,6 +263,7 @@ ScanLineInputFile::Data::Data (int numThreads)
     //
 
     lineBuffers.resize (max (1, 2 * numThreads));
+    minLineBuffers = lineBuffers.size ();
 }
 
 ScanLineInputFile::Data::~Data ()
@@ -255,6 +285,8 @@ void
 reconstructLineOffsets (
     OPENEXR_IMF_INTERNAL_NAMESPACE::IStream& is,
     LineOrder                                lineOrder,
+    int                                      minY,
+    int                                      linesInBuffer,
     vector<uint64_t>&                        lineOffsets)
 {
     uint64_t position = is.tellg ();
@@ -282,8 +314,22 @@ reconstructLineOffsets (
 
             if (lineOrder == INCREASING_Y)
                 lineOffsets[i] = lineOffset;
-            else
+            else if (lineOrder == DECREASING_Y)
                 lineOffsets[lineOffsets.size () - i - 1] = lineOffset;
+            else
+            {
+                //
+                // Chunks may be stored in any order; place each
+                // one by the scan line in its header.
+                //
+
+                int64_t n = (int64_t (y) - minY) / linesInBuffer;
+
+                if (y < minY || n >= int64_t (lineOffsets.size ()))
+                    throw IEX_NAMESPACE::IoExc ("Invalid scan line");
+
+                lineOffsets[n] = lineOffset;
+            }
         }
     }
     catch (...) //NOSONAR - suppress vulnerability reports from SonarCloud.
@@ -304,6 +350,8 @@ void
 readLineOffsets (
     OPENEXR_IMF_INTERNAL_NAMESPACE::IStream& is,
     LineOrder                                lineOrder,
+    int                                      minY,
+    int                                      linesInBuffer,
     vector<uint64_t>&                        lineOffsets,
     bool&                                    complete)
 {
@@ -333,7 +381,8 @@ readLineOffsets (
             //
 
             complete = false;
-            reconstructLineOffsets (is, lineOrder, lineOffsets);
+            reconstructLineOffsets (
+                is, lineOrder, minY, linesInBuffer, lineOffsets);
             break;
         }
     }
@@ -439,8 +488,162 @@ readPixelData (
 
     if (ifd->lineOrder == INCREASING_Y)
         ifd->nextLineBufferMinY = minY + ifd->linesInBuffer;
-    else
+    else if (ifd->lineOrder == DECREASING_Y)
         ifd->nextLineBufferMinY = minY - ifd->linesInBuffer;
+    else
+        ifd->nextLineBufferMinY = ifd->minY - 1; // any chunk may follow
+}
+
+//
+// Read a single line buffer with IStream::readAt() instead of seekg()
+// and read().  This is called by the line buffer tasks, without the
+// stream mutex, so that several tasks can wait for I/O at once.  It
+// does not move the stream, so nextLineBufferMinY stays valid.
+//
+
+void
+readPixelDataAt (ScanLineInputFile::Data* ifd, LineBuffer* lineBuffer)
+{
+    lineBuffer->needsRead = false;
+
+    try
+    {
+        int minY             = lineBuffer->minY;
+        int lineBufferNumber = (minY - ifd->minY) / ifd->linesInBuffer;
+        if (lineBufferNumber < 0 ||
+            lineBufferNumber >= int (ifd->lineOffsets.size ()))
+            THROW (
+                IEX_NAMESPACE::InputExc,
+                "Invalid scan line " << minY << " requested or missing.");
+
+        uint64_t lineOffset = ifd->lineOffsets[lineBufferNumber];
+
+        if (lineOffset == 0)
+            THROW (
+                IEX_NAMESPACE::InputExc,
+                "Scan line " << minY << " is missing.");
+
+        //
+        // Read the data block's header: the part number in a
+        // multi-part file, the y coordinate and the data size.
+        //
+
+        char header[3 * 4];
+        int  headerSize =
+            (isMultiPart (ifd->version) ? 3 : 2) * Xdr::size<int> ();
+
+        ifd->statelessStream->readAt (lineOffset, header, headerSize);
+
+        const char* readPtr = header;
+        int         yInFile;
+        int         dataSize;
+
+        if (isMultiPart (ifd->version))
+        {
+            int partNumber;
+            Xdr::read<CharPtrIO> (readPtr, partNumber);
+            if (partNumber != ifd->partNumber)
+            {
+                THROW (
+                    IEX_NAMESPACE::ArgExc,
+                    "Unexpected part number " << partNumber << ", should be "
+                                              << ifd->partNumber << ".");
+            }
+        }
+
+        Xdr::read<CharPtrIO> (readPtr, yInFile);
+        Xdr::read<CharPtrIO> (readPtr, dataSize);
+
+        if (yInFile != minY)
+            throw IEX_NAMESPACE::InputExc (
+                "Unexpected data block y coordinate.");
+
+        if (dataSize < 0 || dataSize > static_cast<int> (ifd->lineBufferSize))
+            throw IEX_NAMESPACE::InputExc ("Unexpected data block length.");
+
+        ifd->statelessStream->readAt (
+            lineOffset + headerSize, lineBuffer->buffer, dataSize);
+
+        lineBuffer->dataSize = dataSize;
+    }
+    catch (...)
+    {
+        //
+        // The buffer holds nothing useful, make sure the
+        // next request for it reads it again.
+        //
+
+        lineBuffer->number = -1;
+        throw;
+    }
+}
+
+//
+// Make sure that scan lines scanLineMin to scanLineMax of a line
+// buffer are available in uncompressed form.  The compressor is
+// asked for the requested lines only, so that compressors that can
+// decode part of a line buffer (e.g. HT) do not have to decode all
+// of it; the compressed data stays in lineBuffer->buffer in case a
+// later request needs lines that have not been uncompressed yet.
+//
+
+void
+uncompressLineBuffer (
+    ScanLineInputFile::Data* ifd,
+    LineBuffer*              lineBuffer,
+    int                      scanLineMin,
+    int                      scanLineMax)
+{
+    if (lineBuffer->uncompressedData != 0 &&
+        scanLineMin >= lineBuffer->validMinY &&
+        scanLineMax <= lineBuffer->validMaxY)
+        return;
+
+    if (lineBuffer->uncompressedData == 0)
+    {
+        size_t uncompressedSize = 0;
+        int    maxY             = min (lineBuffer->maxY, ifd->maxY);
+
+        for (int i = lineBuffer->minY - ifd->minY; i <= maxY - ifd->minY; ++i)
+        {
+            uncompressedSize += ifd->bytesPerLine[i];
+        }
+
+        if (!lineBuffer->compressor ||
+            static_cast<size_t> (lineBuffer->dataSize) >= uncompressedSize)
+        {
+            //
+            // If the line is uncompressed, it's in XDR format,
+            // regardless of the compressor's output format.
+            //
+
+            lineBuffer->format           = Compressor::XDR;
+            lineBuffer->uncompressedData = lineBuffer->buffer;
+            lineBuffer->validMinY        = lineBuffer->minY;
+            lineBuffer->validMaxY        = lineBuffer->maxY;
+            return;
+        }
+
+        lineBuffer->packedDataSize = lineBuffer->dataSize;
+    }
+
+    int         lineMin = scanLineMin;
+    int         lineMax = scanLineMax;
+    const char* outPtr  = 0;
+
+    int size = lineBuffer->compressor->uncompressLines (
+        lineBuffer->buffer,
+        lineBuffer->packedDataSize,
+        lineBuffer->minY,
+        lineMin,
+        lineMax,
+        outPtr);
+
+    lineBuffer->format           = lineBuffer->compressor->format ();
+    lineBuffer->dataSize         = size;
+    lineBuffer->uncompressedData = outPtr;
+    lineBuffer->validMinY        = lineMin;
+    lineBuffer->validMaxY        = lineMax;
 }
 
 //
@@ -503,46 +706,16 @@ LineBufferTask::execute ()
     try
     {
         //
-        // Uncompress the data, if necessary
+        // Read and uncompress the data, if necessary
         //
 
-        if (_lineBuffer->uncompressedData == 0)
-        {
-            size_t uncompressedSize = 0;
-            int    maxY             = min (_lineBuffer->maxY, _ifd->maxY);
-
-            for (int i = _lineBuffer->minY - _ifd->minY; i <= maxY - _ifd->minY;
-                 ++i)
-            {
-                uncompressedSize += _ifd->bytesPerLine[i];
-            }
+        if (_lineBuffer->needsRead) readPixelDataAt (_ifd, _lineBuffer);
 
-            if (_lineBuffer->compressor &&
-                static_cast<size_t> (_lineBuffer->dataSize) < uncompressedSize)
-            {
-                _lineBuffer->format = _lineBuffer->compressor->format ();
-
-                _lineBuffer->dataSize = _lineBuffer->compressor->uncompress (
-                    _lineBuffer->buffer,
-                    _lineBuffer->dataSize,
-                    _lineBuffer->minY,
-                    _lineBuffer->uncompressedData);
-            }
-            else
-            {
-                //
-                // If the line is uncompressed, it's in XDR format,
-                // regardless of the compressor's output format.
-                //
-
-                _lineBuffer->format           = Compressor::XDR;
-                _lineBuffer->uncompressedData = _lineBuffer->buffer;
-            }
-        }
+        uncompressLineBuffer (_ifd, _lineBuffer, _scanLineMin, _scanLineMax);
 
         int yStart, yStop, dy;
 
-        if (_ifd->lineOrder == INCREASING_Y)
+        if (_ifd->lineOrder != DECREASING_Y)
         {
             yStart = _scanLineMin;
             yStop  = _scanLineMax + 1;
@@ -822,46 +995,16 @@ LineBufferTaskIIF::execute ()
     try
     {
         //
-        // Uncompress the data, if necessary
+        // Read and uncompress the data, if necessary
         //
 
-        if (_lineBuffer->uncompressedData == 0)
-        {
-            size_t uncompressedSize = 0;
-            int    maxY             = min (_lineBuffer->maxY, _ifd->maxY);
-
-            for (int i = _lineBuffer->minY - _ifd->minY; i <= maxY - _ifd->minY;
-                 ++i)
-            {
-                uncompressedSize += _ifd->bytesPerLine[i];
-            }
+        if (_lineBuffer->needsRead) readPixelDataAt (_ifd, _lineBuffer);
 
-            if (_lineBuffer->compressor &&
-                static_cast<size_t> (_lineBuffer->dataSize) < uncompressedSize)
-            {
-                _lineBuffer->format = _lineBuffer->compressor->format ();
-
-                _lineBuffer->dataSize = _lineBuffer->compressor->uncompress (
-                    _lineBuffer->buffer,
-                    _lineBuffer->dataSize,
-                    _lineBuffer->minY,
-                    _lineBuffer->uncompressedData);
-            }
-            else
-            {
-                //
-                // If the line is uncompressed, it's in XDR format,
-                // regardless of the compressor's output format.
-                //
-
-                _lineBuffer->format           = Compressor::XDR;
-                _lineBuffer->uncompressedData = _lineBuffer->buffer;
-            }
-        }
+        uncompressLineBuffer (_ifd, _lineBuffer, _scanLineMin, _scanLineMax);
 
         int yStart, yStop, dy;
 
-        if (_ifd->lineOrder == INCREASING_Y)
+        if (_ifd->lineOrder != DECREASING_Y)
         {
             yStart = _scanLineMin;
             yStop  = _scanLineMax + 1;
@@ -1073,12 +1216,15 @@ newLineBufferTask (
             lineBuffer->number           = number;
             lineBuffer->uncompressedData = 0;
 
-            readPixelData (
-                streamData,
-                ifd,
-                lineBuffer->minY,
-                lineBuffer->buffer,
-                lineBuffer->dataSize);
+            if (ifd->statelessStream)
+                lineBuffer->needsRead = true;
+            else
+                readPixelData (
+                    streamData,
+                    ifd,
+                    lineBuffer->minY,
+                    lineBuffer->buffer,
+                    lineBuffer->dataSize);
         }
     }
     catch (std::exception& e)
@@ -1129,6 +1275,230 @@ newLineBufferTask (
     return retTask;
 }
 
+//
+// A PrefetchTask reads and uncompresses a line buffer ahead of the
+// read that will need it, without touching the frame buffer.
+//
+
+class PrefetchTask : public Task
+{
+public:
+    PrefetchTask (
+        TaskGroup* group, ScanLineInputFile::Data* ifd, LineBuffer* lineBuffer)
+        : Task (group), _ifd (ifd), _lineBuffer (lineBuffer)
+    {}
+
+    virtual ~PrefetchTask () { _lineBuffer->post (); }
+
+    virtual void execute ()
+    {
+        try
+        {
+            if (_lineBuffer->needsRead) readPixelDataAt (_ifd, _lineBuffer);
+
+            uncompressLineBuffer (
+                _ifd,
+                _lineBuffer,
+                _lineBuffer->minY,
+                min (_lineBuffer->maxY, _ifd->maxY));
+        }
+        catch (...) //NOSONAR - suppress vulnerability reports from SonarCloud.
+        {
+            //
+            // Leave it to the read that needs the line
+            // buffer to read it again and report the error.
+            //
+
+            _lineBuffer->number = -1;
+        }
+    }
+
+private:
+    ScanLineInputFile::Data* _ifd;
+    LineBuffer*              _lineBuffer;
+};
+
+//
+// Check the scan line range of a read, and add the tasks that read
+// its line buffers to taskGroup.  Returns the number of the line
+// buffer after the last one, in the order they are stored in the file.
+//
+
+int
+addLineBufferTasks (
+    TaskGroup*               taskGroup,
+    InputStreamMutex*        streamData,
+    ScanLineInputFile::Data* ifd,
+    int                      scanLine1,
+    int                      scanLine2)
+{
+    if (ifd->slices.size () == 0)
+        throw IEX_NAMESPACE::ArgExc (
+            "No frame buffer specified as pixel data destination.");
+
+    int scanLineMin = min (scanLine1, scanLine2);
+    int scanLineMax = max (scanLine1, scanLine2);
+
+    if (scanLineMin < ifd->minY || scanLineMax > ifd->maxY)
+        throw IEX_NAMESPACE::ArgExc ("Tried to read scan line outside "
+                                     "the image file's data window.");
+
+    //
+    // We impose a numbering scheme on the lineBuffers where the first
+    // scanline is contained in lineBuffer 1.
+    //
+    // Determine the first and last lineBuffer numbers in this scanline
+    // range. We always attempt to read the scanlines in the order that
+    // they are stored in the file.
+    //
+
+    int start, stop, dl;
+
+    if (ifd->lineOrder != DECREASING_Y)
+    {
+        start = (scanLineMin - ifd->minY) / ifd->linesInBuffer;
+        stop  = (scanLineMax - ifd->minY) / ifd->linesInBuffer + 1;
+        dl    = 1;
+    }
+    else
+    {
+        start = (scanLineMax - ifd->minY) / ifd->linesInBuffer;
+        stop  = (scanLineMin - ifd->minY) / ifd->linesInBuffer - 1;
+        dl    = -1;
+    }
+
+    //
+    // Add the line buffer tasks.
+    //
+    // The tasks will execute in the order that they are created
+    // because we lock the line buffers during construction and the
+    // constructors are called by the main thread.  Hence, in order
+    // for a successive task to execute the previous task which
+    // used that line buffer must have completed already.
+    //
+
+    for (int l = start; l != stop; l += dl)
+    {
+        ThreadPool::addGlobalTask (newLineBufferTask (
+            taskGroup,
+            streamData,
+            ifd,
+            l,
+            scanLineMin,
+            scanLineMax,
+            ifd->optimizationMode));
+    }
+
+    return stop;
+}
+
+//
+// Start reading and uncompressing ifd->readAhead line buffers, from
+// line buffer number on in the order they are stored in the file, so
+// that a sequential reader finds them ready.  Line buffers that are
+// still busy are skipped rather than waited for.
+//
+
+void
+prefetchLineBuffers (
+    InputStreamMutex* streamData, ScanLineInputFile::Data* ifd, int number)
+{
+    if (ifd->readAhead <= 0 ||
+        ThreadPool::globalThreadPool ().numThreads () == 0)
+        return;
+
+    int dl = (ifd->lineOrder != DECREASING_Y) ? 1 : -1;
+
+    for (int i = 0; i < ifd->readAhead; ++i, number += dl)
+    {
+        if (number < 0 || number >= int (ifd->lineOffsets.size ())) break;
+
+        LineBuffer* lineBuffer = ifd->getLineBuffer (number);
+
+        if (!lineBuffer->tryWait ()) continue;
+
+        if (lineBuffer->number == number)
+        {
+            lineBuffer->post ();
+            continue;
+        }
+
+        try
+        {
+            lineBuffer->minY = ifd->minY + number * ifd->linesInBuffer;
+            lineBuffer->maxY = lineBuffer->minY + ifd->linesInBuffer - 1;
+
+            lineBuffer->number           = number;
+            lineBuffer->uncompressedData = 0;
+
+            if (ifd->statelessStream)
+                lineBuffer->needsRead = true;
+            else
+                readPixelData (
+                    streamData,
+                    ifd,
+                    lineBuffer->minY,
+                    lineBuffer->buffer,
+                    lineBuffer->dataSize);
+        }
+        catch (...) //NOSONAR - suppress vulnerability reports from SonarCloud.
+        {
+            //
+            // Most likely an incomplete file; the read
+            // that needs this line buffer reports it.
+            //
+
+            lineBuffer->number = -1;
+            lineBuffer->post ();
+            break;
+        }
+
+        ThreadPool::addGlobalTask (
+            new PrefetchTask (ifd->prefetchTasks.get (), ifd, lineBuffer));
+    }
+}
+
+//
+// Return the first exception that the line buffer tasks stored in
+// the line buffers, if any, and clear them all.
+//
+
+bool
+collectLineBufferException (ScanLineInputFile::Data* ifd, string& exception)
+{
+    bool found = false;
+
+    for (size_t i = 0; i < ifd->lineBuffers.size (); ++i)
+    {
+        LineBuffer* lineBuffer = ifd->lineBuffers[i];
+
+        if (lineBuffer->hasException && !found)
+        {
+            exception = lineBuffer->exception;
+            found     = true;
+        }
+
+        lineBuffer->hasException = false;
+    }
+
+    return found;
+}
+
+//
+// Wait for a pending asynchronous read before changing anything its
+// tasks use.  Its exceptions are reported by its AsyncRead handle.
+//
+
+void
+finishPendingRead (ScanLineInputFile::Data* ifd)
+{
+    if (ifd->pendingRead)
+    {
+        ifd->pendingRead->finish ();
+        ifd->pendingRead.reset ();
+    }
+}
+
 static const int gLargeChunkTableSize = 1024 * 1024;
 
 } // namespace
@@ -1224,6 +1594,8 @@ ScanLineInputFile::ScanLineInputFile (InputPartData* part)
     _data               = new Data (part->numThreads);
     _streamData         = part->mutex;
     _data->memoryMapped = _streamData->is->isMemoryMapped ();
+    if (!_data->memoryMapped && _streamData->is->isStatelessRead ())
+        _data->statelessStream = _streamData->is;
 
     _data->version = part->version;
 
@@ -1266,6 +1638,8 @@ ScanLineInputFile::ScanLineInputFile (
 {
     _streamData->is     = is;
     _data->memoryMapped = is->isMemoryMapped ();
+    if (!_data->memoryMapped && is->isStatelessRead ())
+        _data->statelessStream = is;
 
     try
     {
@@ -1282,6 +1656,8 @@ ScanLineInputFile::ScanLineInputFile (
         readLineOffsets (
             *_streamData->is,
             _data->lineOrder,
+            _data->minY,
+            _data->linesInBuffer,
             _data->lineOffsets,
             _data->fileIsComplete);
     }
@@ -1309,6 +1685,13 @@ ScanLineInputFile::ScanLineInputFile (
 
 ScanLineInputFile::~ScanLineInputFile ()
 {
+    //
+    // Let background reads finish before the line buffers go away
+    //
+
+    if (_data->pendingRead) _data->pendingRead->finish ();
+    _data->prefetchTasks.reset ();
+
     if (!_data->memoryMapped)
     {
         for (size_t i = 0; i < _data->lineBuffers.size (); i++)
@@ -1421,6 +1804,8 @@ ScanLineInputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
     std::lock_guard<std::mutex> lock (*_streamData);
 #endif
 
+    finishPendingRead (_data);
+
     const ChannelList& channels = _data->header.channels ();
     for (FrameBuffer::ConstIterator j = frameBuffer.begin ();
          j != frameBuffer.end ();
@@ -1637,40 +2022,7 @@ ScanLineInputFile::readPixels (int scanLine1, int scanLine2)
 #if ILMTHREAD_THREADING_ENABLED
         std::lock_guard<std::mutex> lock (*_streamData);
 #endif
-        if (_data->slices.size () == 0)
-            throw IEX_NAMESPACE::ArgExc (
-                "No frame buffer specified as pixel data destination.");
-
-        int scanLineMin = min (scanLine1, scanLine2);
-        int scanLineMax = max (scanLine1, scanLine2);
-
-        if (scanLineMin < _data->minY || scanLineMax > _data->maxY)
-            throw IEX_NAMESPACE::ArgExc ("Tried to read scan line outside "
-                                         "the image file's data window.");
-
-        //
-        // We impose a numbering scheme on the lineBuffers where the first
-        // scanline is contained in lineBuffer 1.
-        //
-        // Determine the first and last lineBuffer numbers in this scanline
-        // range. We always attempt to read the scanlines in the order that
-        // they are stored in the file.
-        //
-
-        int start, stop, dl;
-
-        if (_data->lineOrder == INCREASING_Y)
-        {
-            start = (scanLineMin - _data->minY) / _data->linesInBuffer;
-            stop  = (scanLineMax - _data->minY) / _data->linesInBuffer + 1;
-            dl    = 1;
-        }
-        else
-        {
-            start = (scanLineMax - _data->minY) / _data->linesInBuffer;
-            stop  = (scanLineMin - _data->minY) / _data->linesInBuffer - 1;
-            dl    = -1;
-        }
+        finishPendingRead (_data);
 
         //
         // Create a task group for all line buffer tasks.  When the
@@ -1678,30 +2030,13 @@ ScanLineInputFile::readPixels (int scanLine1, int scanLine2)
         // all tasks are complete.
         //
 
+        int next;
+
         {
             TaskGroup taskGroup;
 
-            //
-            // Add the line buffer tasks.
-            //
-            // The tasks will execute in the order that they are created
-            // because we lock the line buffers during construction and the
-            // constructors are called by the main thread.  Hence, in order
-            // for a successive task to execute the previous task which
-            // used that line buffer must have completed already.
-            //
-
-            for (int l = start; l != stop; l += dl)
-            {
-                ThreadPool::addGlobalTask (newLineBufferTask (
-                    &taskGroup,
-                    _streamData,
-                    _data,
-                    l,
-                    scanLineMin,
-                    scanLineMax,
-                    _data->optimizationMode));
-            }
+            next = addLineBufferTasks (
+                &taskGroup, _streamData, _data, scanLine1, scanLine2);
 
             //
             // finish all tasks
@@ -1723,19 +2058,56 @@ ScanLineInputFile::readPixels (int scanLine1, int scanLine2)
         // ignore all others.)
         //
 
-        const string* exception = 0;
+        string exception;
 
-        for (size_t i = 0; i < _data->lineBuffers.size (); ++i)
-        {
-            LineBuffer* lineBuffer = _data->lineBuffers[i];
+        if (collectLineBufferException (_data, exception))
+            throw IEX_NAMESPACE::IoExc (exception);
 
-            if (lineBuffer->hasException && !exception)
-                exception = &lineBuffer->exception;
+        prefetchLineBuffers (_streamData, _data, next);
+    }
+    catch (IEX_NAMESPACE::BaseExc& e)
+    {
+        REPLACE_EXC (
+            e,
+            "Error reading pixel data from image "
+            "file \""
+                << fileName () << "\". " << e.what ());
+        throw;
+    }
+}
 
-            lineBuffer->hasException = false;
-        }
+AsyncRead
+ScanLineInputFile::readPixelsAsync (int scanLine1, int scanLine2)
+{
+    try
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (*_streamData);
+#endif
+        finishPendingRead (_data);
+
+        std::shared_ptr<AsyncRead::Data> read =
+            std::make_shared<AsyncRead::Data> (fileName ());
+
+        Data* data = _data;
+
+        read->collectExceptions = [data] (string& exception) {
+            return collectLineBufferException (data, exception);
+        };
+
+        //
+        // If queuing the tasks fails, the read's destructor
+        // waits for the ones that have been queued already.
+        //
+
+        int next = addLineBufferTasks (
+            read->taskGroup.get (), _streamData, _data, scanLine1, scanLine2);
 
-        if (exception) throw IEX_NAMESPACE::IoExc (*exception);
+        _data->pendingRead = read;
+
+        prefetchLineBuffers (_streamData, _data, next);
+
+        return AsyncRead (read);
     }
     catch (IEX_NAMESPACE::BaseExc& e)
     {
@@ -1748,12 +2120,247 @@ ScanLineInputFile::readPixels (int scanLine1, int scanLine2)
     }
 }
 
+void
+ScanLineInputFile::setReadAhead (int numChunks)
+{
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (*_streamData);
+#endif
+
+    if (numChunks < 0)
+        throw IEX_NAMESPACE::ArgExc (
+            "Attempt to set a negative read-ahead.");
+
+    //
+    // Prefetched line buffers must not evict the ones a read has
+    // just filled, so read-ahead gets line buffers of its own.
+    //
+
+    size_t numLineBuffers = _data->minLineBuffers + size_t (numChunks);
+
+    if (numLineBuffers > _data->lineBuffers.size ())
+    {
+        finishPendingRead (_data);
+        _data->prefetchTasks.reset (new TaskGroup);
+
+        Compression comp = _data->header.compression ();
+
+        size_t maxBytesPerLine = *std::max_element (
+            _data->bytesPerLine.begin (), _data->bytesPerLine.end ());
+
+        while (_data->lineBuffers.size () < numLineBuffers)
+        {
+            LineBuffer* lineBuffer = new LineBuffer (
+                newCompressor (comp, maxBytesPerLine, _data->header));
+
+            _data->lineBuffers.push_back (lineBuffer);
+
+            if (!_data->memoryMapped)
+            {
+                lineBuffer->buffer = (char*) EXRAllocAligned (
+                    _data->lineBufferSize * sizeof (char), 16);
+
+                if (!lineBuffer->buffer)
+                {
+                    throw IEX_NAMESPACE::LogicExc (
+                        "Failed to allocate memory for scanline buffers");
+                }
+            }
+        }
+    }
+
+    _data->readAhead = numChunks;
+}
+
+int
+ScanLineInputFile::readAhead () const
+{
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (*_streamData);
+#endif
+    return _data->readAhead;
+}
+
 void
 ScanLineInputFile::readPixels (int scanLine)
 {
     readPixels (scanLine, scanLine);
 }
 
+void
+ScanLineInputFile::readPixelsReduced (int level)
+{
+    try
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (*_streamData);
+#endif
+        finishPendingRead (_data);
+
+        if (_data->slices.size () == 0)
+            throw IEX_NAMESPACE::ArgExc (
+                "No frame buffer specified as pixel data destination.");
+
+        Compression comp = _data->header.compression ();
+
+        if (comp != HT_COMPRESSION && comp != HT256_COMPRESSION &&
+            comp != HT_LOSSY_COMPRESSION && comp != HT_STRIPED_COMPRESSION)
+        {
+            throw IEX_NAMESPACE::ArgExc (
+                "Reading pixels at a reduced resolution requires "
+                "HT compression.");
+        }
+
+        //
+        // Reduced chunks only tile the reduced image if all but the
+        // last have a multiple of 2^level lines.
+        //
+
+        if (level < 0 || level > HTCompressor::MAX_REDUCTION_LEVEL ||
+            (_data->linesInBuffer <= _data->maxY - _data->minY &&
+             _data->linesInBuffer % (1 << level) != 0))
+        {
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Invalid resolution level " << level << ".");
+        }
+
+        const ChannelList& channels = _data->header.channels ();
+        int                width    = _data->maxX - _data->minX + 1;
+        int                rw       = HTCompressor::reducedSize (width, level);
+        size_t             rowSize  = 0;
+
+        for (ChannelList::ConstIterator i = channels.begin ();
+             i != channels.end ();
+             ++i)
+        {
+            if (i.channel ().xSampling != 1 || i.channel ().ySampling != 1)
+            {
+                throw IEX_NAMESPACE::ArgExc (
+                    "Cannot read subsampled channels at a reduced "
+                    "resolution.");
+            }
+
+            rowSize += rw * pixelTypeSize (i.channel ().type);
+        }
+
+        //
+        // A decoder of our own keeps this independent of the line
+        // buffers used by readPixels ().
+        //
+
+        HTCompressor decoder (_data->header, _data->linesInBuffer);
+
+        vector<char> chunk (_data->lineBufferSize);
+        vector<char> sampled;
+
+        for (int minY = _data->minY; minY <= _data->maxY;
+             minY += _data->linesInBuffer)
+        {
+            int maxY = min (minY + _data->linesInBuffer - 1, _data->maxY);
+            int rh   = HTCompressor::reducedSize (maxY - minY + 1, level);
+
+            char* buffer = chunk.data ();
+            int   dataSize;
+
+            readPixelData (_streamData, _data, minY, buffer, dataSize);
+
+            size_t uncompressedSize = 0;
+            for (int y = minY; y <= maxY; ++y)
+                uncompressedSize += _data->bytesPerLine[y - _data->minY];
+
+            const char*        readPtr;
+            Compressor::Format format;
+
+            if (static_cast<size_t> (dataSize) < uncompressedSize)
+            {
+                decoder.uncompressReduced (
+                    buffer, dataSize, minY, level, readPtr);
+
+                format = decoder.format ();
+            }
+            else
+            {
+                //
+                // Chunks that did not compress are stored as is, so
+                // fall back to point sampling them.
+                //
+
+                sampled.resize (rh * rowSize);
+
+                char* writePtr = sampled.data ();
+
+                for (int y = 0; y < rh; ++y)
+                {
+                    const char* line =
+                        buffer + _data->offsetInLineBuffer
+                                     [minY + (y << level) - _data->minY];
+
+                    for (ChannelList::ConstIterator i = channels.begin ();
+                         i != channels.end ();
+                         ++i)
+                    {
+                        int size = pixelTypeSize (i.channel ().type);
+
+                        for (int x = 0; x < rw; ++x, writePtr += size)
+                            memcpy (writePtr, line + (x << level) * size, size);
+
+                        line += width * size;
+                    }
+                }
+
+                readPtr = sampled.data ();
+                format  = Compressor::XDR;
+            }
+
+            int firstY = _data->minY + ((minY - _data->minY) >> level);
+
+            for (int y = firstY; y < firstY + rh; ++y)
+            {
+                for (unsigned int i = 0; i < _data->slices.size (); ++i)
+                {
+                    const InSliceInfo& slice = _data->slices[i];
+
+                    if (slice.skip)
+                    {
+                        skipChannel (readPtr, slice.typeInFile, rw);
+                        continue;
+                    }
+
+                    intptr_t linePtr = reinterpret_cast<intptr_t> (slice.base) +
+                                       intptr_t (y) * intptr_t (slice.yStride);
+
+                    char* writePtr = reinterpret_cast<char*> (
+                        linePtr + intptr_t (_data->minX) * intptr_t (slice.xStride));
+                    char* endPtr = reinterpret_cast<char*> (
+                        linePtr + intptr_t (_data->minX + rw - 1) *
+                                      intptr_t (slice.xStride));
+
+                    copyIntoFrameBuffer (
+                        readPtr,
+                        writePtr,
+                        endPtr,
+                        slice.xStride,
+                        slice.fill,
+                        slice.fillValue,
+                        format,
+                        slice.typeInFrameBuffer,
+                        slice.typeInFile);
+                }
+            }
+        }
+    }
+    catch (IEX_NAMESPACE::BaseExc& e)
+    {
+        REPLACE_EXC (
+            e,
+            "Error reading reduced resolution pixel data from image "
+            "file \""
+                << fileName () << "\". " << e.what ());
+        throw;
+    }
+}
+
 void
 ScanLineInputFile::rawPixelData (
     int firstScanLine, const char*& pixelData, int& pixelDataSize)
@@ -1772,14 +2379,19 @@ ScanLineInputFile::rawPixelData (
         int minY =
             lineBufferMinY (firstScanLine, _data->minY, _data->linesInBuffer);
 
-        readPixelData (
-            _streamData,
-            _data,
-            minY,
-            _data->lineBuffers[0]->buffer,
-            pixelDataSize);
+        //
+        // The line buffers may be in use by a pending asynchronous read
+        // or by prefetch tasks, and hold decoded pixels that later reads
+        // look up by number, so the raw chunk goes into a buffer of its
+        // own. Memory-mapped streams just point into the mapping.
+        //
+
+        _data->rawBuffer.resize (_data->lineBufferSize);
+        char* buffer = _data->rawBuffer.data ();
+
+        readPixelData (_streamData, _data, minY, buffer, pixelDataSize);
 
-        pixelData = _data->lineBuffers[0]->buffer;
+        pixelData = buffer;
     }
     catch (IEX_NAMESPACE::BaseExc& e)
     {
@@ -14,6 +14,7 @@
 
 #include "ImfForward.h"
 
+#include "ImfAsyncRead.h"
 #include "ImfGenericInputFile.h"
 #include "ImfThreading.h"
 
@@ -143,6 +144,69 @@ public:
     IMF_EXPORT
     void readPixels (int scanLine);
 
+    //---------------------------------------------------------------
+    // Read pixel data asynchronously:
+    //
+    // readPixelsAsync(s1,s2) starts reading the same scan lines as
+    // readPixels(s1,s2), and returns once their chunks have been
+    // queued for the global thread pool to read and uncompress.
+    // Queuing a chunk blocks while all line buffers are busy, so
+    // only reads that fit in the line buffers return right away.
+    // Use the returned AsyncRead to wait for the read to finish.
+    //
+    // The frame buffer must stay valid until the read is finished.
+    // Only one read can be in progress at a time: readPixels(),
+    // readPixelsAsync() and setFrameBuffer() first wait for a
+    // pending asynchronous read.
+    //
+    //---------------------------------------------------------------
+
+    IMF_EXPORT
+    AsyncRead readPixelsAsync (int scanLine1, int scanLine2);
+
+    //---------------------------------------------------------------
+    // Read-ahead:
+    //
+    // setReadAhead(n) makes each read also start reading and
+    // uncompressing, in the background, the n chunks that follow
+    // the ones it read in the file, so that they are ready for a
+    // reader that goes through the file in order.  This needs a
+    // worker thread, and n additional line buffers.  The default,
+    // n = 0, turns read-ahead off.
+    //
+    //---------------------------------------------------------------
+
+    IMF_EXPORT
+    void setReadAhead (int numChunks);
+
+    IMF_EXPORT
+    int readAhead () const;
+
+    //---------------------------------------------------------------
+    // Read pixel data at a reduced resolution:
+    //
+    // readPixelsReduced(l) reads the whole image at 1 / 2^l of its
+    // width and height, for l in [0, 5], decoding only the lower
+    // wavelet levels of the file's HT codestreams.  This is much
+    // faster than reading the image in full and filtering it down,
+    // e.g. to make thumbnails or proxies.
+    //
+    // The reduced image has the top left corner of the data window,
+    // header().dataWindow().min, and a size of ceil (w / 2^l) by
+    // ceil (h / 2^l) pixels, where w and h are the size of the data
+    // window; the current frame buffer must cover it.
+    //
+    // The part must be compressed with HT_COMPRESSION,
+    // HT256_COMPRESSION, HT_LOSSY_COMPRESSION or HT_STRIPED_COMPRESSION
+    // and have no
+    // subsampled channels, and l must not exceed the number of
+    // wavelet decomposition levels (see htDecompositionLevels).
+    //
+    //---------------------------------------------------------------
+
+    IMF_EXPORT
+    void readPixelsReduced (int level);
+
     //----------------------------------------------
     // Read a block of raw pixel data from the file,
     // without uncompressing it (this function is
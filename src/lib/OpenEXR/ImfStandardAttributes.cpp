@@ -117,6 +117,10 @@ IMF_STD_ATTRIBUTE_IMP (wrapmodes, Wrapmodes, string)
 IMF_STD_ATTRIBUTE_IMP (multiView, MultiView, StringVector)
 IMF_STD_ATTRIBUTE_IMP (deepImageState, DeepImageState, DeepImageState)
 IMF_STD_ATTRIBUTE_IMP (dwaCompressionLevel, DwaCompressionLevel, float)
+IMF_STD_ATTRIBUTE_IMP (htDecompositionLevels, HtDecompositionLevels, int)
+IMF_STD_ATTRIBUTE_IMP (htCodeBlockSize, HtCodeBlockSize, V2i)
+IMF_STD_ATTRIBUTE_IMP (htProgressionOrder, HtProgressionOrder, string)
+IMF_STD_ATTRIBUTE_IMP (htPrecinctSize, HtPrecinctSize, V2i)
 IMF_STD_ATTRIBUTE_IMP (idManifest, IDManifest, CompressedIDManifest)
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
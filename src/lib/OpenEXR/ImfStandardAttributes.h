@@ -707,6 +707,28 @@ IMF_STD_ATTRIBUTE_DEF_DEPRECATED (
     float,
     "use compression method in ImfHeader")
 
+//
+// htDecompositionLevels, htCodeBlockSize, htProgressionOrder,
+// htPrecinctSize -- coding parameters for images compressed with the
+// HT or HT256 method.  If an attribute is absent, the defaults are
+// used: 5 decomposition levels, 128x32 code blocks, RPCL progression
+// and maximal precincts.
+//
+// htCodeBlockSize is the code block width and height; both must be
+// powers of two between 4 and 1024, with an area of at most 4096.
+// htProgressionOrder is one of "LRCP", "RLCP", "RPCL", "PCRL" or
+// "CPRL".  htPrecinctSize is the precinct width and height, powers
+// of two of at least 2, used at every resolution level.
+//
+// The parameters are also recorded in each codestream, so readers
+// do not need these attributes to decode the pixels.
+//
+
+IMF_STD_ATTRIBUTE_DEF (htDecompositionLevels, HtDecompositionLevels, int)
+IMF_STD_ATTRIBUTE_DEF (htCodeBlockSize, HtCodeBlockSize, IMATH_NAMESPACE::V2i)
+IMF_STD_ATTRIBUTE_DEF (htProgressionOrder, HtProgressionOrder, std::string)
+IMF_STD_ATTRIBUTE_DEF (htPrecinctSize, HtPrecinctSize, IMATH_NAMESPACE::V2i)
+
 //
 // ID Manifest
 //
@@ -25,6 +25,12 @@
 #    include <sys/stat.h>
 #    include <sys/types.h>
 #    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <string.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
 #endif
 
 using namespace std;
@@ -191,33 +197,161 @@ checkError (ostream& os)
     }
 }
 
+void
+throwEarlyEnd (int nread, int n)
+{
+    THROW (
+        IEX_NAMESPACE::InputExc,
+        "Early end of file: read " << nread << " out of " << n
+                                   << " requested bytes.");
+}
+
+//
+// Native file handles for StdIFStream::readAt().  A failure to
+// open one is not an error; readAt() is simply not offered.
+//
+
+#ifdef _WIN32
+void*
+openReadHandle (const char* fileName)
+{
+    wstring wfn = WidenFilename (fileName);
+    HANDLE  h   = CreateFileW (
+        wfn.c_str (),
+        GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL);
+    return h == INVALID_HANDLE_VALUE ? nullptr : h;
+}
+
+void
+readFullyAt (void* handle, uint64_t pos, char c[/*n*/], int n)
+{
+    int nread = 0;
+
+    while (nread < n)
+    {
+        OVERLAPPED    overlap = {0};
+        LARGE_INTEGER lint;
+        DWORD         got = 0;
+
+        lint.QuadPart      = static_cast<LONGLONG> (pos + nread);
+        overlap.Offset     = lint.LowPart;
+        overlap.OffsetHigh = lint.HighPart;
+
+        if (!ReadFile (handle, c + nread, DWORD (n - nread), &got, &overlap))
+        {
+            if (GetLastError () != ERROR_HANDLE_EOF)
+                throw IEX_NAMESPACE::IoExc ("Positional file read failed.");
+            got = 0;
+        }
+
+        if (got == 0) throwEarlyEnd (nread, n);
+        nread += int (got);
+    }
+}
+#else
+int
+openReadHandle (const char* fileName)
+{
+    return ::open (fileName, O_RDONLY | O_CLOEXEC);
+}
+
+void
+readFullyAt (int fd, uint64_t pos, char c[/*n*/], int n)
+{
+    int nread = 0;
+
+    while (nread < n)
+    {
+        ssize_t got = pread (
+            fd, c + nread, size_t (n - nread), static_cast<off_t> (pos + nread));
+
+        if (got < 0)
+        {
+            if (errno == EINTR) continue;
+            IEX_NAMESPACE::throwErrnoExc ();
+        }
+
+        if (got == 0) throwEarlyEnd (nread, n);
+        nread += int (got);
+    }
+}
+#endif
+
 } // namespace
 
 StdIFStream::StdIFStream (const char fileName[])
     : OPENEXR_IMF_INTERNAL_NAMESPACE::IStream (fileName)
     , _is (make_ifstream (fileName))
     , _deleteStream (true)
+#ifdef _WIN32
+    , _handle (nullptr)
+#else
+    , _fd (-1)
+#endif
 {
     if (!*_is)
     {
         delete _is;
         IEX_NAMESPACE::throwErrnoExc ();
     }
+
+#ifdef _WIN32
+    _handle = openReadHandle (fileName);
+#else
+    _fd = openReadHandle (fileName);
+#endif
 }
 
 StdIFStream::StdIFStream (ifstream& is, const char fileName[])
     : OPENEXR_IMF_INTERNAL_NAMESPACE::IStream (fileName)
     , _is (&is)
     , _deleteStream (false)
+#ifdef _WIN32
+    , _handle (nullptr)
+#else
+    , _fd (-1)
+#endif
 {
     // empty
 }
 
 StdIFStream::~StdIFStream ()
 {
+#ifdef _WIN32
+    if (_handle) CloseHandle (_handle);
+#else
+    if (_fd >= 0) ::close (_fd);
+#endif
     if (_deleteStream) delete _is;
 }
 
+bool
+StdIFStream::isStatelessRead () const
+{
+#ifdef _WIN32
+    return _handle != nullptr;
+#else
+    return _fd >= 0;
+#endif
+}
+
+void
+StdIFStream::readAt (uint64_t pos, char c[/*n*/], int n)
+{
+    if (!isStatelessRead ()) IStream::readAt (pos, c, n);
+
+#ifdef _WIN32
+    readFullyAt (_handle, pos, c, n);
+#else
+    readFullyAt (_fd, pos, c, n);
+#endif
+}
+
 bool
 StdIFStream::read (char c[/*n*/], int n)
 {
@@ -297,6 +431,174 @@ StdISStream::str (const std::string& s)
     _is.str (s);
 }
 
+MMapIStream::MMapIStream (const char fileName[])
+    : OPENEXR_IMF_INTERNAL_NAMESPACE::IStream (fileName)
+    , _base (nullptr)
+    , _size (0)
+    , _pos (0)
+#ifdef _WIN32
+    , _mapping (nullptr)
+#endif
+{
+#ifdef _WIN32
+    wstring wfn  = WidenFilename (fileName);
+    HANDLE  file = CreateFileW (
+        wfn.c_str (),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        THROW (
+            IEX_NAMESPACE::IoExc,
+            "Cannot open file \"" << fileName << "\" for reading.");
+
+    LARGE_INTEGER fsize = {0};
+    if (!GetFileSizeEx (file, &fsize))
+    {
+        CloseHandle (file);
+        THROW (
+            IEX_NAMESPACE::IoExc,
+            "Cannot determine the size of file \"" << fileName << "\".");
+    }
+
+    if (fsize.QuadPart > 0)
+    {
+        HANDLE mapping =
+            CreateFileMappingW (file, NULL, PAGE_READONLY, 0, 0, NULL);
+        void* base =
+            mapping ? MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+        if (!base)
+        {
+            if (mapping) CloseHandle (mapping);
+            CloseHandle (file);
+            THROW (
+                IEX_NAMESPACE::IoExc,
+                "Cannot map file \"" << fileName << "\" into memory.");
+        }
+
+        _mapping = mapping;
+        _base    = static_cast<char*> (base);
+        _size    = static_cast<uint64_t> (fsize.QuadPart);
+    }
+
+    // the view keeps the file open
+    CloseHandle (file);
+#else
+    int fd = ::open (fileName, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) IEX_NAMESPACE::throwErrnoExc ();
+
+    struct stat sbuf;
+    if (fstat (fd, &sbuf) != 0)
+    {
+        int e = errno;
+        ::close (fd);
+        IEX_NAMESPACE::throwErrnoExc (
+            "Cannot determine the size of file \"" + std::string (fileName) +
+                "\" (%T).",
+            e);
+    }
+
+    if (sbuf.st_size > 0)
+    {
+        void* base = mmap (
+            NULL,
+            static_cast<size_t> (sbuf.st_size),
+            PROT_READ,
+            MAP_PRIVATE,
+            fd,
+            0);
+
+        if (base == MAP_FAILED)
+        {
+            int e = errno;
+            ::close (fd);
+            IEX_NAMESPACE::throwErrnoExc (
+                "Cannot map file \"" + std::string (fileName) +
+                    "\" into memory (%T).",
+                e);
+        }
+
+        _base = static_cast<char*> (base);
+        _size = static_cast<uint64_t> (sbuf.st_size);
+    }
+
+    // the mapping keeps the file open
+    ::close (fd);
+#endif
+}
+
+MMapIStream::~MMapIStream ()
+{
+#ifdef _WIN32
+    if (_base) UnmapViewOfFile (_base);
+    if (_mapping) CloseHandle (_mapping);
+#else
+    if (_base) munmap (_base, static_cast<size_t> (_size));
+#endif
+}
+
+bool
+MMapIStream::isMemoryMapped () const
+{
+    return true;
+}
+
+bool
+MMapIStream::read (char c[/*n*/], int n)
+{
+    const char* data = readMemoryMapped (n);
+    if (n > 0) memcpy (c, data, n);
+    return _pos < _size;
+}
+
+char*
+MMapIStream::readMemoryMapped (int n)
+{
+    if (n < 0 || _pos > _size || static_cast<uint64_t> (n) > _size - _pos)
+    {
+        THROW (
+            IEX_NAMESPACE::InputExc,
+            "Early end of file: read "
+                << (_pos < _size ? _size - _pos : 0) << " out of " << n
+                << " requested bytes.");
+    }
+
+    char* data = _base + _pos;
+    _pos += n;
+    return data;
+}
+
+bool
+MMapIStream::isStatelessRead () const
+{
+    return true;
+}
+
+void
+MMapIStream::readAt (uint64_t pos, char c[/*n*/], int n)
+{
+    if (n < 0 || pos > _size || static_cast<uint64_t> (n) > _size - pos)
+        throwEarlyEnd (pos < _size ? int (min<uint64_t> (_size - pos, n)) : 0, n);
+
+    if (n > 0) memcpy (c, _base + pos, n);
+}
+
+uint64_t
+MMapIStream::tellg ()
+{
+    return _pos;
+}
+
+void
+MMapIStream::seekg (uint64_t pos)
+{
+    _pos = pos;
+}
+
 StdOFStream::StdOFStream (const char fileName[])
     : OPENEXR_IMF_INTERNAL_NAMESPACE::OStream (fileName)
     , _os (make_ofstream (fileName))
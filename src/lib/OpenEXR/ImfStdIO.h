@@ -58,9 +58,24 @@ public:
     IMF_EXPORT virtual void     seekg (uint64_t pos);
     IMF_EXPORT virtual void     clear ();
 
+    //---------------------------------------------------------
+    // If the StdIFStream opened the file itself, it also keeps
+    // a native file handle open, and readAt() reads from that
+    // with pread() (ReadFile() on Windows), without touching
+    // the std::ifstream.
+    //---------------------------------------------------------
+
+    IMF_EXPORT virtual bool isStatelessRead () const;
+    IMF_EXPORT virtual void readAt (uint64_t pos, char c[/*n*/], int n);
+
 private:
     std::ifstream* _is;
     bool           _deleteStream;
+#ifdef _WIN32
+    void* _handle;
+#else
+    int _fd;
+#endif
 };
 
 //------------------------------------------------
@@ -92,6 +107,49 @@ private:
     std::istringstream _is;
 };
 
+//-------------------------------------------------------------
+// class MMapIStream -- an implementation of class
+// OPENEXR_IMF_INTERNAL_NAMESPACE::IStream that maps the whole
+// file into memory.  readMemoryMapped() returns pointers into
+// the mapping, so the readers hand chunks to the decompressors
+// without copying them.  The mapping is read-only, and the
+// bytes behind those pointers must not be modified.
+//-------------------------------------------------------------
+
+class IMF_EXPORT_TYPE MMapIStream
+    : public OPENEXR_IMF_INTERNAL_NAMESPACE::IStream
+{
+public:
+    //-------------------------------------------------------
+    // A constructor that maps the file with the given name.
+    // The destructor will unmap and close the file.
+    //-------------------------------------------------------
+
+    IMF_EXPORT MMapIStream (const char fileName[]);
+
+    IMF_EXPORT virtual ~MMapIStream ();
+    MMapIStream (const MMapIStream&) = delete;
+    MMapIStream (MMapIStream&&)      = delete;
+    MMapIStream& operator= (const MMapIStream&) = delete;
+    MMapIStream& operator= (MMapIStream&&) = delete;
+
+    IMF_EXPORT virtual bool     isMemoryMapped () const;
+    IMF_EXPORT virtual bool     read (char c[/*n*/], int n);
+    IMF_EXPORT virtual char*    readMemoryMapped (int n);
+    IMF_EXPORT virtual uint64_t tellg ();
+    IMF_EXPORT virtual void     seekg (uint64_t pos);
+    IMF_EXPORT virtual bool     isStatelessRead () const;
+    IMF_EXPORT virtual void     readAt (uint64_t pos, char c[/*n*/], int n);
+
+private:
+    char*    _base;
+    uint64_t _size;
+    uint64_t _pos;
+#ifdef _WIN32
+    void* _mapping;
+#endif
+};
+
 //-------------------------------------------
 // class StdOFStream -- an implementation of
 // class OPENEXR_IMF_INTERNAL_NAMESPACE::OStream based on class std::ofstream
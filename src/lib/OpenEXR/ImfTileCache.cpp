@@ -0,0 +1,398 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//-----------------------------------------------------------------------------
+//
+//	Tile cache for the OpenEXR library
+//
+//	The cache is split into shards, each with its own lock, LRU list
+//	and share of the size limit, so that threads decompressing
+//	different tiles rarely contend for the same lock.
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfTileCache.h"
+#include "ImfCachedTile.h"
+#include "ImfMisc.h"
+#include "ImfStdIO.h"
+
+#include "IlmThreadConfig.h"
+
+#include <atomic>
+#include <list>
+#include <sstream>
+#include <unordered_map>
+
+#if ILMTHREAD_THREADING_ENABLED
+#    include <mutex>
+#endif
+
+#ifdef _WIN32
+#    define VC_EXTRALEAN
+#    include <windows.h>
+#else
+#    include <sys/stat.h>
+#endif
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+using std::shared_ptr;
+using std::string;
+
+namespace
+{
+
+const int NUM_SHARDS = 16;
+
+struct Entry
+{
+    string                       fileId;
+    int                          partNumber;
+    int                          dx;
+    int                          dy;
+    int                          lx;
+    int                          ly;
+    uint64_t                     offset;
+    size_t                       hash;
+    shared_ptr<const CachedTile> tile;
+
+    bool matches (const TileCacheKey& key) const
+    {
+        return offset == key.offset && dx == key.dx && dy == key.dy &&
+               lx == key.lx && ly == key.ly && partNumber == key.partNumber &&
+               fileId == *key.fileId;
+    }
+};
+
+typedef std::list<Entry> EntryList;
+
+struct Shard
+#if ILMTHREAD_THREADING_ENABLED
+    : public std::mutex
+#endif
+{
+    EntryList entries; // most recently used first
+    std::unordered_multimap<size_t, EntryList::iterator> index;
+    size_t                                               size     = 0;
+    size_t                                               capacity = 0;
+
+    EntryList::iterator find (const TileCacheKey& key, size_t hash);
+    void                erase (EntryList::iterator i);
+    void                trim ();
+    void                clear ();
+};
+
+struct TileCache
+{
+    Shard                 shards[NUM_SHARDS];
+    std::atomic<size_t>   maxBytes{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+};
+
+TileCache&
+theCache ()
+{
+    static TileCache cache;
+    return cache;
+}
+
+//
+// Append the identity of the named file to s, or return false if it
+// cannot be determined
+//
+
+bool
+appendFileIdentity (std::ostringstream& s, const char* fileName)
+{
+#ifdef _WIN32
+    std::wstring wfn = WidenFilename (fileName);
+    HANDLE       file = CreateFileW (
+        wfn.c_str (),
+        0,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    BY_HANDLE_FILE_INFORMATION info;
+    BOOL                       ok = GetFileInformationByHandle (file, &info);
+    CloseHandle (file);
+    if (!ok) return false;
+
+    s << info.dwVolumeSerialNumber << ':' << info.nFileIndexHigh << ':'
+      << info.nFileIndexLow << ':' << info.nFileSizeHigh << ':'
+      << info.nFileSizeLow << ':' << info.ftLastWriteTime.dwHighDateTime
+      << ':' << info.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat sbuf;
+    if (stat (fileName, &sbuf) != 0 || !S_ISREG (sbuf.st_mode)) return false;
+
+    s << uint64_t (sbuf.st_dev) << ':' << uint64_t (sbuf.st_ino) << ':'
+      << uint64_t (sbuf.st_size) << ':' << int64_t (sbuf.st_mtime);
+#    if defined(__APPLE__)
+    s << '.' << sbuf.st_mtimespec.tv_nsec;
+#    elif defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L
+    s << '.' << sbuf.st_mtim.tv_nsec;
+#    endif
+#endif
+    return true;
+}
+
+size_t
+keyHash (const TileCacheKey& key)
+{
+    //
+    // Combine the fields in the style of boost::hash_combine
+    //
+
+    size_t h = key.fileHash;
+
+    const uint64_t fields[] = {
+        uint64_t (key.partNumber),
+        uint64_t (key.dx),
+        uint64_t (key.dy),
+        uint64_t (key.lx),
+        uint64_t (key.ly),
+        key.offset};
+
+    for (uint64_t f: fields)
+        h ^= size_t (f) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+
+    return h;
+}
+
+Shard&
+shardFor (size_t hash)
+{
+    return theCache ().shards[(hash >> 7) % NUM_SHARDS];
+}
+
+EntryList::iterator
+Shard::find (const TileCacheKey& key, size_t hash)
+{
+    auto range = index.equal_range (hash);
+
+    for (auto i = range.first; i != range.second; ++i)
+        if (i->second->matches (key)) return i->second;
+
+    return entries.end ();
+}
+
+void
+Shard::erase (EntryList::iterator e)
+{
+    auto range = index.equal_range (e->hash);
+
+    for (auto i = range.first; i != range.second; ++i)
+    {
+        if (i->second == e)
+        {
+            index.erase (i);
+            break;
+        }
+    }
+
+    size -= e->tile->data.size ();
+    entries.erase (e);
+}
+
+void
+Shard::trim ()
+{
+    while (size > capacity && !entries.empty ())
+    {
+        erase (std::prev (entries.end ()));
+        ++theCache ().evictions;
+    }
+}
+
+void
+Shard::clear ()
+{
+    entries.clear ();
+    index.clear ();
+    size = 0;
+}
+
+} // namespace
+
+void
+setTileCacheSize (size_t maxBytes)
+{
+    TileCache& cache = theCache ();
+    cache.maxBytes   = maxBytes;
+
+    for (Shard& shard: cache.shards)
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (shard);
+#endif
+        shard.capacity = maxBytes / NUM_SHARDS;
+
+        if (maxBytes == 0)
+            shard.clear ();
+        else
+            shard.trim ();
+    }
+}
+
+size_t
+tileCacheSize ()
+{
+    return theCache ().maxBytes;
+}
+
+TileCacheStats
+tileCacheStats ()
+{
+    TileCache&     cache = theCache ();
+    TileCacheStats stats;
+
+    stats.hits      = cache.hits;
+    stats.misses    = cache.misses;
+    stats.evictions = cache.evictions;
+    stats.size      = 0;
+
+    for (Shard& shard: cache.shards)
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (shard);
+#endif
+        stats.size += shard.size;
+    }
+
+    return stats;
+}
+
+void
+clearTileCache ()
+{
+    TileCache& cache = theCache ();
+
+    for (Shard& shard: cache.shards)
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (shard);
+#endif
+        shard.clear ();
+    }
+
+    cache.hits      = 0;
+    cache.misses    = 0;
+    cache.evictions = 0;
+}
+
+string
+tileCacheFileId (IStream& is)
+{
+    static std::atomic<uint64_t> nextStreamId{0};
+
+    //
+    // Only streams that open the file by name themselves are known to
+    // read the file that fileName () names; a StdIFStream built around
+    // an already open std::ifstream (which is not a stateless reader),
+    // or a user's stream, may not.
+    //
+
+    const char*        name = is.fileName ();
+    StdIFStream*       ifs  = dynamic_cast<StdIFStream*> (&is);
+    std::ostringstream s;
+
+    if (name && ((ifs && ifs->isStatelessRead ()) ||
+                 dynamic_cast<MMapIStream*> (&is)))
+    {
+        s << "file:";
+        if (appendFileIdentity (s, name)) return s.str ();
+        s.str (string ());
+    }
+
+    s << "stream:" << nextStreamId++;
+    return s.str ();
+}
+
+bool
+tileCacheEnabled ()
+{
+    return theCache ().maxBytes != 0;
+}
+
+shared_ptr<const CachedTile>
+findCachedTile (const TileCacheKey& key)
+{
+    TileCache& cache = theCache ();
+    size_t     hash  = keyHash (key);
+    Shard&     shard = shardFor (hash);
+
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (shard);
+#endif
+        EntryList::iterator e = shard.find (key, hash);
+
+        if (e != shard.entries.end ())
+        {
+            shard.entries.splice (shard.entries.begin (), shard.entries, e);
+            ++cache.hits;
+            return e->tile;
+        }
+    }
+
+    ++cache.misses;
+    return shared_ptr<const CachedTile> ();
+}
+
+void
+cacheTile (
+    const TileCacheKey& key,
+    const char*         data,
+    size_t              size,
+    Compressor::Format  format)
+{
+    size_t hash  = keyHash (key);
+    Shard& shard = shardFor (hash);
+
+    //
+    // Copy the data before taking the lock; tiles that would not
+    // fit into their shard even when it is empty are not cached.
+    //
+
+    if (size == 0 || size > theCache ().maxBytes / NUM_SHARDS) return;
+
+    std::shared_ptr<CachedTile> tile (new CachedTile);
+    tile->data.assign (data, data + size);
+    tile->format = format;
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (shard);
+#endif
+
+    //
+    // Another thread may have cached the same tile in the meantime
+    //
+
+    if (shard.find (key, hash) != shard.entries.end ()) return;
+
+    Entry entry;
+    entry.fileId     = *key.fileId;
+    entry.partNumber = key.partNumber;
+    entry.dx         = key.dx;
+    entry.dy         = key.dy;
+    entry.lx         = key.lx;
+    entry.ly         = key.ly;
+    entry.offset     = key.offset;
+    entry.hash       = hash;
+    entry.tile       = tile;
+
+    shard.entries.push_front (std::move (entry));
+    shard.index.emplace (hash, shard.entries.begin ());
+    shard.size += size;
+    shard.trim ();
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
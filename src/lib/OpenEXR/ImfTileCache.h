@@ -0,0 +1,81 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_TILE_CACHE_H
+#define INCLUDED_IMF_TILE_CACHE_H
+
+#include "ImfExport.h"
+#include "ImfNamespace.h"
+
+#include <cstddef>
+#include <cstdint>
+
+//-----------------------------------------------------------------------------
+//
+//	Tile cache for the OpenEXR library
+//
+//	Texture-style access patterns read the same tiles of a file over
+//	and over, and each read normally costs a trip to the file and a
+//	full decompression.  The tile cache keeps recently uncompressed
+//	tiles in memory, so that TiledInputFile::readTile() can copy a
+//	tile straight into the frame buffer on a hit.
+//
+//	The cache is shared by all TiledInputFile and TiledInputPart
+//	objects in the process, is bounded by a total number of bytes,
+//	and evicts the least recently used tiles first.  It is safe to
+//	use from several threads; its entries are spread over a number
+//	of independently locked shards.
+//
+//	Tiles are identified by file, part number, level, tile coordinates
+//	and the tile's offset in the file.  A file that the library opens
+//	by name is identified by its device and inode (volume and file
+//	index on Windows), size and modification time, so all readers of
+//	the file share its tiles, and a file that is rewritten no longer
+//	matches the tiles cached before.  Tiles read through any other
+//	stream, whose file cannot be known, are only found again by the
+//	same TiledInputFile or TiledInputPart.
+//
+//	The cache is disabled (its size is zero) by default.
+//
+//-----------------------------------------------------------------------------
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+struct TileCacheStats
+{
+    uint64_t hits;      // tiles found in the cache
+    uint64_t misses;    // tiles looked up but not found
+    uint64_t evictions; // tiles dropped to make room for others
+    size_t   size;      // bytes currently held by the cache
+};
+
+//-----------------------------------------------------------------------------
+// Set the maximum number of bytes of uncompressed tile data kept by
+// the cache.  Zero disables the cache and frees its contents.
+//-----------------------------------------------------------------------------
+
+IMF_EXPORT void setTileCacheSize (size_t maxBytes);
+
+//-----------------------------------------------------------------------------
+// Return the maximum number of bytes kept by the cache
+//-----------------------------------------------------------------------------
+
+IMF_EXPORT size_t tileCacheSize ();
+
+//-----------------------------------------------------------------------------
+// Return the cache's hit, miss and eviction counts and its current size
+//-----------------------------------------------------------------------------
+
+IMF_EXPORT TileCacheStats tileCacheStats ();
+
+//-----------------------------------------------------------------------------
+// Drop all cached tiles and reset the counters
+//-----------------------------------------------------------------------------
+
+IMF_EXPORT void clearTileCache ();
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
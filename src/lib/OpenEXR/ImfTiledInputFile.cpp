@@ -15,6 +15,7 @@
 #include "IlmThreadPool.h"
 #include "IlmThreadSemaphore.h"
 #include "ImathVec.h"
+#include "ImfCachedTile.h"
 #include "ImfChannelList.h"
 #include "ImfCompressor.h"
 #include "ImfConvert.h"
@@ -35,6 +36,8 @@
 #include "ImfXdr.h"
 #include <algorithm>
 #include <assert.h>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -116,9 +119,13 @@ struct TileBuffer
     int                dy;
     int                lx;
     int                ly;
+    bool               needsRead; // buffer is filled in by the task
     bool               hasException;
     string             exception;
 
+    std::shared_ptr<const CachedTile> cachedTile; // set on a cache hit
+    TileCacheKey cacheKey; // fileId is null if the tile is not cached
+
     TileBuffer (Compressor* const comp);
     ~TileBuffer ();
 
@@ -144,8 +151,11 @@ TileBuffer::TileBuffer (Compressor* comp)
     , dy (-1)
     , lx (-1)
     , ly (-1)
+    , needsRead (false)
     , hasException (false)
     , exception ()
+    , cachedTile ()
+    , cacheKey ()
     , _sem (1)
 {
     // empty
@@ -213,6 +223,9 @@ struct TiledInputFile::Data
 
     bool memoryMapped; // if the stream is memory mapped
 
+    string cacheFileId;   // identifies the file in the tile cache
+    size_t cacheFileHash; // hash of cacheFileId
+
     InputStreamMutex* _streamData;
     bool              _deleteStream;
 
@@ -242,6 +255,7 @@ TiledInputFile::Data::Data (int numThreads)
     , numThreads (numThreads)
     , multiPartFile (nullptr)
     , memoryMapped (false)
+    , cacheFileHash (0)
     , _streamData (NULL)
     , _deleteStream (false)
 {
@@ -450,6 +464,89 @@ readTileData (
     streamData->currentPosition = tileOffset + 5 * Xdr::size<int> () + dataSize;
 }
 
+//
+// Read a single tile block with IStream::readAt() instead of seekg()
+// and read().  This is called by the tile buffer tasks, without the
+// stream mutex, so that several tasks can wait for I/O at once.  It
+// does not move the stream, so currentPosition stays valid.
+//
+
+void
+readTileDataAt (TiledInputFile::Data* ifd, TileBuffer* tileBuffer)
+{
+    tileBuffer->needsRead = false;
+
+    int dx = tileBuffer->dx;
+    int dy = tileBuffer->dy;
+    int lx = tileBuffer->lx;
+    int ly = tileBuffer->ly;
+
+    uint64_t tileOffset = ifd->tileOffsets (dx, dy, lx, ly);
+
+    if (tileOffset == 0)
+    {
+        THROW (
+            IEX_NAMESPACE::InputExc,
+            "Tile (" << dx << ", " << dy << ", " << lx << ", " << ly
+                     << ") is missing.");
+    }
+
+    //
+    // Read and verify the tile's header: the part number in a
+    // multi-part file, the tile and level coordinates and the
+    // data size.
+    //
+
+    char header[6 * 4];
+    int  headerSize = (isMultiPart (ifd->version) ? 6 : 5) * Xdr::size<int> ();
+
+    ifd->_streamData->is->readAt (tileOffset, header, headerSize);
+
+    const char* readPtr = header;
+    int         tileXCoord, tileYCoord, levelX, levelY, dataSize;
+
+    if (isMultiPart (ifd->version))
+    {
+        int partNumber;
+        Xdr::read<CharPtrIO> (readPtr, partNumber);
+        if (partNumber != ifd->partNumber)
+        {
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Unexpected part number " << partNumber << ", should be "
+                                          << ifd->partNumber << ".");
+        }
+    }
+
+    Xdr::read<CharPtrIO> (readPtr, tileXCoord);
+    Xdr::read<CharPtrIO> (readPtr, tileYCoord);
+    Xdr::read<CharPtrIO> (readPtr, levelX);
+    Xdr::read<CharPtrIO> (readPtr, levelY);
+    Xdr::read<CharPtrIO> (readPtr, dataSize);
+
+    if (tileXCoord != dx)
+        throw IEX_NAMESPACE::InputExc ("Unexpected tile x coordinate.");
+
+    if (tileYCoord != dy)
+        throw IEX_NAMESPACE::InputExc ("Unexpected tile y coordinate.");
+
+    if (levelX != lx)
+        throw IEX_NAMESPACE::InputExc (
+            "Unexpected tile x level number coordinate.");
+
+    if (levelY != ly)
+        throw IEX_NAMESPACE::InputExc (
+            "Unexpected tile y level number coordinate.");
+
+    if (dataSize < 0 || dataSize > static_cast<int> (ifd->tileBufferSize))
+        throw IEX_NAMESPACE::InputExc ("Unexpected tile block length.");
+
+    ifd->_streamData->is->readAt (
+        tileOffset + headerSize, tileBuffer->buffer, dataSize);
+
+    tileBuffer->dataSize = dataSize;
+}
+
 void
 readNextTileData (
     InputStreamMutex*     streamData,
@@ -537,6 +634,7 @@ TileBufferTask::~TileBufferTask ()
     // Signal that the tile buffer is now free
     //
 
+    _tileBuffer->cachedTile.reset ();
     _tileBuffer->post ();
 }
 
@@ -567,29 +665,55 @@ TileBufferTask::execute ()
 
         int sizeOfTile = _ifd->bytesPerPixel * numPixelsInTile;
 
-        //
-        // Uncompress the data, if necessary
-        //
-
-        if (_tileBuffer->compressor && _tileBuffer->dataSize < sizeOfTile)
+        if (_tileBuffer->cachedTile)
         {
-            _tileBuffer->format = _tileBuffer->compressor->format ();
+            //
+            // The tile cache already holds the uncompressed data
+            //
 
-            _tileBuffer->dataSize = _tileBuffer->compressor->uncompressTile (
-                _tileBuffer->buffer,
-                _tileBuffer->dataSize,
-                tileRange,
-                _tileBuffer->uncompressedData);
+            _tileBuffer->format = _tileBuffer->cachedTile->format;
+            _tileBuffer->uncompressedData =
+                _tileBuffer->cachedTile->data.data ();
         }
         else
         {
+            if (_tileBuffer->needsRead) readTileDataAt (_ifd, _tileBuffer);
+
             //
-            // If the line is uncompressed, it's in XDR format,
-            // regardless of the compressor's output format.
+            // Uncompress the data, if necessary
             //
 
-            _tileBuffer->format           = Compressor::XDR;
-            _tileBuffer->uncompressedData = _tileBuffer->buffer;
+            if (_tileBuffer->compressor && _tileBuffer->dataSize < sizeOfTile)
+            {
+                _tileBuffer->format = _tileBuffer->compressor->format ();
+
+                _tileBuffer->dataSize =
+                    _tileBuffer->compressor->uncompressTile (
+                        _tileBuffer->buffer,
+                        _tileBuffer->dataSize,
+                        tileRange,
+                        _tileBuffer->uncompressedData);
+            }
+            else
+            {
+                //
+                // If the line is uncompressed, it's in XDR format,
+                // regardless of the compressor's output format.
+                //
+
+                _tileBuffer->format           = Compressor::XDR;
+                _tileBuffer->uncompressedData = _tileBuffer->buffer;
+            }
+
+            if (_tileBuffer->cacheKey.fileId &&
+                _tileBuffer->dataSize == sizeOfTile)
+            {
+                cacheTile (
+                    _tileBuffer->cacheKey,
+                    _tileBuffer->uncompressedData,
+                    sizeOfTile,
+                    _tileBuffer->format);
+            }
         }
 
         //
@@ -716,15 +840,47 @@ newTileBufferTask (
 
         tileBuffer->uncompressedData = 0;
 
-        readTileData (
-            streamData,
-            ifd,
-            dx,
-            dy,
-            lx,
-            ly,
-            tileBuffer->buffer,
-            tileBuffer->dataSize);
+        //
+        // If the tile cache holds the tile, the task needs
+        // neither the compressed data nor the compressor.
+        //
+
+        tileBuffer->cacheKey.fileId = nullptr;
+
+        if (tileCacheEnabled ())
+        {
+            uint64_t tileOffset = ifd->tileOffsets (dx, dy, lx, ly);
+
+            if (tileOffset != 0)
+            {
+                TileCacheKey& key = tileBuffer->cacheKey;
+                key.fileId        = &ifd->cacheFileId;
+                key.fileHash      = ifd->cacheFileHash;
+                key.partNumber    = ifd->partNumber;
+                key.dx            = dx;
+                key.dy            = dy;
+                key.lx            = lx;
+                key.ly            = ly;
+                key.offset        = tileOffset;
+
+                tileBuffer->cachedTile = findCachedTile (key);
+            }
+        }
+
+        if (tileBuffer->cachedTile)
+            tileBuffer->needsRead = false;
+        else if (!ifd->memoryMapped && streamData->is->isStatelessRead ())
+            tileBuffer->needsRead = true;
+        else
+            readTileData (
+                streamData,
+                ifd,
+                dx,
+                dy,
+                lx,
+                ly,
+                tileBuffer->buffer,
+                tileBuffer->dataSize);
     }
     catch (...)
     {
@@ -1031,6 +1187,10 @@ TiledInputFile::initialize ()
     // (for multipart files, the chunk offset table has already been read)
     //
     if (!isMultiPart (_data->version)) { _data->validateStreamSize (); }
+
+    _data->cacheFileId   = tileCacheFileId (*_data->_streamData->is);
+    _data->cacheFileHash = std::hash<string> () (_data->cacheFileId);
+
     _data->tileDesc  = _data->header.tileDescription ();
     _data->lineOrder = _data->header.lineOrder ();
 
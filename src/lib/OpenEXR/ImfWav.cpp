@@ -14,6 +14,7 @@
 //-----------------------------------------------------------------------------
 
 #include "ImfNamespace.h"
+#include "ImfSimd.h"
 #include <ImfWav.h>
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
@@ -97,6 +98,350 @@ wdec16 (
     a      = aa;
 }
 
+//
+// With SIMD, the levels whose samples are ox * p = 1 or 2 apart are
+// done one pair of lines at a time: the horizontal step on both lines,
+// then the vertical step on all the columns of the pair, on whole
+// vectors with the lanes that are not part of the level left
+// untouched.  Wider levels leave too few useful lanes, and keep the
+// scalar block loop below.
+//
+
+#if defined(IMF_HAVE_SSE2) || defined(IMF_HAVE_NEON_AARCH64)
+#    define IMF_WAV_SIMD 1
+
+enum WavOp
+{
+    WAV_ENC14,
+    WAV_ENC16,
+    WAV_DEC14,
+    WAV_DEC16
+};
+
+#    if defined(IMF_HAVE_NEON_AARCH64)
+
+typedef uint16x8_t WavVec;
+
+inline WavVec
+vLoad (const unsigned short* p)
+{
+    return vld1q_u16 (p);
+}
+inline void
+vStore (unsigned short* p, WavVec v)
+{
+    vst1q_u16 (p, v);
+}
+inline WavVec
+vSplat (unsigned short x)
+{
+    return vdupq_n_u16 (x);
+}
+inline WavVec
+vAdd (WavVec a, WavVec b)
+{
+    return vaddq_u16 (a, b);
+}
+inline WavVec
+vSub (WavVec a, WavVec b)
+{
+    return vsubq_u16 (a, b);
+}
+inline WavVec
+vAnd (WavVec a, WavVec b)
+{
+    return vandq_u16 (a, b);
+}
+inline WavVec
+vXor (WavVec a, WavVec b)
+{
+    return veorq_u16 (a, b);
+}
+inline WavVec
+vSra1 (WavVec a)
+{
+    return vreinterpretq_u16_s16 (vshrq_n_s16 (vreinterpretq_s16_u16 (a), 1));
+}
+inline WavVec
+vSrl1 (WavVec a)
+{
+    return vshrq_n_u16 (a, 1);
+}
+inline WavVec
+vLessU (WavVec a, WavVec b)
+{
+    return vcltq_u16 (a, b);
+}
+inline WavVec
+vSelect (WavVec m, WavVec a, WavVec b)
+{
+    return vbslq_u16 (m, a, b);
+}
+inline WavVec
+vLaneIndex ()
+{
+    static const unsigned short idx[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    return vld1q_u16 (idx);
+}
+inline WavVec
+vEqual (WavVec a, WavVec b)
+{
+    return vceqq_u16 (a, b);
+}
+template <int S>
+inline WavVec
+vShiftDown (WavVec v)
+{
+    return vextq_u16 (v, vdupq_n_u16 (0), S);
+}
+template <int S>
+inline WavVec
+vShiftUp (WavVec v)
+{
+    return vextq_u16 (vdupq_n_u16 (0), v, 8 - S);
+}
+
+#    else
+
+typedef __m128i WavVec;
+
+inline WavVec
+vLoad (const unsigned short* p)
+{
+    return _mm_loadu_si128 ((const __m128i*) p);
+}
+inline void
+vStore (unsigned short* p, WavVec v)
+{
+    _mm_storeu_si128 ((__m128i*) p, v);
+}
+inline WavVec
+vSplat (unsigned short x)
+{
+    return _mm_set1_epi16 ((short) x);
+}
+inline WavVec
+vAdd (WavVec a, WavVec b)
+{
+    return _mm_add_epi16 (a, b);
+}
+inline WavVec
+vSub (WavVec a, WavVec b)
+{
+    return _mm_sub_epi16 (a, b);
+}
+inline WavVec
+vAnd (WavVec a, WavVec b)
+{
+    return _mm_and_si128 (a, b);
+}
+inline WavVec
+vXor (WavVec a, WavVec b)
+{
+    return _mm_xor_si128 (a, b);
+}
+inline WavVec
+vSra1 (WavVec a)
+{
+    return _mm_srai_epi16 (a, 1);
+}
+inline WavVec
+vSrl1 (WavVec a)
+{
+    return _mm_srli_epi16 (a, 1);
+}
+inline WavVec
+vLessU (WavVec a, WavVec b)
+{
+    const __m128i sign = _mm_set1_epi16 ((short) 0x8000);
+    return _mm_cmplt_epi16 (_mm_xor_si128 (a, sign), _mm_xor_si128 (b, sign));
+}
+inline WavVec
+vSelect (WavVec m, WavVec a, WavVec b)
+{
+    return _mm_or_si128 (_mm_and_si128 (m, a), _mm_andnot_si128 (m, b));
+}
+inline WavVec
+vLaneIndex ()
+{
+    return _mm_setr_epi16 (0, 1, 2, 3, 4, 5, 6, 7);
+}
+inline WavVec
+vEqual (WavVec a, WavVec b)
+{
+    return _mm_cmpeq_epi16 (a, b);
+}
+template <int S>
+inline WavVec
+vShiftDown (WavVec v)
+{
+    return _mm_srli_si128 (v, 2 * S);
+}
+template <int S>
+inline WavVec
+vShiftUp (WavVec v)
+{
+    return _mm_slli_si128 (v, 2 * S);
+}
+
+#    endif
+
+const int WAV_LANES = 8;
+
+//
+// The lanes whose index modulo period is phase
+//
+
+inline WavVec
+vLaneMask (int period, int phase)
+{
+    return vEqual (
+        vAnd (vLaneIndex (), vSplat ((unsigned short) (period - 1))),
+        vSplat ((unsigned short) phase));
+}
+
+template <int Op>
+inline void
+wavPair (
+    unsigned short a, unsigned short b, unsigned short& l, unsigned short& h)
+{
+    switch (Op)
+    {
+        case WAV_ENC14: wenc14 (a, b, l, h); break;
+        case WAV_ENC16: wenc16 (a, b, l, h); break;
+        case WAV_DEC14: wdec14 (a, b, l, h); break;
+        default: wdec16 (a, b, l, h); break;
+    }
+}
+
+//
+// Same as wavPair, one pair per lane, in 16-bit arithmetic
+//
+
+template <int Op>
+inline void
+wavPair (WavVec a, WavVec b, WavVec& l, WavVec& h)
+{
+    const WavVec one  = vSplat (1);
+    const WavVec sign = vSplat (0x8000);
+    WavVec       t;
+
+    switch (Op)
+    {
+        case WAV_ENC14:
+            // floor ((a + b) / 2) without leaving 16 bits
+            l = vAdd (vAdd (vSra1 (a), vSra1 (b)), vAnd (vAnd (a, b), one));
+            h = vSub (a, b);
+            break;
+        case WAV_ENC16:
+            a = vXor (a, sign);
+            t = vAdd (vAnd (a, b), vSrl1 (vXor (a, b)));
+            l = vXor (t, vAnd (vLessU (a, b), sign));
+            h = vSub (a, b);
+            break;
+        case WAV_DEC14:
+            t = vAdd (vAdd (a, vAnd (b, one)), vSra1 (b));
+            h = vSub (t, b);
+            l = t;
+            break;
+        default:
+            t = vSub (a, vSrl1 (b));
+            l = vXor (vAdd (b, t), sign);
+            h = t;
+            break;
+    }
+}
+
+//
+// Horizontal step on one line: n pairs (row[2ks], row[2ks + S]).
+// A vector may only be used if it does not reach past the last
+// sample of the line, as the line may end the buffer.
+//
+
+template <int S, int Op>
+void
+wavLine (unsigned short* row, int n)
+{
+    const WavVec ml = vLaneMask (2 * S, 0);
+    const WavVec mh = vLaneMask (2 * S, S);
+    int          k  = 0;
+
+    for (; 2 * k * S + WAV_LANES <= (2 * n - 1) * S + 1;
+         k += WAV_LANES / (2 * S))
+    {
+        unsigned short* p = row + 2 * k * S;
+        WavVec          v = vLoad (p);
+        WavVec          l, h;
+
+        wavPair<Op> (v, vShiftDown<S> (v), l, h);
+        vStore (p, vSelect (ml, l, vSelect (mh, vShiftUp<S> (h), v)));
+    }
+
+    for (row += 2 * k * S; k < n; ++k, row += 2 * S)
+        wavPair<Op> (row[0], row[S], row[0], row[S]);
+}
+
+//
+// Vertical step on a pair of lines: n pairs (a[kS], b[kS]).
+//
+
+template <int S, int Op>
+void
+wavColumns (unsigned short* a, unsigned short* b, int n)
+{
+    const WavVec m = vLaneMask (S, 0);
+    int          k = 0;
+
+    for (; k * S + WAV_LANES <= (n - 1) * S + 1; k += WAV_LANES / S)
+    {
+        WavVec va = vLoad (a + k * S);
+        WavVec vb = vLoad (b + k * S);
+        WavVec l, h;
+
+        wavPair<Op> (va, vb, l, h);
+        vStore (a + k * S, vSelect (m, l, va));
+        vStore (b + k * S, vSelect (m, h, vb));
+    }
+
+    for (a += k * S, b += k * S; k < n; ++k, a += S, b += S)
+        wavPair<Op> (*a, *b, *a, *b);
+}
+
+//
+// One level of the transform with samples S apart
+//
+
+template <int S, int Op>
+void
+wavLines (unsigned short* py, int nx, int ny, int p, int oy1)
+{
+    const bool encode = (Op == WAV_ENC14 || Op == WAV_ENC16);
+    int        nbx    = nx / (2 * p);                 // 2x2 blocks per line
+    int        ncx    = 2 * nbx + ((nx & p) ? 1 : 0); // columns, odd included
+
+    for (int y = ny / (2 * p); y > 0; --y, py += 2 * oy1)
+    {
+        if (!encode) wavColumns<S, Op> (py, py + oy1, ncx);
+        wavLine<S, Op> (py, nbx);
+        wavLine<S, Op> (py + oy1, nbx);
+        if (encode) wavColumns<S, Op> (py, py + oy1, ncx);
+    }
+
+    if (ny & p) wavLine<S, Op> (py, nbx);
+}
+
+template <int Op>
+void
+wavLines (unsigned short* py, int nx, int ny, int p, int ox1, int oy1)
+{
+    if (ox1 == 1)
+        wavLines<1, Op> (py, nx, ny, p, oy1);
+    else
+        wavLines<2, Op> (py, nx, ny, p, oy1);
+}
+
+#endif
+
 } // namespace
 
 //
@@ -131,81 +476,93 @@ wav2Encode (
         int             ox2 = ox * p2;
         unsigned short  i00, i01, i10, i11;
 
-        //
-        // Y loop
-        //
-
-        for (; py <= ey; py += oy2)
+#ifdef IMF_WAV_SIMD
+        if (ox1 <= 2)
+        {
+            if (w14)
+                wavLines<WAV_ENC14> (py, nx, ny, p, ox1, oy1);
+            else
+                wavLines<WAV_ENC16> (py, nx, ny, p, ox1, oy1);
+        }
+        else
+#endif
         {
-            unsigned short* px = py;
-            unsigned short* ex = py + ox * (nx - p2);
-
             //
-            // X loop
+            // Y loop
             //
 
-            for (; px <= ex; px += ox2)
+            for (; py <= ey; py += oy2)
             {
-                unsigned short* p01 = px + ox1;
-                unsigned short* p10 = px + oy1;
-                unsigned short* p11 = p10 + ox1;
+                unsigned short* px = py;
+                unsigned short* ex = py + ox * (nx - p2);
 
                 //
-                // 2D wavelet encoding
+                // X loop
                 //
 
-                if (w14)
+                for (; px <= ex; px += ox2)
                 {
-                    wenc14 (*px, *p01, i00, i01);
-                    wenc14 (*p10, *p11, i10, i11);
-                    wenc14 (i00, i10, *px, *p10);
-                    wenc14 (i01, i11, *p01, *p11);
+                    unsigned short* p01 = px + ox1;
+                    unsigned short* p10 = px + oy1;
+                    unsigned short* p11 = p10 + ox1;
+
+                    //
+                    // 2D wavelet encoding
+                    //
+
+                    if (w14)
+                    {
+                        wenc14 (*px, *p01, i00, i01);
+                        wenc14 (*p10, *p11, i10, i11);
+                        wenc14 (i00, i10, *px, *p10);
+                        wenc14 (i01, i11, *p01, *p11);
+                    }
+                    else
+                    {
+                        wenc16 (*px, *p01, i00, i01);
+                        wenc16 (*p10, *p11, i10, i11);
+                        wenc16 (i00, i10, *px, *p10);
+                        wenc16 (i01, i11, *p01, *p11);
+                    }
                 }
-                else
+
+                //
+                // Encode (1D) odd column (still in Y loop)
+                //
+
+                if (nx & p)
                 {
-                    wenc16 (*px, *p01, i00, i01);
-                    wenc16 (*p10, *p11, i10, i11);
-                    wenc16 (i00, i10, *px, *p10);
-                    wenc16 (i01, i11, *p01, *p11);
+                    unsigned short* p10 = px + oy1;
+
+                    if (w14)
+                        wenc14 (*px, *p10, i00, *p10);
+                    else
+                        wenc16 (*px, *p10, i00, *p10);
+
+                    *px = i00;
                 }
             }
 
             //
-            // Encode (1D) odd column (still in Y loop)
+            // Encode (1D) odd line (must loop in X)
             //
 
-            if (nx & p)
+            if (ny & p)
             {
-                unsigned short* p10 = px + oy1;
-
-                if (w14)
-                    wenc14 (*px, *p10, i00, *p10);
-                else
-                    wenc16 (*px, *p10, i00, *p10);
+                unsigned short* px = py;
+                unsigned short* ex = py + ox * (nx - p2);
 
-                *px = i00;
-            }
-        }
-
-        //
-        // Encode (1D) odd line (must loop in X)
-        //
-
-        if (ny & p)
-        {
-            unsigned short* px = py;
-            unsigned short* ex = py + ox * (nx - p2);
-
-            for (; px <= ex; px += ox2)
-            {
-                unsigned short* p01 = px + ox1;
+                for (; px <= ex; px += ox2)
+                {
+                    unsigned short* p01 = px + ox1;
 
-                if (w14)
-                    wenc14 (*px, *p01, i00, *p01);
-                else
-                    wenc16 (*px, *p01, i00, *p01);
+                    if (w14)
+                        wenc14 (*px, *p01, i00, *p01);
+                    else
+                        wenc16 (*px, *p01, i00, *p01);
 
-                *px = i00;
+                    *px = i00;
+                }
             }
         }
 
@@ -261,81 +618,93 @@ wav2Decode (
         int             ox2 = ox * p2;
         unsigned short  i00, i01, i10, i11;
 
-        //
-        // Y loop
-        //
-
-        for (; py <= ey; py += oy2)
+#ifdef IMF_WAV_SIMD
+        if (ox1 <= 2)
+        {
+            if (w14)
+                wavLines<WAV_DEC14> (py, nx, ny, p, ox1, oy1);
+            else
+                wavLines<WAV_DEC16> (py, nx, ny, p, ox1, oy1);
+        }
+        else
+#endif
         {
-            unsigned short* px = py;
-            unsigned short* ex = py + ox * (nx - p2);
-
             //
-            // X loop
+            // Y loop
             //
 
-            for (; px <= ex; px += ox2)
+            for (; py <= ey; py += oy2)
             {
-                unsigned short* p01 = px + ox1;
-                unsigned short* p10 = px + oy1;
-                unsigned short* p11 = p10 + ox1;
+                unsigned short* px = py;
+                unsigned short* ex = py + ox * (nx - p2);
 
                 //
-                // 2D wavelet decoding
+                // X loop
                 //
 
-                if (w14)
+                for (; px <= ex; px += ox2)
                 {
-                    wdec14 (*px, *p10, i00, i10);
-                    wdec14 (*p01, *p11, i01, i11);
-                    wdec14 (i00, i01, *px, *p01);
-                    wdec14 (i10, i11, *p10, *p11);
+                    unsigned short* p01 = px + ox1;
+                    unsigned short* p10 = px + oy1;
+                    unsigned short* p11 = p10 + ox1;
+
+                    //
+                    // 2D wavelet decoding
+                    //
+
+                    if (w14)
+                    {
+                        wdec14 (*px, *p10, i00, i10);
+                        wdec14 (*p01, *p11, i01, i11);
+                        wdec14 (i00, i01, *px, *p01);
+                        wdec14 (i10, i11, *p10, *p11);
+                    }
+                    else
+                    {
+                        wdec16 (*px, *p10, i00, i10);
+                        wdec16 (*p01, *p11, i01, i11);
+                        wdec16 (i00, i01, *px, *p01);
+                        wdec16 (i10, i11, *p10, *p11);
+                    }
                 }
-                else
+
+                //
+                // Decode (1D) odd column (still in Y loop)
+                //
+
+                if (nx & p)
                 {
-                    wdec16 (*px, *p10, i00, i10);
-                    wdec16 (*p01, *p11, i01, i11);
-                    wdec16 (i00, i01, *px, *p01);
-                    wdec16 (i10, i11, *p10, *p11);
+                    unsigned short* p10 = px + oy1;
+
+                    if (w14)
+                        wdec14 (*px, *p10, i00, *p10);
+                    else
+                        wdec16 (*px, *p10, i00, *p10);
+
+                    *px = i00;
                 }
             }
 
             //
-            // Decode (1D) odd column (still in Y loop)
+            // Decode (1D) odd line (must loop in X)
             //
 
-            if (nx & p)
+            if (ny & p)
             {
-                unsigned short* p10 = px + oy1;
-
-                if (w14)
-                    wdec14 (*px, *p10, i00, *p10);
-                else
-                    wdec16 (*px, *p10, i00, *p10);
+                unsigned short* px = py;
+                unsigned short* ex = py + ox * (nx - p2);
 
-                *px = i00;
-            }
-        }
-
-        //
-        // Decode (1D) odd line (must loop in X)
-        //
-
-        if (ny & p)
-        {
-            unsigned short* px = py;
-            unsigned short* ex = py + ox * (nx - p2);
-
-            for (; px <= ex; px += ox2)
-            {
-                unsigned short* p01 = px + ox1;
+                for (; px <= ex; px += ox2)
+                {
+                    unsigned short* p01 = px + ox1;
 
-                if (w14)
-                    wdec14 (*px, *p01, i00, *p01);
-                else
-                    wdec16 (*px, *p01, i00, *p01);
+                    if (w14)
+                        wdec14 (*px, *p01, i00, *p01);
+                    else
+                        wdec16 (*px, *p01, i00, *p01);
 
-                *px = i00;
+                    *px = i00;
+                }
             }
         }
 
@@ -208,3 +208,23 @@ exr_get_default_dwa_compression_quality (float* q)
 {
     if (q) *q = sDefaultDwaLevel;
 }
+
+/**************************************/
+
+static float sDefaultHtLevel = 4.f;
+
+void
+exr_set_default_ht_compression_quality (float q)
+{
+    if (!(q > 0.f)) q = 1.f;
+    if (q > 1024.f) q = 1024.f;
+    sDefaultHtLevel = q;
+}
+
+/**************************************/
+
+void
+exr_get_default_ht_compression_quality (float* q)
+{
+    if (q) *q = sDefaultHtLevel;
+}
@@ -2202,3 +2202,390 @@ internal_validate_next_chunk (
     }
     return rv;
 }
+
+/**************************************/
+
+#define EXR_COPY_CHUNKS_DEFAULT_BUFFER_SIZE ((uint64_t) 16 * 1024 * 1024)
+
+/* A window on the source file holding the raw bytes of a run of
+ * neighbouring chunks, so copying reads the file in large sequential
+ * blocks instead of one small read per chunk. */
+struct copy_window
+{
+    uint8_t* buf;
+    uint64_t bufsize;
+    uint64_t start; /* file offset of buf[0] */
+    uint64_t size;  /* valid bytes in buf */
+    uint64_t last;  /* offset of the previous chunk, to follow the read direction */
+};
+
+static exr_result_t
+fetch_copy_window (
+    const struct _internal_exr_context* pctxt,
+    struct copy_window*                 win,
+    uint64_t                            begin,
+    uint64_t                            end,
+    const uint8_t**                     out)
+{
+    exr_result_t rv;
+    uint64_t     need, start, readsize, offset;
+    int64_t      nread;
+
+    if (end < begin)
+        return pctxt->report_error (
+            pctxt, EXR_ERR_CORRUPT_CHUNK, "Invalid chunk data range");
+
+    if (win->buf && begin >= win->start && end <= win->start + win->size)
+    {
+        win->last = begin;
+        *out      = win->buf + (begin - win->start);
+        return EXR_ERR_SUCCESS;
+    }
+
+    need = end - begin;
+    if (need > win->bufsize)
+    {
+        if (win->buf) pctxt->free_fn (win->buf);
+        win->buf = (uint8_t*) pctxt->alloc_fn (need);
+        if (!win->buf)
+        {
+            win->bufsize = 0;
+            return pctxt->standard_error (pctxt, EXR_ERR_OUT_OF_MEMORY);
+        }
+        win->bufsize = need;
+    }
+    else if (!win->buf)
+    {
+        win->buf = (uint8_t*) pctxt->alloc_fn (win->bufsize);
+        if (!win->buf)
+            return pctxt->standard_error (pctxt, EXR_ERR_OUT_OF_MEMORY);
+    }
+
+    /* files written in decreasing y order store their chunks back to
+     * front, so fill the window with the bytes before the chunk */
+    readsize = win->bufsize;
+    if (begin < win->last)
+        start = (end > readsize) ? end - readsize : 0;
+    else
+        start = begin;
+
+    if (pctxt->file_size > 0 && start + readsize > (uint64_t) pctxt->file_size)
+    {
+        readsize = ((uint64_t) pctxt->file_size > start)
+                       ? (uint64_t) pctxt->file_size - start
+                       : 0;
+        if (readsize < end - start) readsize = end - start;
+    }
+
+    offset = start;
+    nread  = 0;
+    rv     = pctxt->do_read (
+        pctxt, win->buf, readsize, &offset, &nread, EXR_ALLOW_SHORT_READ);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    if (nread < 0 || (uint64_t) nread < end - start)
+        return pctxt->print_error (
+            pctxt,
+            EXR_ERR_READ_IO,
+            "Short read of chunk data at offset %" PRIu64 " (%" PRIu64
+            " bytes)",
+            begin,
+            need);
+
+    win->start = start;
+    win->size  = (uint64_t) nread;
+    win->last  = begin;
+    *out       = win->buf + (begin - start);
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+static int
+copy_parts_match (
+    const struct _internal_exr_part* a, const struct _internal_exr_part* b)
+{
+    const exr_attr_chlist_t* ca;
+    const exr_attr_chlist_t* cb;
+
+    if (a->storage_mode != b->storage_mode || a->comp_type != b->comp_type ||
+        a->chunk_count != b->chunk_count ||
+        a->lines_per_chunk != b->lines_per_chunk ||
+        a->data_window.min.x != b->data_window.min.x ||
+        a->data_window.min.y != b->data_window.min.y ||
+        a->data_window.max.x != b->data_window.max.x ||
+        a->data_window.max.y != b->data_window.max.y)
+        return 0;
+
+    if (a->storage_mode == EXR_STORAGE_TILED ||
+        a->storage_mode == EXR_STORAGE_DEEP_TILED)
+    {
+        if (!a->tiles || !b->tiles) return 0;
+        if (a->tiles->tiledesc->x_size != b->tiles->tiledesc->x_size ||
+            a->tiles->tiledesc->y_size != b->tiles->tiledesc->y_size ||
+            a->tiles->tiledesc->level_and_round !=
+                b->tiles->tiledesc->level_and_round)
+            return 0;
+    }
+
+    if (!a->channels || !b->channels) return 0;
+    ca = a->channels->chlist;
+    cb = b->channels->chlist;
+    if (ca->num_channels != cb->num_channels) return 0;
+
+    for (int c = 0; c < ca->num_channels; ++c)
+    {
+        const exr_attr_chlist_entry_t* ea = ca->entries + c;
+        const exr_attr_chlist_entry_t* eb = cb->entries + c;
+
+        if (ea->pixel_type != eb->pixel_type ||
+            ea->x_sampling != eb->x_sampling ||
+            ea->y_sampling != eb->y_sampling ||
+            ea->name.length != eb->name.length ||
+            memcmp (ea->name.str, eb->name.str, (size_t) ea->name.length))
+            return 0;
+    }
+
+    return 1;
+}
+
+/**************************************/
+
+static exr_result_t
+copy_one_chunk (
+    exr_const_context_t src,
+    int                 src_part_index,
+    exr_context_t       dst,
+    int                 dst_part_index,
+    const int32_t*      coords, /* y, or tilex, tiley, levelx, levely */
+    int                 is_tiled,
+    int                 is_deep,
+    struct copy_window* win)
+{
+    exr_result_t                        rv;
+    exr_chunk_info_t                    cinfo;
+    const uint8_t*                      data;
+    uint64_t                            begin, end;
+    const struct _internal_exr_context* pctxt = EXR_CCTXT (src);
+
+    if (is_tiled)
+        rv = exr_read_tile_chunk_info (
+            src,
+            src_part_index,
+            coords[0],
+            coords[1],
+            coords[2],
+            coords[3],
+            &cinfo);
+    else
+        rv = exr_read_scanline_chunk_info (
+            src, src_part_index, coords[0], &cinfo);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    begin = cinfo.data_offset;
+    end   = cinfo.data_offset + cinfo.packed_size;
+    if (is_deep)
+    {
+        if (cinfo.sample_count_data_offset < begin)
+            begin = cinfo.sample_count_data_offset;
+        if (cinfo.sample_count_data_offset + cinfo.sample_count_table_size >
+            end)
+            end = cinfo.sample_count_data_offset +
+                  cinfo.sample_count_table_size;
+    }
+
+    rv = fetch_copy_window (pctxt, win, begin, end, &data);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    if (is_deep)
+    {
+        const uint8_t* packed  = data + (cinfo.data_offset - begin);
+        const uint8_t* samples = data + (cinfo.sample_count_data_offset - begin);
+
+        if (is_tiled)
+            return exr_write_deep_tile_chunk (
+                dst,
+                dst_part_index,
+                coords[0],
+                coords[1],
+                coords[2],
+                coords[3],
+                packed,
+                cinfo.packed_size,
+                cinfo.unpacked_size,
+                samples,
+                cinfo.sample_count_table_size);
+        return exr_write_deep_scanline_chunk (
+            dst,
+            dst_part_index,
+            cinfo.start_y,
+            packed,
+            cinfo.packed_size,
+            cinfo.unpacked_size,
+            samples,
+            cinfo.sample_count_table_size);
+    }
+
+    if (is_tiled)
+        return exr_write_tile_chunk (
+            dst,
+            dst_part_index,
+            coords[0],
+            coords[1],
+            coords[2],
+            coords[3],
+            data,
+            cinfo.packed_size);
+    return exr_write_scanline_chunk (
+        dst, dst_part_index, cinfo.start_y, data, cinfo.packed_size);
+}
+
+/**************************************/
+
+exr_result_t
+exr_copy_chunks (
+    exr_const_context_t src,
+    int                 src_part_index,
+    exr_context_t       dst,
+    int                 dst_part_index,
+    uint64_t            buffer_size)
+{
+    exr_result_t                        rv = EXR_ERR_SUCCESS;
+    const struct _internal_exr_context* dctxt;
+    const struct _internal_exr_part*    dpart;
+    struct copy_window                  win;
+    int32_t                             coords[1];
+    int32_t*                            tiles = NULL;
+    int                                 is_deep;
+    EXR_PROMOTE_READ_CONST_CONTEXT_AND_PART_OR_ERROR (src, src_part_index);
+
+    dctxt = EXR_CCTXT (dst);
+    if (!dctxt) return EXR_ERR_MISSING_CONTEXT_ARG;
+    if (dctxt->mode != EXR_CONTEXT_WRITING_DATA)
+    {
+        if (dctxt->mode == EXR_CONTEXT_WRITE)
+            return dctxt->standard_error (dctxt, EXR_ERR_HEADER_NOT_WRITTEN);
+        return dctxt->standard_error (dctxt, EXR_ERR_NOT_OPEN_WRITE);
+    }
+    if (dst_part_index < 0 || dst_part_index >= dctxt->num_parts)
+        return dctxt->print_error (
+            dctxt,
+            EXR_ERR_ARGUMENT_OUT_OF_RANGE,
+            "Part index (%d) out of range",
+            dst_part_index);
+    dpart = dctxt->parts[dst_part_index];
+
+    if (!copy_parts_match (part, dpart))
+        return dctxt->print_error (
+            dctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Part %d does not match the storage, compression, data window, tiling or channels of the source part %d",
+            dst_part_index,
+            src_part_index);
+
+    is_deep = (part->storage_mode == EXR_STORAGE_DEEP_SCANLINE ||
+               part->storage_mode == EXR_STORAGE_DEEP_TILED);
+
+    memset (&win, 0, sizeof (win));
+    win.bufsize = buffer_size > 0 ? buffer_size
+                                  : EXR_COPY_CHUNKS_DEFAULT_BUFFER_SIZE;
+
+    if (part->storage_mode == EXR_STORAGE_SCANLINE ||
+        part->storage_mode == EXR_STORAGE_DEEP_SCANLINE)
+    {
+        for (int ci = 0; rv == EXR_ERR_SUCCESS && ci < part->chunk_count;
+             ++ci)
+        {
+            coords[0] = part->data_window.min.y + ci * part->lines_per_chunk;
+            rv        = copy_one_chunk (
+                src,
+                src_part_index,
+                dst,
+                dst_part_index,
+                coords,
+                0,
+                is_deep,
+                &win);
+        }
+    }
+    else
+    {
+        /* the destination takes tiles in chunk table order, so find the
+         * tile coordinates of each chunk index first */
+        const exr_attr_tiledesc_t* td = part->tiles->tiledesc;
+        int                        rip, nlx, nly, found = 0;
+
+        tiles = (int32_t*) pctxt->alloc_fn (
+            sizeof (int32_t) * 4 * (size_t) part->chunk_count);
+        if (!tiles)
+            return pctxt->standard_error (pctxt, EXR_ERR_OUT_OF_MEMORY);
+        for (int ci = 0; ci < part->chunk_count; ++ci)
+            tiles[ci * 4] = -1;
+
+        rip = (EXR_GET_TILE_LEVEL_MODE ((*td)) == EXR_TILE_RIPMAP_LEVELS);
+        nlx = part->num_tile_levels_x;
+        nly = rip ? part->num_tile_levels_y : 1;
+
+        for (int ly = 0; rv == EXR_ERR_SUCCESS && ly < nly; ++ly)
+        {
+            for (int lx = 0; rv == EXR_ERR_SUCCESS && lx < nlx; ++lx)
+            {
+                int lvy = rip ? ly : lx;
+                int nx  = part->tile_level_tile_count_x[lx];
+                int ny  = part->tile_level_tile_count_y[lvy];
+
+                for (int ty = 0; rv == EXR_ERR_SUCCESS && ty < ny; ++ty)
+                {
+                    for (int tx = 0; rv == EXR_ERR_SUCCESS && tx < nx; ++tx)
+                    {
+                        int32_t cidx = -1;
+                        rv           = validate_and_compute_tile_chunk_off (
+                            dctxt, dpart, tx, ty, lx, lvy, &cidx);
+                        if (rv != EXR_ERR_SUCCESS) break;
+                        if (tiles[cidx * 4] >= 0)
+                        {
+                            rv = dctxt->print_error (
+                                dctxt,
+                                EXR_ERR_INVALID_ARGUMENT,
+                                "Tiles share chunk index %d",
+                                cidx);
+                            break;
+                        }
+                        tiles[cidx * 4 + 0] = tx;
+                        tiles[cidx * 4 + 1] = ty;
+                        tiles[cidx * 4 + 2] = lx;
+                        tiles[cidx * 4 + 3] = lvy;
+                        ++found;
+                    }
+                }
+            }
+        }
+
+        if (rv == EXR_ERR_SUCCESS && found != part->chunk_count)
+            rv = pctxt->print_error (
+                pctxt,
+                EXR_ERR_INVALID_ARGUMENT,
+                "Tile levels describe %d chunks, but the part has %d",
+                found,
+                part->chunk_count);
+
+        for (int ci = 0; rv == EXR_ERR_SUCCESS && ci < part->chunk_count;
+             ++ci)
+        {
+            rv = copy_one_chunk (
+                src,
+                src_part_index,
+                dst,
+                dst_part_index,
+                tiles + ci * 4,
+                1,
+                is_deep,
+                &win);
+        }
+
+        pctxt->free_fn (tiles);
+    }
+
+    if (win.buf) pctxt->free_fn (win.buf);
+    return rv;
+}
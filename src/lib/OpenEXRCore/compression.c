@@ -5,10 +5,13 @@
 
 #include "openexr_compression.h"
 #include "openexr_base.h"
+#include "internal_compress.h"
 #include "internal_memory.h"
 #include "internal_structs.h"
 
 #include <libdeflate.h>
+#include <stdlib.h>
+#include <string.h>
 
 #if (                                                                          \
     LIBDEFLATE_VERSION_MAJOR > 1 ||                                            \
@@ -50,6 +53,292 @@ exr_compress_max_buffer_size (size_t in_bytes)
 
 /**************************************/
 
+/*
+ * A libdeflate compressor carries hundreds of KB of hash tables, so
+ * rather than allocating one for every chunk (ZIPS has one line per
+ * chunk), compressors and decompressors are returned to a pool when
+ * done, and reused by the next call that needs the same level.
+ * Contexts have a pool of their own, allocated with the context's
+ * allocator when the context is created and freed with it; calls
+ * without a context share a process wide pool, which is emptied at
+ * exit. Each pool has a mutex of its own, held only while a pointer
+ * is taken or put back, so coding chunks does not contend for the
+ * context lock.
+ */
+
+#define EXR_DEFLATE_POOL_SIZE 16
+
+struct _internal_exr_deflate_pool
+{
+    struct libdeflate_compressor*   comp[EXR_DEFLATE_POOL_SIZE];
+    int                             level[EXR_DEFLATE_POOL_SIZE];
+    int                             num_comp;
+    struct libdeflate_decompressor* decomp[EXR_DEFLATE_POOL_SIZE];
+    int                             num_decomp;
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    CRITICAL_SECTION mutex;
+#    else
+    pthread_mutex_t mutex;
+#    endif
+#endif
+};
+
+#if defined(ILMTHREAD_THREADING_ENABLED) && !defined(_WIN32)
+static struct _internal_exr_deflate_pool sGlobalPool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER};
+#else
+static struct _internal_exr_deflate_pool sGlobalPool;
+#endif
+static int sGlobalPoolAtExit = 0;
+
+#if defined(ILMTHREAD_THREADING_ENABLED) && defined(_WIN32)
+static volatile long sGlobalPoolInit = 0;
+#endif
+
+static void destroy_global_pool (void);
+
+static struct _internal_exr_deflate_pool*
+lock_pool (const struct _internal_exr_context* pctxt)
+{
+    struct _internal_exr_deflate_pool* pool =
+        pctxt ? pctxt->deflate_pool : &sGlobalPool;
+
+    if (!pool) return NULL;
+
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    if (!pctxt)
+    {
+        if (InterlockedIncrement (&sGlobalPoolInit) == 1)
+            InitializeCriticalSection (&sGlobalPool.mutex);
+        sGlobalPoolInit = 1; // avoids overflow on long running programs...
+    }
+    EnterCriticalSection (&pool->mutex);
+#    else
+    pthread_mutex_lock (&pool->mutex);
+#    endif
+#endif
+
+    if (!pctxt && !sGlobalPoolAtExit)
+    {
+        /* atexit handlers registered from a shared library also run
+         * when it is unloaded */
+        sGlobalPoolAtExit = 1;
+        atexit (destroy_global_pool);
+    }
+    return pool;
+}
+
+static void
+unlock_pool (struct _internal_exr_deflate_pool* pool)
+{
+    if (!pool) return;
+
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    LeaveCriticalSection (&pool->mutex);
+#    else
+    pthread_mutex_unlock (&pool->mutex);
+#    endif
+#endif
+}
+
+static void
+set_deflate_allocator (const struct _internal_exr_context* pctxt)
+{
+#ifndef EXR_USE_CONFIG_DEFLATE_STRUCT
+    /* older libdeflate only has a global allocator */
+    libdeflate_set_memory_allocator (
+        pctxt ? pctxt->alloc_fn : internal_exr_alloc,
+        pctxt ? pctxt->free_fn : internal_exr_free);
+#else
+    (void) pctxt;
+#endif
+}
+
+static struct libdeflate_compressor*
+acquire_compressor (const struct _internal_exr_context* pctxt, int level)
+{
+    struct _internal_exr_deflate_pool* pool;
+    struct libdeflate_compressor*      comp = NULL;
+
+    pool = lock_pool (pctxt);
+    if (pool)
+    {
+        for (int i = pool->num_comp - 1; i >= 0; --i)
+        {
+            if (pool->level[i] == level)
+            {
+                comp = pool->comp[i];
+                --pool->num_comp;
+                pool->comp[i]  = pool->comp[pool->num_comp];
+                pool->level[i] = pool->level[pool->num_comp];
+                break;
+            }
+        }
+    }
+    unlock_pool (pool);
+
+    if (!comp)
+    {
+#ifdef EXR_USE_CONFIG_DEFLATE_STRUCT
+        struct libdeflate_options opt = {
+            .sizeof_options = sizeof (struct libdeflate_options),
+            .malloc_func    = pctxt ? pctxt->alloc_fn : internal_exr_alloc,
+            .free_func      = pctxt ? pctxt->free_fn : internal_exr_free};
+
+        comp = libdeflate_alloc_compressor_ex (level, &opt);
+#else
+        set_deflate_allocator (pctxt);
+        comp = libdeflate_alloc_compressor (level);
+#endif
+    }
+    return comp;
+}
+
+static void
+release_compressor (
+    const struct _internal_exr_context* pctxt,
+    int                                 level,
+    struct libdeflate_compressor*       comp)
+{
+    struct _internal_exr_deflate_pool* pool;
+
+    pool = lock_pool (pctxt);
+    if (pool && pool->num_comp < EXR_DEFLATE_POOL_SIZE)
+    {
+        pool->comp[pool->num_comp]  = comp;
+        pool->level[pool->num_comp] = level;
+        ++pool->num_comp;
+        comp = NULL;
+    }
+    unlock_pool (pool);
+
+    if (comp)
+    {
+        set_deflate_allocator (pctxt);
+        libdeflate_free_compressor (comp);
+    }
+}
+
+static struct libdeflate_decompressor*
+acquire_decompressor (const struct _internal_exr_context* pctxt)
+{
+    struct _internal_exr_deflate_pool* pool;
+    struct libdeflate_decompressor*    decomp = NULL;
+
+    pool = lock_pool (pctxt);
+    if (pool && pool->num_decomp > 0)
+        decomp = pool->decomp[--pool->num_decomp];
+    unlock_pool (pool);
+
+    if (!decomp)
+    {
+#ifdef EXR_USE_CONFIG_DEFLATE_STRUCT
+        struct libdeflate_options opt = {
+            .sizeof_options = sizeof (struct libdeflate_options),
+            .malloc_func    = pctxt ? pctxt->alloc_fn : internal_exr_alloc,
+            .free_func      = pctxt ? pctxt->free_fn : internal_exr_free};
+
+        decomp = libdeflate_alloc_decompressor_ex (&opt);
+#else
+        set_deflate_allocator (pctxt);
+        decomp = libdeflate_alloc_decompressor ();
+#endif
+    }
+    return decomp;
+}
+
+static void
+release_decompressor (
+    const struct _internal_exr_context* pctxt,
+    struct libdeflate_decompressor*     decomp)
+{
+    struct _internal_exr_deflate_pool* pool;
+
+    pool = lock_pool (pctxt);
+    if (pool && pool->num_decomp < EXR_DEFLATE_POOL_SIZE)
+    {
+        pool->decomp[pool->num_decomp++] = decomp;
+        decomp                           = NULL;
+    }
+    unlock_pool (pool);
+
+    if (decomp)
+    {
+        set_deflate_allocator (pctxt);
+        libdeflate_free_decompressor (decomp);
+    }
+}
+
+static void
+free_pool_entries (
+    const struct _internal_exr_context* pctxt,
+    struct _internal_exr_deflate_pool*  pool)
+{
+    set_deflate_allocator (pctxt);
+    for (int i = 0; i < pool->num_comp; ++i)
+        libdeflate_free_compressor (pool->comp[i]);
+    for (int i = 0; i < pool->num_decomp; ++i)
+        libdeflate_free_decompressor (pool->decomp[i]);
+    pool->num_comp   = 0;
+    pool->num_decomp = 0;
+}
+
+static void
+destroy_global_pool (void)
+{
+    free_pool_entries (NULL, lock_pool (NULL));
+    unlock_pool (&sGlobalPool);
+}
+
+void
+internal_exr_init_deflate_pool (struct _internal_exr_context* ctxt)
+{
+    struct _internal_exr_deflate_pool* pool;
+
+    /* without a pool every call just allocates its own (de)compressor */
+    pool = ctxt->alloc_fn (sizeof (struct _internal_exr_deflate_pool));
+    if (!pool) return;
+
+    memset (pool, 0, sizeof (struct _internal_exr_deflate_pool));
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    InitializeCriticalSection (&(pool->mutex));
+#    else
+    if (pthread_mutex_init (&(pool->mutex), NULL) != 0)
+    {
+        ctxt->free_fn (pool);
+        return;
+    }
+#    endif
+#endif
+    ctxt->deflate_pool = pool;
+}
+
+void
+internal_exr_destroy_deflate_pool (struct _internal_exr_context* ctxt)
+{
+    struct _internal_exr_deflate_pool* pool = ctxt->deflate_pool;
+
+    if (!pool) return;
+
+    free_pool_entries (ctxt, pool);
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    DeleteCriticalSection (&(pool->mutex));
+#    else
+    pthread_mutex_destroy (&(pool->mutex));
+#    endif
+#endif
+
+    ctxt->free_fn (pool);
+    ctxt->deflate_pool = NULL;
+}
+
+/**************************************/
+
 exr_result_t
 exr_compress_buffer (
     exr_const_context_t ctxt,
@@ -62,17 +351,6 @@ exr_compress_buffer (
 {
     struct libdeflate_compressor*       comp;
     const struct _internal_exr_context* pctxt = EXR_CCTXT (ctxt);
-#ifdef EXR_USE_CONFIG_DEFLATE_STRUCT
-    struct libdeflate_options opt = {
-        .sizeof_options = sizeof (struct libdeflate_options),
-        .malloc_func    = pctxt ? pctxt->alloc_fn : internal_exr_alloc,
-        .free_func      = pctxt ? pctxt->free_fn : internal_exr_free};
-
-#else
-    libdeflate_set_memory_allocator (
-        pctxt ? pctxt->alloc_fn : internal_exr_alloc,
-        pctxt ? pctxt->free_fn : internal_exr_free);
-#endif
 
     if (level < 0)
     {
@@ -81,18 +359,14 @@ exr_compress_buffer (
         if (level < 0) level = EXR_DEFAULT_ZLIB_COMPRESS_LEVEL;
     }
 
-#ifdef EXR_USE_CONFIG_DEFLATE_STRUCT
-    comp = libdeflate_alloc_compressor_ex (level, &opt);
-#else
-    comp = libdeflate_alloc_compressor (level);
-#endif
+    comp = acquire_compressor (pctxt, level);
     if (comp)
     {
         size_t outsz;
         outsz =
             libdeflate_zlib_compress (comp, in, in_bytes, out, out_bytes_avail);
 
-        libdeflate_free_compressor (comp);
+        release_compressor (pctxt, level, comp);
 
         if (outsz != 0)
         {
@@ -119,20 +393,8 @@ exr_uncompress_buffer (
     enum libdeflate_result              res;
     size_t                              actual_in_bytes;
     const struct _internal_exr_context* pctxt = EXR_CCTXT (ctxt);
-#ifdef EXR_USE_CONFIG_DEFLATE_STRUCT
-    struct libdeflate_options opt = {
-        .sizeof_options = sizeof (struct libdeflate_options),
-        .malloc_func    = pctxt ? pctxt->alloc_fn : internal_exr_alloc,
-        .free_func      = pctxt ? pctxt->free_fn : internal_exr_free};
-
-    decomp = libdeflate_alloc_decompressor_ex (&opt);
-#else
-    libdeflate_set_memory_allocator (
-        pctxt ? pctxt->alloc_fn : internal_exr_alloc,
-        pctxt ? pctxt->free_fn : internal_exr_free);
-    decomp = libdeflate_alloc_decompressor ();
-#endif
 
+    decomp = acquire_decompressor (pctxt);
     if (decomp)
     {
         res = libdeflate_zlib_decompress_ex (
@@ -144,7 +406,7 @@ exr_uncompress_buffer (
             &actual_in_bytes,
             actual_out);
 
-        libdeflate_free_decompressor (decomp);
+        release_decompressor (pctxt, decomp);
 
         if (res == LIBDEFLATE_SUCCESS)
         {
@@ -277,6 +277,7 @@ exr_start_read (
                 {
                     inits.size_fn = &default_query_size_func;
                     rv            = default_init_read_file (ret);
+                    if (rv == EXR_ERR_SUCCESS) default_map_read_file (ret);
                 }
 
                 if (rv == EXR_ERR_SUCCESS)
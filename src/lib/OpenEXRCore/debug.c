@@ -84,9 +84,18 @@ print_attr (const exr_attribute_t* a, int verbose)
                 "b44",
                 "b44a",
                 "dwaa",
-                "dwab"};
+                "dwab",
+                "ht",
+                "ht256",
+                "htk",
+                "htk256",
+                "htlossy",
+                "pizms",
+                "htstriped"};
             printf (
-                "'%s'", (a->uc < 10 ? compressionnames[a->uc] : "<UNKNOWN>"));
+                "'%s'",
+                (a->uc < EXR_COMPRESSION_LAST_TYPE ? compressionnames[a->uc]
+                                                   : "<UNKNOWN>"));
             if (verbose) printf (" (0x%02X)", a->uc);
             break;
         }
@@ -132,6 +132,24 @@ read_uncompressed_direct (exr_decode_pipeline_t* decode)
     return EXR_ERR_SUCCESS;
 }
 
+/* whether a chunk can be decoded straight out of the file mapping:
+ * it has to be entirely inside the file (short, uncompressed chunks
+ * are zero filled by exr_read_chunk) and match the part, the same as
+ * exr_read_chunk checks */
+static int
+mapped_chunk (
+    const struct _internal_exr_context* pctxt,
+    const struct _internal_exr_part*    part,
+    const exr_chunk_info_t*             cinfo)
+{
+    if (!pctxt->mmap_base || cinfo->packed_size == 0) return 0;
+    if (cinfo->idx < 0 || cinfo->idx >= part->chunk_count) return 0;
+    if (cinfo->type != (uint8_t) part->storage_mode) return 0;
+    if (cinfo->compression != (uint8_t) part->comp_type) return 0;
+    if (cinfo->data_offset > pctxt->mmap_size) return 0;
+    return cinfo->packed_size <= pctxt->mmap_size - cinfo->data_offset;
+}
+
 static exr_result_t
 default_read_chunk (exr_decode_pipeline_t* decode)
 {
@@ -181,6 +199,19 @@ default_read_chunk (exr_decode_pipeline_t* decode)
                 decode->packed_sample_count_table);
         }
     }
+    else if (mapped_chunk (pctxt, part, &(decode->chunk)))
+    {
+        /* hand the decompressor (or, for uncompressed chunks, the
+         * unpacker) the bytes in place. A zero alloc size marks the
+         * buffer as not ours, so it is never freed */
+        rv = internal_decode_free_buffer (
+            decode,
+            EXR_TRANSCODE_BUFFER_PACKED,
+            &(decode->packed_buffer),
+            &(decode->packed_alloc_size));
+        decode->packed_buffer = EXR_CONST_CAST (
+            void*, pctxt->mmap_base + decode->chunk.data_offset);
+    }
     else
     {
         rv = internal_decode_alloc_buffer (
@@ -243,6 +274,10 @@ decompress_data (
             rv = internal_exr_undo_piz (
                 decode, packbufptr, packsz, unpackbufptr, unpacksz);
             break;
+        case EXR_COMPRESSION_PIZ_MS:
+            rv = internal_exr_undo_piz_ms (
+                decode, packbufptr, packsz, unpackbufptr, unpacksz);
+            break;
         case EXR_COMPRESSION_PXR24:
             rv = internal_exr_undo_pxr24 (
                 decode, packbufptr, packsz, unpackbufptr, unpacksz);
@@ -263,6 +298,20 @@ decompress_data (
             rv = internal_exr_undo_dwab (
                 decode, packbufptr, packsz, unpackbufptr, unpacksz);
             break;
+        case EXR_COMPRESSION_HT:
+        case EXR_COMPRESSION_HT256:
+        case EXR_COMPRESSION_HT_LOSSY:
+        case EXR_COMPRESSION_HT_STRIPED:
+            rv = internal_exr_undo_ht (
+                decode, packbufptr, packsz, unpackbufptr, unpacksz);
+            break;
+        case EXR_COMPRESSION_HTK:
+        case EXR_COMPRESSION_HTK256:
+            return pctxt->print_error (
+                pctxt,
+                EXR_ERR_FEATURE_NOT_IMPLEMENTED,
+                "Compression technique 0x%02X not supported",
+                ctype);
         case EXR_COMPRESSION_LAST_TYPE:
         default:
             return pctxt->print_error (
@@ -12,6 +12,8 @@
 
 #include "openexr_compression.h"
 
+#include <string.h>
+
 /**************************************/
 
 static exr_result_t
@@ -47,6 +49,9 @@ default_compress_chunk (exr_encode_pipeline_t* encode)
         case EXR_COMPRESSION_ZIP:
         case EXR_COMPRESSION_ZIPS: rv = internal_exr_apply_zip (encode); break;
         case EXR_COMPRESSION_PIZ: rv = internal_exr_apply_piz (encode); break;
+        case EXR_COMPRESSION_PIZ_MS:
+            rv = internal_exr_apply_piz_ms (encode);
+            break;
         case EXR_COMPRESSION_PXR24:
             rv = internal_exr_apply_pxr24 (encode);
             break;
@@ -54,6 +59,19 @@ default_compress_chunk (exr_encode_pipeline_t* encode)
         case EXR_COMPRESSION_B44A: rv = internal_exr_apply_b44a (encode); break;
         case EXR_COMPRESSION_DWAA: rv = internal_exr_apply_dwaa (encode); break;
         case EXR_COMPRESSION_DWAB: rv = internal_exr_apply_dwab (encode); break;
+        case EXR_COMPRESSION_HT:
+        case EXR_COMPRESSION_HT256:
+        case EXR_COMPRESSION_HT_LOSSY:
+        case EXR_COMPRESSION_HT_STRIPED:
+            rv = internal_exr_apply_ht (encode);
+            break;
+        case EXR_COMPRESSION_HTK:
+        case EXR_COMPRESSION_HTK256:
+            return pctxt->print_error (
+                pctxt,
+                EXR_ERR_FEATURE_NOT_IMPLEMENTED,
+                "Compression technique 0x%02X not supported",
+                (int) part->comp_type);
         case EXR_COMPRESSION_LAST_TYPE:
         default:
             return pctxt->print_error (
@@ -467,3 +485,450 @@ exr_encoding_destroy (exr_const_context_t ctxt, exr_encode_pipeline_t* encode)
     }
     return EXR_UNLOCK_WRITE_AND_RETURN_PCTXT (EXR_ERR_SUCCESS);
 }
+
+/**************************************/
+
+/* exr_encode_chunks keeps a window of chunks in flight, one slot
+ * each, indexed by chunk index modulo the window size. A slot goes
+ * FREE -> QUEUED (prepared by the caller) -> RUNNING (claimed by a
+ * worker, a submitted task or the caller) -> DONE -> FREE (written
+ * by the caller). All state changes happen under the mutex. */
+
+enum
+{
+    ENCODE_SLOT_FREE = 0,
+    ENCODE_SLOT_QUEUED,
+    ENCODE_SLOT_RUNNING,
+    ENCODE_SLOT_DONE
+};
+
+struct _encode_chunks_state;
+
+struct _encode_chunks_slot
+{
+    struct _encode_chunks_state* state;
+    exr_encode_pipeline_t        encoder;
+    int                          chunk;
+    int                          status;
+    int                          initialized;
+    exr_result_t                 rv;
+};
+
+struct _encode_chunks_state
+{
+    exr_context_t               ctxt;
+    int                         part_index;
+    struct _encode_chunks_slot* slots;
+    int                         num_slots;
+    int                         outstanding; /* submitted, not yet called */
+    int                         stop;
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    CRITICAL_SECTION   mutex;
+    CONDITION_VARIABLE cond;
+#    else
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+#    endif
+#endif
+};
+
+static inline void
+encode_chunks_lock (struct _encode_chunks_state* st)
+{
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    EnterCriticalSection (&st->mutex);
+#    else
+    pthread_mutex_lock (&st->mutex);
+#    endif
+#else
+    (void) st;
+#endif
+}
+
+static inline void
+encode_chunks_unlock (struct _encode_chunks_state* st)
+{
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    LeaveCriticalSection (&st->mutex);
+#    else
+    pthread_mutex_unlock (&st->mutex);
+#    endif
+#else
+    (void) st;
+#endif
+}
+
+static inline void
+encode_chunks_wait (struct _encode_chunks_state* st)
+{
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    SleepConditionVariableCS (&st->cond, &st->mutex, INFINITE);
+#    else
+    pthread_cond_wait (&st->cond, &st->mutex);
+#    endif
+#else
+    (void) st;
+#endif
+}
+
+static inline void
+encode_chunks_broadcast (struct _encode_chunks_state* st)
+{
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    WakeAllConditionVariable (&st->cond);
+#    else
+    pthread_cond_broadcast (&st->cond);
+#    endif
+#else
+    (void) st;
+#endif
+}
+
+/* called with the mutex held, returns with it held */
+static void
+encode_chunks_run_slot (
+    struct _encode_chunks_state* st, struct _encode_chunks_slot* slot)
+{
+    exr_result_t rv;
+
+    slot->status = ENCODE_SLOT_RUNNING;
+    encode_chunks_unlock (st);
+
+    rv = exr_encoding_run (st->ctxt, st->part_index, &(slot->encoder));
+
+    encode_chunks_lock (st);
+    slot->rv     = rv;
+    slot->status = ENCODE_SLOT_DONE;
+    encode_chunks_broadcast (st);
+}
+
+static void
+encode_chunks_task (void* data)
+{
+    struct _encode_chunks_slot*  slot = (struct _encode_chunks_slot*) data;
+    struct _encode_chunks_state* st   = slot->state;
+
+    /* the caller may have claimed the chunk while the task waited
+     * in the pool, in which case there is nothing left to do */
+    encode_chunks_lock (st);
+    if (slot->status == ENCODE_SLOT_QUEUED) encode_chunks_run_slot (st, slot);
+    --(st->outstanding);
+    encode_chunks_broadcast (st);
+    encode_chunks_unlock (st);
+}
+
+#ifdef ILMTHREAD_THREADING_ENABLED
+static struct _encode_chunks_slot*
+encode_chunks_next_queued (struct _encode_chunks_state* st)
+{
+    struct _encode_chunks_slot* best = NULL;
+
+    for (int s = 0; s < st->num_slots; ++s)
+    {
+        struct _encode_chunks_slot* slot = st->slots + s;
+        if (slot->status == ENCODE_SLOT_QUEUED &&
+            (!best || slot->chunk < best->chunk))
+            best = slot;
+    }
+    return best;
+}
+
+#    ifdef _WIN32
+static DWORD WINAPI
+encode_chunks_worker (LPVOID data)
+#    else
+static void*
+encode_chunks_worker (void* data)
+#    endif
+{
+    struct _encode_chunks_state* st = (struct _encode_chunks_state*) data;
+    struct _encode_chunks_slot*  slot;
+
+    encode_chunks_lock (st);
+    while (!st->stop)
+    {
+        slot = encode_chunks_next_queued (st);
+        if (slot)
+            encode_chunks_run_slot (st, slot);
+        else
+            encode_chunks_wait (st);
+    }
+    encode_chunks_unlock (st);
+    return 0;
+}
+#endif
+
+static exr_result_t
+encode_chunks_prepare (
+    const struct _internal_exr_context* pctxt,
+    const struct _internal_exr_part*    part,
+    struct _encode_chunks_state*        st,
+    struct _encode_chunks_slot*         slot,
+    const exr_frame_channel_t*          channels,
+    int                                 num_channels)
+{
+    exr_result_t     rv;
+    exr_chunk_info_t cinfo;
+    int              y = part->data_window.min.y +
+            slot->chunk * (int) part->lines_per_chunk;
+
+    rv = exr_write_scanline_chunk_info (st->ctxt, st->part_index, y, &cinfo);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    if (!slot->initialized)
+    {
+        rv = exr_encoding_initialize (
+            st->ctxt, st->part_index, &cinfo, &(slot->encoder));
+        if (rv != EXR_ERR_SUCCESS) return rv;
+        slot->initialized = 1;
+    }
+    else
+    {
+        rv = exr_encoding_update (
+            st->ctxt, st->part_index, &cinfo, &(slot->encoder));
+        if (rv != EXR_ERR_SUCCESS) return rv;
+    }
+
+    for (int c = 0; c < slot->encoder.channel_count; ++c)
+    {
+        exr_coding_channel_info_t* encc = slot->encoder.channels + c;
+        const exr_frame_channel_t* fc   = NULL;
+        int32_t                    ys   = encc->y_samples > 1 ? encc->y_samples : 1;
+        int64_t                    first, row;
+
+        for (int f = 0; f < num_channels; ++f)
+        {
+            if (channels[f].channel_name &&
+                0 == strcmp (channels[f].channel_name, encc->channel_name))
+            {
+                fc = channels + f;
+                break;
+            }
+        }
+
+        if (!fc || !fc->base_ptr)
+            return pctxt->print_error (
+                pctxt,
+                EXR_ERR_INVALID_ARGUMENT,
+                "Missing frame data for channel '%s'",
+                encc->channel_name);
+
+        /* rows of the frame are the sampled lines of the data window,
+         * so count the sampled lines above the chunk */
+        first = ((int64_t) part->data_window.min.y + ys - 1);
+        first -= ((first % ys) + ys) % ys;
+        row = (int64_t) cinfo.start_y + ys - 1;
+        row -= ((row % ys) + ys) % ys;
+        row = (row - first) / ys;
+
+        encc->user_pixel_stride      = fc->user_pixel_stride;
+        encc->user_line_stride       = fc->user_line_stride;
+        encc->user_bytes_per_element = fc->user_bytes_per_element;
+        encc->user_data_type         = fc->user_data_type;
+        encc->encode_from_ptr = fc->base_ptr + row * (int64_t) fc->user_line_stride;
+    }
+
+    if (slot->encoder.convert_and_pack_fn == NULL)
+    {
+        rv = exr_encoding_choose_default_routines (
+            st->ctxt, st->part_index, &(slot->encoder));
+        if (rv != EXR_ERR_SUCCESS) return rv;
+    }
+
+    /* the caller writes the chunks in order once they are compressed */
+    slot->encoder.yield_until_ready_fn = NULL;
+    slot->encoder.write_fn             = NULL;
+    return EXR_ERR_SUCCESS;
+}
+
+exr_result_t
+exr_encode_chunks (
+    exr_context_t              ctxt,
+    int                        part_index,
+    const exr_frame_channel_t* channels,
+    int                        num_channels,
+    int                        num_workers,
+    int                        max_chunks_in_flight,
+    exr_task_submit_func_ptr_t submit_fn,
+    void*                      submit_data)
+{
+    exr_result_t                rv = EXR_ERR_SUCCESS;
+    struct _encode_chunks_state st;
+    int                         next_submit = 0, next_write = 0;
+#ifdef ILMTHREAD_THREADING_ENABLED
+    int num_threads = 0;
+#    ifdef _WIN32
+    HANDLE* threads = NULL;
+#    else
+    pthread_t* threads = NULL;
+#    endif
+#endif
+    EXR_PROMOTE_CONST_CONTEXT_AND_PART_OR_ERROR_NO_LOCK (ctxt, part_index);
+
+    if (pctxt->mode != EXR_CONTEXT_WRITING_DATA)
+    {
+        if (pctxt->mode == EXR_CONTEXT_WRITE)
+            return pctxt->standard_error (pctxt, EXR_ERR_HEADER_NOT_WRITTEN);
+        return pctxt->standard_error (pctxt, EXR_ERR_NOT_OPEN_WRITE);
+    }
+
+    if (part->storage_mode != EXR_STORAGE_SCANLINE)
+        return pctxt->report_error (
+            pctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "exr_encode_chunks only supports flat scanline parts");
+
+    if (!channels || num_channels <= 0)
+        return pctxt->standard_error (pctxt, EXR_ERR_INVALID_ARGUMENT);
+
+#ifndef ILMTHREAD_THREADING_ENABLED
+    num_workers = 0;
+    submit_fn   = NULL;
+#endif
+    if (num_workers < 0) num_workers = 0;
+    if (max_chunks_in_flight <= 0)
+        max_chunks_in_flight = num_workers > 0 ? 2 * num_workers : 1;
+    if (max_chunks_in_flight > part->chunk_count)
+        max_chunks_in_flight = part->chunk_count;
+    if (max_chunks_in_flight < 1) max_chunks_in_flight = 1;
+
+    memset (&st, 0, sizeof (st));
+    st.ctxt       = ctxt;
+    st.part_index = part_index;
+    st.num_slots  = max_chunks_in_flight;
+    st.slots      = (struct _encode_chunks_slot*) pctxt->alloc_fn (
+        sizeof (struct _encode_chunks_slot) * (size_t) st.num_slots);
+    if (!st.slots) return pctxt->standard_error (pctxt, EXR_ERR_OUT_OF_MEMORY);
+    memset (st.slots, 0, sizeof (struct _encode_chunks_slot) * (size_t) st.num_slots);
+    for (int s = 0; s < st.num_slots; ++s)
+        st.slots[s].state = &st;
+
+#ifdef ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+    InitializeCriticalSection (&st.mutex);
+    InitializeConditionVariable (&st.cond);
+#    else
+    pthread_mutex_init (&st.mutex, NULL);
+    pthread_cond_init (&st.cond, NULL);
+#    endif
+
+    if (!submit_fn && num_workers > 0)
+    {
+        threads = pctxt->alloc_fn (sizeof (*threads) * (size_t) num_workers);
+        if (!threads)
+            rv = pctxt->standard_error (pctxt, EXR_ERR_OUT_OF_MEMORY);
+        for (int t = 0; threads && t < num_workers; ++t)
+        {
+#    ifdef _WIN32
+            threads[t] =
+                CreateThread (NULL, 0, &encode_chunks_worker, &st, 0, NULL);
+            if (!threads[t]) break;
+#    else
+            if (pthread_create (threads + t, NULL, &encode_chunks_worker, &st))
+                break;
+#    endif
+            ++num_threads;
+        }
+    }
+#endif
+
+    while (rv == EXR_ERR_SUCCESS && next_write < part->chunk_count)
+    {
+        struct _encode_chunks_slot* slot;
+
+        /* fill the window */
+        while (rv == EXR_ERR_SUCCESS && next_submit < part->chunk_count &&
+               next_submit - next_write < st.num_slots)
+        {
+            slot        = st.slots + (next_submit % st.num_slots);
+            slot->chunk = next_submit;
+            rv          = encode_chunks_prepare (
+                pctxt, part, &st, slot, channels, num_channels);
+            if (rv != EXR_ERR_SUCCESS) break;
+
+            encode_chunks_lock (&st);
+            slot->status = ENCODE_SLOT_QUEUED;
+            if (submit_fn) ++(st.outstanding);
+            encode_chunks_broadcast (&st);
+            encode_chunks_unlock (&st);
+
+            if (submit_fn) submit_fn (submit_data, &encode_chunks_task, slot);
+            ++next_submit;
+        }
+        if (rv != EXR_ERR_SUCCESS) break;
+
+        /* wait for the next chunk in order, compressing it here if
+         * nobody has started on it yet */
+        slot = st.slots + (next_write % st.num_slots);
+        encode_chunks_lock (&st);
+        while (slot->status != ENCODE_SLOT_DONE)
+        {
+            if (slot->status == ENCODE_SLOT_QUEUED)
+                encode_chunks_run_slot (&st, slot);
+            else
+                encode_chunks_wait (&st);
+        }
+        rv           = slot->rv;
+        slot->status = ENCODE_SLOT_FREE;
+        encode_chunks_unlock (&st);
+
+        if (rv == EXR_ERR_SUCCESS)
+            rv = exr_write_scanline_chunk (
+                ctxt,
+                part_index,
+                slot->encoder.chunk.start_y,
+                slot->encoder.compressed_buffer,
+                slot->encoder.compressed_bytes);
+        ++next_write;
+    }
+
+    /* cancel what has not started, then wait for running chunks,
+     * the workers and any task still sitting in the caller's pool */
+    encode_chunks_lock (&st);
+    for (int s = 0; s < st.num_slots; ++s)
+        if (st.slots[s].status == ENCODE_SLOT_QUEUED)
+            st.slots[s].status = ENCODE_SLOT_FREE;
+    st.stop = 1;
+    encode_chunks_broadcast (&st);
+    for (;;)
+    {
+        int busy = st.outstanding > 0;
+        for (int s = 0; s < st.num_slots; ++s)
+            if (st.slots[s].status == ENCODE_SLOT_RUNNING) busy = 1;
+        if (!busy) break;
+        encode_chunks_wait (&st);
+    }
+    encode_chunks_unlock (&st);
+
+#ifdef ILMTHREAD_THREADING_ENABLED
+    for (int t = 0; t < num_threads; ++t)
+    {
+#    ifdef _WIN32
+        WaitForSingleObject (threads[t], INFINITE);
+        CloseHandle (threads[t]);
+#    else
+        pthread_join (threads[t], NULL);
+#    endif
+    }
+    if (threads) pctxt->free_fn (threads);
+
+#    ifdef _WIN32
+    DeleteCriticalSection (&st.mutex);
+#    else
+    pthread_cond_destroy (&st.cond);
+    pthread_mutex_destroy (&st.mutex);
+#    endif
+#endif
+
+    for (int s = 0; s < st.num_slots; ++s)
+        if (st.slots[s].initialized)
+            exr_encoding_destroy (ctxt, &(st.slots[s].encoder));
+    pctxt->free_fn (st.slots);
+
+    return rv;
+}
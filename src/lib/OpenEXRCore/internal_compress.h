@@ -8,6 +8,15 @@
 
 #include "openexr_encode.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct _internal_exr_context;
+
+void internal_exr_init_deflate_pool (struct _internal_exr_context* ctxt);
+void internal_exr_destroy_deflate_pool (struct _internal_exr_context* ctxt);
+
 uint64_t internal_rle_compress (
     void* out, uint64_t outbytes, const void* src, uint64_t srcbytes);
 
@@ -23,6 +32,8 @@ exr_result_t internal_exr_apply_zip (exr_encode_pipeline_t* encode);
 
 exr_result_t internal_exr_apply_piz (exr_encode_pipeline_t* encode);
 
+exr_result_t internal_exr_apply_piz_ms (exr_encode_pipeline_t* encode);
+
 exr_result_t internal_exr_apply_pxr24 (exr_encode_pipeline_t* encode);
 
 exr_result_t internal_exr_apply_b44 (exr_encode_pipeline_t* encode);
@@ -33,4 +44,10 @@ exr_result_t internal_exr_apply_dwaa (exr_encode_pipeline_t* encode);
 
 exr_result_t internal_exr_apply_dwab (exr_encode_pipeline_t* encode);
 
+exr_result_t internal_exr_apply_ht (exr_encode_pipeline_t* encode);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
 #endif /* OPENEXR_CORE_COMPRESS_H */
@@ -139,6 +139,39 @@ has_native_half (void)
 #endif
 }
 
+static inline int
+has_avx2 (void)
+{
+#if OPENEXR_ENABLE_X86_SIMD_CHECK
+    int sse2, avx, f16c;
+    check_for_x86_simd (&f16c, &avx, &sse2);
+    /* avx is only set when the OS saves the ymm registers */
+    if (!avx) return 0;
+#    if defined(__AVX2__)
+    return 1;
+#    elif defined(_WIN32)
+    {
+        int regs[4] = {0};
+        __cpuid (regs, 0);
+        if (regs[0] < 7) return 0;
+        __cpuidex (regs, 7, 0);
+        /* AVX2 is bit 5 of EBX (reg 1) of leaf 7 */
+        return (regs[1] & (1 << 5)) ? 1 : 0;
+    }
+#    else
+    {
+        unsigned int regs[4] = {0};
+        if (__get_cpuid_max (0, NULL) < 7) return 0;
+        __cpuid_count (7, 0, regs[0], regs[1], regs[2], regs[3]);
+        /* AVX2 is bit 5 of EBX (reg 1) of leaf 7 */
+        return (regs[1] & (1 << 5)) ? 1 : 0;
+    }
+#    endif
+#else
+    return 0;
+#endif
+}
+
 #undef OPENEXR_ENABLE_X86_SIMD_CHECK
 #endif
 
@@ -8,6 +8,10 @@
 
 #include "openexr_decode.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /*
  * for uncompressing, we might be doing either the deep sample count
  * table or the actual pixel data so need to receive the destination
@@ -38,6 +42,13 @@ exr_result_t internal_exr_undo_piz (
     void*                  uncompressed_data,
     uint64_t               uncompressed_size);
 
+exr_result_t internal_exr_undo_piz_ms (
+    exr_decode_pipeline_t* decode,
+    const void*            compressed_data,
+    uint64_t               comp_buf_size,
+    void*                  uncompressed_data,
+    uint64_t               uncompressed_size);
+
 exr_result_t internal_exr_undo_pxr24 (
     exr_decode_pipeline_t* decode,
     const void*            compressed_data,
@@ -73,4 +84,15 @@ exr_result_t internal_exr_undo_dwab (
     void*                  uncompressed_data,
     uint64_t               uncompressed_size);
 
+exr_result_t internal_exr_undo_ht (
+    exr_decode_pipeline_t* decode,
+    const void*            compressed_data,
+    uint64_t               comp_buf_size,
+    void*                  uncompressed_data,
+    uint64_t               uncompressed_size);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
 #endif /* OPENEXR_CORE_DECOMPRESS_H */
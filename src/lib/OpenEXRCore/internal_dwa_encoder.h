@@ -294,6 +294,15 @@ quantize (float dctval, float errorTolerance)
     return src;
 }
 
+static void
+dctForwardQuantize64_scalar (uint16_t* dst, float* data, const float* tolerance)
+{
+    dctForward8x8 (data);
+
+    for (int i = 0; i < 64; ++i)
+        dst[i] = quantize (data[i], tolerance[i]);
+}
+
 /**************************************/
 
 //
@@ -453,19 +462,11 @@ LossyDctEncoder_execute (
             for (int chan = 0; chan < numComp; ++chan)
             {
                 //
-                // Forward DCT
+                // Forward DCT, quantize to half, and zigzag
                 //
-                dctForward8x8 (chanData[chan]->_dctData);
 
-                //
-                // Quantize to half, and zigzag
-                //
-
-                for (int i = 0; i < 64; ++i)
-                {
-                    halfCoef[i] =
-                        quantize (chanData[chan]->_dctData[i], quantTable[i]);
-                }
+                dctForwardQuantize64 (
+                    halfCoef, chanData[chan]->_dctData, quantTable);
 
                 toZigZag (halfZigCoef, halfCoef);
 
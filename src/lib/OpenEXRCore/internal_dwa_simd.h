@@ -43,6 +43,17 @@
 #    endif /* __LP64__ */
 #endif     /* OPENEXR_IMF_HAVE_GCC_INLINE_ASM_AVX */
 
+#if defined(IMF_HAVE_SSE2) && (defined(__x86_64__) || defined(_M_X64)) &&     \
+    (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#    define IMF_HAVE_AVX2_DISPATCH 1
+#    include <immintrin.h>
+#    if defined(__GNUC__) || defined(__clang__)
+#        define DWA_AVX2_TARGET __attribute__ ((target ("avx2,f16c")))
+#    else
+#        define DWA_AVX2_TARGET
+#    endif
+#endif
+
 #define _SSE_ALIGNMENT 32
 #define _SSE_ALIGNMENT_MASK 0x0F
 #define _AVX_ALIGNMENT_MASK 0x1F
@@ -2266,6 +2277,214 @@ dctForward8x8 (float* data)
 
 #endif /* IMF_HAVE_SSE2 */
 
+#ifdef IMF_HAVE_AVX2_DISPATCH
+
+//
+// AVX2 forward DCT, with the same arithmetic as the SSE2 version
+// (so the results are identical), but each pass works on whole
+// rows of 8 floats. data need not be aligned.
+//
+
+DWA_AVX2_TARGET static void
+dctForward8x8_avx2 (float* data)
+{
+    __m256 row[8];
+    __m256 a0, a1, a2, a3, a4, a5, a6, a7;
+    __m256 k0, k1, rotX, rotY;
+    __m256 t[8], u[8];
+
+    const __m256 c4     = _mm256_set1_ps (.70710678f);
+    const __m256 c4Neg  = _mm256_set1_ps (-.70710678f);
+    const __m256 c1Half = _mm256_set1_ps (.490392640f);
+    const __m256 c2Half = _mm256_set1_ps (.461939770f);
+    const __m256 c3Half = _mm256_set1_ps (.415734810f);
+    const __m256 c5Half = _mm256_set1_ps (.277785120f);
+    const __m256 c6Half = _mm256_set1_ps (.191341720f);
+    const __m256 c7Half = _mm256_set1_ps (.097545161f);
+    const __m256 half   = _mm256_set1_ps (.5f);
+
+    for (int i = 0; i < 8; ++i)
+        row[i] = _mm256_loadu_ps (data + 8 * i);
+
+    for (int iter = 0; iter < 2; ++iter)
+    {
+        a0 = _mm256_add_ps (row[0], row[7]);
+        a1 = _mm256_add_ps (row[1], row[2]);
+        a3 = _mm256_add_ps (row[3], row[4]);
+        a5 = _mm256_add_ps (row[5], row[6]);
+
+        a7 = _mm256_sub_ps (row[0], row[7]);
+        a2 = _mm256_sub_ps (row[1], row[2]);
+        a4 = _mm256_sub_ps (row[3], row[4]);
+        a6 = _mm256_sub_ps (row[5], row[6]);
+
+        k0 = _mm256_mul_ps (c4, _mm256_add_ps (a0, a3));
+        k1 = _mm256_mul_ps (c4, _mm256_add_ps (a1, a5));
+
+        row[0] = _mm256_mul_ps (_mm256_add_ps (k0, k1), half);
+        row[4] = _mm256_mul_ps (_mm256_sub_ps (k0, k1), half);
+
+        k0 = _mm256_sub_ps (a2, a6);
+        k1 = _mm256_sub_ps (a0, a3);
+
+        row[2] = _mm256_add_ps (
+            _mm256_mul_ps (c6Half, k0), _mm256_mul_ps (c2Half, k1));
+        row[6] = _mm256_sub_ps (
+            _mm256_mul_ps (c6Half, k1), _mm256_mul_ps (c2Half, k0));
+
+        k0 = _mm256_mul_ps (_mm256_sub_ps (a1, a5), c4);
+        k1 = _mm256_mul_ps (_mm256_add_ps (a2, a6), c4Neg);
+
+        rotX   = _mm256_sub_ps (a7, k0);
+        rotY   = _mm256_add_ps (a4, k1);
+        row[3] = _mm256_sub_ps (
+            _mm256_mul_ps (c3Half, rotX), _mm256_mul_ps (c5Half, rotY));
+        row[5] = _mm256_add_ps (
+            _mm256_mul_ps (c5Half, rotX), _mm256_mul_ps (c3Half, rotY));
+
+        rotX   = _mm256_add_ps (a7, k0);
+        rotY   = _mm256_sub_ps (k1, a4);
+        row[1] = _mm256_sub_ps (
+            _mm256_mul_ps (c1Half, rotX), _mm256_mul_ps (c7Half, rotY));
+        row[7] = _mm256_add_ps (
+            _mm256_mul_ps (c7Half, rotX), _mm256_mul_ps (c1Half, rotY));
+
+        //
+        // Transpose, so that the second pass runs over the rows
+        //
+
+        for (int i = 0; i < 8; i += 2)
+        {
+            t[i]     = _mm256_unpacklo_ps (row[i], row[i + 1]);
+            t[i + 1] = _mm256_unpackhi_ps (row[i], row[i + 1]);
+        }
+        for (int i = 0; i < 8; i += 4)
+        {
+            u[i]     = _mm256_shuffle_ps (t[i], t[i + 2], 0x44);
+            u[i + 1] = _mm256_shuffle_ps (t[i], t[i + 2], 0xEE);
+            u[i + 2] = _mm256_shuffle_ps (t[i + 1], t[i + 3], 0x44);
+            u[i + 3] = _mm256_shuffle_ps (t[i + 1], t[i + 3], 0xEE);
+        }
+        for (int i = 0; i < 4; ++i)
+        {
+            row[i]     = _mm256_permute2f128_ps (u[i], u[i + 4], 0x20);
+            row[i + 4] = _mm256_permute2f128_ps (u[i], u[i + 4], 0x31);
+        }
+    }
+
+    for (int i = 0; i < 8; ++i)
+        _mm256_storeu_ps (data + 8 * i, row[i]);
+}
+
+//
+// Forward DCT, then quantize each coefficient as quantize () does:
+// round to half with F16C, and test up to 16 candidates from
+// closestData against the tolerance at once, taking the first
+// one that fits. Candidate lists which end too close to the end
+// of closestData to load 16 values take the scalar loop.
+//
+
+DWA_AVX2_TARGET static void
+dctForwardQuantize64_avx2 (uint16_t* dst, float* data, const float* tolerance)
+{
+    static const size_t numClosest =
+        sizeof (closestData) / sizeof (closestData[0]);
+
+    uint16_t src[64];
+    uint16_t numSetBits[64];
+    float    srcFloat[64];
+
+    const __m128i m1 = _mm_set1_epi16 (0x5555);
+    const __m128i m2 = _mm_set1_epi16 (0x3333);
+    const __m128i m4 = _mm_set1_epi16 (0x0f0f);
+    const __m256  absMask =
+        _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff));
+
+    dctForward8x8_avx2 (data);
+
+    for (int i = 0; i < 64; i += 8)
+    {
+        __m128i h = _mm256_cvtps_ph (
+            _mm256_loadu_ps (data + i), _MM_FROUND_TO_NEAREST_INT);
+        __m128i n =
+            _mm_sub_epi16 (h, _mm_and_si128 (_mm_srli_epi16 (h, 1), m1));
+
+        n = _mm_add_epi16 (
+            _mm_and_si128 (n, m2), _mm_and_si128 (_mm_srli_epi16 (n, 2), m2));
+        n = _mm_and_si128 (_mm_add_epi16 (n, _mm_srli_epi16 (n, 4)), m4);
+        n = _mm_and_si128 (
+            _mm_add_epi16 (n, _mm_srli_epi16 (n, 8)), _mm_set1_epi16 (0x1f));
+
+        _mm_storeu_si128 ((__m128i*) (src + i), h);
+        _mm_storeu_si128 ((__m128i*) (numSetBits + i), n);
+        _mm256_storeu_ps (srcFloat + i, _mm256_cvtph_ps (h));
+    }
+
+    for (int i = 0; i < 64; ++i)
+    {
+        uint32_t        offset  = closestDataOffset[src[i]];
+        const uint16_t* closest = closestData + offset;
+        int             n       = numSetBits[i];
+        uint32_t        hit;
+        __m256          f, tol;
+
+        dst[i] = src[i];
+        if (n == 0) continue;
+
+        if (offset + 16 > numClosest)
+        {
+            for (int k = 0; k < n; ++k)
+            {
+                if (fabsf (half_to_float (closest[k]) - srcFloat[i]) <
+                    tolerance[i])
+                {
+                    dst[i] = closest[k];
+                    break;
+                }
+            }
+            continue;
+        }
+
+        f   = _mm256_set1_ps (srcFloat[i]);
+        tol = _mm256_set1_ps (tolerance[i]);
+
+        hit = (uint32_t) _mm256_movemask_ps (_mm256_cmp_ps (
+            _mm256_and_ps (
+                _mm256_sub_ps (
+                    _mm256_cvtph_ps (
+                        _mm_loadu_si128 ((const __m128i*) closest)),
+                    f),
+                absMask),
+            tol,
+            _CMP_LT_OQ));
+        if (n > 8)
+            hit |= (uint32_t) _mm256_movemask_ps (_mm256_cmp_ps (
+                       _mm256_and_ps (
+                           _mm256_sub_ps (
+                               _mm256_cvtph_ps (_mm_loadu_si128 (
+                                   (const __m128i*) (closest + 8))),
+                               f),
+                           absMask),
+                       tol,
+                       _CMP_LT_OQ))
+                   << 8;
+
+        hit &= (1u << n) - 1;
+        if (hit)
+        {
+#    if defined(_MSC_VER)
+            unsigned long first;
+            _BitScanForward (&first, hit);
+#    else
+            int first = __builtin_ctz (hit);
+#    endif
+            dst[i] = closest[first];
+        }
+    }
+}
+
+#endif /* IMF_HAVE_AVX2_DISPATCH */
+
 /**************************************/
 
 //
@@ -2296,6 +2515,17 @@ static void (*dctInverse8x8_5) (float*) = dctInverse8x8_scalar_5;
 static void (*dctInverse8x8_6) (float*) = dctInverse8x8_scalar_6;
 static void (*dctInverse8x8_7) (float*) = dctInverse8x8_scalar_7;
 
+//
+// Forward DCT of an 8x8 block, followed by quantization of each
+// coefficient to half against a per-coefficient error tolerance.
+// The output is in natural order, not zig-zag order.
+//
+static void dctForwardQuantize64_scalar (
+    uint16_t* dst, float* data, const float* tolerance);
+
+static void (*dctForwardQuantize64) (uint16_t*, float*, const float*) =
+    dctForwardQuantize64_scalar;
+
 static void
 initializeFuncs (void)
 {
@@ -2312,9 +2542,14 @@ initializeFuncs (void)
 #else
     convertFloatToHalf64 = convertFloatToHalf64_scalar;
     fromHalfZigZag       = fromHalfZigZag_scalar;
+    dctForwardQuantize64 = dctForwardQuantize64_scalar;
 
     check_for_x86_simd (&f16c, &avx, &sse2);
 
+#    ifdef IMF_HAVE_AVX2_DISPATCH
+    if (f16c && has_avx2 ()) dctForwardQuantize64 = dctForwardQuantize64_avx2;
+#    endif
+
     //
     // Setup HALF <-> FLOAT conversion implementations
     //
@@ -0,0 +1,1049 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#include "internal_compress.h"
+#include "internal_decompress.h"
+
+#include "internal_coding.h"
+#include "internal_cpuid.h"
+#include "internal_xdr.h"
+
+#include <string.h>
+
+#if EXR_HOST_IS_NOT_LITTLE_ENDIAN
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define HT_SIMD_SSE2 1
+#    include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#    define HT_SIMD_NEON 1
+#    include <arm_neon.h>
+#endif
+
+#include <exception>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <ojph_arch.h>
+#include <ojph_codestream.h>
+#include <ojph_file.h>
+#include <ojph_mem.h>
+#include <ojph_params.h>
+
+/*
+ * High-Throughput JPEG 2000 (HTJ2K) compression. Each channel of the
+ * chunk is one J2K component: HALF channels are 16-bit components and
+ * FLOAT / UINT channels are 32-bit components, with HALF and FLOAT
+ * values stored as sign-magnitude integers, and channel sampling
+ * rates become component subsampling factors. When full resolution
+ * HALF R, G and B channels are present, they are moved to the first
+ * three components so the reversible color transform can be applied,
+ * matching the C++ HTCompressor bit for bit.
+ */
+
+typedef struct
+{
+    exr_pixel_type_t      type;
+    ojph::point           sampling;
+    ojph::ui32            width;  /* samples per line */
+    ojph::ui32            height; /* lines in the stripe */
+    std::vector<uint64_t> lines;  /* offset of each line in the chunk */
+} ht_component_t;
+
+typedef struct
+{
+    std::vector<int> cs_to_file_ch;
+    bool             isRGB;
+    bool             isSubsampled;
+} ht_layout_t;
+
+/*
+ * COD marker settings, taken from the optional htDecompositionLevels,
+ * htCodeBlockSize, htProgressionOrder and htPrecinctSize attributes.
+ * A zero precinct size means maximal precincts. HT_LOSSY uses the
+ * irreversible transform, with a quantization step of qstep units
+ * in the last place of a HALF value.
+ */
+typedef struct
+{
+    ojph::ui32 levels;
+    ojph::size block;
+    char       progression[5];
+    ojph::size precinct;
+    bool       irreversible;
+    float      qstep;
+} ht_coding_t;
+
+/**************************************/
+
+static inline bool
+ht_is_pow2 (int32_t v, int32_t lo, int32_t hi)
+{
+    return v >= lo && v <= hi && (v & (v - 1)) == 0;
+}
+
+static exr_result_t
+ht_coding_params (exr_const_context_t ctxt, int part_index, ht_coding_t& coding)
+{
+    static const char* orders[] = {"LRCP", "RLCP", "RPCL", "PCRL", "CPRL"};
+
+    exr_result_t      rv;
+    exr_compression_t ctype;
+    int32_t           levels;
+    exr_attr_v2i_t    v2i;
+    int32_t           len;
+    const char*       str;
+
+    coding.levels = 5;
+    coding.block  = ojph::size (128, 32);
+    memcpy (coding.progression, "RPCL", 5);
+    coding.precinct = ojph::size (0, 0);
+
+    rv = exr_get_compression (ctxt, part_index, &ctype);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    coding.irreversible = ctype == EXR_COMPRESSION_HT_LOSSY;
+    coding.qstep        = 0.f;
+    if (coding.irreversible)
+    {
+        rv = exr_get_ht_compression_level (ctxt, part_index, &coding.qstep);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+    }
+
+    rv = exr_attr_get_int (ctxt, part_index, "htDecompositionLevels", &levels);
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        if (levels < 0 || levels > 32) return EXR_ERR_INVALID_ATTR;
+        coding.levels = (ojph::ui32) levels;
+    }
+    else if (rv != EXR_ERR_NO_ATTR_BY_NAME)
+        return rv;
+
+    rv = exr_attr_get_v2i (ctxt, part_index, "htCodeBlockSize", &v2i);
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        if (!ht_is_pow2 (v2i.x, 4, 1024) || !ht_is_pow2 (v2i.y, 4, 1024) ||
+            v2i.x * v2i.y > 4096)
+            return EXR_ERR_INVALID_ATTR;
+        coding.block = ojph::size ((ojph::ui32) v2i.x, (ojph::ui32) v2i.y);
+    }
+    else if (rv != EXR_ERR_NO_ATTR_BY_NAME)
+        return rv;
+
+    rv = exr_attr_get_string (
+        ctxt, part_index, "htProgressionOrder", &len, &str);
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        bool found = false;
+
+        for (size_t i = 0; i < sizeof (orders) / sizeof (orders[0]); ++i)
+            found = found || (len == 4 && !memcmp (str, orders[i], 4));
+        if (!found) return EXR_ERR_INVALID_ATTR;
+        memcpy (coding.progression, str, 4);
+    }
+    else if (rv != EXR_ERR_NO_ATTR_BY_NAME)
+        return rv;
+
+    rv = exr_attr_get_v2i (ctxt, part_index, "htPrecinctSize", &v2i);
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        if (!ht_is_pow2 (v2i.x, 2, 32768) || !ht_is_pow2 (v2i.y, 2, 32768))
+            return EXR_ERR_INVALID_ATTR;
+        coding.precinct = ojph::size ((ojph::ui32) v2i.x, (ojph::ui32) v2i.y);
+    }
+    else if (rv != EXR_ERR_NO_ATTR_BY_NAME)
+        return rv;
+
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+static exr_result_t
+ht_channel_map (
+    const exr_coding_channel_info_t* channels,
+    int                              channel_count,
+    ht_layout_t&                     layout)
+{
+    int r_index = -1;
+    int g_index = -1;
+    int b_index = -1;
+
+    layout.isSubsampled = false;
+
+    for (int c = 0; c < channel_count; ++c)
+    {
+        const exr_coding_channel_info_t* curc = channels + c;
+        bool                             isColor;
+
+        if (curc->data_type != EXR_PIXEL_HALF &&
+            curc->data_type != EXR_PIXEL_FLOAT &&
+            curc->data_type != EXR_PIXEL_UINT)
+            return EXR_ERR_FEATURE_NOT_IMPLEMENTED;
+
+        if (curc->x_samples != 1 || curc->y_samples != 1)
+            layout.isSubsampled = true;
+
+        isColor = curc->data_type == EXR_PIXEL_HALF && curc->x_samples == 1 &&
+                  curc->y_samples == 1;
+        if (!isColor) continue;
+
+        if (!strcmp (curc->channel_name, "R"))
+            r_index = c;
+        else if (!strcmp (curc->channel_name, "G"))
+            g_index = c;
+        else if (!strcmp (curc->channel_name, "B"))
+            b_index = c;
+    }
+
+    layout.cs_to_file_ch.resize (channel_count);
+
+    layout.isRGB = (r_index >= 0 && g_index >= 0 && b_index >= 0);
+    if (layout.isRGB)
+    {
+        int cs_i = 3;
+
+        layout.cs_to_file_ch[0] = r_index;
+        layout.cs_to_file_ch[1] = g_index;
+        layout.cs_to_file_ch[2] = b_index;
+
+        for (int c = 0; c < channel_count; ++c)
+        {
+            if (c != r_index && c != g_index && c != b_index)
+                layout.cs_to_file_ch[cs_i++] = c;
+        }
+    }
+    else
+    {
+        for (int c = 0; c < channel_count; ++c)
+            layout.cs_to_file_ch[c] = c;
+    }
+
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
+static inline int
+ht_floor_div (int a, int b)
+{
+    return (a >= 0) ? a / b : -((b - 1 - a) / b);
+}
+
+/* number of multiples of s in [a, b] */
+static inline int
+ht_num_samples (int s, int a, int b)
+{
+    return (b < a) ? 0 : ht_floor_div (b, s) - ht_floor_div (a - 1, s);
+}
+
+/*
+ * Build the components for scan lines y0 to y1 - 1 of a chunk
+ * starting at scan line start_y, in codestream order, recording
+ * where each of their lines starts in the packed buffer, and
+ * return the size of the packed chunk.
+ */
+static uint64_t
+ht_stripe_components (
+    const exr_coding_channel_info_t* channels,
+    int                              channel_count,
+    const ht_layout_t&               layout,
+    int                              start_y,
+    int                              height,
+    int                              y0,
+    int                              y1,
+    std::vector<ht_component_t>&     comps)
+{
+    uint64_t         offset = 0;
+    std::vector<int> file_to_cs (channel_count);
+
+    comps.resize (channel_count);
+    for (int c = 0; c < channel_count; ++c)
+    {
+        const exr_coding_channel_info_t* curc =
+            channels + layout.cs_to_file_ch[c];
+
+        file_to_cs[layout.cs_to_file_ch[c]] = c;
+
+        comps[c].type     = (exr_pixel_type_t) curc->data_type;
+        comps[c].sampling = ojph::point (
+            (ojph::ui32) curc->x_samples, (ojph::ui32) curc->y_samples);
+        comps[c].width  = (ojph::ui32) curc->width;
+        comps[c].height = 0;
+        comps[c].lines.clear ();
+    }
+
+    for (int y = start_y; y < start_y + height; ++y)
+    {
+        for (int c = 0; c < channel_count; ++c)
+        {
+            const exr_coding_channel_info_t* curc = channels + c;
+
+            if (y - ht_floor_div (y, curc->y_samples) * curc->y_samples != 0)
+                continue;
+
+            if (y >= y0 && y < y1)
+            {
+                ht_component_t& comp = comps[file_to_cs[c]];
+
+                comp.lines.push_back (offset);
+                comp.height++;
+            }
+
+            offset += (uint64_t) curc->width * curc->bytes_per_element;
+        }
+    }
+
+    return offset;
+}
+
+static inline ojph::ui32
+ht_bit_depth (exr_pixel_type_t type)
+{
+    return type == EXR_PIXEL_HALF ? 16 : 32;
+}
+
+/*
+ * HALF and FLOAT samples are sign-magnitude values; the codestream
+ * holds them as two's complement integers with the same ordering.
+ */
+template <class T>
+static void
+ht_pack_line (T* out, const uint8_t* in, exr_pixel_type_t type, ojph::ui32 width)
+{
+    switch (type)
+    {
+        case EXR_PIXEL_HALF:
+            for (ojph::ui32 p = 0; p < width; ++p)
+            {
+                int16_t v = (int16_t) unaligned_load16 (in + p * 2);
+                out[p]    = v < 0 ? v ^ 0x7FFF : v;
+            }
+            break;
+        case EXR_PIXEL_FLOAT:
+            for (ojph::ui32 p = 0; p < width; ++p)
+            {
+                int32_t v = (int32_t) unaligned_load32 (in + p * 4);
+                out[p]    = v < 0 ? v ^ 0x7FFFFFFF : v;
+            }
+            break;
+        case EXR_PIXEL_UINT:
+            for (ojph::ui32 p = 0; p < width; ++p)
+                out[p] = (T) unaligned_load32 (in + p * 4);
+            break;
+        default: break;
+    }
+}
+
+template <class T>
+static void
+ht_unpack_line (uint8_t* out, const T* in, exr_pixel_type_t type, ojph::ui32 width)
+{
+    switch (type)
+    {
+        case EXR_PIXEL_HALF:
+            for (ojph::ui32 p = 0; p < width; ++p)
+            {
+                T v = in[p] < 0 ? in[p] ^ 0x7FFF : in[p];
+                unaligned_store16 (out + p * 2, (uint16_t) (int16_t) v);
+            }
+            break;
+        case EXR_PIXEL_FLOAT:
+            for (ojph::ui32 p = 0; p < width; ++p)
+            {
+                T v = in[p] < 0 ? in[p] ^ 0x7FFFFFFF : in[p];
+                unaligned_store32 (out + p * 4, (uint32_t) (int32_t) v);
+            }
+            break;
+        case EXR_PIXEL_UINT:
+            for (ojph::ui32 p = 0; p < width; ++p)
+                unaligned_store32 (out + p * 4, (uint32_t) in[p]);
+            break;
+        default: break;
+    }
+}
+
+/*
+ * Quantization noise can push lossy samples past infinity, into NaN
+ * bit patterns, or out of the range of the pixel type altogether.
+ */
+template <class T>
+static void
+ht_clamp_line (T* line, exr_pixel_type_t type, ojph::ui32 width)
+{
+    T lo, hi;
+
+    switch (type)
+    {
+        case EXR_PIXEL_HALF:
+            lo = -0x7C00 - 1; /* -inf */
+            hi = 0x7C00;      /* +inf */
+            break;
+        case EXR_PIXEL_FLOAT:
+            lo = -0x7F800000 - 1;
+            hi = 0x7F800000;
+            break;
+        default: return;
+    }
+
+    for (ojph::ui32 p = 0; p < width; ++p)
+        line[p] = line[p] < lo ? lo : (line[p] > hi ? hi : line[p]);
+}
+
+/*
+ * HALF lines with 32-bit line buffers are the common case, so they
+ * get vectorized versions of the above on little-endian hosts.
+ */
+typedef void (*ht_pack_half_fn) (
+    ojph::si32* out, const uint8_t* in, ojph::ui32 width);
+typedef void (*ht_unpack_half_fn) (
+    uint8_t* out, const ojph::si32* in, ojph::ui32 width);
+
+static void
+ht_pack_half_line_scalar (ojph::si32* out, const uint8_t* in, ojph::ui32 width)
+{
+    ht_pack_line (out, in, EXR_PIXEL_HALF, width);
+}
+
+static void
+ht_unpack_half_line_scalar (
+    uint8_t* out, const ojph::si32* in, ojph::ui32 width)
+{
+    ht_unpack_line (out, in, EXR_PIXEL_HALF, width);
+}
+
+#if defined(HT_SIMD_SSE2)
+
+static void
+ht_pack_half_line_sse2 (ojph::si32* out, const uint8_t* in, ojph::ui32 width)
+{
+    const __m128i mask = _mm_set1_epi16 (0x7FFF);
+    ojph::ui32    p    = 0;
+
+    for (; p + 8 <= width; p += 8)
+    {
+        __m128i v = _mm_loadu_si128 ((const __m128i*) (in + p * 2));
+
+        v = _mm_xor_si128 (v, _mm_and_si128 (_mm_srai_epi16 (v, 15), mask));
+
+        _mm_storeu_si128 (
+            (__m128i*) (out + p),
+            _mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16));
+        _mm_storeu_si128 (
+            (__m128i*) (out + p + 4),
+            _mm_srai_epi32 (_mm_unpackhi_epi16 (v, v), 16));
+    }
+
+    ht_pack_line (out + p, in + p * 2, EXR_PIXEL_HALF, width - p);
+}
+
+static void
+ht_unpack_half_line_sse2 (uint8_t* out, const ojph::si32* in, ojph::ui32 width)
+{
+    const __m128i mask = _mm_set1_epi16 (0x7FFF);
+    ojph::ui32    p    = 0;
+
+    for (; p + 8 <= width; p += 8)
+    {
+        __m128i v = _mm_packs_epi32 (
+            _mm_loadu_si128 ((const __m128i*) (in + p)),
+            _mm_loadu_si128 ((const __m128i*) (in + p + 4)));
+
+        v = _mm_xor_si128 (v, _mm_and_si128 (_mm_srai_epi16 (v, 15), mask));
+
+        _mm_storeu_si128 ((__m128i*) (out + p * 2), v);
+    }
+
+    ht_unpack_line (out + p * 2, in + p, EXR_PIXEL_HALF, width - p);
+}
+
+#elif defined(HT_SIMD_NEON)
+
+static void
+ht_pack_half_line_neon (ojph::si32* out, const uint8_t* in, ojph::ui32 width)
+{
+    const int16x8_t mask = vdupq_n_s16 (0x7FFF);
+    ojph::ui32      p    = 0;
+
+    for (; p + 8 <= width; p += 8)
+    {
+        int16x8_t v = vld1q_s16 ((const int16_t*) (in + p * 2));
+
+        v = veorq_s16 (v, vandq_s16 (vshrq_n_s16 (v, 15), mask));
+
+        vst1q_s32 (out + p, vmovl_s16 (vget_low_s16 (v)));
+        vst1q_s32 (out + p + 4, vmovl_high_s16 (v));
+    }
+
+    ht_pack_line (out + p, in + p * 2, EXR_PIXEL_HALF, width - p);
+}
+
+static void
+ht_unpack_half_line_neon (uint8_t* out, const ojph::si32* in, ojph::ui32 width)
+{
+    const int16x8_t mask = vdupq_n_s16 (0x7FFF);
+    ojph::ui32      p    = 0;
+
+    for (; p + 8 <= width; p += 8)
+    {
+        int16x8_t v = vcombine_s16 (
+            vqmovn_s32 (vld1q_s32 (in + p)),
+            vqmovn_s32 (vld1q_s32 (in + p + 4)));
+
+        v = veorq_s16 (v, vandq_s16 (vshrq_n_s16 (v, 15), mask));
+
+        vst1q_s16 ((int16_t*) (out + p * 2), v);
+    }
+
+    ht_unpack_line (out + p * 2, in + p, EXR_PIXEL_HALF, width - p);
+}
+
+#endif
+
+struct ht_half_impl_t
+{
+    ht_pack_half_fn   pack;
+    ht_unpack_half_fn unpack;
+};
+
+static ht_half_impl_t
+ht_choose_half_impl (void)
+{
+    ht_half_impl_t impl = {
+        &ht_pack_half_line_scalar, &ht_unpack_half_line_scalar};
+
+#if defined(HT_SIMD_SSE2)
+    int f16c, avx, sse2;
+
+    check_for_x86_simd (&f16c, &avx, &sse2);
+    if (sse2)
+    {
+        impl.pack   = &ht_pack_half_line_sse2;
+        impl.unpack = &ht_unpack_half_line_sse2;
+    }
+#elif defined(HT_SIMD_NEON)
+    impl.pack   = &ht_pack_half_line_neon;
+    impl.unpack = &ht_unpack_half_line_neon;
+#endif
+
+    return impl;
+}
+
+static const ht_half_impl_t&
+ht_half_impl (void)
+{
+    static const ht_half_impl_t impl = ht_choose_half_impl ();
+    return impl;
+}
+
+/**************************************/
+
+/*
+ * EXR_COMPRESSION_HT_STRIPED chunks are coded as a sequence of
+ * independent codestreams, one per horizontal stripe of
+ * HT_STRIPE_LINES lines, so readers can decode a chunk with several
+ * threads:
+ *
+ *   uint32_t  number of stripes, n >= 1
+ *   uint32_t  stripe height, in scan lines
+ *   uint32_t  size of each codestream, n times
+ *   uint8_t   codestreams, back to back
+ *
+ * The chunks of all other HT compression types hold a single bare
+ * codestream.
+ */
+#define HT_STRIPE_LINES 256
+
+static exr_result_t
+ht_is_striped (exr_const_context_t ctxt, int part_index, bool& striped)
+{
+    exr_compression_t ctype;
+    exr_result_t      rv = exr_get_compression (ctxt, part_index, &ctype);
+
+    striped = ctype == EXR_COMPRESSION_HT_STRIPED;
+    return rv;
+}
+
+/*
+ * Unlike the C++ library, the core has no codec object that lives
+ * across chunks, so the codestream is cached per thread instead.
+ * OpenJPH keeps the memory of a codestream across restart (), so
+ * chunks after the first on a thread allocate next to nothing.
+ */
+typedef struct
+{
+    ojph::codestream cs;
+    bool             cs_used;
+} ht_thread_state_t;
+
+static thread_local ht_thread_state_t ht_state;
+
+static ojph::codestream&
+ht_reset_codestream (void)
+{
+    if (ht_state.cs_used) ht_state.cs.restart ();
+    ht_state.cs_used = true;
+    return ht_state.cs;
+}
+
+/*
+ * Codestreams are written straight into the compressed buffer of
+ * the encode pipeline. A chunk whose codestreams do not fit would
+ * be stored uncompressed anyway, so running out of room only sets
+ * a flag, rather than making OpenJPH report a write error.
+ */
+class ht_chunk_outfile : public ojph::outfile_base
+{
+public:
+    ht_chunk_outfile (uint8_t* buf, size_t capacity)
+        : buf (buf), capacity (capacity), pos (0), overflow (false)
+    {}
+
+    size_t write (const void* ptr, size_t size) override
+    {
+        if (overflow || size > capacity - pos)
+            overflow = true;
+        else
+        {
+            memcpy (buf + pos, ptr, size);
+            pos += size;
+        }
+        return size;
+    }
+
+    ojph::si64 tell () override { return (ojph::si64) pos; }
+
+    uint8_t* buf;
+    size_t   capacity;
+    size_t   pos;
+    bool     overflow;
+};
+
+static void
+ht_encode_stripe (
+    const uint8_t*                     packed,
+    const std::vector<ht_component_t>& comps,
+    ojph::ui32                         width,
+    ojph::ui32                         height,
+    ojph::ui32                         y_offset,
+    const ht_layout_t&                 layout,
+    const ht_coding_t&                 coding,
+    ojph::outfile_base&                output)
+{
+    const ht_half_impl_t& half  = ht_half_impl ();
+    ojph::codestream&     cs    = ht_reset_codestream ();
+    ojph::ui32            total = 0;
+
+    cs.set_planar (layout.isSubsampled);
+
+    ojph::param_siz siz = cs.access_siz ();
+
+    siz.set_num_components ((ojph::ui32) comps.size ());
+    for (ojph::ui32 c = 0; c < comps.size (); c++)
+    {
+        siz.set_component (
+            c,
+            comps[c].sampling,
+            ht_bit_depth (comps[c].type),
+            comps[c].type != EXR_PIXEL_UINT);
+        total += comps[c].height;
+    }
+
+    /* the vertical offset lines the J2K sampling grid up with the
+     * data window, see HTCompressor */
+    siz.set_image_offset (ojph::point (0, y_offset));
+    siz.set_tile_offset (ojph::point (0, 0));
+    siz.set_image_extent (ojph::point (width, y_offset + height));
+    siz.set_tile_size (ojph::size (width, y_offset + height));
+
+    ojph::param_cod cod = cs.access_cod ();
+
+    cod.set_color_transform (layout.isRGB);
+    cod.set_reversible (!coding.irreversible);
+    cod.set_block_dims (coding.block.w, coding.block.h);
+    cod.set_num_decomposition (coding.levels);
+    cod.set_progression_order (coding.progression);
+    if (coding.precinct.w != 0)
+    {
+        std::vector<ojph::size> precincts (coding.levels + 1, coding.precinct);
+        cod.set_precinct_size ((int) precincts.size (), precincts.data ());
+    }
+
+    if (coding.irreversible)
+    {
+        /* samples are normalized by their bit depth, and FLOAT has 13
+         * more mantissa bits than HALF */
+        ojph::param_qcd qcd = cs.access_qcd ();
+
+        qcd.set_irrev_quant (coding.qstep / 65536.f);
+        for (ojph::ui32 c = 0; c < comps.size (); c++)
+        {
+            if (comps[c].type == EXR_PIXEL_FLOAT)
+                qcd.set_irrev_quant (c, coding.qstep / 524288.f);
+        }
+    }
+
+    cs.write_headers (&output);
+
+    std::vector<ojph::ui32> line (comps.size (), 0);
+    ojph::ui32              next_comp = 0;
+    ojph::line_buf*         cur_line  = cs.exchange (NULL, next_comp);
+
+    for (ojph::ui32 i = 0; i < total; ++i)
+    {
+        const ht_component_t& comp = comps[next_comp];
+        const uint8_t*        in   = packed + comp.lines[line[next_comp]++];
+
+        if (cur_line->flags & ojph::line_buf::LFT_64BIT)
+            ht_pack_line (cur_line->i64, in, comp.type, comp.width);
+        else if (comp.type == EXR_PIXEL_HALF)
+            half.pack (cur_line->i32, in, comp.width);
+        else
+            ht_pack_line (cur_line->i32, in, comp.type, comp.width);
+
+        cur_line = cs.exchange (cur_line, next_comp);
+    }
+
+    cs.flush ();
+}
+
+static exr_result_t
+ht_store_packed (exr_encode_pipeline_t* encode)
+{
+    memcpy (
+        encode->compressed_buffer, encode->packed_buffer, encode->packed_bytes);
+    encode->compressed_bytes = encode->packed_bytes;
+    return EXR_ERR_SUCCESS;
+}
+
+static exr_result_t
+apply_ht_impl (exr_encode_pipeline_t* encode)
+{
+    ht_layout_t       layout;
+    ht_coding_t       coding;
+    exr_result_t      rv;
+    exr_attr_box2i_t  dw;
+    uint64_t          compbufsz, capacity;
+    ojph::ui32        width  = (ojph::ui32) encode->chunk.width;
+    ojph::ui32        height = (ojph::ui32) encode->chunk.height;
+    int               start_y = encode->chunk.start_y;
+    ojph::ui32        nstripes, stripe_lines;
+    bool              striped;
+    uint8_t*          out;
+    uint8_t*          sizes;
+
+    rv = ht_channel_map (encode->channels, encode->channel_count, layout);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    rv = exr_get_data_window (encode->context, encode->part_index, &dw);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    rv = ht_coding_params (encode->context, encode->part_index, coding);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    /* quantizing UINT samples would not be meaningful */
+    if (coding.irreversible)
+    {
+        for (int c = 0; c < encode->channel_count; ++c)
+            if (encode->channels[c].data_type == EXR_PIXEL_UINT)
+                return EXR_ERR_FEATURE_NOT_IMPLEMENTED;
+    }
+
+    rv = ht_is_striped (encode->context, encode->part_index, striped);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    stripe_lines = striped ? HT_STRIPE_LINES : height;
+    nstripes     = (height + stripe_lines - 1) / stripe_lines;
+
+    std::vector<ht_component_t> comps;
+
+    /* anything that does not fit below the packed size is stored as
+     * is, so that is all the room the codestreams get */
+    capacity = encode->packed_bytes - 1;
+    if (capacity > encode->compressed_alloc_size)
+        capacity = encode->compressed_alloc_size;
+
+    compbufsz = striped ? (2 + nstripes) * sizeof (uint32_t) : 0;
+    if (compbufsz >= capacity) return ht_store_packed (encode);
+
+    out   = (uint8_t*) encode->compressed_buffer;
+    sizes = out + 2 * sizeof (uint32_t);
+    if (striped)
+    {
+        unaligned_store32 (out, nstripes);
+        unaligned_store32 (out + sizeof (uint32_t), stripe_lines);
+    }
+
+    for (ojph::ui32 s = 0; s < nstripes; ++s)
+    {
+        ojph::ui32 y0 = s * stripe_lines;
+        ojph::ui32 y1 = y0 + stripe_lines;
+
+        if (y1 > height) y1 = height;
+
+        if (ht_stripe_components (
+                encode->channels,
+                encode->channel_count,
+                layout,
+                start_y,
+                (int) height,
+                start_y + (int) y0,
+                start_y + (int) y1,
+                comps) != encode->packed_bytes)
+            return EXR_ERR_INVALID_ARGUMENT;
+
+        /* J2K components can not be empty */
+        for (size_t c = 0; c < comps.size (); ++c)
+            if (comps[c].height == 0) return EXR_ERR_FEATURE_NOT_IMPLEMENTED;
+
+        ht_chunk_outfile output (out + compbufsz, capacity - compbufsz);
+
+        ht_encode_stripe (
+            (const uint8_t*) encode->packed_buffer,
+            comps,
+            width,
+            y1 - y0,
+            layout.isSubsampled ? (ojph::ui32) (start_y + (int) y0 - dw.min.y)
+                                : 0,
+            layout,
+            coding,
+            output);
+
+        if (output.overflow) return ht_store_packed (encode);
+
+        if (striped)
+            unaligned_store32 (
+                sizes + s * sizeof (uint32_t), (uint32_t) output.pos);
+
+        compbufsz += output.pos;
+    }
+
+    encode->compressed_bytes = compbufsz;
+    return EXR_ERR_SUCCESS;
+}
+
+extern "C" exr_result_t
+internal_exr_apply_ht (exr_encode_pipeline_t* encode)
+{
+    try
+    {
+        return apply_ht_impl (encode);
+    }
+    catch (std::bad_alloc&)
+    {
+        return EXR_ERR_OUT_OF_MEMORY;
+    }
+    catch (std::exception&)
+    {
+        return EXR_ERR_UNKNOWN;
+    }
+}
+
+/**************************************/
+
+static exr_result_t
+ht_decode_stripe (
+    const uint8_t*                     data,
+    uint64_t                           size,
+    uint8_t*                           unpacked,
+    const std::vector<ht_component_t>& comps,
+    ojph::ui32                         width,
+    const ht_layout_t&                 layout)
+{
+    const ht_half_impl_t& half = ht_half_impl ();
+    ojph::mem_infile      infile;
+    ojph::ui32            total = 0;
+
+    infile.open (data, (size_t) size);
+
+    ojph::codestream& cs = ht_reset_codestream ();
+    cs.read_headers (&infile);
+
+    bool irreversible = !cs.access_cod ().is_reversible ();
+
+    ojph::param_siz siz = cs.access_siz ();
+    ojph::ui32 cs_width = siz.get_image_extent ().x - siz.get_image_offset ().x;
+
+    if (siz.get_num_components () != comps.size () || cs_width != width)
+        return EXR_ERR_CORRUPT_CHUNK;
+
+    for (ojph::ui32 c = 0; c < comps.size (); c++)
+    {
+        if (siz.get_recon_width (c) != comps[c].width ||
+            siz.get_recon_height (c) != comps[c].height ||
+            siz.get_bit_depth (c) != ht_bit_depth (comps[c].type) ||
+            siz.is_signed (c) != (comps[c].type != EXR_PIXEL_UINT))
+            return EXR_ERR_CORRUPT_CHUNK;
+        total += comps[c].height;
+    }
+
+    cs.set_planar (layout.isSubsampled);
+
+    cs.create ();
+
+    std::vector<ojph::ui32> line (comps.size (), 0);
+
+    for (ojph::ui32 i = 0; i < total; ++i)
+    {
+        ojph::ui32      next_comp = 0;
+        ojph::line_buf* cur_line  = cs.pull (next_comp);
+
+        if (next_comp >= comps.size () ||
+            line[next_comp] >= comps[next_comp].height)
+            return EXR_ERR_CORRUPT_CHUNK;
+
+        const ht_component_t& comp = comps[next_comp];
+        uint8_t*              out = unpacked + comp.lines[line[next_comp]++];
+
+        if (irreversible)
+        {
+            if (cur_line->flags & ojph::line_buf::LFT_64BIT)
+                ht_clamp_line (cur_line->i64, comp.type, comp.width);
+            else
+                ht_clamp_line (cur_line->i32, comp.type, comp.width);
+        }
+
+        if (cur_line->flags & ojph::line_buf::LFT_64BIT)
+            ht_unpack_line (out, cur_line->i64, comp.type, comp.width);
+        else if (comp.type == EXR_PIXEL_HALF)
+            half.unpack (out, cur_line->i32, comp.width);
+        else
+            ht_unpack_line (out, cur_line->i32, comp.type, comp.width);
+    }
+
+    infile.close ();
+
+    return EXR_ERR_SUCCESS;
+}
+
+static exr_result_t
+undo_ht_impl (
+    exr_decode_pipeline_t* decode,
+    const void*            compressed_data,
+    uint64_t               comp_buf_size,
+    void*                  uncompressed_data,
+    uint64_t               uncompressed_size)
+{
+    ht_layout_t                 layout;
+    exr_result_t                rv;
+    ojph::ui32                  width   = (ojph::ui32) decode->chunk.width;
+    int                         height  = decode->chunk.height;
+    int                         start_y = decode->chunk.start_y;
+    const uint8_t*              in      = (const uint8_t*) compressed_data;
+    bool                        striped;
+    std::vector<ht_component_t> comps;
+
+    rv = ht_channel_map (decode->channels, decode->channel_count, layout);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    rv = ht_is_striped (decode->context, decode->part_index, striped);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    if (!striped)
+    {
+        if (ht_stripe_components (
+                decode->channels,
+                decode->channel_count,
+                layout,
+                start_y,
+                height,
+                start_y,
+                start_y + height,
+                comps) > uncompressed_size)
+            return EXR_ERR_CORRUPT_CHUNK;
+
+        return ht_decode_stripe (
+            in,
+            comp_buf_size,
+            (uint8_t*) uncompressed_data,
+            comps,
+            width,
+            layout);
+    }
+    else
+    {
+        const uint8_t* data;
+        uint64_t       avail;
+        uint32_t       nstripes, stripe_lines;
+
+        if (comp_buf_size < 2 * sizeof (uint32_t)) return EXR_ERR_CORRUPT_CHUNK;
+
+        nstripes     = unaligned_load32 (in);
+        stripe_lines = unaligned_load32 (in + 4);
+        in += 2 * sizeof (uint32_t);
+
+        if (nstripes < 1 || stripe_lines == 0 ||
+            (uint64_t) (nstripes - 1) * stripe_lines >= (uint64_t) height ||
+            (uint64_t) nstripes * stripe_lines < (uint64_t) height ||
+            (uint64_t) nstripes * sizeof (uint32_t) >
+                comp_buf_size - 2 * sizeof (uint32_t))
+            return EXR_ERR_CORRUPT_CHUNK;
+
+        data  = in + nstripes * sizeof (uint32_t);
+        avail = comp_buf_size - (uint64_t) (data - (const uint8_t*) compressed_data);
+
+        for (uint32_t s = 0; s < nstripes && rv == EXR_ERR_SUCCESS; ++s)
+        {
+            uint32_t size = unaligned_load32 (in);
+            int      y0   = start_y + (int) (s * stripe_lines);
+            int      y1   = y0 + (int) stripe_lines;
+
+            if (y1 > start_y + height) y1 = start_y + height;
+            if (size > avail) return EXR_ERR_CORRUPT_CHUNK;
+
+            if (ht_stripe_components (
+                    decode->channels,
+                    decode->channel_count,
+                    layout,
+                    start_y,
+                    height,
+                    y0,
+                    y1,
+                    comps) > uncompressed_size)
+                return EXR_ERR_CORRUPT_CHUNK;
+
+            rv = ht_decode_stripe (
+                data,
+                size,
+                (uint8_t*) uncompressed_data,
+                comps,
+                width,
+                layout);
+
+            in += sizeof (uint32_t);
+            data += size;
+            avail -= size;
+        }
+    }
+
+    return rv;
+}
+
+extern "C" exr_result_t
+internal_exr_undo_ht (
+    exr_decode_pipeline_t* decode,
+    const void*            compressed_data,
+    uint64_t               comp_buf_size,
+    void*                  uncompressed_data,
+    uint64_t               uncompressed_size)
+{
+    try
+    {
+        return undo_ht_impl (
+            decode,
+            compressed_data,
+            comp_buf_size,
+            uncompressed_data,
+            uncompressed_size);
+    }
+    catch (std::bad_alloc&)
+    {
+        return EXR_ERR_OUT_OF_MEMORY;
+    }
+    catch (std::exception&)
+    {
+        return EXR_ERR_CORRUPT_CHUNK;
+    }
+}
@@ -10,6 +10,7 @@
 #include "internal_structs.h"
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <math.h>
 #include <string.h>
@@ -121,7 +122,10 @@ hufCanonicalCodeTable (uint64_t* hcode)
         n[i] = 0;
 
     for (int i = 0; i < HUF_ENCSIZE; ++i)
-        n[hcode[i]] += 1;
+    {
+        // most entries are unused; counting them only stalls on n[0]
+        if (hcode[i] > 0) n[hcode[i]] += 1;
+    }
 
     //
     // For each i from 58 through 1, compute the
@@ -161,129 +165,87 @@ hufCanonicalCodeTable (uint64_t* hcode)
 //	- original frequencies are destroyed;
 //	- encoding tables are used by hufEncode() and hufBuildDecTable();
 //
-// NB: The following code "(*a == *b) && (a > b))" was added to ensure
-//     elements in the heap with the same value are sorted by index.
-//     This is to ensure, the STL make_heap()/pop_heap()/push_heap() methods
-//     produced a resultant sorted heap that is identical across OSes.
+// The code must not depend on the platform, so ties between equal
+// frequencies are broken by symbol index: each node carries a key,
+// (frequency << HUF_KEYSHIFT) | index, and a node made by merging two
+// others takes the index of the second one. This gives the same
+// tree, and so the same code lengths, as repeatedly merging the two
+// smallest nodes of a heap ordered by those keys, so the output does
+// not change, but takes linear time once the leaves are sorted.
 //
 
-static inline int
-FHeapCompare (uint64_t* a, uint64_t* b)
-{
-    return ((*a > *b) || ((*a == *b) && (a > b)));
-}
+#define HUF_KEYSHIFT (HUF_ENCBITS + 1)
+#define HUF_KEYMASK ((1 << HUF_KEYSHIFT) - 1)
 
-static inline void
-intern_push_heap (
-    uint64_t** first, size_t holeIndex, size_t topIndex, uint64_t* value)
-{
-    size_t parent = (holeIndex - 1) / 2;
-    while (holeIndex > topIndex && FHeapCompare (*(first + parent), value))
-    {
-        *(first + holeIndex) = *(first + parent);
-        holeIndex            = parent;
-        parent               = (holeIndex - 1) / 2;
-    }
-    *(first + holeIndex) = value;
-}
+//
+// Sort n keys by frequency, keeping keys with equal frequencies in
+// index order. The keys are built in index order, so a stable LSD
+// radix sort over the bytes of the frequency is enough; only the
+// bytes the largest frequency uses get a pass.
+//
 
-static inline void
-adjust_heap (uint64_t** first, size_t holeIndex, size_t len, uint64_t* value)
+static uint64_t*
+hufSortKeys (uint64_t* keys, uint64_t* tmp, uint32_t n, uint64_t maxFreq)
 {
-    const size_t topIndex    = holeIndex;
-    size_t       secondChild = holeIndex;
+    uint32_t count[256];
 
-    while (secondChild < (len - 1) / 2)
+    for (int shift = HUF_KEYSHIFT; (maxFreq >> (shift - HUF_KEYSHIFT)) != 0;
+         shift += 8)
     {
-        secondChild = 2 * (secondChild + 1);
-        if (FHeapCompare (*(first + secondChild), *(first + (secondChild - 1))))
-            --secondChild;
-        *(first + holeIndex) = *(first + secondChild);
-        holeIndex            = secondChild;
-    }
+        uint32_t  sum = 0;
+        uint64_t* t;
 
-    if ((len & 1) == 0 && secondChild == (len - 2) / 2)
-    {
-        secondChild          = 2 * (secondChild + 1);
-        *(first + holeIndex) = *(first + (secondChild - 1));
-        holeIndex            = secondChild - 1;
-    }
+        memset (count, 0, sizeof (count));
 
-    intern_push_heap (first, holeIndex, topIndex, value);
-}
+        for (uint32_t i = 0; i < n; ++i)
+            count[(keys[i] >> shift) & 0xff]++;
 
-static inline void
-push_heap (uint64_t** first, uint64_t** last)
-{
-    uint64_t* value = *(last - 1);
-    intern_push_heap (first, (size_t) (last - first) - 1, 0, value);
-}
+        for (int b = 0; b < 256; ++b)
+        {
+            uint32_t c = count[b];
+            count[b]   = sum;
+            sum += c;
+        }
 
-static inline void
-intern_pop_heap (uint64_t** first, uint64_t** last, uint64_t** result)
-{
-    uint64_t* value = *result;
-    *result         = *first;
-    adjust_heap (first, 0, (size_t) (last - first), value);
-}
+        for (uint32_t i = 0; i < n; ++i)
+            tmp[count[(keys[i] >> shift) & 0xff]++] = keys[i];
 
-static inline void
-pop_heap (uint64_t** first, uint64_t** last)
-{
-    if (last - first > 1)
-    {
-        --last;
-        intern_pop_heap (first, last, last);
+        t    = keys;
+        keys = tmp;
+        tmp  = t;
     }
-}
-
-static void
-make_heap (uint64_t** first, uint64_t len)
-{
-    size_t parent;
 
-    if (len < 2) return;
-    parent = (len - 2) / 2;
-
-    while (1)
-    {
-        uint64_t* value = *(first + parent);
-        adjust_heap (first, parent, len, value);
-        if (parent == 0) return;
-        --parent;
-    }
+    return keys;
 }
 
 static void
 hufBuildEncTable (
-    uint64_t*  frq,
-    uint32_t*  im,
-    uint32_t*  iM,
-    uint32_t*  hlink,
-    uint64_t** fHeap,
-    uint64_t*  scode)
+    uint64_t* frq,
+    uint32_t* im,
+    uint32_t* iM,
+    uint32_t* sym,
+    uint32_t* leafParent,
+    uint64_t* scode)
 {
+    uint64_t* keys;
+    uint64_t  maxFreq = 1;
+    uint32_t  nf      = 0;
+    uint32_t  root, leaf, next;
+
     //
     // This function assumes that when it is called, array frq
     // indicates the frequency of all possible symbols in the data
     // that are to be Huffman-encoded.  (frq[i] contains the number
     // of occurrences of symbol i in the data.)
     //
-    // The loop below does three things:
-    //
-    // 1) Finds the minimum and maximum indices that point
-    //    to non-zero entries in frq:
+    // The loop below finds the minimum and maximum indices that
+    // point to non-zero entries in frq:
     //
     //     frq[im] != 0, and frq[i] == 0 for all i < im
     //     frq[iM] != 0, and frq[i] == 0 for all i > iM
     //
-    // 2) Fills array fHeap with pointers to all non-zero
-    //    entries in frq.
-    //
-    // 3) Initializes array hlink such that hlink[i] == i
-    //    for all array entries.
+    // and fills scode with the keys of all non-zero entries.
     //
-    uint32_t nf = 0;
 
     *im = 0;
 
@@ -292,132 +254,109 @@ hufBuildEncTable (
 
     for (uint32_t i = *im; i < HUF_ENCSIZE; i++)
     {
-        hlink[i] = i;
-
         if (frq[i])
         {
-            fHeap[nf] = &frq[i];
-            ++nf;
+            scode[nf++] = (frq[i] << HUF_KEYSHIFT) | i;
+            if (frq[i] > maxFreq) maxFreq = frq[i];
             *iM = i;
         }
     }
 
     //
-    // Add a pseudo-symbol, with a frequency count of 1, to frq;
-    // adjust the fHeap and hlink array accordingly.  Function
+    // Add a pseudo-symbol, with a frequency count of 1.  Function
     // hufEncode() uses the pseudo-symbol for run-length encoding.
     //
 
     (*iM)++;
-    frq[*iM]  = 1;
-    fHeap[nf] = &frq[*iM];
-    ++nf;
+    scode[nf++] = (1 << HUF_KEYSHIFT) | *iM;
 
     //
-    // Build an array, scode, such that scode[i] contains the number
-    // of bits assigned to symbol i.  Conceptually this is done by
-    // constructing a tree whose leaves are the symbols with non-zero
-    // frequency:
-    //
-    //     Make a heap that contains all symbols with a non-zero frequency,
-    //     with the least frequent symbol on top.
-    //
-    //     Repeat until only one symbol is left on the heap:
-    //
-    //         Take the two least frequent symbols off the top of the heap.
-    //         Create a new node that has first two nodes as children, and
-    //         whose frequency is the sum of the frequencies of the first
-    //         two nodes.  Put the new node back into the heap.
-    //
-    // The last node left on the heap is the root of the tree.  For each
-    // leaf node, the distance between the root and the leaf is the length
-    // of the code for the corresponding symbol.
-    //
-    // The loop below doesn't actually build the tree; instead we compute
-    // the distances of the leaves from the root on the fly.  When a new
-    // node is added to the heap, then that node's descendants are linked
-    // into a single linear list that starts at the new node, and the code
-    // lengths of the descendants (that is, their distance from the root
-    // of the tree) are incremented by one.
+    // Sort the leaves, using frq as scratch space; the frequencies
+    // are all in the keys now.
     //
 
-    make_heap (fHeap, nf);
+    keys = hufSortKeys (scode, frq, nf, maxFreq);
 
-    memset (scode, 0, sizeof (uint64_t) * HUF_ENCSIZE);
-
-    while (nf > 1)
+    if (keys != scode)
     {
-        uint32_t mm, m;
-        //
-        // Find the indices, mm and m, of the two smallest non-zero frq
-        // values in fHeap, add the smallest frq to the second-smallest
-        // frq, and remove the smallest frq value from fHeap.
-        //
+        memcpy (scode, keys, sizeof (uint64_t) * nf);
+        keys = scode;
+    }
 
-        mm = (uint32_t) (fHeap[0] - frq);
-        pop_heap (&fHeap[0], &fHeap[nf]);
-        --nf;
+    for (uint32_t i = 0; i < nf; ++i)
+        sym[i] = (uint32_t) (keys[i] & HUF_KEYMASK);
 
-        m = (uint32_t) (fHeap[0] - frq);
-        pop_heap (&fHeap[0], &fHeap[nf]);
+    //
+    // Build the tree in place (Moffat and Katajainen, "In-Place
+    // Calculation of Minimum-Redundancy Codes"). Leaves are taken
+    // from the front of keys, and internal nodes are stored behind
+    // them, in keys[0 .. next - 1], in the order they are made; the
+    // smallest unmerged node is always at the head of one of those
+    // two queues. A merged node's slot is reused for its parent's
+    // position, and each leaf's parent is kept in leafParent.
+    //
 
-        frq[m] += frq[mm];
-        push_heap (&fHeap[0], &fHeap[nf]);
+    leafParent[0] = 0;
+    leafParent[1] = 0;
+    keys[0]       = (((keys[0] >> HUF_KEYSHIFT) + (keys[1] >> HUF_KEYSHIFT))
+               << HUF_KEYSHIFT) |
+              (keys[1] & HUF_KEYMASK);
+    root = 0;
+    leaf = 2;
 
-        //
-        // The entries in scode are linked into lists with the
-        // entries in hlink serving as "next" pointers and with
-        // the end of a list marked by hlink[j] == j.
-        //
-        // Traverse the lists that start at scode[m] and scode[mm].
-        // For each element visited, increment the length of the
-        // corresponding code by one bit. (If we visit scode[j]
-        // during the traversal, then the code for symbol j becomes
-        // one bit longer.)
-        //
-        // Merge the lists that start at scode[m] and scode[mm]
-        // into a single list that starts at scode[m].
-        //
+    for (next = 1; next < nf - 1; ++next)
+    {
+        uint64_t a, b;
 
-        //
-        // Add a bit to all codes in the first list.
-        //
+        if (leaf >= nf || keys[root] < keys[leaf])
+        {
+            a            = keys[root];
+            keys[root++] = next;
+        }
+        else
+        {
+            a                  = keys[leaf];
+            leafParent[leaf++] = next;
+        }
 
-        for (uint32_t j = m;; j = hlink[j])
+        if (leaf >= nf || (root < next && keys[root] < keys[leaf]))
         {
-            scode[j]++;
+            b            = keys[root];
+            keys[root++] = next;
+        }
+        else
+        {
+            b                  = keys[leaf];
+            leafParent[leaf++] = next;
+        }
 
-            if (hlink[j] == j)
-            {
-                //
-                // Merge the two lists.
-                //
+        keys[next] = (((a >> HUF_KEYSHIFT) + (b >> HUF_KEYSHIFT))
+                      << HUF_KEYSHIFT) |
+                     (b & HUF_KEYMASK);
+    }
 
-                hlink[j] = mm;
-                break;
-            }
-        }
+    //
+    // Turn the parent positions of the internal nodes into depths,
+    // from the root down, then give each leaf the depth below its
+    // parent. Those depths are the code lengths.
+    //
 
-        //
-        // Add a bit to all codes in the second list
-        //
+    keys[nf - 2] = 0;
 
-        for (uint32_t j = mm;; j = hlink[j])
-        {
-            scode[j]++;
+    for (uint32_t i = nf - 2; i-- > 0;)
+        keys[i] = keys[keys[i]] + 1;
 
-            if (hlink[j] == j) break;
-        }
-    }
+    memset (frq, 0, sizeof (uint64_t) * HUF_ENCSIZE);
+
+    for (uint32_t i = 0; i < nf; ++i)
+        frq[sym[i]] = keys[leafParent[i]] + 1;
 
     //
     // Build a canonical Huffman code table, replacing the code
-    // lengths in scode with (code, code length) pairs.  Copy the
-    // code table from scode into frq.
+    // lengths in frq with (code, code length) pairs.
     //
 
-    hufCanonicalCodeTable (scode);
-    memcpy (frq, scode, sizeof (uint64_t) * HUF_ENCSIZE);
+    hufCanonicalCodeTable (frq);
 }
 
 //
@@ -703,44 +642,105 @@ hufFreeDecTable (const struct _internal_exr_context* pctxt, HufDec* hdecod)
 // ENCODING
 //
 
-static inline exr_result_t
-outputCode (uint64_t code, uint64_t* c, int* lc, uint8_t** out, uint8_t* outend)
+//
+// Codes are packed MSB first into a 64-bit accumulator. After each
+// code, all 8 bytes of it are stored, and the output pointer moves
+// past the whole bytes only; the partial byte stays at the top of the
+// accumulator and is stored again with the next code. That leaves no
+// branch on the bit count in the loop. Near the end of the output
+// buffer, bytes are written one at a time instead, and running out of
+// room is only noted, so that the writers need no error returns;
+// hufEncode checks it once at the end.
+//
+// As for getChar() and getCode() below, the writers are macros to
+// force the compiler to inline them, which also keeps the writer
+// state in registers.
+//
+
+typedef struct
 {
-    return outputBits (hufLength (code), hufCode (code), c, lc, out, outend);
-}
+    uint64_t acc;      // pending bits, left justified
+    int      nbits;    // number of pending bits, less than 8 between calls
+    int      overflow; // set once a byte did not fit before outend
+    uint8_t* out;
+    uint8_t* outend;
+} HufWriter;
 
-static inline exr_result_t
-sendCode (
-    uint64_t  sCode,
-    int       runCount,
-    uint64_t  runCode,
-    uint64_t* c,
-    int*      lc,
-    uint8_t** out,
-    uint8_t*  outend)
+static inline void
+hufStore64 (uint8_t* out, uint64_t v)
 {
-    exr_result_t rv;
-    if (hufLength (sCode) + hufLength (runCode) + 8 <
-        hufLength (sCode) * runCount)
-    {
-        rv = outputCode (sCode, c, lc, out, outend);
-        if (rv == EXR_ERR_SUCCESS)
-            rv = outputCode (runCode, c, lc, out, outend);
-        if (rv == EXR_ERR_SUCCESS)
-            rv = outputBits (8, (uint64_t) runCount, c, lc, out, outend);
-    }
-    else
-    {
-        rv = EXR_ERR_SUCCESS;
-        while (runCount-- >= 0)
-        {
-            rv = outputCode (sCode, c, lc, out, outend);
-            if (rv != EXR_ERR_SUCCESS) break;
-        }
-    }
-    return rv;
+#if !EXR_HOST_IS_NOT_LITTLE_ENDIAN && defined(_MSC_VER)
+    v = _byteswap_uint64 (v);
+#elif !EXR_HOST_IS_NOT_LITTLE_ENDIAN
+    v = __builtin_bswap64 (v);
+#endif
+    memcpy (out, &v, sizeof (uint64_t));
 }
 
+// nBits must be at most 32
+#define hufWriteBits(w, nBits, bits)                                           \
+    do                                                                         \
+    {                                                                          \
+        w.nbits += (nBits);                                                    \
+        w.acc |= (uint64_t) (bits) << (64 - w.nbits);                          \
+        if (w.outend - w.out >= (ptrdiff_t) sizeof (uint64_t))                 \
+        {                                                                      \
+            hufStore64 (w.out, w.acc);                                         \
+            w.out += w.nbits >> 3;                                             \
+            w.acc <<= w.nbits & ~7;                                            \
+            w.nbits &= 7;                                                      \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            while (w.nbits >= 8)                                               \
+            {                                                                  \
+                if (w.out < w.outend)                                          \
+                    *w.out++ = (uint8_t) (w.acc >> 56);                        \
+                else                                                           \
+                    w.overflow = 1;                                            \
+                w.acc <<= 8;                                                   \
+                w.nbits -= 8;                                                  \
+            }                                                                  \
+        }                                                                      \
+    } while (0)
+
+// only very skewed histograms give codes longer than 32 bits
+#define hufWriteCode(w, code)                                                  \
+    do                                                                         \
+    {                                                                          \
+        int len_ = hufLength (code);                                           \
+        if (len_ <= 32) { hufWriteBits (w, len_, hufCode (code)); }            \
+        else                                                                   \
+        {                                                                      \
+            hufWriteBits (w, len_ - 32, hufCode (code) >> 32);                 \
+            hufWriteBits (w, 32, hufCode (code) & 0xffffffff);                 \
+        }                                                                      \
+    } while (0)
+
+//
+// Output a run of runCount instances of the symbol sCode.
+// Output the symbols explicitly, or if that is shorter, output
+// the sCode symbol once followed by a runCode symbol and runCount
+// expressed as an 8-bit number.
+//
+
+#define sendCode(w, sCode, runCount, runCode)                                  \
+    do                                                                         \
+    {                                                                          \
+        if (hufLength (sCode) + hufLength (runCode) + 8 <                      \
+            hufLength (sCode) * runCount)                                      \
+        {                                                                      \
+            hufWriteCode (w, sCode);                                           \
+            hufWriteCode (w, runCode);                                         \
+            hufWriteBits (w, 8, runCount);                                     \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            while (runCount-- >= 0)                                            \
+                hufWriteCode (w, sCode);                                       \
+        }                                                                      \
+    } while (0)
+
 //
 // Encode (compress) ni values based on the Huffman encoding table hcode:
 //
@@ -755,13 +755,17 @@ hufEncode (
     uint8_t*        outend,
     uint32_t*       outbytes)
 {
-    exr_result_t rv = EXR_ERR_SUCCESS;
+    HufWriter w;
+    uint64_t  runCode = hcode[rlc];
+    uint16_t  s       = in[0];
+    int       cs      = 0;
+    uint64_t  nBits;
 
-    uint8_t* outStart = out;
-    uint64_t c        = 0; // bits not yet written to out
-    int      lc       = 0; // number of valid bits in c (LSB)
-    uint16_t s        = in[0];
-    int      cs       = 0;
+    w.acc      = 0;
+    w.nbits    = 0;
+    w.overflow = 0;
+    w.out      = out;
+    w.outend   = outend;
 
     //
     // Loop on input values
@@ -776,8 +780,12 @@ hufEncode (
         if (s == in[i] && cs < 255) { cs++; }
         else
         {
-            rv = sendCode (hcode[s], cs, hcode[rlc], &c, &lc, &out, outend);
-            if (rv != EXR_ERR_SUCCESS) break;
+            uint64_t sCode = hcode[s];
+
+            if (cs == 0)
+                hufWriteCode (w, sCode);
+            else
+                sendCode (w, sCode, cs, runCode);
             cs = 0;
         }
 
@@ -785,26 +793,30 @@ hufEncode (
     }
 
     //
-    // Send remaining code
+    // Send remaining code, and whatever is left in the accumulator;
+    // the last byte is padded with zeroes.
     //
 
-    if (rv == EXR_ERR_SUCCESS)
-        rv = sendCode (hcode[s], cs, hcode[rlc], &c, &lc, &out, outend);
-
-    if (rv == EXR_ERR_SUCCESS)
     {
-        if (lc)
-        {
-            if (out >= outend) return EXR_ERR_ARGUMENT_OUT_OF_RANGE;
-            *out = (c << (8 - lc)) & 0xff;
-        }
+        uint64_t sCode = hcode[s];
 
-        c = (((uintptr_t) out) - ((uintptr_t) outStart)) * 8 + (uint64_t) (lc);
-        if (c > (uint64_t) UINT32_MAX) return EXR_ERR_ARGUMENT_OUT_OF_RANGE;
-        *outbytes = (uint32_t) c;
+        sendCode (w, sCode, cs, runCode);
     }
+    if (w.overflow) return EXR_ERR_ARGUMENT_OUT_OF_RANGE;
 
-    return rv;
+    nBits = (uint64_t) (w.out - out) * 8 + (uint64_t) w.nbits;
+    if (nBits > (uint64_t) UINT32_MAX) return EXR_ERR_ARGUMENT_OUT_OF_RANGE;
+
+    while (w.nbits > 0)
+    {
+        if (w.out >= w.outend) return EXR_ERR_ARGUMENT_OUT_OF_RANGE;
+        *w.out++ = (uint8_t) (w.acc >> 56);
+        w.acc <<= 8;
+        w.nbits -= 8;
+    }
+
+    *outbytes = (uint32_t) nBits;
+    return EXR_ERR_SUCCESS;
 }
 
 //
@@ -969,11 +981,36 @@ hufDecode (
     return EXR_ERR_SUCCESS;
 }
 
+//
+// PIZ data has long runs of equal values, and incrementing the same
+// counter again and again waits on the previous increment every
+// time. A block of 8 values that all equal the value before them is
+// found with one 16-byte compare, which compilers turn into a vector
+// or two 64-bit compares, and counted with a single add.
+//
+
 static inline void
 countFrequencies (uint64_t* freq, const uint16_t* data, uint64_t n)
 {
+    uint64_t i = 1;
+
     memset (freq, 0, HUF_ENCSIZE * sizeof (uint64_t));
-    for (uint64_t i = 0; i < n; ++i)
+    if (n == 0) return;
+
+    ++freq[data[0]];
+
+    for (; i + 8 <= n; i += 8)
+    {
+        if (memcmp (data + i - 1, data + i, 8 * sizeof (uint16_t)) == 0)
+            freq[data[i]] += 8;
+        else
+        {
+            for (int k = 0; k < 8; ++k)
+                ++freq[data[i + k]];
+        }
+    }
+
+    for (; i < n; ++i)
         ++freq[data[i]];
 }
 
@@ -1520,221 +1557,418 @@ fasthuf_decode_enabled (void)
 #endif
 }
 
-static exr_result_t
-fasthuf_decode (
-    const struct _internal_exr_context* pctxt,
-    FastHufDecoder*                     fhd,
-    const uint8_t*                      src,
-    uint64_t                            numSrcBits,
-    uint16_t*                           dst,
-    uint64_t                            numDstElems)
+//
+// State of one bit reader of the fast decoder. A multi-stream payload
+// has one per stream, all sharing the same decoding tables.
+//
+
+typedef struct FastHufStream
+{
+    uint64_t       buffer;            // current bits, left justified
+    uint64_t       bufferBack;        // the next 64-bits, to refill from
+    int            bufferNumBits;     // number of bits left in buffer
+    int            bufferBackNumBits; // number of bits left in bufferBack
+    const uint8_t* currByte;          // current byte in the bitstream
+    uint64_t       numSrcBits;        // bits not yet read into bufferBack
+    uint16_t*      dst;
+    uint64_t       dstIdx;
+    uint64_t       numDstElems;
+} FastHufStream;
+
+static inline void
+fasthuf_stream_init (
+    FastHufStream* s,
+    const uint8_t* src,
+    uint64_t       numSrcBits,
+    uint16_t*      dst,
+    uint64_t       numDstElems)
 {
     //
     // Current position (byte/bit) in the src data stream
     // (after the first buffer fill)
     //
-    uint64_t             buffer, bufferBack, dstIdx;
-    int                  bufferNumBits, bufferBackNumBits;
-    const unsigned char* currByte = src + 2 * sizeof (uint64_t);
 
-    numSrcBits -= 8 * 2 * (int) sizeof (uint64_t);
+    s->currByte   = src + 2 * sizeof (uint64_t);
+    s->numSrcBits = numSrcBits - 8 * 2 * sizeof (uint64_t);
 
     //
     // 64-bit buffer holding the current bits in the stream
     //
 
-    buffer        = READ64 (src);
-    bufferNumBits = 64;
+    s->buffer        = READ64 (src);
+    s->bufferNumBits = 64;
 
     //
     // 64-bit buffer holding the next bits in the stream
     //
 
-    bufferBack        = READ64 ((src + sizeof (uint64_t)));
-    bufferBackNumBits = 64;
-    dstIdx            = 0;
+    s->bufferBack        = READ64 ((src + sizeof (uint64_t)));
+    s->bufferBackNumBits = 64;
 
-    while (dstIdx < numDstElems)
+    s->dst         = dst;
+    s->dstIdx      = 0;
+    s->numDstElems = numDstElems;
+}
+
+static void
+fasthuf_stream_refill (FastHufStream* s)
+{
+    FastHufDecoder_refill (
+        &s->buffer,
+        64 - s->bufferNumBits,
+        &s->bufferBack,
+        &s->bufferBackNumBits,
+        &s->currByte,
+        &s->numSrcBits);
+
+    s->bufferNumBits = 64;
+}
+
+//
+// Decode one symbol (or one run) of a stream, whatever its code. The
+// caller makes sure the stream still has output left, that is
+// dstIdx < numDstElems.
+//
+
+static exr_result_t
+fasthuf_stream_step_slow (
+    const struct _internal_exr_context* pctxt,
+    const FastHufDecoder*               fhd,
+    FastHufStream*                      s)
+{
+    int      codeLen;
+    int      symbol;
+    int      rleCount;
+    uint64_t buffer;
+
+    //
+    // The search for long codes needs a full buffer
+    //
+
+    if (s->bufferNumBits < 64)
     {
-        int codeLen;
-        int symbol;
-        int rleCount;
+        FastHufDecoder_refill (
+            &s->buffer,
+            64 - s->bufferNumBits,
+            &s->bufferBack,
+            &s->bufferBackNumBits,
+            &s->currByte,
+            &s->numSrcBits);
+
+        s->bufferNumBits = 64;
+    }
+    buffer = s->buffer;
+
+    //
+    // Test if we can be table accelerated. If so, directly
+    // lookup the output symbol. Otherwise, we need to fall
+    // back to searching for the code.
+    //
+    // If we're doing table lookups, we don't really need
+    // a re-filled buffer, so long as we have TABLE_LOOKUP_BITS
+    // left. But for a search, we do need a refilled table.
+    //
+
+    if (fhd->_tableMin <= buffer)
+    {
+        int tableIdx = fhd->_lookupSymbol[buffer >> (64 - TABLE_LOOKUP_BITS)];
 
         //
-        // Test if we can be table accelerated. If so, directly
-        // lookup the output symbol. Otherwise, we need to fall
-        // back to searching for the code.
+        // For invalid codes, _tableCodeLen[] should return 0. This
+        // will cause the decoder to get stuck in the current spot
+        // until we run out of elements, then barf that the codestream
+        // is bad.  So we don't need to stick a condition like
+        //     if (codeLen > _maxCodeLength) in this inner.
+        //
+
+        codeLen = tableIdx >> 24;
+        symbol  = tableIdx & 0xffffff;
+    }
+    else
+    {
+        uint64_t id;
         //
-        // If we're doing table lookups, we don't really need
-        // a re-filled buffer, so long as we have TABLE_LOOKUP_BITS
-        // left. But for a search, we do need a refilled table.
+        // Brute force search:
+        // Find the smallest length where _ljBase[length] <= buffer
         //
 
-        if (fhd->_tableMin <= buffer)
-        {
-            int tableIdx =
-                fhd->_lookupSymbol[buffer >> (64 - TABLE_LOOKUP_BITS)];
+        codeLen = TABLE_LOOKUP_BITS + 1;
 
-            //
-            // For invalid codes, _tableCodeLen[] should return 0. This
-            // will cause the decoder to get stuck in the current spot
-            // until we run out of elements, then barf that the codestream
-            // is bad.  So we don't need to stick a condition like
-            //     if (codeLen > _maxCodeLength) in this inner.
-            //
+        /* sentinel zero can never be greater than buffer */
+        while (fhd->_ljBase[codeLen] >
+               buffer /* && codeLen <= _maxCodeLength */)
+            codeLen++;
 
-            codeLen = tableIdx >> 24;
-            symbol  = tableIdx & 0xffffff;
+        if (codeLen > fhd->_maxCodeLength)
+        {
+            if (pctxt)
+                pctxt->print_error (
+                    pctxt,
+                    EXR_ERR_CORRUPT_CHUNK,
+                    "Huffman decode error (Decoded an invalid symbol)");
+            return EXR_ERR_CORRUPT_CHUNK;
         }
+
+        id = fhd->_ljOffset[codeLen] + (buffer >> (64 - codeLen));
+        if (id < (uint64_t) fhd->_numSymbols) { symbol = fhd->_idToSymbol[id]; }
         else
         {
-            uint64_t id;
-            //
-            // Brute force search:
-            // Find the smallest length where _ljBase[length] <= buffer
-            //
+            if (pctxt)
+                pctxt->print_error (
+                    pctxt,
+                    EXR_ERR_CORRUPT_CHUNK,
+                    "Huffman decode error (Decoded an invalid symbol)");
+            return EXR_ERR_CORRUPT_CHUNK;
+        }
+    }
 
-            codeLen = TABLE_LOOKUP_BITS + 1;
+    //
+    // Shift over bit stream, and update the bit count in the buffer
+    //
 
-            /* sentinel zero can never be greater than buffer */
-            while (fhd->_ljBase[codeLen] >
-                   buffer /* && codeLen <= _maxCodeLength */)
-                codeLen++;
+    s->buffer = buffer << codeLen;
+    s->bufferNumBits -= codeLen;
 
-            if (codeLen > fhd->_maxCodeLength)
-            {
-                if (pctxt)
-                    pctxt->print_error (
-                        pctxt,
-                        EXR_ERR_CORRUPT_CHUNK,
-                        "Huffman decode error (Decoded an invalid symbol)");
-                return EXR_ERR_CORRUPT_CHUNK;
-            }
+    //
+    // If we received a RLE symbol (_rleSymbol), then we need
+    // to read ahead 8 bits to know how many times to repeat
+    // the previous symbol. Need to ensure we at least have
+    // 8 bits of data in the buffer
+    //
 
-            id = fhd->_ljOffset[codeLen] + (buffer >> (64 - codeLen));
-            if (id < (uint64_t) fhd->_numSymbols)
-            {
-                symbol = fhd->_idToSymbol[id];
-            }
-            else
-            {
-                if (pctxt)
-                    pctxt->print_error (
-                        pctxt,
-                        EXR_ERR_CORRUPT_CHUNK,
-                        "Huffman decode error (Decoded an invalid symbol)");
-                return EXR_ERR_CORRUPT_CHUNK;
-            }
+    if (symbol == fhd->_rleSymbol)
+    {
+        if (s->bufferNumBits < 8)
+        {
+            FastHufDecoder_refill (
+                &s->buffer,
+                64 - s->bufferNumBits,
+                &s->bufferBack,
+                &s->bufferBackNumBits,
+                &s->currByte,
+                &s->numSrcBits);
+
+            s->bufferNumBits = 64;
         }
 
-        //
-        // Shift over bit stream, and update the bit count in the buffer
-        //
+        rleCount = s->buffer >> 56;
 
-        buffer = buffer << codeLen;
-        bufferNumBits -= codeLen;
+        if (s->dstIdx < 1)
+        {
+            if (pctxt)
+                pctxt->print_error (
+                    pctxt,
+                    EXR_ERR_CORRUPT_CHUNK,
+                    "Huffman decode error (RLE code with no previous symbol)");
+            return EXR_ERR_CORRUPT_CHUNK;
+        }
 
-        //
-        // If we received a RLE symbol (_rleSymbol), then we need
-        // to read ahead 8 bits to know how many times to repeat
-        // the previous symbol. Need to ensure we at least have
-        // 8 bits of data in the buffer
-        //
+        if (s->dstIdx + (uint64_t) rleCount > s->numDstElems)
+        {
+            if (pctxt)
+                pctxt->print_error (
+                    pctxt,
+                    EXR_ERR_CORRUPT_CHUNK,
+                    "Huffman decode error (Symbol run beyond expected output buffer length)");
+            return EXR_ERR_CORRUPT_CHUNK;
+        }
 
-        if (symbol == fhd->_rleSymbol)
+        if (rleCount <= 0)
         {
-            if (bufferNumBits < 8)
-            {
-                FastHufDecoder_refill (
-                    &buffer,
-                    64 - bufferNumBits,
-                    &bufferBack,
-                    &bufferBackNumBits,
-                    &currByte,
-                    &numSrcBits);
-
-                bufferNumBits = 64;
-            }
+            if (pctxt)
+                pctxt->print_error (
+                    pctxt,
+                    EXR_ERR_CORRUPT_CHUNK,
+                    "Huffman decode error (Invalid RLE length)");
+            return EXR_ERR_CORRUPT_CHUNK;
+        }
 
-            rleCount = buffer >> 56;
+        for (int i = 0; i < rleCount; ++i)
+            s->dst[s->dstIdx + (uint64_t) i] = s->dst[s->dstIdx - 1];
 
-            if (dstIdx < 1)
-            {
-                if (pctxt)
-                    pctxt->print_error (
-                        pctxt,
-                        EXR_ERR_CORRUPT_CHUNK,
-                        "Huffman decode error (RLE code with no previous symbol)");
-                return EXR_ERR_CORRUPT_CHUNK;
-            }
+        s->dstIdx += (uint64_t) rleCount;
 
-            if (dstIdx + (uint64_t) rleCount > numDstElems)
-            {
-                if (pctxt)
-                    pctxt->print_error (
-                        pctxt,
-                        EXR_ERR_CORRUPT_CHUNK,
-                        "Huffman decode error (Symbol run beyond expected output buffer length)");
-                return EXR_ERR_CORRUPT_CHUNK;
-            }
+        s->buffer = s->buffer << 8;
+        s->bufferNumBits -= 8;
+    }
+    else
+    {
+        s->dst[s->dstIdx] = (uint16_t) symbol;
+        s->dstIdx++;
+    }
 
-            if (rleCount <= 0)
-            {
-                if (pctxt)
-                    pctxt->print_error (
-                        pctxt,
-                        EXR_ERR_CORRUPT_CHUNK,
-                        "Huffman decode error (Invalid RLE length)");
-                return EXR_ERR_CORRUPT_CHUNK;
-            }
+    //
+    // refill bit stream buffer if we're below the number of
+    // bits needed for a table lookup
+    //
 
-            for (int i = 0; i < rleCount; ++i)
-                dst[dstIdx + (uint64_t) i] = dst[dstIdx - 1];
+    if (s->bufferNumBits < 64)
+    {
+        FastHufDecoder_refill (
+            &s->buffer,
+            64 - s->bufferNumBits,
+            &s->bufferBack,
+            &s->bufferBackNumBits,
+            &s->currByte,
+            &s->numSrcBits);
+
+        s->bufferNumBits = 64;
+    }
 
-            dstIdx += (uint64_t) rleCount;
+    return EXR_ERR_SUCCESS;
+}
 
-            buffer = buffer << 8;
-            bufferNumBits -= 8;
-        }
-        else
-        {
-            dst[dstIdx] = (uint16_t) symbol;
-            dstIdx++;
-        }
+//
+// Decode one symbol of a stream. Short codes that are not runs take
+// an inline path small enough to interleave several streams, which
+// only tops up the buffer once it holds less than a table lookup.
+// Everything else goes through fasthuf_stream_step_slow.
+//
 
-        //
-        // refill bit stream buffer if we're below the number of
-        // bits needed for a table lookup
-        //
+static inline exr_result_t
+fasthuf_stream_step (
+    const struct _internal_exr_context* pctxt,
+    const FastHufDecoder*               fhd,
+    FastHufStream*                      s)
+{
+    uint64_t buffer = s->buffer;
 
-        if (bufferNumBits < 64)
+    if (fhd->_tableMin <= buffer)
+    {
+        int tableIdx = fhd->_lookupSymbol[buffer >> (64 - TABLE_LOOKUP_BITS)];
+        int symbol   = tableIdx & 0xffffff;
+
+        if (symbol != fhd->_rleSymbol)
         {
-            FastHufDecoder_refill (
-                &buffer,
-                64 - bufferNumBits,
-                &bufferBack,
-                &bufferBackNumBits,
-                &currByte,
-                &numSrcBits);
-
-            bufferNumBits = 64;
+            int codeLen = tableIdx >> 24;
+
+            s->buffer = buffer << codeLen;
+            s->bufferNumBits -= codeLen;
+            s->dst[s->dstIdx++] = (uint16_t) symbol;
+
+            if (s->bufferNumBits < TABLE_LOOKUP_BITS) fasthuf_stream_refill (s);
+            return EXR_ERR_SUCCESS;
         }
     }
 
-    if (numSrcBits != 0)
+    return fasthuf_stream_step_slow (pctxt, fhd, s);
+}
+
+static exr_result_t
+fasthuf_stream_finish (
+    const struct _internal_exr_context* pctxt,
+    const FastHufDecoder*               fhd,
+    FastHufStream*                      s)
+{
+    exr_result_t rv;
+
+    while (s->dstIdx < s->numDstElems)
+    {
+        rv = fasthuf_stream_step (pctxt, fhd, s);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+    }
+
+    if (s->numSrcBits != 0)
     {
         if (pctxt)
             pctxt->print_error (
                 pctxt,
                 EXR_ERR_CORRUPT_CHUNK,
                 "Huffman decode error (%d bits of compressed data remains after filling expected output buffer)",
-                (int) numSrcBits);
+                (int) s->numSrcBits);
         return EXR_ERR_CORRUPT_CHUNK;
     }
 
     return EXR_ERR_SUCCESS;
 }
 
+static exr_result_t
+fasthuf_decode (
+    const struct _internal_exr_context* pctxt,
+    FastHufDecoder*                     fhd,
+    const uint8_t*                      src,
+    uint64_t                            numSrcBits,
+    uint16_t*                           dst,
+    uint64_t                            numDstElems)
+{
+    FastHufStream s;
+
+    fasthuf_stream_init (&s, src, numSrcBits, dst, numDstElems);
+    return fasthuf_stream_finish (pctxt, fhd, &s);
+}
+
+//
+// Decode the streams of a multi-stream payload. Each symbol depends
+// on the bits consumed by the previous one, so a single stream leaves
+// most of the CPU idle waiting on table lookups and shifts. Stepping
+// groups of streams in lock step gives the CPU independent chains to
+// overlap. Local copies of the stream states let the compiler keep
+// them in registers.
+//
+
+static exr_result_t
+fasthuf_decode_streams (
+    const struct _internal_exr_context* pctxt,
+    const FastHufDecoder*               fhd,
+    FastHufStream*                      streams,
+    int                                 numStreams)
+{
+    exr_result_t rv = EXR_ERR_SUCCESS;
+    int          i  = 0;
+
+    for (; i + 4 <= numStreams; i += 4)
+    {
+        FastHufStream s0 = streams[i];
+        FastHufStream s1 = streams[i + 1];
+        FastHufStream s2 = streams[i + 2];
+        FastHufStream s3 = streams[i + 3];
+
+        while (s0.dstIdx < s0.numDstElems && s1.dstIdx < s1.numDstElems &&
+               s2.dstIdx < s2.numDstElems && s3.dstIdx < s3.numDstElems)
+        {
+            rv = fasthuf_stream_step (pctxt, fhd, &s0);
+            if (rv != EXR_ERR_SUCCESS) return rv;
+            rv = fasthuf_stream_step (pctxt, fhd, &s1);
+            if (rv != EXR_ERR_SUCCESS) return rv;
+            rv = fasthuf_stream_step (pctxt, fhd, &s2);
+            if (rv != EXR_ERR_SUCCESS) return rv;
+            rv = fasthuf_stream_step (pctxt, fhd, &s3);
+            if (rv != EXR_ERR_SUCCESS) return rv;
+        }
+
+        streams[i]     = s0;
+        streams[i + 1] = s1;
+        streams[i + 2] = s2;
+        streams[i + 3] = s3;
+    }
+
+    for (; i + 2 <= numStreams; i += 2)
+    {
+        FastHufStream s0 = streams[i];
+        FastHufStream s1 = streams[i + 1];
+
+        while (s0.dstIdx < s0.numDstElems && s1.dstIdx < s1.numDstElems)
+        {
+            rv = fasthuf_stream_step (pctxt, fhd, &s0);
+            if (rv != EXR_ERR_SUCCESS) return rv;
+            rv = fasthuf_stream_step (pctxt, fhd, &s1);
+            if (rv != EXR_ERR_SUCCESS) return rv;
+        }
+
+        streams[i]     = s0;
+        streams[i + 1] = s1;
+    }
+
+    //
+    // Finish whatever each stream has left on its own
+    //
+
+    for (i = 0; i < numStreams && rv == EXR_ERR_SUCCESS; ++i)
+        rv = fasthuf_stream_finish (pctxt, fhd, streams + i);
+
+    return rv;
+}
+
 /**************************************/
 
 uint64_t
@@ -1743,8 +1977,8 @@ internal_exr_huf_compress_spare_bytes (void)
     uint64_t ret = 0;
     ret += HUF_ENCSIZE * sizeof (uint64_t);  // freq
     ret += HUF_ENCSIZE * sizeof (uint64_t);  // scode
-    ret += HUF_ENCSIZE * sizeof (uint64_t*); // fheap
-    ret += HUF_ENCSIZE * sizeof (uint32_t);  // hlink
+    ret += HUF_ENCSIZE * sizeof (uint32_t);  // sym
+    ret += HUF_ENCSIZE * sizeof (uint32_t);  // leafParent
     return ret;
 }
 
@@ -1772,8 +2006,8 @@ internal_huf_compress (
 {
     exr_result_t rv;
     uint64_t*    freq;
-    uint32_t*    hlink;
-    uint64_t**   fHeap;
+    uint32_t*    sym;
+    uint32_t*    leafParent;
     uint64_t*    scode;
     uint32_t     im = 0;
     uint32_t     iM = 0;
@@ -1794,14 +2028,14 @@ internal_huf_compress (
     if (sparebytes != internal_exr_huf_compress_spare_bytes ())
         return EXR_ERR_INVALID_ARGUMENT;
 
-    freq  = (uint64_t*) spare;
-    scode = freq + HUF_ENCSIZE;
-    fHeap = (uint64_t**) (scode + HUF_ENCSIZE);
-    hlink = (uint32_t*) (fHeap + HUF_ENCSIZE);
+    freq       = (uint64_t*) spare;
+    scode      = freq + HUF_ENCSIZE;
+    sym        = (uint32_t*) (scode + HUF_ENCSIZE);
+    leafParent = sym + HUF_ENCSIZE;
 
     countFrequencies (freq, raw, nRaw);
 
-    hufBuildEncTable (freq, &im, &iM, hlink, fHeap, scode);
+    hufBuildEncTable (freq, &im, &iM, sym, leafParent, scode);
 
     rv = hufPackEncTable (freq, im, iM, &tableEnd, maxcompout);
 
@@ -1909,3 +2143,219 @@ internal_huf_decompress (
     }
     return rv;
 }
+
+/**************************************/
+
+//
+// Multi-stream payload:
+//
+//   im, iM, tableLength, nStreams, 0   (5 x uint32)
+//   nBits of each stream              (nStreams x uint32)
+//   packed encoding table             (tableLength bytes)
+//   stream data, each stream starting on a byte boundary
+//
+// Stream i codes symbols [nRaw * i / nStreams, nRaw * (i + 1) / nStreams)
+// with the shared table. Runs never cross a stream boundary, so every
+// stream decodes on its own.
+//
+
+static inline uint64_t
+hufStreamStart (uint64_t nRaw, uint32_t i, uint32_t nStreams)
+{
+    return nRaw * i / nStreams;
+}
+
+exr_result_t
+internal_huf_compress_streams (
+    uint64_t*       encbytes,
+    void*           out,
+    uint64_t        outsz,
+    const uint16_t* raw,
+    uint64_t        nRaw,
+    int             nStreams,
+    void*           spare,
+    uint64_t        sparebytes)
+{
+    exr_result_t rv;
+    uint64_t*    freq;
+    uint32_t*    sym;
+    uint32_t*    leafParent;
+    uint64_t*    scode;
+    uint32_t     im = 0;
+    uint32_t     iM = 0;
+    uint32_t     tableLength, nBits;
+    uint64_t     hdrbytes;
+    uint8_t*     dataStart;
+    uint8_t*     compressed = (uint8_t*) out;
+    uint8_t*     tableStart;
+    uint8_t*     tableEnd;
+    uint8_t*     maxcompout = compressed + outsz;
+
+    if (nRaw == 0)
+    {
+        *encbytes = 0;
+        return EXR_ERR_SUCCESS;
+    }
+
+    if (nStreams < 1 || nStreams > HUF_MAX_STREAMS)
+        return EXR_ERR_INVALID_ARGUMENT;
+    if ((uint64_t) nStreams > nRaw) nStreams = (int) nRaw;
+
+    hdrbytes = 20 + (uint64_t) nStreams * sizeof (uint32_t);
+    if (outsz < hdrbytes) return EXR_ERR_INVALID_ARGUMENT;
+    if (sparebytes != internal_exr_huf_compress_spare_bytes ())
+        return EXR_ERR_INVALID_ARGUMENT;
+
+    freq       = (uint64_t*) spare;
+    scode      = freq + HUF_ENCSIZE;
+    sym        = (uint32_t*) (scode + HUF_ENCSIZE);
+    leafParent = sym + HUF_ENCSIZE;
+
+    countFrequencies (freq, raw, nRaw);
+
+    hufBuildEncTable (freq, &im, &iM, sym, leafParent, scode);
+
+    tableStart = compressed + hdrbytes;
+    tableEnd   = tableStart;
+    rv         = hufPackEncTable (freq, im, iM, &tableEnd, maxcompout);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+    tableLength =
+        (uint32_t) (((uintptr_t) tableEnd) - ((uintptr_t) tableStart));
+    dataStart = tableEnd;
+
+    for (uint32_t i = 0; i < (uint32_t) nStreams; ++i)
+    {
+        uint64_t b = hufStreamStart (nRaw, i, (uint32_t) nStreams);
+        uint64_t e = hufStreamStart (nRaw, i + 1, (uint32_t) nStreams);
+
+        rv = hufEncode (freq, raw + b, e - b, iM, dataStart, maxcompout, &nBits);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+
+        writeUInt (compressed + 20 + i * sizeof (uint32_t), nBits);
+        dataStart += (nBits + 7) / 8;
+    }
+
+    writeUInt (compressed, im);
+    writeUInt (compressed + 4, iM);
+    writeUInt (compressed + 8, tableLength);
+    writeUInt (compressed + 12, (uint32_t) nStreams);
+    writeUInt (compressed + 16, 0); // room for future extensions
+
+    *encbytes = (((uintptr_t) dataStart) - ((uintptr_t) compressed));
+    return EXR_ERR_SUCCESS;
+}
+
+exr_result_t
+internal_huf_decompress_streams (
+    exr_decode_pipeline_t* decode,
+    const uint8_t*         compressed,
+    uint64_t               nCompressed,
+    uint16_t*              raw,
+    uint64_t               nRaw,
+    void*                  spare,
+    uint64_t               sparebytes)
+{
+    uint32_t                            im, iM, tableLength, nStreams;
+    uint32_t                            nBits[HUF_MAX_STREAMS];
+    uint64_t                            hdrbytes, nBytes;
+    const uint8_t*                      ptr;
+    const uint8_t*                      dataStart;
+    const uint8_t*                      src;
+    int                                 useFast;
+    exr_result_t                        rv;
+    const struct _internal_exr_context* pctxt = NULL;
+
+    if (decode) pctxt = EXR_CCTXT (decode->context);
+    //
+    // need at least 20 bytes for header
+    //
+    if (nCompressed < 20)
+    {
+        if (nRaw != 0) return EXR_ERR_INVALID_ARGUMENT;
+        return EXR_ERR_SUCCESS;
+    }
+
+    if (sparebytes != internal_exr_huf_decompress_spare_bytes ())
+        return EXR_ERR_INVALID_ARGUMENT;
+
+    im          = readUInt (compressed);
+    iM          = readUInt (compressed + 4);
+    tableLength = readUInt (compressed + 8);
+    nStreams    = readUInt (compressed + 12);
+
+    if (im >= HUF_ENCSIZE || iM >= HUF_ENCSIZE) return EXR_ERR_CORRUPT_CHUNK;
+    if (nStreams < 1 || nStreams > HUF_MAX_STREAMS || nStreams > nRaw)
+        return EXR_ERR_CORRUPT_CHUNK;
+
+    hdrbytes = 20 + (uint64_t) nStreams * sizeof (uint32_t);
+    if (hdrbytes + tableLength > nCompressed) return EXR_ERR_CORRUPT_CHUNK;
+
+    //
+    // Fast decoder needs at least 2x64-bits of compressed data in
+    // every stream, and needs to be run-able on this platform.
+    // Otherwise, fall back to the original decoder
+    //
+
+    useFast = fasthuf_decode_enabled ();
+    nBytes  = hdrbytes + tableLength;
+    for (uint32_t i = 0; i < nStreams; ++i)
+    {
+        nBits[i] = readUInt (compressed + 20 + i * sizeof (uint32_t));
+        nBytes += (((uint64_t) (nBits[i]) + 7)) / 8;
+        if (nBits[i] <= 128) useFast = 0;
+    }
+
+    // must be nBytes remaining in buffer
+    if (nBytes > nCompressed) return EXR_ERR_OUT_OF_MEMORY;
+
+    ptr       = compressed + hdrbytes;
+    dataStart = ptr + tableLength;
+
+    if (useFast)
+    {
+        FastHufDecoder* fhd = (FastHufDecoder*) spare;
+        FastHufStream   streams[HUF_MAX_STREAMS];
+
+        rv = fasthuf_initialize (
+            pctxt, fhd, &ptr, nCompressed - hdrbytes, im, iM, (int) iM);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+        if (ptr > dataStart) return EXR_ERR_CORRUPT_CHUNK;
+
+        src = dataStart;
+        for (uint32_t i = 0; i < nStreams; ++i)
+        {
+            uint64_t b = hufStreamStart (nRaw, i, nStreams);
+            uint64_t e = hufStreamStart (nRaw, i + 1, nStreams);
+
+            fasthuf_stream_init (streams + i, src, nBits[i], raw + b, e - b);
+            src += (((uint64_t) (nBits[i]) + 7)) / 8;
+        }
+
+        rv = fasthuf_decode_streams (pctxt, fhd, streams, (int) nStreams);
+    }
+    else
+    {
+        uint64_t* freq  = (uint64_t*) spare;
+        HufDec*   hdec  = (HufDec*) (freq + HUF_ENCSIZE);
+        uint64_t  nLeft = tableLength;
+
+        hufClearDecTable (hdec);
+        rv = hufUnpackEncTable (&ptr, &nLeft, im, iM, freq);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+
+        rv = hufBuildDecTable (pctxt, freq, im, iM, hdec);
+
+        src = dataStart;
+        for (uint32_t i = 0; i < nStreams && rv == EXR_ERR_SUCCESS; ++i)
+        {
+            uint64_t b = hufStreamStart (nRaw, i, nStreams);
+            uint64_t e = hufStreamStart (nRaw, i + 1, nStreams);
+
+            rv = hufDecode (freq, hdec, src, nBits[i], iM, e - b, raw + b);
+            src += (((uint64_t) (nBits[i]) + 7)) / 8;
+        }
+
+        hufFreeDecTable (pctxt, hdec);
+    }
+    return rv;
+}
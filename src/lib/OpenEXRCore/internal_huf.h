@@ -9,6 +9,9 @@
 #include "openexr_errors.h"
 #include "openexr_decode.h"
 
+/* Most streams a multi-stream Huffman payload may be split into. */
+#define HUF_MAX_STREAMS 8
+
 uint64_t internal_exr_huf_compress_spare_bytes (void);
 uint64_t internal_exr_huf_decompress_spare_bytes (void);
 
@@ -30,4 +33,26 @@ exr_result_t internal_huf_decompress (
     void*                  spare,
     uint64_t               sparebytes);
 
+/* Like internal_huf_compress, but split the coded symbols into
+ * nStreams independent bitstreams sharing one code table, so the
+ * decoder can run several bit readers side by side. */
+exr_result_t internal_huf_compress_streams (
+    uint64_t*       encbytes,
+    void*           out,
+    uint64_t        outsz,
+    const uint16_t* raw,
+    uint64_t        nRaw,
+    int             nStreams,
+    void*           spare,
+    uint64_t        sparebytes);
+
+exr_result_t internal_huf_decompress_streams (
+    exr_decode_pipeline_t* decode,
+    const uint8_t*         compressed,
+    uint64_t               nCompressed,
+    uint16_t*              raw,
+    uint64_t               nRaw,
+    void*                  spare,
+    uint64_t               sparebytes);
+
 #endif /* OPENEXR_CORE_HUF_CODING_H */
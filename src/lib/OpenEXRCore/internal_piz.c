@@ -7,6 +7,7 @@
 #include "internal_decompress.h"
 
 #include "internal_coding.h"
+#include "internal_cpuid.h"
 #include "internal_huf.h"
 #include "internal_xdr.h"
 
@@ -166,6 +167,640 @@ wdec16 (uint16_t l, uint16_t h, uint16_t* a, uint16_t* b)
     *a     = (uint16_t) aa;
 }
 
+/**************************************/
+//
+// When SIMD is available, the levels whose samples are s = ox * p = 1
+// or 2 apart are done one pair of lines at a time: the horizontal
+// step on both lines, then the vertical step on all the columns of
+// the pair, on whole vectors with the lanes that are not part of the
+// level left untouched. Wider levels leave too few useful lanes, and
+// keep the scalar block loop.
+//
+
+enum
+{
+    WAV_ENC14 = 0,
+    WAV_ENC16,
+    WAV_DEC14,
+    WAV_DEC16
+};
+
+// expand to one copy of a pass loop per op, with the op a constant
+#define WAV_OP_CASES(fn, ...)                                                  \
+    switch (op)                                                                \
+    {                                                                          \
+        case WAV_ENC14: fn (__VA_ARGS__, WAV_ENC14); break;                    \
+        case WAV_ENC16: fn (__VA_ARGS__, WAV_ENC16); break;                    \
+        case WAV_DEC14: fn (__VA_ARGS__, WAV_DEC14); break;                    \
+        default: fn (__VA_ARGS__, WAV_DEC16); break;                           \
+    }
+
+static inline void
+wav_pair (uint16_t a, uint16_t b, uint16_t* l, uint16_t* h, int op)
+{
+    switch (op)
+    {
+        case WAV_ENC14: wenc14 (a, b, l, h); break;
+        case WAV_ENC16: wenc16 (a, b, l, h); break;
+        case WAV_DEC14: wdec14 (a, b, l, h); break;
+        default: wdec16 (a, b, l, h); break;
+    }
+}
+
+//
+// Horizontal step on one line: n pairs (row[2ks], row[2ks + s]).
+//
+
+static inline void
+wav_hpass_scalar (uint16_t* row, int n, int s, int op)
+{
+    for (int k = 0; k < n; ++k, row += 2 * s)
+        wav_pair (row[0], row[s], row, row + s, op);
+}
+
+//
+// Vertical step on a pair of lines: n pairs (a[ks], b[ks]).
+//
+
+static inline void
+wav_vpass_scalar (uint16_t* a, uint16_t* b, int n, int s, int op)
+{
+    for (int k = 0; k < n; ++k, a += s, b += s)
+        wav_pair (*a, *b, a, b, op);
+}
+
+//
+// A vector of L lanes starting at a pair may only be used if it does
+// not reach past the last sample of the line, as the line may end
+// the buffer; the remaining pairs are done by the scalar code.
+//
+
+#define WAV_HPASS_FITS(k, n, s, L) (2 * (k) * (s) + (L) <= (2 * (n) - 1) * (s) + 1)
+#define WAV_VPASS_FITS(k, n, s, L) ((k) * (s) + (L) <= ((n) - 1) * (s) + 1)
+
+#if defined(__SSE2__) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#    define IMF_HAVE_SSE2 1
+#    include <emmintrin.h>
+#endif
+
+#if (defined(__x86_64__) || defined(_M_X64)) &&                               \
+    (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#    define IMF_HAVE_AVX2_DISPATCH 1
+#    if defined(__GNUC__) || defined(__clang__)
+#        define WAV_AVX2_TARGET __attribute__ ((target ("avx2")))
+#    else
+#        define WAV_AVX2_TARGET
+#    endif
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#    define IMF_HAVE_NEON_AARCH64 1
+#    include <arm_neon.h>
+#endif
+
+#ifdef IMF_HAVE_SSE2
+
+static inline void
+wav_pair_sse2 (__m128i a, __m128i b, __m128i* l, __m128i* h, int op)
+{
+    const __m128i one  = _mm_set1_epi16 (1);
+    const __m128i sign = _mm_set1_epi16 ((short) 0x8000);
+    __m128i       t;
+
+    switch (op)
+    {
+        case WAV_ENC14:
+            // floor ((a + b) / 2) without leaving 16 bits
+            t  = _mm_and_si128 (_mm_and_si128 (a, b), one);
+            *l = _mm_add_epi16 (
+                _mm_add_epi16 (_mm_srai_epi16 (a, 1), _mm_srai_epi16 (b, 1)),
+                t);
+            *h = _mm_sub_epi16 (a, b);
+            break;
+        case WAV_ENC16:
+            a  = _mm_xor_si128 (a, sign);
+            t  = _mm_add_epi16 (
+                _mm_and_si128 (a, b),
+                _mm_srli_epi16 (_mm_xor_si128 (a, b), 1));
+            // unsigned a < b, as a signed compare of the flipped values
+            *h = _mm_cmplt_epi16 (
+                _mm_xor_si128 (a, sign), _mm_xor_si128 (b, sign));
+            *l = _mm_xor_si128 (t, _mm_and_si128 (*h, sign));
+            *h = _mm_sub_epi16 (a, b);
+            break;
+        case WAV_DEC14:
+            t  = _mm_add_epi16 (
+                _mm_add_epi16 (a, _mm_and_si128 (b, one)),
+                _mm_srai_epi16 (b, 1));
+            *h = _mm_sub_epi16 (t, b);
+            *l = t;
+            break;
+        default:
+            t  = _mm_sub_epi16 (a, _mm_srli_epi16 (b, 1));
+            *l = _mm_xor_si128 (_mm_add_epi16 (b, t), sign);
+            *h = t;
+            break;
+    }
+}
+
+static inline __m128i
+wav_lane_mask_sse2 (int period, int phase)
+{
+    const __m128i idx = _mm_setr_epi16 (0, 1, 2, 3, 4, 5, 6, 7);
+    return _mm_cmpeq_epi16 (
+        _mm_and_si128 (idx, _mm_set1_epi16 ((short) (period - 1))),
+        _mm_set1_epi16 ((short) phase));
+}
+
+// lane i gets lane i + s
+static inline __m128i
+wav_shift_down_sse2 (__m128i v, int s)
+{
+    switch (s)
+    {
+        case 1: return _mm_srli_si128 (v, 2);
+        default: return _mm_srli_si128 (v, 4);
+    }
+}
+
+// lane i gets lane i - s
+static inline __m128i
+wav_shift_up_sse2 (__m128i v, int s)
+{
+    switch (s)
+    {
+        case 1: return _mm_slli_si128 (v, 2);
+        default: return _mm_slli_si128 (v, 4);
+    }
+}
+
+static inline void
+wav_hpass_sse2_op (uint16_t* row, int n, int s, int op)
+{
+    int k = 0;
+
+    __m128i ml   = wav_lane_mask_sse2 (2 * s, 0);
+    __m128i mh   = wav_lane_mask_sse2 (2 * s, s);
+    __m128i keep = _mm_andnot_si128 (
+        _mm_or_si128 (ml, mh), _mm_set1_epi16 ((short) 0xffff));
+
+    for (; WAV_HPASS_FITS (k, n, s, 8); k += 4 / s)
+    {
+        __m128i* p = (__m128i*) (row + 2 * k * s);
+        __m128i  v = _mm_loadu_si128 (p);
+        __m128i  l, h;
+
+        wav_pair_sse2 (v, wav_shift_down_sse2 (v, s), &l, &h, op);
+        h = wav_shift_up_sse2 (h, s);
+        _mm_storeu_si128 (
+            p,
+            _mm_or_si128 (
+                _mm_or_si128 (_mm_and_si128 (ml, l), _mm_and_si128 (mh, h)),
+                _mm_and_si128 (keep, v)));
+    }
+
+    wav_hpass_scalar (row + 2 * k * s, n - k, s, op);
+}
+
+static void
+wav_hpass_sse2 (uint16_t* row, int n, int s, int op)
+{
+    if (s == 1)
+    {
+        WAV_OP_CASES (wav_hpass_sse2_op, row, n, 1)
+    }
+    else
+    {
+        WAV_OP_CASES (wav_hpass_sse2_op, row, n, 2)
+    }
+}
+
+static inline void
+wav_vpass_sse2_op (uint16_t* a, uint16_t* b, int n, int s, int op)
+{
+    int k = 0;
+
+    __m128i m = wav_lane_mask_sse2 (s, 0);
+
+    for (; WAV_VPASS_FITS (k, n, s, 8); k += 8 / s)
+    {
+        __m128i* pa = (__m128i*) (a + k * s);
+        __m128i* pb = (__m128i*) (b + k * s);
+        __m128i  va = _mm_loadu_si128 (pa);
+        __m128i  vb = _mm_loadu_si128 (pb);
+        __m128i  l, h;
+
+        wav_pair_sse2 (va, vb, &l, &h, op);
+        _mm_storeu_si128 (
+            pa,
+            _mm_or_si128 (_mm_and_si128 (m, l), _mm_andnot_si128 (m, va)));
+        _mm_storeu_si128 (
+            pb,
+            _mm_or_si128 (_mm_and_si128 (m, h), _mm_andnot_si128 (m, vb)));
+    }
+
+    wav_vpass_scalar (a + k * s, b + k * s, n - k, s, op);
+}
+
+static void
+wav_vpass_sse2 (uint16_t* a, uint16_t* b, int n, int s, int op)
+{
+    if (s == 1)
+    {
+        WAV_OP_CASES (wav_vpass_sse2_op, a, b, n, 1)
+    }
+    else
+    {
+        WAV_OP_CASES (wav_vpass_sse2_op, a, b, n, 2)
+    }
+}
+
+#endif /* IMF_HAVE_SSE2 */
+
+#ifdef IMF_HAVE_AVX2_DISPATCH
+
+WAV_AVX2_TARGET static inline void
+wav_pair_avx2 (__m256i a, __m256i b, __m256i* l, __m256i* h, int op)
+{
+    const __m256i one  = _mm256_set1_epi16 (1);
+    const __m256i sign = _mm256_set1_epi16 ((short) 0x8000);
+    __m256i       t;
+
+    switch (op)
+    {
+        case WAV_ENC14:
+            t  = _mm256_and_si256 (_mm256_and_si256 (a, b), one);
+            *l = _mm256_add_epi16 (
+                _mm256_add_epi16 (
+                    _mm256_srai_epi16 (a, 1), _mm256_srai_epi16 (b, 1)),
+                t);
+            *h = _mm256_sub_epi16 (a, b);
+            break;
+        case WAV_ENC16:
+            a  = _mm256_xor_si256 (a, sign);
+            t  = _mm256_add_epi16 (
+                _mm256_and_si256 (a, b),
+                _mm256_srli_epi16 (_mm256_xor_si256 (a, b), 1));
+            *h = _mm256_cmpgt_epi16 (
+                _mm256_xor_si256 (b, sign), _mm256_xor_si256 (a, sign));
+            *l = _mm256_xor_si256 (t, _mm256_and_si256 (*h, sign));
+            *h = _mm256_sub_epi16 (a, b);
+            break;
+        case WAV_DEC14:
+            t  = _mm256_add_epi16 (
+                _mm256_add_epi16 (a, _mm256_and_si256 (b, one)),
+                _mm256_srai_epi16 (b, 1));
+            *h = _mm256_sub_epi16 (t, b);
+            *l = t;
+            break;
+        default:
+            t  = _mm256_sub_epi16 (a, _mm256_srli_epi16 (b, 1));
+            *l = _mm256_xor_si256 (_mm256_add_epi16 (b, t), sign);
+            *h = t;
+            break;
+    }
+}
+
+WAV_AVX2_TARGET static inline __m256i
+wav_lane_mask_avx2 (int period, int phase)
+{
+    const __m256i idx = _mm256_setr_epi16 (
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    return _mm256_cmpeq_epi16 (
+        _mm256_and_si256 (idx, _mm256_set1_epi16 ((short) (period - 1))),
+        _mm256_set1_epi16 ((short) phase));
+}
+
+// these shift each 128-bit half on its own, which is all that is
+// needed as pairs of s <= 2 never straddle the halves
+
+WAV_AVX2_TARGET static inline __m256i
+wav_shift_down_avx2 (__m256i v, int s)
+{
+    switch (s)
+    {
+        case 1: return _mm256_srli_si256 (v, 2);
+        default: return _mm256_srli_si256 (v, 4);
+    }
+}
+
+WAV_AVX2_TARGET static inline __m256i
+wav_shift_up_avx2 (__m256i v, int s)
+{
+    switch (s)
+    {
+        case 1: return _mm256_slli_si256 (v, 2);
+        default: return _mm256_slli_si256 (v, 4);
+    }
+}
+
+WAV_AVX2_TARGET static inline void
+wav_hpass_avx2_op (uint16_t* row, int n, int s, int op)
+{
+    int k = 0;
+
+    __m256i ml   = wav_lane_mask_avx2 (2 * s, 0);
+    __m256i mh   = wav_lane_mask_avx2 (2 * s, s);
+    __m256i keep = _mm256_andnot_si256 (
+        _mm256_or_si256 (ml, mh), _mm256_set1_epi16 ((short) 0xffff));
+
+    for (; WAV_HPASS_FITS (k, n, s, 16); k += 8 / s)
+    {
+        __m256i* p = (__m256i*) (row + 2 * k * s);
+        __m256i  v = _mm256_loadu_si256 (p);
+        __m256i  l, h;
+
+        wav_pair_avx2 (v, wav_shift_down_avx2 (v, s), &l, &h, op);
+        h = wav_shift_up_avx2 (h, s);
+        _mm256_storeu_si256 (
+            p,
+            _mm256_or_si256 (
+                _mm256_or_si256 (
+                    _mm256_and_si256 (ml, l), _mm256_and_si256 (mh, h)),
+                _mm256_and_si256 (keep, v)));
+    }
+
+    wav_hpass_scalar (row + 2 * k * s, n - k, s, op);
+}
+
+WAV_AVX2_TARGET static void
+wav_hpass_avx2 (uint16_t* row, int n, int s, int op)
+{
+    if (s == 1)
+    {
+        WAV_OP_CASES (wav_hpass_avx2_op, row, n, 1)
+    }
+    else
+    {
+        WAV_OP_CASES (wav_hpass_avx2_op, row, n, 2)
+    }
+}
+
+WAV_AVX2_TARGET static inline void
+wav_vpass_avx2_op (uint16_t* a, uint16_t* b, int n, int s, int op)
+{
+    int k = 0;
+
+    __m256i m = wav_lane_mask_avx2 (s, 0);
+
+    for (; WAV_VPASS_FITS (k, n, s, 16); k += 16 / s)
+    {
+        __m256i* pa = (__m256i*) (a + k * s);
+        __m256i* pb = (__m256i*) (b + k * s);
+        __m256i  va = _mm256_loadu_si256 (pa);
+        __m256i  vb = _mm256_loadu_si256 (pb);
+        __m256i  l, h;
+
+        wav_pair_avx2 (va, vb, &l, &h, op);
+        _mm256_storeu_si256 (
+            pa,
+            _mm256_or_si256 (
+                _mm256_and_si256 (m, l), _mm256_andnot_si256 (m, va)));
+        _mm256_storeu_si256 (
+            pb,
+            _mm256_or_si256 (
+                _mm256_and_si256 (m, h), _mm256_andnot_si256 (m, vb)));
+    }
+
+    wav_vpass_scalar (a + k * s, b + k * s, n - k, s, op);
+}
+
+WAV_AVX2_TARGET static void
+wav_vpass_avx2 (uint16_t* a, uint16_t* b, int n, int s, int op)
+{
+    if (s == 1)
+    {
+        WAV_OP_CASES (wav_vpass_avx2_op, a, b, n, 1)
+    }
+    else
+    {
+        WAV_OP_CASES (wav_vpass_avx2_op, a, b, n, 2)
+    }
+}
+
+#endif /* IMF_HAVE_AVX2_DISPATCH */
+
+#ifdef IMF_HAVE_NEON_AARCH64
+
+static inline void
+wav_pair_neon (uint16x8_t a, uint16x8_t b, uint16x8_t* l, uint16x8_t* h, int op)
+{
+    const uint16x8_t one  = vdupq_n_u16 (1);
+    const uint16x8_t sign = vdupq_n_u16 (0x8000);
+    uint16x8_t       t;
+
+    switch (op)
+    {
+        case WAV_ENC14:
+            t  = vandq_u16 (vandq_u16 (a, b), one);
+            *l = vaddq_u16 (
+                vaddq_u16 (
+                    vreinterpretq_u16_s16 (
+                        vshrq_n_s16 (vreinterpretq_s16_u16 (a), 1)),
+                    vreinterpretq_u16_s16 (
+                        vshrq_n_s16 (vreinterpretq_s16_u16 (b), 1))),
+                t);
+            *h = vsubq_u16 (a, b);
+            break;
+        case WAV_ENC16:
+            a  = veorq_u16 (a, sign);
+            t  = vaddq_u16 (vandq_u16 (a, b), vshrq_n_u16 (veorq_u16 (a, b), 1));
+            *l = veorq_u16 (t, vandq_u16 (vcltq_u16 (a, b), sign));
+            *h = vsubq_u16 (a, b);
+            break;
+        case WAV_DEC14:
+            t = vaddq_u16 (
+                vaddq_u16 (a, vandq_u16 (b, one)),
+                vreinterpretq_u16_s16 (
+                    vshrq_n_s16 (vreinterpretq_s16_u16 (b), 1)));
+            *h = vsubq_u16 (t, b);
+            *l = t;
+            break;
+        default:
+            t  = vsubq_u16 (a, vshrq_n_u16 (b, 1));
+            *l = veorq_u16 (vaddq_u16 (b, t), sign);
+            *h = t;
+            break;
+    }
+}
+
+static inline uint16x8_t
+wav_lane_mask_neon (int period, int phase)
+{
+    static const uint16_t idx[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    return vceqq_u16 (
+        vandq_u16 (vld1q_u16 (idx), vdupq_n_u16 ((uint16_t) (period - 1))),
+        vdupq_n_u16 ((uint16_t) phase));
+}
+
+static inline uint16x8_t
+wav_shift_down_neon (uint16x8_t v, int s)
+{
+    const uint16x8_t z = vdupq_n_u16 (0);
+    switch (s)
+    {
+        case 1: return vextq_u16 (v, z, 1);
+        default: return vextq_u16 (v, z, 2);
+    }
+}
+
+static inline uint16x8_t
+wav_shift_up_neon (uint16x8_t v, int s)
+{
+    const uint16x8_t z = vdupq_n_u16 (0);
+    switch (s)
+    {
+        case 1: return vextq_u16 (z, v, 7);
+        default: return vextq_u16 (z, v, 6);
+    }
+}
+
+static inline void
+wav_hpass_neon_op (uint16_t* row, int n, int s, int op)
+{
+    int k = 0;
+
+    uint16x8_t ml = wav_lane_mask_neon (2 * s, 0);
+    uint16x8_t mh = wav_lane_mask_neon (2 * s, s);
+
+    for (; WAV_HPASS_FITS (k, n, s, 8); k += 4 / s)
+    {
+        uint16_t*  p = row + 2 * k * s;
+        uint16x8_t v = vld1q_u16 (p);
+        uint16x8_t l, h;
+
+        wav_pair_neon (v, wav_shift_down_neon (v, s), &l, &h, op);
+        h = wav_shift_up_neon (h, s);
+        vst1q_u16 (p, vbslq_u16 (ml, l, vbslq_u16 (mh, h, v)));
+    }
+
+    wav_hpass_scalar (row + 2 * k * s, n - k, s, op);
+}
+
+static void
+wav_hpass_neon (uint16_t* row, int n, int s, int op)
+{
+    if (s == 1)
+    {
+        WAV_OP_CASES (wav_hpass_neon_op, row, n, 1)
+    }
+    else
+    {
+        WAV_OP_CASES (wav_hpass_neon_op, row, n, 2)
+    }
+}
+
+static inline void
+wav_vpass_neon_op (uint16_t* a, uint16_t* b, int n, int s, int op)
+{
+    int k = 0;
+
+    uint16x8_t m = wav_lane_mask_neon (s, 0);
+
+    for (; WAV_VPASS_FITS (k, n, s, 8); k += 8 / s)
+    {
+        uint16x8_t va = vld1q_u16 (a + k * s);
+        uint16x8_t vb = vld1q_u16 (b + k * s);
+        uint16x8_t l, h;
+
+        wav_pair_neon (va, vb, &l, &h, op);
+        vst1q_u16 (a + k * s, vbslq_u16 (m, l, va));
+        vst1q_u16 (b + k * s, vbslq_u16 (m, h, vb));
+    }
+
+    wav_vpass_scalar (a + k * s, b + k * s, n - k, s, op);
+}
+
+static void
+wav_vpass_neon (uint16_t* a, uint16_t* b, int n, int s, int op)
+{
+    if (s == 1)
+    {
+        WAV_OP_CASES (wav_vpass_neon_op, a, b, n, 1)
+    }
+    else
+    {
+        WAV_OP_CASES (wav_vpass_neon_op, a, b, n, 2)
+    }
+}
+
+#endif /* IMF_HAVE_NEON_AARCH64 */
+
+//
+// Function pointers for the line passes. They start out on the scalar
+// passes and are only ever switched to an equivalent vector pass by
+// initializeWavFuncs (), so a thread racing the first initialization
+// always calls a valid implementation.
+//
+
+static void (*wav_hpass) (uint16_t*, int, int, int) = wav_hpass_scalar;
+static void (*wav_vpass) (uint16_t*, uint16_t*, int, int, int) =
+    wav_vpass_scalar;
+
+static void
+initializeWavFuncs (void)
+{
+    static int done = 0;
+    if (done) return;
+
+#if defined(IMF_HAVE_NEON_AARCH64)
+    wav_hpass = wav_hpass_neon;
+    wav_vpass = wav_vpass_neon;
+#else
+#    ifdef IMF_HAVE_SSE2
+    wav_hpass = wav_hpass_sse2;
+    wav_vpass = wav_vpass_sse2;
+#    endif
+#    ifdef IMF_HAVE_AVX2_DISPATCH
+    if (has_avx2 ())
+    {
+        wav_hpass = wav_hpass_avx2;
+        wav_vpass = wav_vpass_avx2;
+    }
+#    endif
+#endif
+
+    done = 1;
+}
+
+/**************************************/
+
+static void
+wav_lines_encode (
+    uint16_t* py, int nx, int ny, int p, int ox1, int oy1, int w14)
+{
+    int op  = w14 ? WAV_ENC14 : WAV_ENC16;
+    int nbx = nx / (2 * p);                     // 2x2 blocks per line
+    int ncx = 2 * nbx + ((nx & p) ? 1 : 0);     // columns, odd one included
+
+    for (int y = ny / (2 * p); y > 0; --y, py += 2 * oy1)
+    {
+        wav_hpass (py, nbx, ox1, op);
+        wav_hpass (py + oy1, nbx, ox1, op);
+        wav_vpass (py, py + oy1, ncx, ox1, op);
+    }
+
+    if (ny & p) wav_hpass (py, nbx, ox1, op);
+}
+
+static void
+wav_lines_decode (
+    uint16_t* py, int nx, int ny, int p, int ox1, int oy1, int w14)
+{
+    int op  = w14 ? WAV_DEC14 : WAV_DEC16;
+    int nbx = nx / (2 * p);
+    int ncx = 2 * nbx + ((nx & p) ? 1 : 0);
+
+    for (int y = ny / (2 * p); y > 0; --y, py += 2 * oy1)
+    {
+        wav_vpass (py, py + oy1, ncx, ox1, op);
+        wav_hpass (py, nbx, ox1, op);
+        wav_hpass (py + oy1, nbx, ox1, op);
+    }
+
+    if (ny & p) wav_hpass (py, nbx, ox1, op);
+}
+
 /**************************************/
 
 static void
@@ -190,77 +825,84 @@ wav_2D_encode (uint16_t* in, int nx, int ox, int ny, int oy, uint16_t mx)
         int       ox2 = ox * p2;
         uint16_t  i00, i01, i10, i11;
 
-        //
-        // Y loop
-        //
-
-        for (; py <= ey; py += oy2)
+        if (ox1 <= 2)
+        {
+            wav_lines_encode (py, nx, ny, p, ox1, oy1, w14);
+        }
+        else
         {
-            uint16_t* px = py;
-            uint16_t* ex = py + ox * (nx - p2);
-
             //
-            // X loop
+            // Y loop
             //
 
-            for (; px <= ex; px += ox2)
+            for (; py <= ey; py += oy2)
             {
-                uint16_t* p01 = px + ox1;
-                uint16_t* p10 = px + oy1;
-                uint16_t* p11 = p10 + ox1;
+                uint16_t* px = py;
+                uint16_t* ex = py + ox * (nx - p2);
 
                 //
-                // 2D wavelet encoding
+                // X loop
                 //
 
-                if (w14)
+                for (; px <= ex; px += ox2)
                 {
-                    wenc14 (*px, *p01, &i00, &i01);
-                    wenc14 (*p10, *p11, &i10, &i11);
-                    wenc14 (i00, i10, px, p10);
-                    wenc14 (i01, i11, p01, p11);
+                    uint16_t* p01 = px + ox1;
+                    uint16_t* p10 = px + oy1;
+                    uint16_t* p11 = p10 + ox1;
+
+                    //
+                    // 2D wavelet encoding
+                    //
+
+                    if (w14)
+                    {
+                        wenc14 (*px, *p01, &i00, &i01);
+                        wenc14 (*p10, *p11, &i10, &i11);
+                        wenc14 (i00, i10, px, p10);
+                        wenc14 (i01, i11, p01, p11);
+                    }
+                    else
+                    {
+                        wenc16 (*px, *p01, &i00, &i01);
+                        wenc16 (*p10, *p11, &i10, &i11);
+                        wenc16 (i00, i10, px, p10);
+                        wenc16 (i01, i11, p01, p11);
+                    }
                 }
-                else
+
+                //
+                // Encode (1D) odd column (still in Y loop)
+                //
+
+                if (nx & p)
                 {
-                    wenc16 (*px, *p01, &i00, &i01);
-                    wenc16 (*p10, *p11, &i10, &i11);
-                    wenc16 (i00, i10, px, p10);
-                    wenc16 (i01, i11, p01, p11);
+                    uint16_t* p10 = px + oy1;
+
+                    if (w14)
+                        wenc14 (*px, *p10, px, p10);
+                    else
+                        wenc16 (*px, *p10, px, p10);
                 }
             }
 
             //
-            // Encode (1D) odd column (still in Y loop)
+            // Encode (1D) odd line (must loop in X)
             //
 
-            if (nx & p)
+            if (ny & p)
             {
-                uint16_t* p10 = px + oy1;
-
-                if (w14)
-                    wenc14 (*px, *p10, px, p10);
-                else
-                    wenc16 (*px, *p10, px, p10);
-            }
-        }
-
-        //
-        // Encode (1D) odd line (must loop in X)
-        //
+                uint16_t* px = py;
+                uint16_t* ex = py + ox * (nx - p2);
 
-        if (ny & p)
-        {
-            uint16_t* px = py;
-            uint16_t* ex = py + ox * (nx - p2);
-
-            for (; px <= ex; px += ox2)
-            {
-                uint16_t* p01 = px + ox1;
+                for (; px <= ex; px += ox2)
+                {
+                    uint16_t* p01 = px + ox1;
 
-                if (w14)
-                    wenc14 (*px, *p01, px, p01);
-                else
-                    wenc16 (*px, *p01, px, p01);
+                    if (w14)
+                        wenc14 (*px, *p01, px, p01);
+                    else
+                        wenc16 (*px, *p01, px, p01);
+                }
             }
         }
 
@@ -314,79 +956,86 @@ wav_2D_decode (
         int       ox2 = ox * p2;
         uint16_t  i00, i01, i10, i11;
 
-        //
-        // Y loop
-        //
-
-        for (; py <= ey; py += oy2)
+        if (ox1 <= 2)
+        {
+            wav_lines_decode (py, nx, ny, p, ox1, oy1, w14);
+        }
+        else
         {
-            uint16_t* px = py;
-            uint16_t* ex = py + ox * (nx - p2);
-
             //
-            // X loop
+            // Y loop
             //
 
-            for (; px <= ex; px += ox2)
+            for (; py <= ey; py += oy2)
             {
-                uint16_t* p01 = px + ox1;
-                uint16_t* p10 = px + oy1;
-                uint16_t* p11 = p10 + ox1;
+                uint16_t* px = py;
+                uint16_t* ex = py + ox * (nx - p2);
 
                 //
-                // 2D wavelet decoding
+                // X loop
                 //
 
-                if (w14)
+                for (; px <= ex; px += ox2)
                 {
-                    wdec14 (*px, *p10, &i00, &i10);
-                    wdec14 (*p01, *p11, &i01, &i11);
-                    wdec14 (i00, i01, px, p01);
-                    wdec14 (i10, i11, p10, p11);
+                    uint16_t* p01 = px + ox1;
+                    uint16_t* p10 = px + oy1;
+                    uint16_t* p11 = p10 + ox1;
+
+                    //
+                    // 2D wavelet decoding
+                    //
+
+                    if (w14)
+                    {
+                        wdec14 (*px, *p10, &i00, &i10);
+                        wdec14 (*p01, *p11, &i01, &i11);
+                        wdec14 (i00, i01, px, p01);
+                        wdec14 (i10, i11, p10, p11);
+                    }
+                    else
+                    {
+                        wdec16 (*px, *p10, &i00, &i10);
+                        wdec16 (*p01, *p11, &i01, &i11);
+                        wdec16 (i00, i01, px, p01);
+                        wdec16 (i10, i11, p10, p11);
+                    }
                 }
-                else
+
+                //
+                // Decode (1D) odd column (still in Y loop)
+                //
+
+                if (nx & p)
                 {
-                    wdec16 (*px, *p10, &i00, &i10);
-                    wdec16 (*p01, *p11, &i01, &i11);
-                    wdec16 (i00, i01, px, p01);
-                    wdec16 (i10, i11, p10, p11);
+                    uint16_t* p10 = px + oy1;
+
+                    if (w14)
+                        wdec14 (*px, *p10, &i00, p10);
+                    else
+                        wdec16 (*px, *p10, &i00, p10);
+                    *px = i00;
                 }
             }
 
             //
-            // Decode (1D) odd column (still in Y loop)
+            // Decode (1D) odd line (must loop in X)
             //
 
-            if (nx & p)
+            if (ny & p)
             {
-                uint16_t* p10 = px + oy1;
-
-                if (w14)
-                    wdec14 (*px, *p10, &i00, p10);
-                else
-                    wdec16 (*px, *p10, &i00, p10);
-                *px = i00;
-            }
-        }
-
-        //
-        // Decode (1D) odd line (must loop in X)
-        //
-
-        if (ny & p)
-        {
-            uint16_t* px = py;
-            uint16_t* ex = py + ox * (nx - p2);
+                uint16_t* px = py;
+                uint16_t* ex = py + ox * (nx - p2);
 
-            for (; px <= ex; px += ox2)
-            {
-                uint16_t* p01 = px + ox1;
+                for (; px <= ex; px += ox2)
+                {
+                    uint16_t* p01 = px + ox1;
 
-                if (w14)
-                    wdec14 (*px, *p01, &i00, p01);
-                else
-                    wdec16 (*px, *p01, &i00, p01);
-                *px = i00;
+                    if (w14)
+                        wdec14 (*px, *p01, &i00, p01);
+                    else
+                        wdec16 (*px, *p01, &i00, p01);
+                    *px = i00;
+                }
             }
         }
 
@@ -399,8 +1048,19 @@ wav_2D_decode (
     }
 }
 
-exr_result_t
-internal_exr_apply_piz (exr_encode_pipeline_t* encode)
+/**************************************/
+
+//
+// PIZ_MS splits the Huffman payload into up to PIZ_MS_STREAMS
+// streams, fewer for small chunks so every stream still codes at
+// least PIZ_MS_MIN_STREAM_SYMBOLS values.
+//
+
+#define PIZ_MS_STREAMS 4
+#define PIZ_MS_MIN_STREAM_SYMBOLS 4096
+
+static exr_result_t
+apply_piz_impl (exr_encode_pipeline_t* encode, int multiStream)
 {
     uint8_t*       out  = encode->compressed_buffer;
     uint64_t       nOut = 0;
@@ -419,6 +1079,8 @@ internal_exr_apply_piz (exr_encode_pipeline_t* encode)
     uint64_t       ndata       = packedbytes / 2;
     uint16_t*      wavbuf;
 
+    initializeWavFuncs ();
+
     rv = internal_encode_alloc_buffer (
         encode,
         EXR_TRANSCODE_BUFFER_SCRATCH1,
@@ -513,14 +1175,34 @@ internal_exr_apply_piz (exr_encode_pipeline_t* encode)
     lengthptr = (uint32_t*) out;
     out += sizeof (uint32_t);
     nOut += sizeof (uint32_t);
-    rv = internal_huf_compress (
-        &nBytes,
-        out,
-        encode->compressed_alloc_size - nOut,
-        encode->scratch_buffer_1,
-        ndata,
-        hufspare,
-        hufSpareBytes);
+    if (multiStream)
+    {
+        uint64_t nStreams = ndata / PIZ_MS_MIN_STREAM_SYMBOLS;
+
+        if (nStreams < 1) nStreams = 1;
+        if (nStreams > PIZ_MS_STREAMS) nStreams = PIZ_MS_STREAMS;
+
+        rv = internal_huf_compress_streams (
+            &nBytes,
+            out,
+            encode->compressed_alloc_size - nOut,
+            encode->scratch_buffer_1,
+            ndata,
+            (int) nStreams,
+            hufspare,
+            hufSpareBytes);
+    }
+    else
+    {
+        rv = internal_huf_compress (
+            &nBytes,
+            out,
+            encode->compressed_alloc_size - nOut,
+            encode->scratch_buffer_1,
+            ndata,
+            hufspare,
+            hufSpareBytes);
+    }
     if (rv != EXR_ERR_SUCCESS)
     {
         if (rv == EXR_ERR_ARGUMENT_OUT_OF_RANGE)
@@ -548,15 +1230,28 @@ internal_exr_apply_piz (exr_encode_pipeline_t* encode)
     return EXR_ERR_SUCCESS;
 }
 
-/**************************************/
+exr_result_t
+internal_exr_apply_piz (exr_encode_pipeline_t* encode)
+{
+    return apply_piz_impl (encode, 0);
+}
 
 exr_result_t
-internal_exr_undo_piz (
+internal_exr_apply_piz_ms (exr_encode_pipeline_t* encode)
+{
+    return apply_piz_impl (encode, 1);
+}
+
+/**************************************/
+
+static exr_result_t
+undo_piz_impl (
     exr_decode_pipeline_t* decode,
     const void*            src,
     uint64_t               packsz,
     void*                  outptr,
-    uint64_t               outsz)
+    uint64_t               outsz,
+    int                    multiStream)
 {
     uint8_t*       out  = outptr;
     uint64_t       nOut = 0;
@@ -573,6 +1268,8 @@ internal_exr_undo_piz (
     uint16_t*      wavbuf;
     uint32_t       hufbytes;
 
+    initializeWavFuncs ();
+
     rv = internal_decode_alloc_buffer (
         decode,
         EXR_TRANSCODE_BUFFER_SCRATCH1,
@@ -633,14 +1330,28 @@ internal_exr_undo_piz (
     if (nBytes + hufbytes > packsz) return EXR_ERR_CORRUPT_CHUNK;
 
     wavbuf = decode->scratch_buffer_1;
-    rv     = internal_huf_decompress (
-        decode,
-        packed + nBytes,
-        hufbytes,
-        wavbuf,
-        outsz / 2,
-        hufspare,
-        hufSpareBytes);
+    if (multiStream)
+    {
+        rv = internal_huf_decompress_streams (
+            decode,
+            packed + nBytes,
+            hufbytes,
+            wavbuf,
+            outsz / 2,
+            hufspare,
+            hufSpareBytes);
+    }
+    else
+    {
+        rv = internal_huf_decompress (
+            decode,
+            packed + nBytes,
+            hufbytes,
+            wavbuf,
+            outsz / 2,
+            hufspare,
+            hufSpareBytes);
+    }
     if (rv != EXR_ERR_SUCCESS) return rv;
 
     //
@@ -710,3 +1421,25 @@ internal_exr_undo_piz (
     if (nOut != outsz) return EXR_ERR_CORRUPT_CHUNK;
     return EXR_ERR_SUCCESS;
 }
+
+exr_result_t
+internal_exr_undo_piz (
+    exr_decode_pipeline_t* decode,
+    const void*            src,
+    uint64_t               packsz,
+    void*                  outptr,
+    uint64_t               outsz)
+{
+    return undo_piz_impl (decode, src, packsz, outptr, outsz, 0);
+}
+
+exr_result_t
+internal_exr_undo_piz_ms (
+    exr_decode_pipeline_t* decode,
+    const void*            src,
+    uint64_t               packsz,
+    void*                  outptr,
+    uint64_t               outsz)
+{
+    return undo_piz_impl (decode, src, packsz, outptr, outsz, 1);
+}
@@ -9,6 +9,7 @@
 #include <errno.h>
 
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -28,15 +29,21 @@
 #    define CAN_USE_PREAD 0
 #endif
 
+/* when reading, map points at a private, copy-on-write mapping of the
+ * whole file (see default_map_read_file), or is NULL */
 #if CAN_USE_PREAD
 struct _internal_exr_filehandle
 {
-    int fd;
+    int    fd;
+    void*  map;
+    size_t map_size;
 };
 #else
 struct _internal_exr_filehandle
 {
     int             fd;
+    void*           map;
+    size_t          map_size;
 #    ifdef ILMTHREAD_THREADING_ENABLED
     pthread_mutex_t mutex;
 #    endif
@@ -52,6 +59,8 @@ default_shutdown (exr_const_context_t c, void* userdata, int failed)
     struct _internal_exr_filehandle* fh = userdata;
     if (fh)
     {
+        if (fh->map) munmap (fh->map, fh->map_size);
+        fh->map = NULL;
         if (fh->fd >= 0) close (fh->fd);
 #if !CAN_USE_PREAD
 #    ifdef ILMTHREAD_THREADING_ENABLED
@@ -140,6 +149,16 @@ default_read_func (
         return retsz;
     }
 
+    if (fh->map)
+    {
+        /* short read at the end of the file, same as pread */
+        if (offset >= (uint64_t) fh->map_size) return 0;
+        if (readsz > (uint64_t) fh->map_size - offset)
+            readsz = (uint64_t) fh->map_size - offset;
+        memcpy (curbuf, ((const char*) fh->map) + offset, (size_t) readsz);
+        return (int64_t) readsz;
+    }
+
 #if !CAN_USE_PREAD
 #    ifdef ILMTHREAD_THREADING_ENABLED
     pthread_mutex_lock (&(fh->mutex));
@@ -330,7 +349,9 @@ default_init_read_file (struct _internal_exr_context* file)
     int                              fd;
     struct _internal_exr_filehandle* fh = file->user_data;
 
-    fh->fd = -1;
+    fh->fd       = -1;
+    fh->map      = NULL;
+    fh->map_size = 0;
 #if !CAN_USE_PREAD
 #    ifdef ILMTHREAD_THREADING_ENABLED
     fd = pthread_mutex_init (&(fh->mutex), NULL);
@@ -360,6 +381,37 @@ default_init_read_file (struct _internal_exr_context* file)
 
 /**************************************/
 
+/* Map the whole file read-only so chunks can be decoded straight from
+ * the page cache; the decompressors and unpackers only ever read their
+ * input. Any failure just leaves the file to be read with pread. */
+static void
+default_map_read_file (struct _internal_exr_context* file)
+{
+    struct stat                      sbuf;
+    struct _internal_exr_filehandle* fh = file->user_data;
+    void*                            map;
+
+    if (fh->fd < 0 || fstat (fh->fd, &sbuf) != 0) return;
+    if (!S_ISREG (sbuf.st_mode) || sbuf.st_size <= 0) return;
+    if ((uint64_t) sbuf.st_size > (uint64_t) (SIZE_MAX / 2)) return;
+
+    map = mmap (
+        NULL,
+        (size_t) sbuf.st_size,
+        PROT_READ,
+        MAP_PRIVATE,
+        fh->fd,
+        0);
+    if (map == MAP_FAILED) return;
+
+    fh->map         = map;
+    fh->map_size    = (size_t) sbuf.st_size;
+    file->mmap_base = (const uint8_t*) map;
+    file->mmap_size = (uint64_t) sbuf.st_size;
+}
+
+/**************************************/
+
 static exr_result_t
 default_init_write_file (struct _internal_exr_context* file)
 {
@@ -381,6 +433,8 @@ default_init_write_file (struct _internal_exr_context* file)
 #endif
 
     fh->fd           = -1;
+    fh->map          = NULL;
+    fh->map_size     = 0;
     file->destroy_fn = &default_shutdown;
     file->write_fn   = &default_write_func;
 
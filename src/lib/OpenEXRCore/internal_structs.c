@@ -6,6 +6,7 @@
 #include "openexr_config.h"
 #include "internal_structs.h"
 #include "internal_attr.h"
+#include "internal_compress.h"
 #include "internal_constants.h"
 #include "internal_memory.h"
 
@@ -247,6 +248,7 @@ internal_exr_add_part (
 
     part->zip_compression_level = f->default_zip_level;
     part->dwa_compression_level = f->default_dwa_quality;
+    part->ht_compression_level  = f->default_ht_quality;
 
     /* put it into the part table */
     if (ncount > 1)
@@ -400,6 +402,7 @@ internal_exr_alloc_context (
 
         exr_get_default_zip_compression_level (&ret->default_zip_level);
         exr_get_default_dwa_compression_quality (&ret->default_dwa_quality);
+        exr_get_default_ht_compression_quality (&ret->default_ht_quality);
         if (initializers->zip_level >= 0)
             ret->default_zip_level = initializers->zip_level;
         if (initializers->dwa_quality >= 0.f)
@@ -436,6 +439,7 @@ internal_exr_alloc_context (
         }
 #    endif
 #endif
+        internal_exr_init_deflate_pool (ret);
 
         *out = ret;
         rv   = EXR_ERR_SUCCESS;
@@ -451,6 +455,7 @@ internal_exr_alloc_context (
                 /* this should never happen since we reserve space for
                  * one in the struct, but maybe we changed
                  * something */
+                internal_exr_destroy_deflate_pool (ret);
                 (initializers->free_fn) (memptr);
                 *out = NULL;
             }
@@ -479,6 +484,7 @@ internal_exr_destroy_context (struct _internal_exr_context* ctxt)
     exr_attr_string_destroy ((exr_context_t) ctxt, &(ctxt->tmp_filename));
     exr_attr_list_destroy ((exr_context_t) ctxt, &(ctxt->custom_handlers));
     internal_exr_destroy_parts (ctxt);
+    internal_exr_destroy_deflate_pool (ctxt);
 #ifdef ILMTHREAD_THREADING_ENABLED
 #    ifdef _WIN32
     DeleteCriticalSection (&(ctxt->mutex));
@@ -99,6 +99,7 @@ struct _internal_exr_part
 
     int32_t zip_compression_level;
     float   dwa_compression_level;
+    float   ht_compression_level;
 
     int32_t  num_tile_levels_x;
     int32_t  num_tile_levels_y;
@@ -181,6 +182,7 @@ struct _internal_exr_context
 
     int   default_zip_level;
     float default_dwa_quality;
+    float default_ht_quality;
 
     void*                         real_user_data;
     void*                         user_data;
@@ -189,6 +191,11 @@ struct _internal_exr_context
     int64_t             file_size;
     exr_read_func_ptr_t read_fn;
 
+    /* the whole file, when the default reader managed to map it, so
+     * chunks can be decoded without a copy (see decoding.c) */
+    const uint8_t* mmap_base;
+    uint64_t       mmap_size;
+
     exr_write_func_ptr_t write_fn;
     /* used when writing under a mutex, is there a better way? */
     uint64_t output_file_offset;
@@ -206,6 +213,9 @@ struct _internal_exr_context
 
     exr_attribute_list_t custom_handlers;
 
+    /* libdeflate objects kept across chunks, see compression.c */
+    struct _internal_exr_deflate_pool* deflate_pool;
+
     /* mostly needed for writing, but used during read to ensure
      * custom attribute handlers are safe */
 #ifdef ILMTHREAD_THREADING_ENABLED
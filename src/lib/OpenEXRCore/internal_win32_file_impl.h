@@ -7,6 +7,7 @@
 
 #include <fileapi.h>
 #include <inttypes.h>
+#include <string.h>
 #include <strsafe.h>
 #include <windows.h>
 
@@ -108,9 +109,14 @@ widen_filename (struct _internal_exr_context* file, const char* fn)
     return wcFn;
 }
 
+/* when reading, map is a copy-on-write view of the whole file (see
+ * default_map_read_file), or NULL */
 struct _internal_exr_filehandle
 {
     HANDLE fd;
+    HANDLE mapping;
+    void*  map;
+    size_t map_size;
 };
 
 /**************************************/
@@ -122,6 +128,10 @@ default_shutdown (exr_const_context_t c, void* userdata, int failed)
     struct _internal_exr_filehandle* fh = userdata;
     if (fh)
     {
+        if (fh->map) UnmapViewOfFile (fh->map);
+        if (fh->mapping) CloseHandle (fh->mapping);
+        fh->map     = NULL;
+        fh->mapping = NULL;
         if (fh->fd != INVALID_HANDLE_VALUE) CloseHandle (fh->fd);
         fh->fd = INVALID_HANDLE_VALUE;
     }
@@ -212,6 +222,16 @@ default_read_func (
         return retsz;
     }
 
+    if (fh->map)
+    {
+        /* short read at the end of the file, same as ReadFile */
+        if (offset >= (uint64_t) fh->map_size) return 0;
+        if (sz > (uint64_t) fh->map_size - offset)
+            sz = (uint64_t) fh->map_size - offset;
+        memcpy (buffer, ((const char*) fh->map) + offset, (size_t) sz);
+        return (int64_t) sz;
+    }
+
     lint.QuadPart      = offset;
     overlap.Offset     = lint.LowPart;
     overlap.OffsetHigh = lint.HighPart;
@@ -310,6 +330,9 @@ default_init_read_file (struct _internal_exr_context* file)
     struct _internal_exr_filehandle* fh = file->user_data;
 
     fh->fd           = INVALID_HANDLE_VALUE;
+    fh->mapping      = NULL;
+    fh->map          = NULL;
+    fh->map_size     = 0;
     file->destroy_fn = &default_shutdown;
     file->read_fn    = &default_read_func;
 
@@ -346,6 +369,40 @@ default_init_read_file (struct _internal_exr_context* file)
 
 /**************************************/
 
+/* Map the whole file read-only so chunks can be decoded straight from
+ * the page cache; the decompressors and unpackers only ever read their
+ * input. Any failure just leaves the file to be read with ReadFile. */
+static void
+default_map_read_file (struct _internal_exr_context* file)
+{
+    struct _internal_exr_filehandle* fh   = file->user_data;
+    LARGE_INTEGER                    lint = {0};
+    HANDLE                           mapping;
+    void*                            map;
+
+    if (fh->fd == INVALID_HANDLE_VALUE) return;
+    if (!GetFileSizeEx (fh->fd, &lint) || lint.QuadPart <= 0) return;
+    if ((uint64_t) lint.QuadPart > (uint64_t) (SIZE_MAX / 2)) return;
+
+    mapping = CreateFileMappingW (fh->fd, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) return;
+
+    map = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!map)
+    {
+        CloseHandle (mapping);
+        return;
+    }
+
+    fh->mapping     = mapping;
+    fh->map         = map;
+    fh->map_size    = (size_t) lint.QuadPart;
+    file->mmap_base = (const uint8_t*) map;
+    file->mmap_size = (uint64_t) lint.QuadPart;
+}
+
+/**************************************/
+
 static exr_result_t
 default_init_write_file (struct _internal_exr_context* file)
 {
@@ -357,6 +414,9 @@ default_init_write_file (struct _internal_exr_context* file)
     if (outfn == NULL) outfn = file->filename.str;
 
     fh->fd           = INVALID_HANDLE_VALUE;
+    fh->mapping      = NULL;
+    fh->map          = NULL;
+    fh->map_size     = 0;
     file->destroy_fn = &default_shutdown;
     file->write_fn   = &default_write_func;
 
@@ -45,6 +45,13 @@ typedef enum
     EXR_COMPRESSION_B44A  = 7,
     EXR_COMPRESSION_DWAA  = 8,
     EXR_COMPRESSION_DWAB  = 9,
+    EXR_COMPRESSION_HT    = 10,
+    EXR_COMPRESSION_HT256 = 11,
+    EXR_COMPRESSION_HTK   = 12, /**< Kakadu coded HT, not supported by the core. */
+    EXR_COMPRESSION_HTK256 = 13, /**< Kakadu coded HT256, not supported by the core. */
+    EXR_COMPRESSION_HT_LOSSY = 14, /**< Irreversible HT, see exr_set_ht_compression_level. */
+    EXR_COMPRESSION_PIZ_MS = 15, /**< PIZ with the Huffman data split into independently decodable streams. */
+    EXR_COMPRESSION_HT_STRIPED = 16, /**< Full frame HT, split into independently decodable 256 line stripes. */
     EXR_COMPRESSION_LAST_TYPE /**< Invalid value, provided for range checking. */
 } exr_compression_t;
 
@@ -136,6 +136,19 @@ EXR_EXPORT void exr_set_default_dwa_compression_quality (float q);
  */
 EXR_EXPORT void exr_get_default_dwa_compression_quality (float* q);
 
+/** @brief Assigns a default HT lossy compression quality level.
+ *
+ * This is the quantization step used by EXR_COMPRESSION_HT_LOSSY,
+ * in units of the last place of a HALF value. This value may be
+ * controlled separately on each part, but this global control
+ * determines the initial value.
+ */
+EXR_EXPORT void exr_set_default_ht_compression_quality (float q);
+
+/** @brief Retrieve the global default HT lossy compression quality
+ */
+EXR_EXPORT void exr_get_default_ht_compression_quality (float* q);
+
 /** @} */
 
 /**
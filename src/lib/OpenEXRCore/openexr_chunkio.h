@@ -164,6 +164,30 @@ exr_result_t exr_write_deep_tile_chunk (
     const void*   sample_data,
     uint64_t      sample_data_size);
 
+/**************************************/
+
+/** Copy all chunks of a part to another file without decoding them.
+ *
+ * The header of @p dst must have been written (@see exr_write_header)
+ * and @p dst_part_index must be the next part to be written. The
+ * destination part must have the same storage type, compression,
+ * data window, tiling and channels as the source part; any other
+ * attribute may differ, so this serves both header edits and
+ * merging parts into a multipart file. Deep parts are copied
+ * together with their sample count tables.
+ *
+ * The source is read in blocks of @p buffer_size bytes (or 16 MiB if
+ * 0), each holding many neighbouring chunks, and chunks are written
+ * to @p dst straight from that block.
+ */
+EXR_EXPORT
+exr_result_t exr_copy_chunks (
+    exr_const_context_t src,
+    int                 src_part_index,
+    exr_context_t       dst,
+    int                 dst_part_index,
+    uint64_t            buffer_size);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
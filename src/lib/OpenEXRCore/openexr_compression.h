@@ -25,7 +25,10 @@ size_t exr_compress_max_buffer_size (size_t in_bytes);
  *
  * If the level is -1, will use the default compression set to the library
  * \ref exr_set_default_zip_compression_level
- * data. This may include some extra padding for headers / scratch */
+ * data. This may include some extra padding for headers / scratch
+ *
+ * The libdeflate state is pooled, per context, or process wide when
+ * ctxt is NULL, so repeated calls do not allocate it again. */
 EXR_EXPORT
 exr_result_t exr_compress_buffer (
     exr_const_context_t ctxt,
@@ -383,6 +383,11 @@ EXR_EXPORT exr_result_t exr_finish (exr_context_t* ctxt);
  * provide a safe context for multiple threads to request data from
  * the same context concurrently.
  *
+ * Without a custom read function, the file is memory mapped when
+ * possible, and the default decode pipeline then decompresses chunks
+ * (or unpacks uncompressed ones) straight from the mapping, without
+ * reading them into a packed buffer first.
+ *
  * Once finished reading data, use exr_finish() to clean up
  * the context.
  *
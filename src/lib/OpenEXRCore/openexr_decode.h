@@ -99,6 +99,10 @@ typedef struct _exr_decode_pipeline
      * If the caller wishes to take control of the buffer, simple
      * adopt the pointer and set it to `NULL` here. Be cognizant of any
      * custom allocators.
+     *
+     * When the default read function decodes a chunk straight from a
+     * memory mapped file, this points into the read-only mapping and
+     * `packed_alloc_size` is 0: it must not be written to or freed.
      */
     void* packed_buffer;
 
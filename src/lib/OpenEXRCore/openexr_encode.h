@@ -337,6 +337,63 @@ EXR_EXPORT
 exr_result_t exr_encoding_destroy (
     exr_const_context_t ctxt, exr_encode_pipeline_t* encode_pipe);
 
+/**************************************/
+
+/** Function used by exr_encode_chunks() to hand a task to the
+ * caller's thread pool.
+ *
+ * The pool must call @p task_fn (@p task_data) exactly once, on any
+ * thread, and may do so before returning. exr_encode_chunks() does
+ * not return until every task it submitted has been called.
+ */
+typedef void (*exr_task_submit_func_ptr_t) (
+    void* submit_data, void (*task_fn) (void*), void* task_data);
+
+/** One channel of a whole frame to be encoded by exr_encode_chunks().
+ *
+ * @p base_ptr points to the first sample of the data window. Sample
+ * (x, y) of the channel, counted in samples of its own sampling rate
+ * from the data window origin, is at
+ * base_ptr + y * user_line_stride + x * user_pixel_stride.
+ */
+typedef struct
+{
+    const char*    channel_name;
+    const uint8_t* base_ptr;
+    int32_t        user_pixel_stride;
+    int32_t        user_line_stride;
+    /** Same meaning as in exr_coding_channel_info_t. */
+    int16_t  user_bytes_per_element;
+    uint16_t user_data_type;
+} exr_frame_channel_t;
+
+/** Compress all chunks of a scanline part in parallel, and write
+ * them in chunk order.
+ *
+ * @p part_index must be the next part to be written, and none of its
+ * chunks may have been written yet. Every channel of the part must be
+ * named in @p channels.
+ *
+ * Chunks are compressed by @p num_workers threads created for the
+ * call, or, if @p submit_fn is not `NULL`, by tasks handed to it, in
+ * which case @p num_workers only sizes the default window. The
+ * calling thread writes the finished chunks in order and compresses
+ * chunks itself while it waits. At most @p max_chunks_in_flight
+ * chunks (or 2 * @p num_workers if 0) are held in memory at once.
+ * With @p num_workers of 0 and no @p submit_fn, or when the library
+ * is built without threading, everything runs on the calling thread.
+ */
+EXR_EXPORT
+exr_result_t exr_encode_chunks (
+    exr_context_t              ctxt,
+    int                        part_index,
+    const exr_frame_channel_t* channels,
+    int                        num_channels,
+    int                        num_workers,
+    int                        max_chunks_in_flight,
+    exr_task_submit_func_ptr_t submit_fn,
+    void*                      submit_data);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -197,6 +197,30 @@ EXR_EXPORT exr_result_t exr_get_dwa_compression_level (
 EXR_EXPORT exr_result_t
 exr_set_dwa_compression_level (exr_context_t ctxt, int part_index, float level);
 
+/** @brief Retrieve the HT lossy compression level used for the specified part.
+ *
+ * This only applies when the compression method is HT_LOSSY.
+ *
+ * This value is NOT persisted in the file, and only exists for the
+ * lifetime of the context, so will be at the default value when just
+ * reading a file.
+ */
+EXR_EXPORT exr_result_t exr_get_ht_compression_level (
+    exr_const_context_t ctxt, int part_index, float* level);
+
+/** @brief Set the HT lossy compression level used for the specified part.
+ *
+ * This only applies when the compression method is HT_LOSSY. The
+ * level is the quantization step of the irreversible wavelet
+ * transform, in units of the last place of a HALF value, in (0, 1024].
+ *
+ * This value is NOT persisted in the file, and only exists for the
+ * lifetime of the context, so this value will be ignored when
+ * reading a file.
+ */
+EXR_EXPORT exr_result_t
+exr_set_ht_compression_level (exr_context_t ctxt, int part_index, float level);
+
 /**************************************/
 
 /** @defgroup PartMetadata Functions to get and set metadata for a particular part.
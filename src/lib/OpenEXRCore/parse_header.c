@@ -2360,10 +2360,17 @@ internal_exr_compute_chunk_offset_size (struct _internal_exr_part* curpart)
             case EXR_COMPRESSION_ZIP:
             case EXR_COMPRESSION_PXR24: linePerChunk = 16; break;
             case EXR_COMPRESSION_PIZ:
+            case EXR_COMPRESSION_PIZ_MS:
             case EXR_COMPRESSION_B44:
             case EXR_COMPRESSION_B44A:
             case EXR_COMPRESSION_DWAA: linePerChunk = 32; break;
-            case EXR_COMPRESSION_DWAB: linePerChunk = 256; break;
+            case EXR_COMPRESSION_DWAB:
+            case EXR_COMPRESSION_HT256:
+            case EXR_COMPRESSION_HTK256:
+            case EXR_COMPRESSION_HT_LOSSY: linePerChunk = 256; break;
+            case EXR_COMPRESSION_HT:
+            case EXR_COMPRESSION_HTK:
+            case EXR_COMPRESSION_HT_STRIPED: linePerChunk = 16000; break;
             case EXR_COMPRESSION_LAST_TYPE:
             default:
                 /* ERROR CONDITION */
@@ -0,0 +1,227 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <IlmThread.h>
+#include <IlmThreadPool.h>
+#include <assert.h>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <testWorkStealingPool.h>
+
+using namespace ILMTHREAD_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+//
+// A task that counts itself, and that adds a nested task to the
+// pool when it runs on a worker thread.
+//
+
+class CountingTask : public Task
+{
+public:
+    CountingTask (
+        TaskGroup*        group,
+        ThreadPool&       pool,
+        std::atomic<int>& count,
+        int               depth)
+        : Task (group), _pool (pool), _count (count), _depth (depth)
+    {}
+
+    void execute () override
+    {
+        if (_depth > 0)
+        {
+            _pool.addTask (
+                new CountingTask (_group, _pool, _count, _depth - 1));
+        }
+
+        ++_count;
+    }
+
+private:
+    ThreadPool&       _pool;
+    std::atomic<int>& _count;
+    int               _depth;
+};
+
+//
+// A task that adds subtasks to its own deque and then waits for
+// them, so that it only finishes if an idle worker wakes up to
+// steal them.
+//
+
+class WaitingTask : public Task
+{
+public:
+    WaitingTask (
+        TaskGroup* group, ThreadPool& pool, std::atomic<int>& count, int n)
+        : Task (group), _pool (pool), _count (count), _n (n)
+    {}
+
+    void execute () override
+    {
+        {
+            TaskGroup subtasks;
+
+            for (int i = 0; i < _n; ++i)
+                _pool.addTask (new CountingTask (&subtasks, _pool, _count, 0));
+        }
+
+        ++_count;
+    }
+
+private:
+    ThreadPool&       _pool;
+    std::atomic<int>& _count;
+    int               _n;
+};
+
+void
+testWakeFromInsideThePool ()
+{
+    cout << "adding tasks from a worker while the others sleep" << endl;
+
+    const int rounds   = 20000;
+    const int subtasks = 3;
+
+    ThreadPool pool (0);
+    pool.setThreadProvider (new WorkStealingThreadPoolProvider (4));
+
+    std::atomic<int> count (0);
+
+    for (int r = 0; r < rounds; ++r)
+    {
+        //
+        // Between rounds every worker runs out of work and goes to
+        // sleep.  A wake-up lost by the worker that adds the
+        // subtasks would leave it waiting for them forever.
+        //
+
+        TaskGroup group;
+        pool.addTask (new WaitingTask (&group, pool, count, subtasks));
+    }
+
+    assert (count == rounds * (subtasks + 1));
+}
+
+void
+testAddTaskDuringResize ()
+{
+    cout << "adding tasks while the pool is resized" << endl;
+
+    const int numProducers  = 4;
+    const int numGroups     = 200;
+    const int tasksPerGroup = 16;
+    const int depth         = 2;
+
+    ThreadPool pool (0);
+    pool.setThreadProvider (new WorkStealingThreadPoolProvider (4));
+
+    std::atomic<int>         count (0);
+    std::atomic<int>         producersLeft (numProducers);
+    std::vector<std::thread> producers;
+
+    for (int p = 0; p < numProducers; ++p)
+    {
+        producers.emplace_back ([&] {
+            for (int g = 0; g < numGroups; ++g)
+            {
+                //
+                // The TaskGroup destructor waits for all of the
+                // group's tasks, nested ones included; a task lost
+                // by a resize would make it wait forever.
+                //
+
+                TaskGroup group;
+
+                for (int t = 0; t < tasksPerGroup; ++t)
+                    pool.addTask (new CountingTask (&group, pool, count, depth));
+            }
+
+            --producersLeft;
+        });
+    }
+
+    //
+    // Resize through ThreadPool::setNumThreads (), which hands the
+    // new count to the provider, until the producers are done.
+    //
+
+    for (int n = 0; producersLeft.load () > 0; ++n)
+    {
+        pool.setNumThreads (1 + n % 7);
+        assert (pool.numThreads () == 1 + n % 7);
+    }
+
+    for (auto& t: producers)
+        t.join ();
+
+    assert (count == numProducers * numGroups * tasksPerGroup * (depth + 1));
+}
+
+void
+testFinishRunsQueuedTasks ()
+{
+    cout << "replacing the provider while tasks are queued" << endl;
+
+    std::atomic<int> count (0);
+
+    {
+        ThreadPool pool (0);
+        pool.setThreadProvider (new WorkStealingThreadPoolProvider (2));
+
+        TaskGroup group;
+
+        for (int t = 0; t < 1000; ++t)
+            pool.addTask (new CountingTask (&group, pool, count, 1));
+
+        //
+        // Switching to no threads finishes the provider; whatever
+        // its workers did not get to must still run.
+        //
+
+        pool.setNumThreads (0);
+        pool.addTask (new CountingTask (&group, pool, count, 0));
+    }
+
+    assert (count == 2001);
+}
+
+} // namespace
+
+void
+testWorkStealingPool ()
+{
+    try
+    {
+        cout << "Testing the work-stealing thread pool provider" << endl;
+
+        if (!supportsThreads ())
+        {
+            cout << "threading disabled, skipped" << endl;
+            return;
+        }
+
+        testAddTaskDuringResize ();
+        testFinishRunsQueuedTasks ();
+        testWakeFromInsideThePool ();
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
@@ -35,4 +35,24 @@ void testBufferCompression (const std::string& tempdir)
     std::cout << "uncompressed size: " << outsz << std::endl;
     if (buf[0] != 'O')
         EXRCORE_TEST_FAIL(buf[0] != 'O');
+
+    // compressors are pooled per level, make sure reusing them across
+    // levels and calls round trips
+    std::vector<char> src (65536), dst;
+    for (size_t i = 0; i < src.size (); ++i)
+        src[i] = (char) ((i * 7) ^ (i >> 5));
+    cbuf.resize (exr_compress_max_buffer_size (src.size ()));
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int level = 0; level <= 12; ++level)
+        {
+            dst.assign (src.size (), 0);
+            EXRCORE_TEST_RVAL (exr_compress_buffer (
+                nullptr, level, src.data (), src.size (), &cbuf[0], cbuf.size (), &outsz));
+            EXRCORE_TEST_RVAL (exr_uncompress_buffer (
+                nullptr, cbuf.data (), outsz, &dst[0], dst.size (), &outsz));
+            if (outsz != src.size () || dst != src)
+                EXRCORE_TEST_FAIL(dst != src);
+        }
+    }
 }
@@ -429,6 +429,24 @@ struct pixels
         }
     }
 
+    // every half bit pattern, at every offset modulo the vector width
+    void fillAllHalves ()
+    {
+        for (int y = 0; y < _h; ++y)
+        {
+            for (int x = 0; x < _w; ++x)
+            {
+                size_t   idx = y * _stride_x + x;
+                uint32_t n   = (uint32_t) (y * _w + x);
+                i[idx]       = n;
+                f[idx]       = float (x);
+                h[idx]       = (uint16_t) (n * 40503u);
+                for (int c = 0; c < 4; ++c)
+                    rgba[c][idx] = (uint16_t) ((n + 7919u * c) * 40503u);
+            }
+        }
+    }
+
     void fillRandom ()
     {
         Rand48 rand;
@@ -1419,9 +1437,13 @@ doWriteRead (
         case EXR_COMPRESSION_RLE:
         case EXR_COMPRESSION_ZIP:
         case EXR_COMPRESSION_ZIPS:
+        case EXR_COMPRESSION_HT:
+        case EXR_COMPRESSION_HT256:
+        case EXR_COMPRESSION_HT_STRIPED:
             restore.compareExact (p, "orig", "C loaded C");
             break;
         case EXR_COMPRESSION_PIZ:
+        case EXR_COMPRESSION_PIZ_MS:
         case EXR_COMPRESSION_PXR24:
         case EXR_COMPRESSION_B44:
         case EXR_COMPRESSION_B44A:
@@ -1486,6 +1508,43 @@ testComp (const std::string& tempdir, exr_compression_t comp)
 
 ////////////////////////////////////////
 
+static void
+testCompHT (const std::string& tempdir, exr_compression_t comp)
+{
+    pixels p{IMG_WIDTH, IMG_HEIGHT, IMG_STRIDE_X};
+
+    // HT is scanline only, but codes every pixel type and sampling
+    const char* patterns[] = {
+        "zeroes", "pattern1", "pattern2", "random", "allhalves"};
+    for (int i = 0; i < 5; ++i)
+    {
+        std::string filename =
+            tempdir + patterns[i] + std::string ("_imf_test_comp_ht.exr");
+        std::string cppfilename =
+            tempdir + patterns[i] + std::string ("_imf_test_comp_ht_cpp.exr");
+
+        switch (i)
+        {
+            case 0: p.fillZero (); break;
+            case 1: p.fillPattern1 (); break;
+            case 2: p.fillPattern2 (); break;
+            case 3: p.fillRandom (); break;
+            default: p.fillAllHalves (); break;
+        }
+
+        for (int xs = 1; xs <= 2; ++xs)
+        {
+            for (int ys = 1; ys <= 2; ++ys)
+            {
+                doWriteRead (
+                    p, filename, cppfilename, false, xs, ys, comp, patterns[i]);
+            }
+        }
+    }
+}
+
+////////////////////////////////////////
+
 void
 testHUF (const std::string& tempdir)
 {
@@ -1493,7 +1552,7 @@ testHUF (const std::string& tempdir)
     uint64_t dsize = internal_exr_huf_decompress_spare_bytes ();
     // decsize 1 << 16 + 1
     // decsize 1 << 14
-    EXRCORE_TEST (esize == 65537 * (8 + 8 + sizeof (uint64_t*) + 4));
+    EXRCORE_TEST (esize == 65537 * (8 + 8 + 4 + 4));
     const uint64_t hufdecsize = (sizeof (uint32_t*) + sizeof(int32_t) + sizeof(uint32_t));
     // sizeof(FastHufDecoder) is bother to manually compute, just assume it's ok
     // if it's returning at least enough for the slow path
@@ -1617,6 +1676,37 @@ testHUF (const std::string& tempdir)
     {
         EXRCORE_TEST (decode.h[i] == p.h[i]);
     }
+
+    // multi-stream layout, used by PIZ_MS
+    EXRCORE_TEST_RVAL (internal_huf_compress_streams (
+        &ebytes,
+        encoded.data (),
+        encoded.size (),
+        p.h.data (),
+        IMG_WIDTH,
+        4,
+        hspare.data (),
+        esize));
+    cppebytes = hufCompressStreams (
+        p.h.data (), IMG_WIDTH, 4, (char*) (&cppencoded[0]));
+    EXRCORE_TEST (ebytes == cppebytes);
+    for (size_t i = 0; i < ebytes; ++i)
+    {
+        EXRCORE_TEST (encoded[i] == cppencoded[i]);
+    }
+    decode.fillZero ();
+    EXRCORE_TEST_RVAL (internal_huf_decompress_streams (
+        NULL,
+        encoded.data (),
+        ebytes,
+        decode.h.data (),
+        IMG_WIDTH,
+        hspare.data (),
+        dsize));
+    for (size_t i = 0; i < IMG_WIDTH; ++i)
+    {
+        EXRCORE_TEST (decode.h[i] == p.h[i]);
+    }
 }
 
 ////////////////////////////////////////
@@ -1651,6 +1741,12 @@ testPIZCompression (const std::string& tempdir)
     testComp (tempdir, EXR_COMPRESSION_PIZ);
 }
 
+void
+testPIZMSCompression (const std::string& tempdir)
+{
+    testComp (tempdir, EXR_COMPRESSION_PIZ_MS);
+}
+
 void
 testPXR24Compression (const std::string& tempdir)
 {
@@ -1681,6 +1777,25 @@ testDWABCompression (const std::string& tempdir)
     testComp (tempdir, EXR_COMPRESSION_DWAB);
 }
 
+void
+testHTCompression (const std::string& tempdir)
+{
+    testCompHT (tempdir, EXR_COMPRESSION_HT);
+}
+
+void
+testHT256Compression (const std::string& tempdir)
+{
+    testCompHT (tempdir, EXR_COMPRESSION_HT256);
+}
+
+void
+testHTStripedCompression (const std::string& tempdir)
+{
+    // vertically subsampled images are tall enough for two stripes
+    testCompHT (tempdir, EXR_COMPRESSION_HT_STRIPED);
+}
+
 void
 testDeepNoCompression (const std::string& tempdir)
 {}
@@ -13,11 +13,15 @@ void testRLECompression (const std::string& tempdir);
 void testZIPCompression (const std::string& tempdir);
 void testZIPSCompression (const std::string& tempdir);
 void testPIZCompression (const std::string& tempdir);
+void testPIZMSCompression (const std::string& tempdir);
 void testPXR24Compression (const std::string& tempdir);
 void testB44Compression (const std::string& tempdir);
 void testB44ACompression (const std::string& tempdir);
 void testDWAACompression (const std::string& tempdir);
 void testDWABCompression (const std::string& tempdir);
+void testHTCompression (const std::string& tempdir);
+void testHT256Compression (const std::string& tempdir);
+void testHTStripedCompression (const std::string& tempdir);
 
 void testDeepNoCompression (const std::string& tempdir);
 void testDeepZIPCompression (const std::string& tempdir);
@@ -189,6 +189,8 @@ main (int argc, char* argv[])
     TEST (testWriteScans, "core_write");
     TEST (testWriteTiles, "core_write");
     TEST (testWriteMultiPart, "core_write");
+    TEST (testCopyChunks, "core_write");
+    TEST (testEncodeChunks, "core_write");
     TEST (testWriteDeep, "core_write");
 
     TEST (testHUF, "core_compression");
@@ -197,11 +199,15 @@ main (int argc, char* argv[])
     TEST (testZIPCompression, "core_compression");
     TEST (testZIPSCompression, "core_compression");
     TEST (testPIZCompression, "core_compression");
+    TEST (testPIZMSCompression, "core_compression");
     TEST (testPXR24Compression, "core_compression");
     TEST (testB44Compression, "core_compression");
     TEST (testB44ACompression, "core_compression");
     TEST (testDWAACompression, "core_compression");
     TEST (testDWABCompression, "core_compression");
+    TEST (testHTCompression, "core_compression");
+    TEST (testHT256Compression, "core_compression");
+    TEST (testHTStripedCompression, "core_compression");
 
     TEST (testDeepNoCompression, "core_compression");
     TEST (testDeepZIPCompression, "core_compression");
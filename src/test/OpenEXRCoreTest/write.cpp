@@ -15,6 +15,8 @@
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <thread>
+#include <vector>
 
 static void
 err_cb (exr_const_context_t f, exr_result_t code, const char* msg)
@@ -1369,3 +1371,319 @@ testWriteMultiPart (const std::string& tempdir)
     EXRCORE_TEST_RVAL (exr_finish (&outf));
     remove (outfn.c_str ());
 }
+
+static void
+compareChunk (
+    exr_context_t f, exr_context_t testf, const exr_chunk_info_t& cinfo,
+    const exr_chunk_info_t& tinfo)
+{
+    EXRCORE_TEST (cinfo.packed_size == tinfo.packed_size);
+    EXRCORE_TEST (cinfo.start_x == tinfo.start_x);
+    EXRCORE_TEST (cinfo.start_y == tinfo.start_y);
+
+    std::vector<uint8_t> a (cinfo.packed_size), b (tinfo.packed_size);
+    EXRCORE_TEST_RVAL (exr_read_chunk (f, 0, &cinfo, a.data ()));
+    EXRCORE_TEST_RVAL (exr_read_chunk (testf, 0, &tinfo, b.data ()));
+    EXRCORE_TEST (a == b);
+}
+
+static void
+copyChunks (
+    const std::string& fn,
+    const std::string& outfn,
+    exr_storage_t      storage,
+    uint64_t           bufsize)
+{
+    exr_context_t             f, outf, testf;
+    int                       partidx;
+    int32_t                   chunks, outchunks;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_start_write (
+        &outf, outfn.c_str (), EXR_WRITE_FILE_DIRECTLY, &cinit));
+    EXRCORE_TEST_RVAL (exr_add_part (outf, "copy", storage, &partidx));
+    EXRCORE_TEST (partidx == 0);
+    EXRCORE_TEST_RVAL (exr_copy_unset_attributes (outf, 0, f, 0));
+
+    // a header edit must not stop the chunks from being copied verbatim
+    EXRCORE_TEST_RVAL (exr_attr_set_string (outf, 0, "owner", "copyChunks"));
+
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_HEADER_NOT_WRITTEN, exr_copy_chunks (f, 0, outf, 0, bufsize));
+    EXRCORE_TEST_RVAL (exr_write_header (outf));
+    EXRCORE_TEST_RVAL (exr_copy_chunks (f, 0, outf, 0, bufsize));
+    EXRCORE_TEST_RVAL (exr_finish (&outf));
+
+    EXRCORE_TEST_RVAL (exr_start_read (&testf, outfn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_get_chunk_count (f, 0, &chunks));
+    EXRCORE_TEST_RVAL (exr_get_chunk_count (testf, 0, &outchunks));
+    EXRCORE_TEST (chunks == outchunks);
+
+    exr_attr_box2i_t dw;
+    EXRCORE_TEST_RVAL (exr_get_data_window (f, 0, &dw));
+
+    if (storage == EXR_STORAGE_TILED)
+    {
+        int32_t tw, th;
+        EXRCORE_TEST_RVAL (exr_get_tile_sizes (f, 0, 0, 0, &tw, &th));
+
+        for (int32_t ty = 0; dw.min.y + ty * th <= dw.max.y; ++ty)
+        {
+            for (int32_t tx = 0; dw.min.x + tx * tw <= dw.max.x; ++tx)
+            {
+                exr_chunk_info_t cinfo, tinfo;
+                EXRCORE_TEST_RVAL (
+                    exr_read_tile_chunk_info (f, 0, tx, ty, 0, 0, &cinfo));
+                EXRCORE_TEST_RVAL (exr_read_tile_chunk_info (
+                    testf, 0, tx, ty, 0, 0, &tinfo));
+                compareChunk (f, testf, cinfo, tinfo);
+            }
+        }
+    }
+    else
+    {
+        int32_t lpc;
+        EXRCORE_TEST_RVAL (exr_get_scanlines_per_chunk (f, 0, &lpc));
+
+        for (int32_t y = dw.min.y; y <= dw.max.y; y += lpc)
+        {
+            exr_chunk_info_t cinfo, tinfo;
+            EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (f, 0, y, &cinfo));
+            EXRCORE_TEST_RVAL (
+                exr_read_scanline_chunk_info (testf, 0, y, &tinfo));
+            compareChunk (f, testf, cinfo, tinfo);
+        }
+    }
+
+    EXRCORE_TEST_RVAL (exr_finish (&testf));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+    remove (outfn.c_str ());
+}
+
+void
+testCopyChunks (const std::string& tempdir)
+{
+    std::string dir   = ILM_IMF_TEST_IMAGEDIR;
+    std::string outfn = tempdir + "testcopychunks.exr";
+
+    // a small buffer forces many refills, a large one holds the whole file
+    for (uint64_t bufsize: {uint64_t (1024), uint64_t (0)})
+    {
+        copyChunks (
+            dir + "v1.7.test.tiled.exr", outfn, EXR_STORAGE_TILED, bufsize);
+        copyChunks (dir + "comp_zip.exr", outfn, EXR_STORAGE_SCANLINE, bufsize);
+        copyChunks (
+            dir + "lineOrder_decreasing.exr",
+            outfn,
+            EXR_STORAGE_SCANLINE,
+            bufsize);
+    }
+}
+
+struct EncodeFrame
+{
+    static const int width  = 38;
+    static const int height = 96;
+    static const int ymin   = -6;
+
+    // A and B are full resolution, C is sampled every other line
+    std::vector<uint16_t> a, c;
+    std::vector<float>    b;
+
+    EncodeFrame ()
+        : a (width * height), c (width * height / 2), b (width * height)
+    {}
+};
+
+static void
+fillFrame (EncodeFrame& frame)
+{
+    for (size_t i = 0; i < frame.a.size (); ++i)
+    {
+        frame.a[i] = (uint16_t) ((i * 7) & 0x3bff);
+        frame.b[i] = (float) i * 0.25f;
+    }
+    for (size_t i = 0; i < frame.c.size (); ++i)
+        frame.c[i] = (uint16_t) ((i * 13) & 0x3bff);
+}
+
+static void
+submitThread (void* data, void (*task_fn) (void*), void* task_data)
+{
+    std::vector<std::thread>* threads = (std::vector<std::thread>*) data;
+    threads->emplace_back (task_fn, task_data);
+}
+
+static void
+encodeFrame (
+    const std::string& outfn,
+    exr_compression_t  comp,
+    const EncodeFrame& frame,
+    int                workers,
+    int                inflight,
+    bool               submit)
+{
+    exr_context_t             outf;
+    int                       partidx;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+
+    EXRCORE_TEST_RVAL (exr_start_write (
+        &outf, outfn.c_str (), EXR_WRITE_FILE_DIRECTLY, &cinit));
+    EXRCORE_TEST_RVAL (
+        exr_add_part (outf, "encode", EXR_STORAGE_SCANLINE, &partidx));
+    EXRCORE_TEST_RVAL (exr_initialize_required_attr_simple (
+        outf, partidx, EncodeFrame::width, EncodeFrame::height, comp));
+
+    exr_attr_box2i_t dw = {
+        {0, EncodeFrame::ymin},
+        {EncodeFrame::width - 1, EncodeFrame::ymin + EncodeFrame::height - 1}};
+    EXRCORE_TEST_RVAL (exr_set_data_window (outf, partidx, &dw));
+    EXRCORE_TEST_RVAL (exr_add_channel (
+        outf, partidx, "A", EXR_PIXEL_HALF, EXR_PERCEPTUALLY_LOGARITHMIC, 1, 1));
+    EXRCORE_TEST_RVAL (exr_add_channel (
+        outf, partidx, "B", EXR_PIXEL_FLOAT, EXR_PERCEPTUALLY_LINEAR, 1, 1));
+    EXRCORE_TEST_RVAL (exr_add_channel (
+        outf, partidx, "C", EXR_PIXEL_HALF, EXR_PERCEPTUALLY_LOGARITHMIC, 1, 2));
+    EXRCORE_TEST_RVAL (exr_write_header (outf));
+
+    exr_frame_channel_t chans[3] = {
+        {"C",
+         (const uint8_t*) frame.c.data (),
+         2,
+         2 * EncodeFrame::width,
+         2,
+         EXR_PIXEL_HALF},
+        {"A",
+         (const uint8_t*) frame.a.data (),
+         2,
+         2 * EncodeFrame::width,
+         2,
+         EXR_PIXEL_HALF},
+        {"B",
+         (const uint8_t*) frame.b.data (),
+         4,
+         4 * EncodeFrame::width,
+         4,
+         EXR_PIXEL_FLOAT}};
+
+    // every channel must be provided
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT,
+        exr_encode_chunks (outf, partidx, chans + 1, 2, 0, 0, NULL, NULL));
+
+    std::vector<std::thread> threads;
+    EXRCORE_TEST_RVAL (exr_encode_chunks (
+        outf,
+        partidx,
+        chans,
+        3,
+        workers,
+        inflight,
+        submit ? &submitThread : NULL,
+        &threads));
+    for (auto& t: threads)
+        t.join ();
+    EXRCORE_TEST_RVAL (exr_finish (&outf));
+}
+
+static void
+decodeFrame (const std::string& fn, EncodeFrame& frame)
+{
+    exr_context_t             f;
+    exr_decode_pipeline_t     decoder = EXR_DECODE_PIPELINE_INITIALIZER;
+    exr_attr_box2i_t          dw;
+    int32_t                   lpc;
+    bool                      first = true;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_get_data_window (f, 0, &dw));
+    EXRCORE_TEST_RVAL (exr_get_scanlines_per_chunk (f, 0, &lpc));
+
+    for (int y = dw.min.y; y <= dw.max.y; y += lpc)
+    {
+        exr_chunk_info_t cinfo;
+        EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (f, 0, y, &cinfo));
+        if (first)
+        {
+            EXRCORE_TEST_RVAL (
+                exr_decoding_initialize (f, 0, &cinfo, &decoder));
+        }
+        else
+        {
+            EXRCORE_TEST_RVAL (exr_decoding_update (f, 0, &cinfo, &decoder));
+        }
+
+        for (int c = 0; c < decoder.channel_count; ++c)
+        {
+            exr_coding_channel_info_t& curchan = decoder.channels[c];
+            int      ys  = curchan.y_samples;
+            int      row = (y - dw.min.y + ys - 1) / ys;
+            uint8_t* ptr;
+
+            if (curchan.height == 0)
+            {
+                curchan.decode_to_ptr = NULL;
+                continue;
+            }
+            if (!strcmp (curchan.channel_name, "A"))
+                ptr = (uint8_t*) (frame.a.data () + row * EncodeFrame::width);
+            else if (!strcmp (curchan.channel_name, "B"))
+                ptr = (uint8_t*) (frame.b.data () + row * EncodeFrame::width);
+            else
+                ptr = (uint8_t*) (frame.c.data () + row * EncodeFrame::width);
+
+            curchan.decode_to_ptr     = ptr;
+            curchan.user_pixel_stride = curchan.user_bytes_per_element;
+            curchan.user_line_stride =
+                curchan.user_bytes_per_element * EncodeFrame::width;
+        }
+
+        if (first)
+        {
+            EXRCORE_TEST_RVAL (
+                exr_decoding_choose_default_routines (f, 0, &decoder));
+        }
+        EXRCORE_TEST_RVAL (exr_decoding_run (f, 0, &decoder));
+        first = false;
+    }
+    EXRCORE_TEST_RVAL (exr_decoding_destroy (f, &decoder));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+}
+
+void
+testEncodeChunks (const std::string& tempdir)
+{
+    std::string outfn = tempdir + "testencodechunks.exr";
+    EncodeFrame frame;
+
+    fillFrame (frame);
+
+    for (exr_compression_t comp:
+         {EXR_COMPRESSION_NONE, EXR_COMPRESSION_RLE, EXR_COMPRESSION_PIZ})
+    {
+        // serial, internal workers with a small and the default window,
+        // and tasks handed to a caller supplied pool
+        for (int mode = 0; mode < 4; ++mode)
+        {
+            EncodeFrame back;
+
+            encodeFrame (
+                outfn,
+                comp,
+                frame,
+                mode == 0 ? 0 : 3,
+                mode == 1 ? 2 : 0,
+                mode == 3);
+            decodeFrame (outfn, back);
+            EXRCORE_TEST (back.a == frame.a);
+            EXRCORE_TEST (back.b == frame.b);
+            EXRCORE_TEST (back.c == frame.c);
+        }
+    }
+    remove (outfn.c_str ());
+}
@@ -22,5 +22,7 @@ void testUpdateMeta (const std::string& tempdir);
 void testWriteScans (const std::string& tempdir);
 void testWriteTiles (const std::string& tempdir);
 void testWriteMultiPart (const std::string& tempdir);
+void testCopyChunks (const std::string& tempdir);
+void testEncodeChunks (const std::string& tempdir);
 
 #endif // OPENEXR_CORE_TEST_WRITE_H
@@ -28,6 +28,7 @@
 #include "testDeepScanLineHuge.h"
 #include "testDeepScanLineMultipleRead.h"
 #include "testDeepTiledBasic.h"
+#include "testDwaCompression.h"
 #include "testDwaCompressorSimd.h"
 #include "testDwaLookups.h"
 #include "testExistingStreams.h"
@@ -192,6 +193,7 @@ main (int argc, char* argv[])
     TEST (testLineOrder, "basic");
     TEST (testCompression, "basic");
     TEST (testHTCompression, "basic");
+    TEST (testDwaCompression, "basic");
     TEST (testCopyPixels, "basic");
     TEST (testLut, "basic");
     TEST (testSampleImages, "basic");
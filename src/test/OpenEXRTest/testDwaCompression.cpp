@@ -0,0 +1,305 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <IlmThread.h>
+#include <ImathRandom.h>
+#include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfOutputFile.h>
+#include <ImfThreading.h>
+#include <half.h>
+
+#include <assert.h>
+#include <fstream>
+#include <iterator>
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace IMF = OPENEXR_IMF_NAMESPACE;
+using namespace IMF;
+using namespace std;
+using namespace IMATH_NAMESPACE;
+
+namespace
+{
+
+//
+// One channel of each kind the DWA compressor handles: two complete
+// CSC sets, a lone LOSSY_DCT channel, an RLE channel and UNKNOWN
+// channels of all three pixel types. Each group is coded as its own
+// job when threads are available.
+//
+
+const char* halfChannels[] = {
+    "R", "G", "B", "left.R", "left.G", "left.B", "Y", "A", "mask"};
+const int numHalfChannels = sizeof (halfChannels) / sizeof (halfChannels[0]);
+
+struct Pixels
+{
+    std::vector<Array2D<half>> h;
+    Array2D<float>             f;
+    Array2D<unsigned int>      ui;
+
+    Pixels (int height, int width)
+        : h (numHalfChannels), f (height, width), ui (height, width)
+    {
+        for (int c = 0; c < numHalfChannels; ++c)
+            h[c].resizeErase (height, width);
+    }
+};
+
+void
+fillPixels (Pixels& pixels, int width, int height)
+{
+    Rand48 rand (0);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            //
+            // Smooth gradients with some noise, so that the DCT
+            // channels produce both zero and non-zero AC values.
+            //
+
+            for (int c = 0; c < numHalfChannels; ++c)
+            {
+                float v = 0.5f + 0.4f * sinf (x * 0.07f + c) *
+                                     cosf (y * 0.05f - c);
+                pixels.h[c][y][x] = v + rand.nextf (-0.02, 0.02);
+            }
+
+            pixels.h[7][y][x] = ((x / 13 + y / 7) & 1) ? 1.0f : 0.0f;
+            pixels.f[y][x]    = rand.nextf (-1000, 1000);
+            pixels.ui[y][x]   = rand.nexti ();
+        }
+    }
+}
+
+FrameBuffer
+frameBuffer (Pixels& pixels, int width, const Box2i& dw)
+{
+    FrameBuffer fb;
+    int         offset = -dw.min.x - dw.min.y * width;
+
+    for (int c = 0; c < numHalfChannels; ++c)
+    {
+        fb.insert (
+            halfChannels[c],
+            Slice (
+                HALF,
+                (char*) (&pixels.h[c][0][0] + offset),
+                sizeof (half),
+                sizeof (half) * width));
+    }
+
+    fb.insert (
+        "Z",
+        Slice (
+            FLOAT,
+            (char*) (&pixels.f[0][0] + offset),
+            sizeof (float),
+            sizeof (float) * width));
+
+    fb.insert (
+        "id",
+        Slice (
+            UINT,
+            (char*) (&pixels.ui[0][0] + offset),
+            sizeof (unsigned int),
+            sizeof (unsigned int) * width));
+
+    return fb;
+}
+
+void
+writeFile (
+    Pixels&            pixels,
+    const Header&      header,
+    const std::string& fileName,
+    int                fileThreads)
+{
+    const Box2i& dw    = header.dataWindow ();
+    int          width = dw.max.x - dw.min.x + 1;
+    int          height = dw.max.y - dw.min.y + 1;
+
+    OutputFile out (fileName.c_str (), header, fileThreads);
+    out.setFrameBuffer (frameBuffer (pixels, width, dw));
+    out.writePixels (height);
+}
+
+void
+readFile (Pixels& pixels, const std::string& fileName, int fileThreads)
+{
+    InputFile    in (fileName.c_str (), fileThreads);
+    const Box2i& dw = in.header ().dataWindow ();
+
+    in.setFrameBuffer (frameBuffer (pixels, dw.max.x - dw.min.x + 1, dw));
+    in.readPixels (dw.min.y, dw.max.y);
+}
+
+std::vector<char>
+fileContents (const std::string& fileName)
+{
+    std::ifstream ifs (fileName.c_str (), std::ios::binary);
+    return std::vector<char> (
+        (std::istreambuf_iterator<char> (ifs)),
+        std::istreambuf_iterator<char> ());
+}
+
+void
+comparePixels (const Pixels& a, const Pixels& b, int width, int height)
+{
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            for (int c = 0; c < numHalfChannels; ++c)
+                assert (a.h[c][y][x].bits () == b.h[c][y][x].bits ());
+
+            assert (a.f[y][x] == b.f[y][x]);
+            assert (a.ui[y][x] == b.ui[y][x]);
+        }
+    }
+}
+
+void
+compareLossless (const Pixels& a, const Pixels& b, int width, int height)
+{
+    //
+    // The RLE and UNKNOWN channels must survive the round trip exactly.
+    //
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            assert (a.h[7][y][x].bits () == b.h[7][y][x].bits ());
+            assert (a.h[8][y][x].bits () == b.h[8][y][x].bits ());
+            assert (a.f[y][x] == b.f[y][x]);
+            assert (a.ui[y][x] == b.ui[y][x]);
+        }
+    }
+}
+
+void
+writeRead (
+    Pixels&            pixels,
+    const std::string& tempDir,
+    int                width,
+    int                height,
+    Compression        comp,
+    int                numThreads)
+{
+    cout << "compression " << comp << ", " << numThreads << " threads"
+         << endl;
+
+    Header header (
+        Box2i (V2i (-3, 5), V2i (width - 4, height + 4)),
+        Box2i (V2i (-3, 5), V2i (width - 4, height + 4)),
+        1,
+        V2f (0, 0),
+        1,
+        INCREASING_Y,
+        comp);
+
+    for (int c = 0; c < numHalfChannels; ++c)
+        header.channels ().insert (halfChannels[c], Channel (HALF));
+
+    header.channels ().insert ("Z", Channel (FLOAT));
+    header.channels ().insert ("id", Channel (UINT));
+
+    std::string serialName   = tempDir + "imf_test_dwa_serial.exr";
+    std::string threadedName = tempDir + "imf_test_dwa_threaded.exr";
+
+    //
+    // Reference: everything on the calling thread.
+    //
+
+    setGlobalThreadCount (0);
+    writeFile (pixels, header, serialName, 0);
+
+    Pixels serial (height, width);
+    readFile (serial, serialName, 0);
+    compareLossless (pixels, serial, width, height);
+
+    std::vector<char> serialBytes = fileContents (serialName);
+
+    setGlobalThreadCount (numThreads);
+
+    //
+    // The channel groups of a chunk are coded in parallel, even when
+    // the file itself does not use the thread pool for line buffers.
+    // Either way the output must not change.
+    //
+
+    for (int fileThreads = 0; fileThreads <= numThreads;
+         fileThreads += numThreads)
+    {
+        writeFile (pixels, header, threadedName, fileThreads);
+        assert (fileContents (threadedName) == serialBytes);
+
+        Pixels threaded (height, width);
+        readFile (threaded, serialName, fileThreads);
+        comparePixels (serial, threaded, width, height);
+    }
+
+    remove (serialName.c_str ());
+    remove (threadedName.c_str ());
+}
+
+} // namespace
+
+void
+testDwaCompression (const std::string& tempDir)
+{
+    try
+    {
+        cout << "Testing threaded DWA compression" << endl;
+
+        if (!ILMTHREAD_NAMESPACE::supportsThreads ())
+        {
+            cout << "threading not supported, skipped\n" << endl;
+            return;
+        }
+
+        int savedThreads = globalThreadCount ();
+
+        //
+        // A width and height that are not multiples of the DCT block
+        // size, and enough lines for a partial last chunk.
+        //
+
+        const int W = 203;
+        const int H = 77;
+
+        Pixels pixels (H, W);
+        fillPixels (pixels, W, H);
+
+        for (int n = 1; n <= 4; n *= 2)
+        {
+            writeRead (pixels, tempDir, W, H, DWAA_COMPRESSION, n);
+            writeRead (pixels, tempDir, W, H, DWAB_COMPRESSION, n);
+        }
+
+        setGlobalThreadCount (savedThreads);
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
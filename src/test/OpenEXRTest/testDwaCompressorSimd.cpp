@@ -329,6 +329,25 @@ testDct ()
         INVERSE_DCT_SCALAR_TEST_N (dctInverse8x8_avx, 6, "2x8")
         INVERSE_DCT_SCALAR_TEST_N (dctInverse8x8_avx, 7, "1x8")
     }
+
+#ifdef IMF_HAVE_AVX2_DISPATCH
+    if (hasAvx2 ())
+    {
+        cout << "      Forward, AVX2" << endl;
+        for (int iter = 0; iter < numIter; ++iter)
+        {
+            for (int i = 0; i < 64; ++i)
+            {
+                orig._buffer[i] = test._buffer[i] = rand48.nextf ();
+            }
+
+            dctForward8x8 (orig._buffer);
+            dctForward8x8_avx2 (test._buffer);
+
+            compareBuffer (orig, test, 0);
+        }
+    }
+#endif
 }
 
 //
@@ -23,6 +23,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 
 #ifdef _WIN32
 #else
@@ -276,7 +277,8 @@ writeReadScanLines (
     // existing StdIFStream, and compare the pixels
     // with the original data.  Then read the image
     // back a second time using a memory-mapped
-    // MMIFStream (see above).
+    // MMIFStream (see above), and a third time using
+    // the library's MMapIStream.
     //
 
     cout << "scan-line based file:" << endl;
@@ -366,6 +368,81 @@ writeReadScanLines (
         }
     }
 
+    {
+        //
+        // readAt() must not move the stream, and must agree
+        // between the file-based and the memory-mapped stream.
+        //
+
+        cout << ", positional reads";
+        StdIFStream sfs (fileName);
+        MMapIStream mfs (fileName);
+        assert (sfs.isStatelessRead () && mfs.isStatelessRead ());
+
+        char a[8], b[8], magic[4];
+        sfs.readAt (4, a, sizeof (a));
+        mfs.readAt (4, b, sizeof (b));
+        assert (memcmp (a, b, sizeof (a)) == 0);
+        assert (sfs.tellg () == 0 && mfs.tellg () == 0);
+
+        sfs.read (magic, sizeof (magic));
+        assert (magic[0] == 0x76 && magic[1] == 0x2f);
+        assert (magic[2] == 0x31 && magic[3] == 0x01);
+
+        bool caught = false;
+        try
+        {
+            mfs.readAt (uint64_t (1) << 40, a, sizeof (a));
+        }
+        catch (const IEX_NAMESPACE::InputExc&)
+        {
+            caught = true;
+        }
+        assert (caught);
+
+        caught = false;
+        try
+        {
+            sfs.readAt (uint64_t (1) << 40, a, sizeof (a));
+        }
+        catch (const IEX_NAMESPACE::InputExc&)
+        {
+            caught = true;
+        }
+        assert (caught);
+    }
+
+    {
+        cout << ", reading (MMapIStream)";
+        MMapIStream   ifs (fileName);
+        RgbaInputFile in (ifs);
+
+        const Box2i& dw = in.dataWindow ();
+        int          w  = dw.max.x - dw.min.x + 1;
+        int          h  = dw.max.y - dw.min.y + 1;
+        int          dx = dw.min.x;
+        int          dy = dw.min.y;
+
+        Array2D<Rgba> p2 (h, w);
+        in.setFrameBuffer (&p2[-dy][-dx], 1, w);
+        in.readPixels (dw.min.y, dw.max.y);
+
+        if (!isLossyCompression (compression))
+        {
+            cout << ", comparing";
+            for (int y = 0; y < h; ++y)
+            {
+                for (int x = 0; x < w; ++x)
+                {
+                    assert (p2[y][x].r == p1[y][x].r);
+                    assert (p2[y][x].g == p1[y][x].g);
+                    assert (p2[y][x].b == p1[y][x].b);
+                    assert (p2[y][x].a == p1[y][x].a);
+                }
+            }
+        }
+    }
+
     cout << endl;
 
     remove (fileName);
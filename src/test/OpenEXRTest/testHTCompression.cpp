@@ -18,12 +18,15 @@
 #include <ImfHeader.h>
 #include <ImfInputFile.h>
 #include <ImfOutputFile.h>
+#include <ImfStandardAttributes.h>
 #include <ImfTiledOutputFile.h>
 #include <half.h>
 
 #include <algorithm>
 #include <assert.h>
 #include <limits>
+#include <memory>
+#include <vector>
 #include <stdio.h>
 
 namespace IMF = OPENEXR_IMF_NAMESPACE;
@@ -135,7 +138,8 @@ writeRead (
     const char  fileName[],
     int         width,
     int         height,
-    Compression comp)
+    Compression comp,
+    const Header* attributes = 0)
 {
 
     //
@@ -159,6 +163,18 @@ writeRead (
     hdr.compression ()         = comp;
     hdr.zipCompressionLevel () = 4;
 
+    if (attributes)
+    {
+        // only the attributes that a default header does not have
+        for (Header::ConstIterator i = attributes->begin ();
+             i != attributes->end ();
+             ++i)
+        {
+            if (hdr.find (i.name ()) == hdr.end ())
+                hdr.insert (i.name (), i.attribute ());
+        }
+    }
+
     static const char* channels[] = {"R", "G", "B", "A", "H"};
 
     for (int c = 0; c < 5; ++c)
@@ -300,6 +316,84 @@ writeRead (
                             decoded_array.rgba[c][y][x].bits ());
                     }
                 }
+                else
+                {
+                    //
+                    // Lossy HT clamps to +/- infinity, so finite
+                    // values never decode to NaN
+                    //
+
+                    assert (
+                        !ref_array.h[y][x].isFinite () ||
+                        !decoded_array.h[y][x].isNan ());
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        assert (
+                            !ref_array.rgba[c][y][x].isFinite () ||
+                            !decoded_array.rgba[c][y][x].isNan ());
+                    }
+                }
+            }
+        }
+    }
+
+    {
+        //
+        // Read a few scan lines from the middle of the image, then
+        // the rest, to exercise partial decoding of a chunk.
+        //
+
+        cout << " partial" << flush;
+        InputFile in (fileName);
+
+        const Box2i& dw = in.header ().dataWindow ();
+        int          w  = dw.max.x - dw.min.x + 1;
+        int          h  = dw.max.y - dw.min.y + 1;
+        int          y0 = dw.min.y + h / 2;
+        int          y1 = std::min (y0 + 20, dw.max.y);
+
+        pixelArray  decoded_array (h, w);
+        FrameBuffer fb;
+
+        fb.insert (
+            "H",
+            Slice (
+                IMF::HALF,
+                (char*) &decoded_array.h[-dw.min.y][-dw.min.x],
+                sizeof (decoded_array.h[0][0]),
+                sizeof (decoded_array.h[0][0]) * w));
+
+        for (int c = 0; c < 4; ++c)
+        {
+            fb.insert (
+                channels[c],
+                Slice (
+                    IMF::HALF,
+                    (char*) &decoded_array.rgba[c][-dw.min.y][-dw.min.x],
+                    sizeof (decoded_array.rgba[c][0][0]),
+                    sizeof (decoded_array.rgba[c][0][0]) * w));
+        }
+
+        in.setFrameBuffer (fb);
+        in.readPixels (y0, y1);
+        in.readPixels (dw.min.y, dw.max.y);
+
+        for (int y = 0; y < h; ++y)
+        {
+            for (int x = 0; x < w; ++x)
+            {
+                if (!isLossyCompression (comp))
+                {
+                    assert (
+                        ref_array.h[y][x].bits () ==
+                        decoded_array.h[y][x].bits ());
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        assert (
+                            ref_array.rgba[c][y][x].bits () ==
+                            decoded_array.rgba[c][y][x].bits ());
+                    }
+                }
             }
         }
     }
@@ -318,6 +412,560 @@ writeRead (
     writeRead (array, filename.c_str (), w, h, HT256_COMPRESSION);
     writeRead (array, filename.c_str (), w, h, HTK_COMPRESSION);
     writeRead (array, filename.c_str (), w, h, HTK256_COMPRESSION);
+    writeRead (array, filename.c_str (), w, h, HT_LOSSY_COMPRESSION);
+    writeRead (array, filename.c_str (), w, h, HT_STRIPED_COMPRESSION);
+}
+
+void
+writeReadCodingParameters (
+    const std::string& tempDir, pixelArray& array, int w, int h)
+{
+    std::string filename = tempDir + "imf_test_comp.exr";
+
+    static const char* orders[] = {"LRCP", "RLCP", "RPCL", "PCRL", "CPRL"};
+    static const V2i   blocks[] = {
+        V2i (64, 64), V2i (32, 128), V2i (128, 32), V2i (16, 16), V2i (256, 16)};
+
+    for (int i = 0; i < 5; ++i)
+    {
+        Header attributes;
+
+        addHtDecompositionLevels (attributes, i);
+        addHtCodeBlockSize (attributes, blocks[i]);
+        addHtProgressionOrder (attributes, orders[i]);
+        if (i % 2) addHtPrecinctSize (attributes, V2i (128, 64));
+
+        cout << "levels " << i << ", " << orders[i] << ", ";
+        writeRead (array, filename.c_str (), w, h, HT_COMPRESSION, &attributes);
+    }
+
+    Header attributes;
+    addHtCodeBlockSize (attributes, V2i (128, 128));
+
+    try
+    {
+        cout << "invalid code block size " << flush;
+        writeRead (array, filename.c_str (), w, h, HT_COMPRESSION, &attributes);
+        assert (false);
+    }
+    catch (const IEX_NAMESPACE::ArgExc&)
+    {
+        cout << "rejected" << endl;
+    }
+
+    remove (filename.c_str ());
+}
+
+//
+// Write a constant image and a varying image, and read them back at
+// every resolution level.  A constant image stays constant, bit for
+// bit, in the low pass bands of the reversible wavelet, and level 0
+// is the image itself.
+//
+
+void
+writeReadReduced (
+    const std::string& tempDir, pixelArray& array, int w, int h, int dx, int dy)
+{
+    std::string filename = tempDir + "imf_test_comp.exr";
+
+    static const char* channels[] = {"R", "G", "B", "H"};
+
+    const half constant = 0.5f;
+    const half sentinel = -7.f;
+
+    for (int constantImage = 0; constantImage < 2; ++constantImage)
+    {
+        static const Compression comps[] = {
+            HT_COMPRESSION, HT256_COMPRESSION, HT_STRIPED_COMPRESSION};
+
+        for (int comp = 0; comp < 3; ++comp)
+        {
+            Header hdr (
+                Box2i (V2i (0, 0), V2i (w - 1, h - 1)),
+                Box2i (V2i (dx, dy), V2i (dx + w - 1, dy + h - 1)));
+
+            hdr.compression () = comps[comp];
+
+            for (int c = 0; c < 4; ++c)
+                hdr.channels ().insert (channels[c], Channel (IMF::HALF));
+
+            {
+                Array2D<half> pixels (h, w);
+
+                for (int y = 0; y < h; ++y)
+                    for (int x = 0; x < w; ++x)
+                        pixels[y][x] =
+                            constantImage ? constant : array.h[y][x];
+
+                FrameBuffer fb;
+
+                for (int c = 0; c < 4; ++c)
+                {
+                    fb.insert (
+                        channels[c],
+                        Slice::Make (
+                            IMF::HALF,
+                            &pixels[0][0],
+                            hdr.dataWindow (),
+                            sizeof (half),
+                            sizeof (half) * w));
+                }
+
+                remove (filename.c_str ());
+
+                OutputFile out (filename.c_str (), hdr);
+                out.setFrameBuffer (fb);
+                out.writePixels (h);
+            }
+
+            InputFile in (filename.c_str ());
+
+            for (int level = 0; level <= 5; ++level)
+            {
+                cout << "compression " << hdr.compression () << ", level "
+                     << level << endl;
+
+                int rw = (w + (1 << level) - 1) >> level;
+                int rh = (h + (1 << level) - 1) >> level;
+
+                //
+                // One pixel of margin on each side must stay untouched,
+                // and channel "Z", not in the file, must be filled.
+                //
+
+                Array2D<half> pixels (rh + 2, rw + 2);
+                Array2D<float> filled (rh, rw);
+
+                for (int y = 0; y < rh + 2; ++y)
+                    for (int x = 0; x < rw + 2; ++x)
+                        pixels[y][x] = sentinel;
+
+                FrameBuffer fb;
+
+                fb.insert (
+                    "H",
+                    Slice::Make (
+                        IMF::HALF,
+                        &pixels[1][1],
+                        Box2i (V2i (dx, dy), V2i (dx + rw - 1, dy + rh - 1)),
+                        sizeof (half),
+                        sizeof (half) * (rw + 2)));
+
+                fb.insert (
+                    "Z",
+                    Slice::Make (
+                        IMF::FLOAT,
+                        &filled[0][0],
+                        Box2i (V2i (dx, dy), V2i (dx + rw - 1, dy + rh - 1)),
+                        sizeof (float),
+                        sizeof (float) * rw,
+                        1,
+                        1,
+                        3.0));
+
+                in.setFrameBuffer (fb);
+                in.readPixelsReduced (level);
+
+                for (int y = 0; y < rh + 2; ++y)
+                {
+                    for (int x = 0; x < rw + 2; ++x)
+                    {
+                        bool inside =
+                            y > 0 && y <= rh && x > 0 && x <= rw;
+
+                        if (!inside)
+                            assert (
+                                pixels[y][x].bits () == sentinel.bits ());
+                        else if (constantImage)
+                            assert (
+                                pixels[y][x].bits () == constant.bits ());
+                        else if (level == 0)
+                            assert (
+                                pixels[y][x].bits () ==
+                                array.h[y - 1][x - 1].bits ());
+
+                        if (inside) assert (filled[y - 1][x - 1] == 3.f);
+                    }
+                }
+            }
+        }
+    }
+
+    //
+    // Levels beyond the number of decomposition levels, and parts
+    // compressed with something other than HT, can not be read at
+    // a reduced resolution.
+    //
+
+    for (int i = 0; i < 2; ++i)
+    {
+        Header hdr (w, h);
+
+        hdr.compression () = i ? ZIP_COMPRESSION : HT_COMPRESSION;
+        hdr.channels ().insert ("H", Channel (IMF::HALF));
+        addHtDecompositionLevels (hdr, 2);
+
+        {
+            FrameBuffer fb;
+
+            fb.insert (
+                "H",
+                Slice (
+                    IMF::HALF,
+                    (char*) &array.h[0][0],
+                    sizeof (half),
+                    sizeof (half) * w));
+
+            remove (filename.c_str ());
+
+            OutputFile out (filename.c_str (), hdr);
+            out.setFrameBuffer (fb);
+            out.writePixels (h);
+        }
+
+        InputFile     in (filename.c_str ());
+        Array2D<half> pixels (h, w);
+        FrameBuffer   fb;
+
+        fb.insert (
+            "H",
+            Slice (
+                IMF::HALF,
+                (char*) &pixels[0][0],
+                sizeof (half),
+                sizeof (half) * w));
+
+        in.setFrameBuffer (fb);
+
+        try
+        {
+            cout << "compression " << hdr.compression ()
+                 << ", unsupported level " << flush;
+            in.readPixelsReduced (3);
+            assert (false);
+        }
+        catch (const IEX_NAMESPACE::BaseExc&)
+        {
+            cout << "rejected" << endl;
+        }
+    }
+
+    remove (filename.c_str ());
+}
+
+//
+// Compress one full frame chunk and uncompress a few lines of it.
+// HT_STRIPED_COMPRESSION only decodes the stripe that holds them;
+// an HT_COMPRESSION chunk is a single codestream, decoded in full.
+//
+
+void
+uncompressLines (pixelArray& array, int w, int h, int dx, int dy)
+{
+    static const Compression comps[] = {
+        HT_COMPRESSION, HT_STRIPED_COMPRESSION};
+
+    for (int i = 0; i < 2; ++i)
+    {
+        Header hdr (
+            Box2i (V2i (0, 0), V2i (w - 1, h - 1)),
+            Box2i (V2i (dx, dy), V2i (dx + w - 1, dy + h - 1)));
+
+        hdr.compression () = comps[i];
+        hdr.channels ().insert ("H", Channel (IMF::HALF));
+
+        cout << "compression " << hdr.compression () << ", uncompress lines"
+             << flush;
+
+        std::unique_ptr<Compressor> compressor (
+            newCompressor (comps[i], w * sizeof (half), hdr));
+
+        assert (compressor->numScanLines () >= h);
+
+        const char* compressed;
+        int         compressedSize = compressor->compress (
+            (const char*) &array.h[0][0], w * h * sizeof (half), dy, compressed);
+
+        std::vector<char> data (compressed, compressed + compressedSize);
+
+        std::unique_ptr<Compressor> decompressor (
+            newCompressor (comps[i], w * sizeof (half), hdr));
+
+        int         lineMin = dy + 300;
+        int         lineMax = dy + 310;
+        const char* uncompressed;
+        int         uncompressedSize = decompressor->uncompressLines (
+            data.data (),
+            static_cast<int> (data.size ()),
+            dy,
+            lineMin,
+            lineMax,
+            uncompressed);
+
+        assert (uncompressedSize == static_cast<int> (w * h * sizeof (half)));
+
+        if (comps[i] == HT_STRIPED_COMPRESSION)
+        {
+            assert (lineMin == dy + 256);
+            assert (lineMax == dy + 511);
+        }
+        else
+        {
+            assert (lineMin == dy);
+            assert (lineMax == dy + h - 1);
+        }
+
+        const half* lines = (const half*) uncompressed;
+
+        for (int y = lineMin - dy; y <= lineMax - dy; ++y)
+            for (int x = 0; x < w; ++x)
+                assert (lines[y * w + x].bits () == array.h[y][x].bits ());
+
+        cout << endl;
+    }
+}
+
+//
+// Compress every chunk of two images, and then of the first one again,
+// with a single compressor, and uncompress them all with another one.
+// Nothing a compressor keeps from one chunk to the next may leak into
+// the next chunk: the second pass over the first image must produce
+// the same bytes as the first pass.
+//
+
+void
+reuseCompressor (pixelArray& array1, pixelArray& array2, int w, int h)
+{
+    static const Compression comps[] = {
+        HT_COMPRESSION, HT256_COMPRESSION, HT_STRIPED_COMPRESSION};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        Header hdr (
+            Box2i (V2i (0, 0), V2i (w - 1, h - 1)),
+            Box2i (V2i (0, 0), V2i (w - 1, h - 1)));
+
+        hdr.compression () = comps[i];
+        hdr.channels ().insert ("H", Channel (IMF::HALF));
+
+        cout << "compression " << hdr.compression () << ", reuse compressor"
+             << flush;
+
+        std::unique_ptr<Compressor> compressor (
+            newCompressor (comps[i], w * sizeof (half), hdr));
+
+        std::unique_ptr<Compressor> decompressor (
+            newCompressor (comps[i], w * sizeof (half), hdr));
+
+        int                            lines = compressor->numScanLines ();
+        pixelArray*                    passes[] = {&array1, &array2, &array1};
+        std::vector<std::vector<char>> firstPass;
+
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            const pixelArray& array = *passes[pass];
+
+            for (int y = 0, chunk = 0; y < h; y += lines, ++chunk)
+            {
+                int n      = std::min (lines, h - y);
+                int inSize = n * w * sizeof (half);
+
+                const char* compressed;
+                int         compressedSize = compressor->compress (
+                    (const char*) &array.h[y][0], inSize, y, compressed);
+
+                std::vector<char> data (
+                    compressed, compressed + compressedSize);
+
+                if (pass == 0)
+                    firstPass.push_back (data);
+                else if (pass == 2)
+                    assert (data == firstPass[chunk]);
+
+                // the caller stores chunks that do not shrink as is
+                if (compressedSize >= inSize) continue;
+
+                const char* uncompressed;
+                int         uncompressedSize = decompressor->uncompress (
+                    data.data (), compressedSize, y, uncompressed);
+
+                assert (uncompressedSize == inSize);
+
+                const half* samples = (const half*) uncompressed;
+
+                for (int j = 0; j < n * w; ++j)
+                    assert (samples[j].bits () == (&array.h[y][0])[j].bits ());
+            }
+        }
+
+        cout << endl;
+    }
+}
+
+//
+// Write and read back one HALF channel that holds every half bit
+// pattern, including negative zero, denormals, infinities and NaNs.
+// The lines are narrow as well as wide, so that the vectorized
+// conversions between half and 32-bit sign-magnitude samples go
+// through both their full-width and their tail code paths.
+//
+
+void
+writeReadAllHalfValues (const std::string& tempDir)
+{
+    std::string filename = tempDir + "imf_test_comp.exr";
+
+    static const Compression comps[] = {
+        HT_COMPRESSION, HT256_COMPRESSION, HT_STRIPED_COMPRESSION};
+
+    static const int widths[] = {1, 7, 8, 9, 15, 16, 17, 1371};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        cout << "compression " << comps[i] << ", all half values, width"
+             << flush;
+
+        for (int k = 0; k < 8; ++k)
+        {
+            int w = widths[k];
+            int h = std::min ((65536 + w - 1) / w, 512);
+
+            cout << " " << w << flush;
+
+            //
+            // Multiplying by an odd number permutes the 16-bit values,
+            // so an image of 65536 or more samples holds all of them.
+            //
+
+            Array2D<half> pixels (h, w);
+
+            for (int y = 0; y < h; ++y)
+                for (int x = 0; x < w; ++x)
+                    pixels[y][x].setBits (
+                        static_cast<unsigned short> ((y * w + x) * 40503));
+
+            Header hdr (w, h);
+            hdr.compression () = comps[i];
+            hdr.channels ().insert ("H", Channel (IMF::HALF));
+
+            {
+                FrameBuffer fb;
+                fb.insert (
+                    "H",
+                    Slice (
+                        IMF::HALF,
+                        (char*) &pixels[0][0],
+                        sizeof (half),
+                        sizeof (half) * w));
+
+                OutputFile out (filename.c_str (), hdr);
+                out.setFrameBuffer (fb);
+                out.writePixels (h);
+            }
+
+            Array2D<half> restored (h, w);
+
+            {
+                FrameBuffer fb;
+                fb.insert (
+                    "H",
+                    Slice (
+                        IMF::HALF,
+                        (char*) &restored[0][0],
+                        sizeof (half),
+                        sizeof (half) * w));
+
+                InputFile in (filename.c_str ());
+                in.setFrameBuffer (fb);
+                in.readPixels (0, h - 1);
+            }
+
+            for (int y = 0; y < h; ++y)
+                for (int x = 0; x < w; ++x)
+                    assert (restored[y][x].bits () == pixels[y][x].bits ());
+        }
+
+        cout << endl;
+    }
+
+    remove (filename.c_str ());
+}
+
+//
+// A chunk that HT can not shrink must come back from compress () as
+// the input itself, which the caller then stores as is.  Each stripe
+// is coded straight into a slot of the chunk buffer no larger than
+// the uncompressed stripe, so for HT_STRIPED_COMPRESSION one stripe
+// that does not fit is enough.  The compressor must still code the
+// next, compressible, chunk correctly.
+//
+
+void
+incompressibleChunks (
+    pixelArray& smooth, pixelArray& noise, pixelArray& mixed, int w, int h)
+{
+    static const Compression comps[] = {
+        HT_COMPRESSION, HT256_COMPRESSION, HT_STRIPED_COMPRESSION};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        Header hdr (
+            Box2i (V2i (0, 0), V2i (w - 1, h - 1)),
+            Box2i (V2i (0, 0), V2i (w - 1, h - 1)));
+
+        hdr.compression () = comps[i];
+        hdr.channels ().insert ("H", Channel (IMF::HALF));
+
+        cout << "compression " << hdr.compression () << ", incompressible"
+             << flush;
+
+        std::unique_ptr<Compressor> compressor (
+            newCompressor (comps[i], w * sizeof (half), hdr));
+
+        int n      = std::min (compressor->numScanLines (), h);
+        int inSize = n * w * sizeof (half);
+
+        const char* inPtr = (const char*) &noise.h[0][0];
+        const char* compressed;
+        int compressedSize = compressor->compress (inPtr, inSize, 0, compressed);
+
+        assert (compressedSize == inSize);
+        assert (compressed == inPtr);
+
+        if (comps[i] == HT_STRIPED_COMPRESSION)
+        {
+            // only the stripes after the first one hold noise
+            inPtr          = (const char*) &mixed.h[0][0];
+            compressedSize = compressor->compress (inPtr, inSize, 0, compressed);
+
+            assert (compressedSize == inSize);
+            assert (compressed == inPtr);
+        }
+
+        inPtr          = (const char*) &smooth.h[0][0];
+        compressedSize = compressor->compress (inPtr, inSize, 0, compressed);
+
+        assert (compressedSize < inSize);
+
+        std::vector<char> data (compressed, compressed + compressedSize);
+
+        std::unique_ptr<Compressor> decompressor (
+            newCompressor (comps[i], w * sizeof (half), hdr));
+
+        const char* uncompressed;
+        int         uncompressedSize = decompressor->uncompress (
+            data.data (), compressedSize, 0, uncompressed);
+
+        assert (uncompressedSize == inSize);
+
+        const half* samples = (const half*) uncompressed;
+
+        for (int j = 0; j < n * w; ++j)
+            assert (samples[j].bits () == (&smooth.h[0][0])[j].bits ());
+
+        cout << endl;
+    }
 }
 
 } // namespace
@@ -359,6 +1007,74 @@ testHTCompression (const std::string& tempDir)
         fillPixels4 (array, W, H);
         writeRead (tempDir, array, W, H, DX, DY);
 
+        //
+        // Tall enough for HT_STRIPED chunks to be split into several
+        // stripes
+        //
+
+        const int TH = 700;
+
+        pixelArray tallArray (TH, W);
+
+        fillPixels3 (tallArray, W, TH);
+        writeRead (tempDir, tallArray, W, TH, DX, DY);
+
+        fillPixels4 (tallArray, W, TH);
+        writeRead (tempDir, tallArray, W, TH, DX, DY);
+
+        //
+        // Non-default coding parameters
+        //
+
+        writeReadCodingParameters (tempDir, tallArray, W, TH);
+
+        //
+        // Reduced resolution decoding
+        //
+
+        fillPixels3 (tallArray, W, TH);
+        writeReadReduced (tempDir, tallArray, W, TH, DX, DY);
+
+        //
+        // Partial decoding of a chunk
+        //
+
+        fillPixels4 (tallArray, W, TH);
+        uncompressLines (tallArray, W, TH, DX, DY);
+
+        //
+        // Compressors reused across chunks and images
+        //
+
+        pixelArray otherArray (TH, W);
+
+        fillPixels3 (tallArray, W, TH);
+        fillPixels2 (otherArray, W, TH);
+        reuseCompressor (tallArray, otherArray, W, TH);
+
+        //
+        // Every half value, at line widths that exercise the
+        // vectorized conversions
+        //
+
+        writeReadAllHalfValues (tempDir);
+
+        //
+        // Chunks that do not fit in the chunk buffer
+        //
+
+        pixelArray noiseArray (TH, W);
+        pixelArray mixedArray (TH, W);
+
+        fillPixels4 (noiseArray, W, TH);
+        fillPixels4 (mixedArray, W, TH);
+
+        for (int y = 0; y < 256; ++y)
+            for (int x = 0; x < W; ++x)
+                mixedArray.h[y][x] = tallArray.h[y][x];
+
+        incompressibleChunks (tallArray, noiseArray, mixedArray, W, TH);
+
         cout << "ok\n" << endl;
     }
     catch (const std::exception& e)
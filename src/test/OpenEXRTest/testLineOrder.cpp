@@ -9,15 +9,18 @@
 
 #include "IlmThread.h"
 #include "half.h"
+#include <Iex.h>
 #include <ImfArray.h>
 #include <ImfChannelList.h>
 #include <ImfFrameBuffer.h>
 #include <ImfHeader.h>
 #include <ImfInputFile.h>
 #include <ImfOutputFile.h>
+#include <ImfStdIO.h>
 #include <ImfThreading.h>
 
 #include <assert.h>
+#include <fstream>
 #include <stdio.h>
 
 using namespace OPENEXR_IMF_NAMESPACE;
@@ -41,7 +44,8 @@ writeRead (
     const char           fileName[],
     int                  width,
     int                  height,
-    LineOrder            lorder)
+    LineOrder            lorder,
+    int                  window = 0)
 {
     //
     // Write the pixel data in ph1 to an image file using
@@ -49,12 +53,18 @@ writeRead (
     // from the file in pseudo-random order and verify that
     // the data did not change.
     //
+    // If window is not zero, write the file out of order with
+    // up to window chunks in flight, a few scan lines per call
+    // so that the calls leave chunks partially full.
+    //
 
     cout << "line order " << lorder << ":" << flush;
 
     Header hdr (width, height);
     hdr.lineOrder () = lorder;
 
+    if (window) hdr.compression () = ZIP_COMPRESSION;
+
     hdr.channels ().insert (
         "H", // name
         Channel (
@@ -82,7 +92,18 @@ writeRead (
         remove (fileName);
         OutputFile out (fileName, hdr);
         out.setFrameBuffer (fb);
-        out.writePixels (height);
+
+        if (window)
+        {
+            cout << " out of order (" << window << " chunks)" << flush;
+
+            out.setOutOfOrderWrites (window);
+
+            for (int y = 0; y < height; y += 7)
+                out.writePixels (min (7, height - y));
+        }
+        else
+            out.writePixels (height);
     }
 
     {
@@ -90,6 +111,8 @@ writeRead (
 
         InputFile in (fileName);
 
+        assert (in.isComplete ());
+
         const Box2i& dw = in.header ().dataWindow ();
         int          w  = dw.max.x - dw.min.x + 1;
         int          h  = dw.max.y - dw.min.y + 1;
@@ -156,10 +179,129 @@ writeRead (
                 assert (ph1[y][x] == ph2[y][x]);
     }
 
+    {
+        //
+        // Read the top half of the image in the background, and
+        // the rest one scan line at a time, with read-ahead.
+        //
+
+        cout << " reading asynchronously" << flush;
+
+        InputFile in (fileName);
+        in.setReadAhead (3);
+        assert (in.readAhead () == 3);
+
+        const Box2i& dw = in.header ().dataWindow ();
+        int          w  = dw.max.x - dw.min.x + 1;
+        int          h  = dw.max.y - dw.min.y + 1;
+        int          dx = dw.min.x;
+        int          dy = dw.min.y;
+
+        Array2D<half> ph2 (h, w);
+
+        FrameBuffer fb;
+
+        fb.insert (
+            "H", // name
+            Slice (
+                HALF,                   // type
+                (char*) &ph2[-dy][-dx], // base
+                sizeof (ph2[0][0]),     // xStride
+                sizeof (ph2[0][0]) * w, // yStride
+                1,                      // xSampling
+                1)                      // ySampling
+        );
+
+        in.setFrameBuffer (fb);
+
+        AsyncRead read = in.readPixelsAsync (dw.min.y, dw.min.y + h / 2);
+        read.wait ();
+        read.wait ();
+
+        for (int y = dw.min.y + h / 2 + 1; y <= dw.max.y; ++y)
+            in.readPixels (y);
+
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                assert (ph1[y][x] == ph2[y][x]);
+    }
+
+    {
+        //
+        // Read through a stream opened by the caller.  It has no
+        // positional reads, so the chunks are fetched with seekg()
+        // and read(), and in a RANDOM_Y file the chunk that follows
+        // one line buffer need not be the next line buffer.
+        //
+
+        cout << " reading through an ifstream" << flush;
+
+        std::ifstream ifs (fileName, std::ios_base::binary);
+        StdIFStream   is (ifs, fileName);
+        InputFile     in (is);
+
+        const Box2i& dw = in.header ().dataWindow ();
+        int          w  = dw.max.x - dw.min.x + 1;
+        int          h  = dw.max.y - dw.min.y + 1;
+        int          dx = dw.min.x;
+        int          dy = dw.min.y;
+
+        Array2D<half> ph2 (h, w);
+
+        FrameBuffer fb;
+
+        fb.insert (
+            "H", // name
+            Slice (
+                HALF,                   // type
+                (char*) &ph2[-dy][-dx], // base
+                sizeof (ph2[0][0]),     // xStride
+                sizeof (ph2[0][0]) * w, // yStride
+                1,                      // xSampling
+                1)                      // ySampling
+        );
+
+        in.setFrameBuffer (fb);
+
+        for (int y = dw.min.y; y <= dw.max.y; ++y)
+            in.readPixels (y);
+
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                assert (ph1[y][x] == ph2[y][x]);
+    }
+
     remove (fileName);
     cout << endl;
 }
 
+void
+rejectOutOfOrder (const char fileName[], LineOrder lorder)
+{
+    //
+    // Chunks written out of order would contradict a header
+    // that declares increasing or decreasing y order.
+    //
+
+    Header hdr (16, 16);
+    hdr.lineOrder () = lorder;
+    hdr.channels ().insert ("H", Channel (HALF));
+
+    OutputFile out (fileName, hdr);
+    bool       caught = false;
+
+    try
+    {
+        out.setOutOfOrderWrites (2);
+    }
+    catch (const IEX_NAMESPACE::ArgExc&)
+    {
+        caught = true;
+    }
+
+    assert (caught);
+}
+
 } // namespace
 
 void
@@ -187,10 +329,15 @@ testLineOrder (const std::string& tempDir)
 
             std::string filename = tempDir + "imf_test_lorder.exr";
 
-            for (int lorder = 0; lorder < RANDOM_Y; ++lorder)
-            {
+            for (int lorder = 0; lorder <= RANDOM_Y; ++lorder)
                 writeRead (ph, filename.c_str (), W, H, LineOrder (lorder));
-            }
+
+            writeRead (ph, filename.c_str (), W, H, RANDOM_Y, 1);
+            writeRead (ph, filename.c_str (), W, H, RANDOM_Y, 5);
+
+            rejectOutOfOrder (filename.c_str (), INCREASING_Y);
+            rejectOutOfOrder (filename.c_str (), DECREASING_Y);
+            remove (filename.c_str ());
         }
 
         cout << "ok\n" << endl;
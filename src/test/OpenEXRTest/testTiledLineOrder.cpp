@@ -14,12 +14,15 @@
 #include <ImfFrameBuffer.h>
 #include <ImfHeader.h>
 #include <ImfInputFile.h>
+#include <ImfStdIO.h>
 #include <ImfThreading.h>
+#include <ImfTileCache.h>
 #include <ImfTiledInputFile.h>
 #include <ImfTiledOutputFile.h>
 #include <half.h>
 
 #include <assert.h>
+#include <fstream>
 #include <stdio.h>
 #include <vector>
 
@@ -392,6 +395,97 @@ writeCopyReadMIP (
                     assert ((levels2[l])[y][x] == (levels[l])[y][x]);
     }
 
+    {
+        cout << " caching" << flush;
+
+        //
+        // Read all tiles twice with the tile cache enabled.  The
+        // first pass misses on every tile, the second pass must
+        // find every tile in the cache and produce the same pixels.
+        //
+
+        setTileCacheSize (64 * 1024 * 1024);
+        clearTileCache ();
+
+        TiledInputFile in (fileName);
+
+        int      numLevels = in.numLevels ();
+        uint64_t numTiles  = 0;
+
+        for (int level = 0; level < numLevels; ++level)
+            numTiles += in.numXTiles (level) * in.numYTiles (level);
+
+        auto readAllTiles = [&] (TiledInputFile& file) {
+            for (int level = 0; level < numLevels; ++level)
+            {
+                int levelWidth  = file.levelWidth (level);
+                int levelHeight = file.levelHeight (level);
+
+                Array2D<half> pixels (levelHeight, levelWidth);
+
+                FrameBuffer fb;
+
+                fb.insert (
+                    "H",
+                    Slice (
+                        HALF,
+                        (char*) &pixels[0][0],
+                        sizeof (pixels[0][0]),
+                        sizeof (pixels[0][0]) * levelWidth));
+
+                file.setFrameBuffer (fb);
+
+                file.readTiles (
+                    0,
+                    file.numXTiles (level) - 1,
+                    0,
+                    file.numYTiles (level) - 1,
+                    level);
+
+                for (int y = 0; y < levelHeight; ++y)
+                    for (int x = 0; x < levelWidth; ++x)
+                        assert (pixels[y][x] == (levels[level])[y][x]);
+            }
+        };
+
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            readAllTiles (in);
+
+            TileCacheStats stats = tileCacheStats ();
+
+            assert (stats.misses == numTiles);
+            assert (stats.hits == (pass == 0 ? 0 : numTiles));
+            assert (stats.size > 0);
+        }
+
+        //
+        // Another reader of the same file shares the cached tiles.
+        // A stream around an std::ifstream opened by the caller does
+        // not identify the file, so its tiles are kept apart.
+        //
+
+        {
+            TiledInputFile in2 (fileName);
+            readAllTiles (in2);
+            assert (tileCacheStats ().hits == 2 * numTiles);
+            assert (tileCacheStats ().misses == numTiles);
+        }
+
+        {
+            std::ifstream  ifs (fileName, std::ios_base::binary);
+            StdIFStream    is (ifs, fileName);
+            TiledInputFile in3 (is);
+
+            readAllTiles (in3);
+            assert (tileCacheStats ().hits == 2 * numTiles);
+            assert (tileCacheStats ().misses == 2 * numTiles);
+        }
+
+        setTileCacheSize (0);
+        assert (tileCacheStats ().size == 0);
+    }
+
     remove (fileName);
     cout << endl;
 }
@@ -14,6 +14,7 @@
 #include <exception>
 #include <iostream>
 #include <stdlib.h>
+#include <vector>
 
 using namespace OPENEXR_IMF_NAMESPACE;
 using namespace std;
@@ -210,6 +211,216 @@ test (int nx, int ny)
     wavEncodeDecode (a, b, nx, ny);
 }
 
+//
+// Reference transform: the original, one 2x2 block at a time scalar
+// code. wav2Encode () and wav2Decode () do the finest levels with
+// vector code where available and have to produce exactly the same
+// coefficients. The core's PIZ codec, which picks its vector passes
+// at run time, is held to the C++ one by the exact cross-library
+// comparisons in OpenEXRCoreTest.
+//
+
+void
+refEnc14 (unsigned short a, unsigned short b, unsigned short& l, unsigned short& h)
+{
+    short as = a;
+    short bs = b;
+
+    l = (short) ((as + bs) >> 1);
+    h = (short) (as - bs);
+}
+
+void
+refDec14 (unsigned short l, unsigned short h, unsigned short& a, unsigned short& b)
+{
+    short ls = l;
+    short hs = h;
+    int   hi = hs;
+    int   ai = ls + (hi & 1) + (hi >> 1);
+
+    a = (short) ai;
+    b = (short) (ai - hi);
+}
+
+void
+refEnc16 (unsigned short a, unsigned short b, unsigned short& l, unsigned short& h)
+{
+    int ao = (a + (1 << 15)) & 0xffff;
+    int m  = ((ao + b) >> 1);
+    int d  = ao - b;
+
+    if (d < 0) m = (m + (1 << 15)) & 0xffff;
+
+    l = m;
+    h = d & 0xffff;
+}
+
+void
+refDec16 (unsigned short l, unsigned short h, unsigned short& a, unsigned short& b)
+{
+    int m  = l;
+    int d  = h;
+    int bb = (m - (d >> 1)) & 0xffff;
+
+    b = bb;
+    a = (d + bb - (1 << 15)) & 0xffff;
+}
+
+void
+refWav2 (
+    unsigned short* in,
+    int             nx,
+    int             ox,
+    int             ny,
+    int             oy,
+    unsigned short  mx,
+    bool            encode)
+{
+    void (*f) (unsigned short, unsigned short, unsigned short&, unsigned short&);
+
+    if (mx < (1 << 14))
+        f = encode ? refEnc14 : refDec14;
+    else
+        f = encode ? refEnc16 : refDec16;
+
+    int n = (nx > ny) ? ny : nx;
+    int p = 1;
+
+    if (!encode)
+    {
+        while (p <= n)
+            p <<= 1;
+
+        p >>= 2;
+    }
+
+    while (encode ? (2 * p <= n) : (p >= 1))
+    {
+        int             p2  = 2 * p;
+        unsigned short* py  = in;
+        unsigned short* ey  = in + oy * (ny - p2);
+        int             oy1 = oy * p;
+        int             ox1 = ox * p;
+        unsigned short  i00, i01, i10, i11;
+
+        for (; py <= ey; py += oy * p2)
+        {
+            unsigned short* px = py;
+            unsigned short* ex = py + ox * (nx - p2);
+
+            for (; px <= ex; px += ox * p2)
+            {
+                unsigned short* p01 = px + ox1;
+                unsigned short* p10 = px + oy1;
+                unsigned short* p11 = p10 + ox1;
+
+                if (encode)
+                {
+                    f (*px, *p01, i00, i01);
+                    f (*p10, *p11, i10, i11);
+                    f (i00, i10, *px, *p10);
+                    f (i01, i11, *p01, *p11);
+                }
+                else
+                {
+                    f (*px, *p10, i00, i10);
+                    f (*p01, *p11, i01, i11);
+                    f (i00, i01, *px, *p01);
+                    f (i10, i11, *p10, *p11);
+                }
+            }
+
+            if (nx & p)
+            {
+                unsigned short* p10 = px + oy1;
+                f (*px, *p10, i00, *p10);
+                *px = i00;
+            }
+        }
+
+        if (ny & p)
+        {
+            unsigned short* px = py;
+            unsigned short* ex = py + ox * (nx - p2);
+
+            for (; px <= ex; px += ox * p2)
+            {
+                unsigned short* p01 = px + ox1;
+                f (*px, *p01, i00, *p01);
+                *px = i00;
+            }
+        }
+
+        if (encode)
+            p <<= 1;
+        else
+            p >>= 1;
+    }
+}
+
+//
+// Transform nc interleaved channels of an nx by ny image with
+// wav2Encode () and wav2Decode (), and check every intermediate
+// result against the reference transform.
+//
+
+void
+compareWithReference (int nx, int ny, int nc, unsigned short mask, int seed)
+{
+    std::vector<unsigned short> a (size_t (nx) * ny * nc);
+    IMATH_NAMESPACE::Rand48     rand48 (seed);
+
+    for (size_t i = 0; i < a.size (); ++i)
+        a[i] = rand48.nexti () & mask;
+
+    std::vector<unsigned short> orig = a;
+    std::vector<unsigned short> b    = a;
+
+    for (int c = 0; c < nc; ++c)
+    {
+        wav2Encode (&a[c], nx, nc, ny, nx * nc, mask);
+        refWav2 (&b[c], nx, nc, ny, nx * nc, mask, true);
+    }
+
+    assert (a == b);
+
+    for (int c = 0; c < nc; ++c)
+    {
+        wav2Decode (&a[c], nx, nc, ny, nx * nc, mask);
+        refWav2 (&b[c], nx, nc, ny, nx * nc, mask, false);
+    }
+
+    assert (a == b);
+    assert (a == orig);
+}
+
+void
+testReference ()
+{
+    static const int sizes[][2] = {
+        {1, 1},
+        {2, 2},
+        {3, 5},
+        {17, 9},
+        {31, 64},
+        {129, 130},
+        {997, 37},
+        {37, 997},
+        {1920, 32}};
+
+    cout << "comparing with the scalar reference transform" << endl;
+
+    int seed = 0;
+    for (const auto& s: sizes)
+    {
+        for (int nc = 1; nc <= 3; ++nc)
+        {
+            compareWithReference (s[0], s[1], nc, 0x3fff, ++seed);
+            compareWithReference (s[0], s[1], nc, 0xffff, ++seed);
+        }
+    }
+}
+
 } // namespace
 
 void
@@ -229,6 +440,8 @@ testWav (const std::string&)
         test (1024, 1024);
         test (997, 997);
 
+        testReference ();
+
         cout << "ok\n" << endl;
     }
     catch (const std::exception& e)